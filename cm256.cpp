@@ -128,22 +128,43 @@ static GF256_FORCE_INLINE unsigned char GetMatrixElement(unsigned char x_i, unsi
     return gf256_div(gf256_add(y_j, x_0), gf256_add(x_i, y_j));
 }
 
+extern "C" unsigned char cm256_get_recovery_coefficient(
+    cm256_encoder_params params, // Encoder parameters
+    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
+    int originalIndex)           // Original block index
+{
+    // First recovery row is all ones, and so is a single original
+    if (recoveryBlockIndex == params.OriginalCount || params.OriginalCount == 1)
+    {
+        return 1;
+    }
+
+    const uint8_t x_0 = static_cast<uint8_t>(params.OriginalCount);
+    const uint8_t x_i = static_cast<uint8_t>(recoveryBlockIndex);
+    const uint8_t y_j = static_cast<uint8_t>(originalIndex);
+
+    return GetMatrixElement(x_i, x_0, y_j);
+}
+
 
 //-----------------------------------------------------------------------------
 // Encoding
 
-extern "C" void cm256_encode_block(
+// Encode one recovery block over the byte range [offset, offset + bytes)
+static void EncodeBlockRange(
     cm256_encoder_params params, // Encoder parameters
     cm256_block* originals,      // Array of pointers to original blocks
     int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
-    void* recoveryBlock)         // Output recovery block
+    uint8_t* recoveryBlock,      // Output recovery block, already offset
+    int offset,                  // Byte offset into the original blocks
+    int bytes)                   // Number of bytes to encode
 {
     // If only one block of input data,
     if (params.OriginalCount == 1)
     {
         // No meaningful operation here, degenerate to outputting the same data each time.
 
-        memcpy(recoveryBlock, originals[0].Block, params.BlockBytes);
+        memcpy(recoveryBlock, static_cast<const uint8_t*>(originals[0].Block) + offset, bytes);
         return;
     }
     // else OriginalCount >= 2:
@@ -153,10 +174,26 @@ extern "C" void cm256_encode_block(
     // so it is merely a parity of the original data.
     if (recoveryBlockIndex == params.OriginalCount)
     {
-        gf256_addset_mem(recoveryBlock, originals[0].Block, originals[1].Block, params.BlockBytes);
-        for (int j = 2; j < params.OriginalCount; ++j)
+        // Sum the originals in one pass over the output per CM256_MAX_BLOCKS of
+        // them, since cm256_encode_block() does not check OriginalCount
+        const void* sources[CM256_MAX_BLOCKS];
+        for (int first = 0; first < params.OriginalCount; first += CM256_MAX_BLOCKS)
         {
-            gf256_add_mem(recoveryBlock, originals[j].Block, params.BlockBytes);
+            const int count = params.OriginalCount - first < CM256_MAX_BLOCKS ?
+                params.OriginalCount - first : CM256_MAX_BLOCKS;
+            for (int j = 0; j < count; ++j)
+            {
+                sources[j] = static_cast<const uint8_t*>(originals[first + j].Block) + offset;
+            }
+
+            if (first == 0)
+            {
+                gf256_addset_n_mem(recoveryBlock, sources, count, bytes);
+            }
+            else
+            {
+                gf256_add_n_mem(recoveryBlock, sources, count, bytes);
+            }
         }
         return;
     }
@@ -175,7 +212,7 @@ extern "C" void cm256_encode_block(
             const uint8_t y_0 = 0;
             const uint8_t matrixElement = GetMatrixElement(x_i, x_0, y_0);
 
-            gf256_mul_mem(recoveryBlock, originals[0].Block, matrixElement, params.BlockBytes);
+            gf256_mul_mem(recoveryBlock, static_cast<const uint8_t*>(originals[0].Block) + offset, matrixElement, bytes);
         }
 
         // For each original data column,
@@ -184,11 +221,20 @@ extern "C" void cm256_encode_block(
             const uint8_t y_j = static_cast<uint8_t>(j);
             const uint8_t matrixElement = GetMatrixElement(x_i, x_0, y_j);
 
-            gf256_muladd_mem(recoveryBlock, matrixElement, originals[j].Block, params.BlockBytes);
+            gf256_muladd_mem(recoveryBlock, matrixElement, static_cast<const uint8_t*>(originals[j].Block) + offset, bytes);
         }
     }
 }
 
+extern "C" void cm256_encode_block(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
+    void* recoveryBlock)         // Output recovery block
+{
+    EncodeBlockRange(params, originals, recoveryBlockIndex, static_cast<uint8_t*>(recoveryBlock), 0, params.BlockBytes);
+}
+
 extern "C" int cm256_encode(
     cm256_encoder_params params, // Encoder params
     cm256_block* originals,      // Array of pointers to original blocks
@@ -201,7 +247,7 @@ extern "C" int cm256_encode(
     {
         return -1;
     }
-    if (params.OriginalCount + params.RecoveryCount > 256)
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
     {
         return -2;
     }
@@ -230,24 +276,49 @@ struct CM256Decoder
     cm256_encoder_params Params;
 
     // Recovery blocks
-    cm256_block* Recovery[256];
+    cm256_block* Recovery[CM256_MAX_BLOCKS];
     int RecoveryCount;
 
     // Original blocks
-    cm256_block* Original[256];
+    cm256_block* Original[CM256_MAX_BLOCKS];
     int OriginalCount;
 
     // Row indices that were erased
-    uint8_t ErasuresIndices[256];
+    uint8_t ErasuresIndices[CM256_MAX_BLOCKS];
+
+    // Matrix decomposition storage for m>1 case
+    // N x N for N recovery blocks, which is at most CM256_MAX_BLOCKS / 2
+    static const int StackAllocSize = (CM256_MAX_BLOCKS * CM256_MAX_BLOCKS / 4 < 2048) ?
+                                      CM256_MAX_BLOCKS * CM256_MAX_BLOCKS / 4 : 2048;
+    uint8_t StackMatrix[StackAllocSize];
+    uint8_t* DynamicMatrix;
+    uint8_t* Matrix_L;
+    uint8_t* Diag_D;
+    uint8_t* Matrix_U;
+
+    CM256Decoder()
+        : DynamicMatrix(nullptr)
+    {
+    }
+    ~CM256Decoder()
+    {
+        delete[] DynamicMatrix;
+    }
 
     // Initialize the decoder
     bool Initialize(cm256_encoder_params& params, cm256_block* blocks);
 
-    // Decode m=1 case
-    void DecodeM1();
+    // Decode m=1 case over the byte range [offset, offset + bytes)
+    void DecodeM1(int offset, int bytes);
+
+    // Generate the matrix decomposition used by Decode() for m>1 case
+    void Decompose();
 
-    // Decode for m>1 case
-    void Decode();
+    // Decode for m>1 case over the byte range [offset, offset + bytes)
+    void Decode(int offset, int bytes);
+
+    // Update the recovery block indices once all byte ranges are decoded
+    void SetRecoveredIndices();
 
     // Generate the LU decomposition of the matrix
     void GenerateLDUDecomposition(uint8_t* matrix_L, uint8_t* diag_D, uint8_t* matrix_U);
@@ -292,7 +363,7 @@ bool CM256Decoder::Initialize(cm256_encoder_params& params, cm256_block* blocks)
     }
 
     // Identify erasures
-    for (int ii = 0, indexCount = 0; ii < 256; ++ii)
+    for (int ii = 0, indexCount = 0; ii < params.OriginalCount; ++ii)
     {
         if (!ErasuresIndices[ii])
         {
@@ -308,37 +379,27 @@ bool CM256Decoder::Initialize(cm256_encoder_params& params, cm256_block* blocks)
     return true;
 }
 
-void CM256Decoder::DecodeM1()
+void CM256Decoder::DecodeM1(int offset, int bytes)
 {
     // XOR all other blocks into the recovery block
-    uint8_t* outBlock = static_cast<uint8_t*>(Recovery[0]->Block);
-    const uint8_t* inBlock = nullptr;
+    uint8_t* outBlock = static_cast<uint8_t*>(Recovery[0]->Block) + offset;
 
-    // For each block,
+    const void* sources[CM256_MAX_BLOCKS];
     for (int ii = 0; ii < OriginalCount; ++ii)
     {
-        const uint8_t* inBlock2 = static_cast<const uint8_t*>(Original[ii]->Block);
-
-        if (!inBlock)
-        {
-            inBlock = inBlock2;
-        }
-        else
-        {
-            // outBlock ^= inBlock ^ inBlock2
-            gf256_add2_mem(outBlock, inBlock, inBlock2, Params.BlockBytes);
-            inBlock = nullptr;
-        }
+        sources[ii] = static_cast<const uint8_t*>(Original[ii]->Block) + offset;
     }
 
-    // Complete XORs
-    if (inBlock)
+    gf256_add_n_mem(outBlock, sources, OriginalCount, bytes);
+}
+
+void CM256Decoder::SetRecoveredIndices()
+{
+    // Recover the indices they correspond to
+    for (int i = 0; i < RecoveryCount; ++i)
     {
-        gf256_add_mem(outBlock, inBlock, Params.BlockBytes);
+        Recovery[i]->Index = ErasuresIndices[i];
     }
-
-    // Recover the index it corresponds to
-    Recovery[0]->Index = ErasuresIndices[0];
 }
 
 // Generate the LU decomposition of the matrix
@@ -355,7 +416,7 @@ void CM256Decoder::GenerateLDUDecomposition(uint8_t* matrix_L, uint8_t* diag_D,
     const int N = RecoveryCount;
 
     // Generators
-    uint8_t g[256], b[256];
+    uint8_t g[CM256_MAX_BLOCKS], b[CM256_MAX_BLOCKS];
     for (int i = 0; i < N; ++i)
     {
         g[i] = 1;
@@ -364,7 +425,7 @@ void CM256Decoder::GenerateLDUDecomposition(uint8_t* matrix_L, uint8_t* diag_D,
 
     // Temporary buffer for rotated row of U matrix
     // This allows for faster GF bulk multiplication
-    uint8_t rotated_row_U[256];
+    uint8_t rotated_row_U[CM256_MAX_BLOCKS];
     uint8_t* last_U = matrix_U + ((N - 1) * N) / 2 - 1;
     int firstOffset_U = 0;
 
@@ -451,7 +512,36 @@ void CM256Decoder::GenerateLDUDecomposition(uint8_t* matrix_L, uint8_t* diag_D,
     diag_D[N - 1] = gf256_div(gf256_mul(L_nn, U_nn), gf256_add(x_n, y_n));
 }
 
-void CM256Decoder::Decode()
+void CM256Decoder::Decompose()
+{
+    // Matrix size is NxN, where N is the number of recovery blocks used.
+    const int N = RecoveryCount;
+
+    // Allocate matrix
+    uint8_t* matrix = StackMatrix;
+    const int requiredSpace = N * N;
+    if (requiredSpace > StackAllocSize)
+    {
+        DynamicMatrix = new uint8_t[requiredSpace];
+        matrix = DynamicMatrix;
+    }
+
+    /*
+        Compute matrix decomposition:
+
+            G = L * D * U
+
+        L is lower-triangular, diagonal is all ones.
+        D is a diagonal matrix.
+        U is upper-triangular, diagonal is all ones.
+    */
+    Matrix_U = matrix;
+    Diag_D = Matrix_U + (N - 1) * N / 2;
+    Matrix_L = Diag_D + N;
+    GenerateLDUDecomposition(Matrix_L, Diag_D, Matrix_U);
+}
+
+void CM256Decoder::Decode(int offset, int bytes)
 {
     // Matrix size is NxN, where N is the number of recovery blocks used.
     const int N = RecoveryCount;
@@ -462,61 +552,36 @@ void CM256Decoder::Decode()
     // Eliminate original data from the the recovery rows
     for (int originalIndex = 0; originalIndex < OriginalCount; ++originalIndex)
     {
-        const uint8_t* inBlock = static_cast<const uint8_t*>(Original[originalIndex]->Block);
+        const uint8_t* inBlock = static_cast<const uint8_t*>(Original[originalIndex]->Block) + offset;
         const uint8_t inRow = Original[originalIndex]->Index;
 
         for (int recoveryIndex = 0; recoveryIndex < N; ++recoveryIndex)
         {
-            uint8_t* outBlock = static_cast<uint8_t*>(Recovery[recoveryIndex]->Block);
+            uint8_t* outBlock = static_cast<uint8_t*>(Recovery[recoveryIndex]->Block) + offset;
             const uint8_t x_i = Recovery[recoveryIndex]->Index;
             const uint8_t y_j = inRow;
             const uint8_t matrixElement = GetMatrixElement(x_i, x_0, y_j);
 
-            gf256_muladd_mem(outBlock, matrixElement, inBlock, Params.BlockBytes);
+            gf256_muladd_mem(outBlock, matrixElement, inBlock, bytes);
         }
     }
 
-    // Allocate matrix
-    static const int StackAllocSize = 2048;
-    uint8_t stackMatrix[StackAllocSize];
-    uint8_t* dynamicMatrix = nullptr;
-    uint8_t* matrix = stackMatrix;
-    const int requiredSpace = N * N;
-    if (requiredSpace > StackAllocSize)
-    {
-        dynamicMatrix = new uint8_t[requiredSpace];
-        matrix = dynamicMatrix;
-    }
-
-    /*
-        Compute matrix decomposition:
-
-            G = L * D * U
-
-        L is lower-triangular, diagonal is all ones.
-        D is a diagonal matrix.
-        U is upper-triangular, diagonal is all ones.
-    */
-    uint8_t* matrix_U = matrix;
-    uint8_t* diag_D = matrix_U + (N - 1) * N / 2;
-    uint8_t* matrix_L = diag_D + N;
-    GenerateLDUDecomposition(matrix_L, diag_D, matrix_U);
-
     /*
         Eliminate lower left triangle.
     */
+    const uint8_t* matrix_L = Matrix_L;
     // For each column,
     for (int j = 0; j < N - 1; ++j)
     {
-        const void* block_j = Recovery[j]->Block;
+        const uint8_t* block_j = static_cast<const uint8_t*>(Recovery[j]->Block) + offset;
 
         // For each row,
         for (int i = j + 1; i < N; ++i)
         {
-            void* block_i = Recovery[i]->Block;
+            uint8_t* block_i = static_cast<uint8_t*>(Recovery[i]->Block) + offset;
             const uint8_t c_ij = *matrix_L++; // Matrix elements are stored column-first, top-down.
 
-            gf256_muladd_mem(block_i, c_ij, block_j, Params.BlockBytes);
+            gf256_muladd_mem(block_i, c_ij, block_j, bytes);
         }
     }
 
@@ -525,30 +590,27 @@ void CM256Decoder::Decode()
     */
     for (int i = 0; i < N; ++i)
     {
-        void* block = Recovery[i]->Block;
-
-        Recovery[i]->Index = ErasuresIndices[i];
+        uint8_t* block = static_cast<uint8_t*>(Recovery[i]->Block) + offset;
 
-        gf256_div_mem(block, block, diag_D[i], Params.BlockBytes);
+        gf256_div_mem(block, block, Diag_D[i], bytes);
     }
 
     /*
         Eliminate upper right triangle.
     */
+    const uint8_t* matrix_U = Matrix_U;
     for (int j = N - 1; j >= 1; --j)
     {
-        const void* block_j = Recovery[j]->Block;
+        const uint8_t* block_j = static_cast<const uint8_t*>(Recovery[j]->Block) + offset;
 
         for (int i = j - 1; i >= 0; --i)
         {
-            void* block_i = Recovery[i]->Block;
+            uint8_t* block_i = static_cast<uint8_t*>(Recovery[i]->Block) + offset;
             const uint8_t c_ij = *matrix_U++; // Matrix elements are stored column-first, bottom-up.
 
-            gf256_muladd_mem(block_i, c_ij, block_j, Params.BlockBytes);
+            gf256_muladd_mem(block_i, c_ij, block_j, bytes);
         }
     }
-
-    delete[] dynamicMatrix;
 }
 
 extern "C" int cm256_decode(
@@ -561,7 +623,7 @@ extern "C" int cm256_decode(
     {
         return -1;
     }
-    if (params.OriginalCount + params.RecoveryCount > 256)
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
     {
         return -2;
     }
@@ -593,11 +655,1051 @@ extern "C" int cm256_decode(
     // If m=1,
     if (params.RecoveryCount == 1)
     {
-        state.DecodeM1();
+        state.DecodeM1(0, params.BlockBytes);
+        state.SetRecoveredIndices();
         return 0;
     }
 
     // Decode for m>1
-    state.Decode();
+    state.Decompose();
+    state.Decode(0, params.BlockBytes);
+    state.SetRecoveredIndices();
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Repair
+
+// Working set that fused passes try to keep resident in cache
+static const int FusedWorkingSetBytes = 256 * 1024;
+
+// Pick a byte window so that one window of each block fits in the working set
+static int GetFusedWindowBytes(int blockCount, int blockBytes)
+{
+    int windowBytes = (FusedWorkingSetBytes / blockCount) & ~63;
+    if (windowBytes < 1024)
+    {
+        windowBytes = 1024;
+    }
+    if (windowBytes > blockBytes)
+    {
+        windowBytes = blockBytes;
+    }
+    return windowBytes;
+}
+
+extern "C" int cm256_repair(
+    cm256_encoder_params params,              // Encoder params
+    cm256_block* blocks,                      // Array of 'originalCount' blocks as described above
+    int lostRecoveryCount,                    // Number of recovery blocks to regenerate
+    const unsigned char* lostRecoveryIndices, // Recovery block indices to regenerate
+    void* recoveryBlocks)                     // Output recovery blocks end-to-end
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        lostRecoveryCount < 0 ||
+        lostRecoveryCount > params.RecoveryCount)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if (!blocks || (lostRecoveryCount > 0 && (!lostRecoveryIndices || !recoveryBlocks)))
+    {
+        return -3;
+    }
+    for (int i = 0; i < lostRecoveryCount; ++i)
+    {
+        const int index = lostRecoveryIndices[i];
+        if (index < params.OriginalCount ||
+            index >= params.OriginalCount + params.RecoveryCount)
+        {
+            return -4;
+        }
+    }
+
+    // Originals in index order, filled in as the decoder identifies them
+    cm256_block originals[CM256_MAX_BLOCKS];
+
+    CM256Decoder state;
+
+    // If there is only one block,
+    if (params.OriginalCount == 1)
+    {
+        // It is the same block repeated
+        blocks[0].Index = 0;
+        state.RecoveryCount = 0;
+        originals[0].Block = blocks[0].Block;
+    }
+    else
+    {
+        if (!state.Initialize(params, blocks))
+        {
+            return -5;
+        }
+
+        for (int i = 0; i < state.OriginalCount; ++i)
+        {
+            originals[state.Original[i]->Index].Block = state.Original[i]->Block;
+        }
+        for (int i = 0; i < state.RecoveryCount; ++i)
+        {
+            originals[state.ErasuresIndices[i]].Block = state.Recovery[i]->Block;
+        }
+
+        if (state.RecoveryCount > 0 && params.RecoveryCount > 1)
+        {
+            state.Decompose();
+        }
+    }
+
+    const int windowBytes = GetFusedWindowBytes(params.OriginalCount + lostRecoveryCount, params.BlockBytes);
+    uint8_t* recoveryBlock = static_cast<uint8_t*>(recoveryBlocks);
+
+    // For each byte window,
+    for (int offset = 0; offset < params.BlockBytes; offset += windowBytes)
+    {
+        int bytes = params.BlockBytes - offset;
+        if (bytes > windowBytes)
+        {
+            bytes = windowBytes;
+        }
+
+        // Recover the lost originals in this window
+        if (state.RecoveryCount > 0)
+        {
+            if (params.RecoveryCount == 1)
+            {
+                state.DecodeM1(offset, bytes);
+            }
+            else
+            {
+                state.Decode(offset, bytes);
+            }
+        }
+
+        // Regenerate the lost recovery rows while the window is still in cache
+        for (int i = 0; i < lostRecoveryCount; ++i)
+        {
+            EncodeBlockRange(params, originals, lostRecoveryIndices[i],
+                             recoveryBlock + i * params.BlockBytes + offset, offset, bytes);
+        }
+    }
+
+    if (state.RecoveryCount > 0)
+    {
+        state.SetRecoveredIndices();
+    }
+
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Copy and Encode
+
+extern "C" int cm256_encode_copy(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* originals,      // Array of pointers to original blocks
+    cm256_block* copies,         // Array of pointers to where the originals are copied
+    void* recoveryBlocks)        // Output recovery blocks end-to-end
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if (!originals || !copies || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    uint8_t* recovery = static_cast<uint8_t*>(recoveryBlocks);
+
+    // Keep one window of every recovery block in cache, plus the original being copied
+    const int windowBytes = GetFusedWindowBytes(params.RecoveryCount + 1, params.BlockBytes);
+
+    // For each byte window,
+    for (int offset = 0; offset < params.BlockBytes; offset += windowBytes)
+    {
+        int bytes = params.BlockBytes - offset;
+        if (bytes > windowBytes)
+        {
+            bytes = windowBytes;
+        }
+
+        // Copy each original and fold it into the recovery rows while it is in cache
+        for (int j = 0; j < params.OriginalCount; ++j)
+        {
+            const uint8_t* source = static_cast<const uint8_t*>(originals[j].Block) + offset;
+            uint8_t* copy = static_cast<uint8_t*>(copies[j].Block) + offset;
+
+            memcpy(copy, source, bytes);
+
+            for (int row = 0; row < params.RecoveryCount; ++row)
+            {
+                uint8_t* recoveryBlock = recovery + row * params.BlockBytes + offset;
+                const uint8_t y = cm256_get_recovery_coefficient(params, params.OriginalCount + row, j);
+
+                if (j == 0)
+                {
+                    if (y == 1)
+                    {
+                        memcpy(recoveryBlock, copy, bytes);
+                    }
+                    else
+                    {
+                        gf256_mul_mem(recoveryBlock, copy, y, bytes);
+                    }
+                }
+                else
+                {
+                    gf256_muladd_mem(recoveryBlock, y, copy, bytes);
+                }
+            }
+        }
+    }
+
     return 0;
 }
+
+
+//-----------------------------------------------------------------------------
+// Verify
+
+extern "C" int cm256_verify(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* originals,      // Array of pointers to original blocks
+    cm256_block* recovery,       // Array of 'recoveryCount' recovery blocks
+    unsigned char* mismatches)   // Optional per-recovery-block output flags
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if (!originals || !recovery)
+    {
+        return -3;
+    }
+    for (int row = 0; row < params.RecoveryCount; ++row)
+    {
+        if (recovery[row].Index < params.OriginalCount ||
+            recovery[row].Index >= params.OriginalCount + params.RecoveryCount)
+        {
+            return -4;
+        }
+    }
+
+    // Only one window of one recovery row is ever materialized, and it stays in cache
+    const int windowBytes = GetFusedWindowBytes(params.OriginalCount + 1, params.BlockBytes);
+    uint8_t* syndrome = new uint8_t[windowBytes];
+    int result = 0;
+
+    if (mismatches)
+    {
+        memset(mismatches, 0, params.RecoveryCount);
+    }
+
+    // For each byte window,
+    for (int offset = 0; offset < params.BlockBytes; offset += windowBytes)
+    {
+        int bytes = params.BlockBytes - offset;
+        if (bytes > windowBytes)
+        {
+            bytes = windowBytes;
+        }
+
+        for (int row = 0; row < params.RecoveryCount; ++row)
+        {
+            // Rows that already failed need not be checked again
+            if (mismatches && mismatches[row])
+            {
+                continue;
+            }
+
+            // syndrome = stored recovery + recomputed recovery, which is zero if they match
+            EncodeBlockRange(params, originals, recovery[row].Index, syndrome, offset, bytes);
+            gf256_add_mem(syndrome, static_cast<const uint8_t*>(recovery[row].Block) + offset, bytes);
+
+            for (int i = 0; i < bytes; ++i)
+            {
+                if (syndrome[i] != 0)
+                {
+                    if (mismatches)
+                    {
+                        mismatches[row] = 1;
+                    }
+                    result = 1;
+                    break;
+                }
+            }
+        }
+
+        // Without per-row flags the first mismatch settles the result
+        if (result && !mismatches)
+        {
+            break;
+        }
+    }
+
+    delete[] syndrome;
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// Cached Decoder
+
+struct cm256_decoder_t
+{
+    // Decoder state holding the matrix decomposition for one erasure pattern
+    CM256Decoder Plan;
+
+    // Positions of the recovery and original blocks in the caller's array
+    uint8_t RecoveryPositions[CM256_MAX_BLOCKS];
+    uint8_t OriginalPositions[CM256_MAX_BLOCKS];
+
+    // Block index expected at each position of the caller's array
+    uint8_t BlockIndices[CM256_MAX_BLOCKS];
+};
+
+extern "C" cm256_decoder* cm256_decoder_create(
+    cm256_encoder_params params,       // Encoder params
+    const unsigned char* blockIndices) // Index of each of the 'originalCount' blocks
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS ||
+        !blockIndices)
+    {
+        return nullptr;
+    }
+
+    cm256_decoder* decoder = new cm256_decoder;
+    CM256Decoder& plan = decoder->Plan;
+
+    cm256_block pattern[CM256_MAX_BLOCKS];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        pattern[i].Block = nullptr;
+        pattern[i].Index = blockIndices[i];
+        decoder->BlockIndices[i] = blockIndices[i];
+    }
+
+    // If there is only one block, it is the same block repeated
+    if (params.OriginalCount == 1)
+    {
+        plan.Params = params;
+        plan.OriginalCount = 1;
+        plan.RecoveryCount = 0;
+        return decoder;
+    }
+
+    if (!plan.Initialize(params, pattern))
+    {
+        delete decoder;
+        return nullptr;
+    }
+
+    for (int i = 0; i < plan.RecoveryCount; ++i)
+    {
+        decoder->RecoveryPositions[i] = static_cast<uint8_t>(plan.Recovery[i] - pattern);
+    }
+    for (int i = 0; i < plan.OriginalCount; ++i)
+    {
+        decoder->OriginalPositions[i] = static_cast<uint8_t>(plan.Original[i] - pattern);
+    }
+
+    if (plan.RecoveryCount > 0 && params.RecoveryCount > 1)
+    {
+        plan.Decompose();
+    }
+
+    return decoder;
+}
+
+// Point a scratch decoder state at the caller's blocks, sharing the cached decomposition
+static bool BindDecoder(const cm256_decoder* decoder, cm256_block* blocks, CM256Decoder& state)
+{
+    const CM256Decoder& plan = decoder->Plan;
+
+    for (int i = 0; i < plan.Params.OriginalCount; ++i)
+    {
+        if (blocks[i].Index != decoder->BlockIndices[i])
+        {
+            // Erasure pattern does not match the one the decoder was created for
+            return false;
+        }
+    }
+
+    state.Params = plan.Params;
+    state.RecoveryCount = plan.RecoveryCount;
+    state.OriginalCount = plan.OriginalCount;
+    state.Matrix_L = plan.Matrix_L;
+    state.Diag_D = plan.Diag_D;
+    state.Matrix_U = plan.Matrix_U;
+
+    for (int i = 0; i < plan.RecoveryCount; ++i)
+    {
+        state.Recovery[i] = blocks + decoder->RecoveryPositions[i];
+        state.ErasuresIndices[i] = plan.ErasuresIndices[i];
+    }
+    for (int i = 0; i < plan.OriginalCount; ++i)
+    {
+        state.Original[i] = blocks + decoder->OriginalPositions[i];
+    }
+
+    return true;
+}
+
+extern "C" int cm256_decoder_decode(
+    cm256_decoder* decoder, // Decoder from cm256_decoder_create()
+    cm256_block* blocks)    // Array of 'originalCount' blocks matching the decoder
+{
+    if (!decoder || !blocks)
+    {
+        return -3;
+    }
+
+    // If there is only one block,
+    if (decoder->Plan.Params.OriginalCount == 1)
+    {
+        // It is the same block repeated
+        blocks[0].Index = 0;
+        return 0;
+    }
+
+    CM256Decoder state;
+    if (!BindDecoder(decoder, blocks, state))
+    {
+        return -6;
+    }
+
+    // If nothing is erased,
+    if (state.RecoveryCount <= 0)
+    {
+        return 0;
+    }
+
+    if (state.Params.RecoveryCount == 1)
+    {
+        state.DecodeM1(0, state.Params.BlockBytes);
+    }
+    else
+    {
+        state.Decode(0, state.Params.BlockBytes);
+    }
+    state.SetRecoveredIndices();
+
+    return 0;
+}
+
+extern "C" int cm256_decoder_decode_range(
+    cm256_decoder* decoder, // Decoder from cm256_decoder_create()
+    cm256_block* blocks,    // Array of 'originalCount' blocks matching the decoder
+    int offset,             // Byte offset into each block
+    int bytes)              // Number of bytes to decode
+{
+    if (!decoder || !blocks)
+    {
+        return -3;
+    }
+    if (offset < 0 || bytes < 0 || offset > decoder->Plan.Params.BlockBytes ||
+        bytes > decoder->Plan.Params.BlockBytes - offset)
+    {
+        return -1;
+    }
+
+    // If there is only one block or nothing to do,
+    if (decoder->Plan.Params.OriginalCount == 1 || bytes == 0)
+    {
+        return 0;
+    }
+
+    CM256Decoder state;
+    if (!BindDecoder(decoder, blocks, state))
+    {
+        return -6;
+    }
+
+    if (state.RecoveryCount > 0)
+    {
+        if (state.Params.RecoveryCount == 1)
+        {
+            state.DecodeM1(offset, bytes);
+        }
+        else
+        {
+            state.Decode(offset, bytes);
+        }
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_decoder_set_indices(
+    cm256_decoder* decoder, // Decoder from cm256_decoder_create()
+    cm256_block* blocks)    // Array of 'originalCount' blocks matching the decoder
+{
+    if (!decoder || !blocks)
+    {
+        return -3;
+    }
+
+    // If there is only one block,
+    if (decoder->Plan.Params.OriginalCount == 1)
+    {
+        // It is the same block repeated
+        blocks[0].Index = 0;
+        return 0;
+    }
+
+    CM256Decoder state;
+    if (!BindDecoder(decoder, blocks, state))
+    {
+        return -6;
+    }
+    state.SetRecoveredIndices();
+
+    return 0;
+}
+
+extern "C" void cm256_decoder_free(cm256_decoder* decoder)
+{
+    delete decoder;
+}
+
+
+//-----------------------------------------------------------------------------
+// Fragment Decoder
+
+// Choose the block index supplying each original for one fragment.
+// Returns false if the fragment has too few survivors to decode.
+static bool GetFragmentPattern(
+    cm256_encoder_params params,
+    const cm256_fragment_block* blocks,
+    int blockCount,
+    int fragment,
+    uint8_t* sources,  // Position in 'blocks' supplying each original
+    uint8_t* pattern)  // Block index supplying each original
+{
+    const int originalCount = params.OriginalCount;
+    bool haveOriginal[CM256_MAX_BLOCKS] = { false };
+    bool haveRecovery[CM256_MAX_BLOCKS] = { false };
+    uint8_t recoverySource[CM256_MAX_BLOCKS];
+
+    memset(sources, 0xff, originalCount);
+    memset(pattern, 0xff, originalCount);
+
+    for (int i = 0; i < blockCount; ++i)
+    {
+        const cm256_fragment_block& block = blocks[i];
+        if (block.Received && !block.Received[fragment])
+        {
+            continue;
+        }
+
+        const int index = block.Index;
+        if (index < originalCount)
+        {
+            if (!haveOriginal[index])
+            {
+                haveOriginal[index] = true;
+                sources[index] = static_cast<uint8_t>(i);
+                pattern[index] = static_cast<uint8_t>(index);
+            }
+        }
+        else if (index < originalCount + params.RecoveryCount && !haveRecovery[index])
+        {
+            haveRecovery[index] = true;
+            recoverySource[index] = static_cast<uint8_t>(i);
+        }
+    }
+
+    // Fill the gaps with the lowest recovery indices received, so that
+    // fragments with the same losses end up with the same pattern
+    int recoveryIndex = originalCount;
+    for (int i = 0; i < originalCount; ++i)
+    {
+        if (haveOriginal[i])
+        {
+            continue;
+        }
+
+        while (recoveryIndex < originalCount + params.RecoveryCount && !haveRecovery[recoveryIndex])
+        {
+            ++recoveryIndex;
+        }
+        if (recoveryIndex >= originalCount + params.RecoveryCount)
+        {
+            return false;
+        }
+
+        sources[i] = recoverySource[recoveryIndex];
+        pattern[i] = static_cast<uint8_t>(recoveryIndex);
+        ++recoveryIndex;
+    }
+
+    return true;
+}
+
+extern "C" int cm256_decode_fragments(
+    cm256_encoder_params params,        // Encoder params
+    int fragmentBytes,                  // Bytes per fragment
+    const cm256_fragment_block* blocks, // Received blocks
+    int blockCount,                     // Number of received blocks
+    void* originals,                    // Output original blocks end-to-end
+    unsigned char* recovered)           // Optional per-fragment output flags
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        fragmentBytes <= 0 ||
+        blockCount < 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if ((!blocks && blockCount > 0) || !originals)
+    {
+        return -3;
+    }
+
+    const int originalCount = params.OriginalCount;
+    const int fragmentCount = (params.BlockBytes + fragmentBytes - 1) / fragmentBytes;
+    uint8_t* output = static_cast<uint8_t*>(originals);
+
+    // Decoders created so far, shared between all ranges with the same pattern
+    cm256_decoder** decoders = new cm256_decoder*[fragmentCount];
+    uint8_t* decoderPatterns = new uint8_t[fragmentCount * originalCount];
+    int decoderCount = 0;
+
+    uint8_t sources[CM256_MAX_BLOCKS], pattern[CM256_MAX_BLOCKS];
+    uint8_t nextSources[CM256_MAX_BLOCKS], nextPattern[CM256_MAX_BLOCKS];
+    int result = 0;
+
+    bool decodable = GetFragmentPattern(params, blocks, blockCount, 0, sources, pattern);
+
+    // For each run of fragments sharing one erasure pattern,
+    for (int first = 0; first < fragmentCount;)
+    {
+        int last = first + 1;
+        bool nextDecodable = false;
+        while (last < fragmentCount)
+        {
+            nextDecodable = GetFragmentPattern(params, blocks, blockCount, last, nextSources, nextPattern);
+            if (nextDecodable != decodable ||
+                memcmp(nextSources, sources, originalCount) != 0 ||
+                memcmp(nextPattern, pattern, originalCount) != 0)
+            {
+                break;
+            }
+            ++last;
+        }
+
+        const int offset = first * fragmentBytes;
+        int bytes = last * fragmentBytes - offset;
+        if (offset + bytes > params.BlockBytes)
+        {
+            bytes = params.BlockBytes - offset;
+        }
+
+        if (decodable)
+        {
+            // Gather the survivors into the output, each in the slot it will be decoded in
+            cm256_block slots[CM256_MAX_BLOCKS];
+            for (int i = 0; i < originalCount; ++i)
+            {
+                slots[i].Block = output + i * params.BlockBytes;
+                slots[i].Index = pattern[i];
+                memcpy(output + i * params.BlockBytes + offset,
+                       static_cast<const uint8_t*>(blocks[sources[i]].Block) + offset, bytes);
+            }
+
+            cm256_decoder* decoder = nullptr;
+            for (int i = decoderCount - 1; i >= 0; --i)
+            {
+                if (memcmp(decoderPatterns + i * originalCount, pattern, originalCount) == 0)
+                {
+                    decoder = decoders[i];
+                    break;
+                }
+            }
+            if (!decoder)
+            {
+                decoder = cm256_decoder_create(params, pattern);
+                if (!decoder)
+                {
+                    result = -5;
+                    break;
+                }
+                decoders[decoderCount] = decoder;
+                memcpy(decoderPatterns + decoderCount * originalCount, pattern, originalCount);
+                ++decoderCount;
+            }
+
+            // Erased originals land in their own slots since recovery blocks are
+            // placed in increasing order of the original they stand in for
+            const int decodeResult = cm256_decoder_decode_range(decoder, slots, offset, bytes);
+            if (decodeResult != 0)
+            {
+                result = decodeResult;
+                break;
+            }
+        }
+        else
+        {
+            // Keep whatever originals did arrive
+            for (int i = 0; i < originalCount; ++i)
+            {
+                if (pattern[i] == i)
+                {
+                    memcpy(output + i * params.BlockBytes + offset,
+                           static_cast<const uint8_t*>(blocks[sources[i]].Block) + offset, bytes);
+                }
+            }
+            result = -7;
+        }
+
+        if (recovered)
+        {
+            for (int i = 0; i < originalCount; ++i)
+            {
+                memset(recovered + i * fragmentCount + first, (decodable || pattern[i] == i) ? 1 : 0, last - first);
+            }
+        }
+
+        first = last;
+        decodable = nextDecodable;
+        memcpy(sources, nextSources, originalCount);
+        memcpy(pattern, nextPattern, originalCount);
+    }
+
+    for (int i = 0; i < decoderCount; ++i)
+    {
+        cm256_decoder_free(decoders[i]);
+    }
+    delete[] decoders;
+    delete[] decoderPatterns;
+
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// Incremental Decoder
+
+struct cm256_incremental_t
+{
+    // Largest number of recovery rows, since OriginalCount + RecoveryCount <= CM256_MAX_BLOCKS
+    static const int MaxRows = CM256_MAX_BLOCKS / 2;
+
+    cm256_encoder_params Params;
+
+    // Caller's array of blocks, and which of its originals count as erased
+    cm256_block* Blocks;
+    bool Erased[CM256_MAX_BLOCKS];
+
+    // Recovery blocks in decomposition order, and the original each recovers
+    cm256_block* Recovery[MaxRows];
+    uint8_t Erasures[MaxRows];
+    int RecoveryCount;
+
+    /*
+        Decomposition of the RecoveryCount x RecoveryCount matrix
+
+            A_ik = GetMatrixElement(Recovery[i]->Index, x_0, Erasures[k])
+
+        as A = L * D * U, where L is lower-triangular and U upper-triangular
+        with ones on their diagonals.  The decomposition of the leading rows
+        and columns does not depend on later ones, so it can be extended one
+        row and column at a time.
+
+        After each step, recovery block i holds row i of L^-1 applied to the
+        recovery data with the received originals eliminated.
+    */
+    uint8_t Lower[MaxRows * MaxRows]; // L_ik at [i * MaxRows + k], k < i
+    uint8_t Upper[MaxRows * MaxRows]; // U_ki at [k * MaxRows + i], k < i
+    uint8_t Diagonal[MaxRows];
+
+    // Add row and column RecoveryCount to the decomposition for recovery block
+    // index x and original y.  Fills in w = L^-1 * (column y of A) for the
+    // existing rows.  Returns false if the extended matrix is singular.
+    bool ExtendDecomposition(uint8_t x, uint8_t y, uint8_t* w);
+
+    // Eliminate the received originals from a recovery block
+    void EliminateOriginals(cm256_block* recovery);
+
+    // Apply row RecoveryCount of L^-1 to the last recovery block
+    void ForwardSubstitute();
+};
+
+bool cm256_incremental_t::ExtendDecomposition(uint8_t x, uint8_t y, uint8_t* w)
+{
+    const int n = RecoveryCount;
+    const uint8_t x_0 = static_cast<uint8_t>(Params.OriginalCount);
+
+    // New column: w = L^-1 * a, then U column = D^-1 * w
+    for (int i = 0; i < n; ++i)
+    {
+        uint8_t sum = GetMatrixElement(Recovery[i]->Index, x_0, y);
+        for (int k = 0; k < i; ++k)
+        {
+            sum = gf256_add(sum, gf256_mul(Lower[i * MaxRows + k], w[k]));
+        }
+        w[i] = sum;
+        Upper[i * MaxRows + n] = gf256_div(sum, Diagonal[i]);
+    }
+
+    // New row: z = b * U^-1, then L row = z * D^-1
+    uint8_t z[MaxRows];
+    for (int k = 0; k < n; ++k)
+    {
+        uint8_t sum = GetMatrixElement(x, x_0, Erasures[k]);
+        for (int j = 0; j < k; ++j)
+        {
+            sum = gf256_add(sum, gf256_mul(z[j], Upper[j * MaxRows + k]));
+        }
+        z[k] = sum;
+        Lower[n * MaxRows + k] = gf256_div(sum, Diagonal[k]);
+    }
+
+    // Schur complement: alpha - z * D^-1 * w
+    uint8_t delta = GetMatrixElement(x, x_0, y);
+    for (int k = 0; k < n; ++k)
+    {
+        delta = gf256_add(delta, gf256_mul(z[k], Upper[k * MaxRows + n]));
+    }
+    Diagonal[n] = delta;
+
+    return delta != 0;
+}
+
+void cm256_incremental_t::EliminateOriginals(cm256_block* recovery)
+{
+    const uint8_t x_0 = static_cast<uint8_t>(Params.OriginalCount);
+    uint8_t* outBlock = static_cast<uint8_t*>(recovery->Block);
+
+    for (int i = 0; i < Params.OriginalCount; ++i)
+    {
+        if (Blocks[i].Index >= Params.OriginalCount || Erased[i])
+        {
+            continue;
+        }
+
+        const uint8_t matrixElement = GetMatrixElement(recovery->Index, x_0, Blocks[i].Index);
+        gf256_muladd_mem(outBlock, matrixElement, Blocks[i].Block, Params.BlockBytes);
+    }
+}
+
+void cm256_incremental_t::ForwardSubstitute()
+{
+    const int n = RecoveryCount;
+    uint8_t* block_n = static_cast<uint8_t*>(Recovery[n]->Block);
+
+    for (int k = 0; k < n; ++k)
+    {
+        const uint8_t c_nk = Lower[n * MaxRows + k];
+        if (c_nk != 0)
+        {
+            gf256_muladd_mem(block_n, c_nk, Recovery[k]->Block, Params.BlockBytes);
+        }
+    }
+}
+
+extern "C" cm256_incremental* cm256_incremental_create(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks)         // Array of 'originalCount' blocks as in cm256_decode()
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS ||
+        !blocks)
+    {
+        return nullptr;
+    }
+
+    cm256_incremental* decoder = new cm256_incremental;
+    decoder->Params = params;
+    decoder->Blocks = blocks;
+    decoder->RecoveryCount = 0;
+
+    // Find the received originals, rejecting repeats
+    bool received[CM256_MAX_BLOCKS] = {};
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        decoder->Erased[i] = false;
+
+        const int index = blocks[i].Index;
+        if (index >= params.OriginalCount + params.RecoveryCount ||
+            (index < params.OriginalCount && received[index]))
+        {
+            delete decoder;
+            return nullptr;
+        }
+        received[index] = true;
+    }
+
+    // Recovery blocks recover the lowest erased originals in order, as in cm256_decode()
+    int nextErasure = 0;
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        if (blocks[i].Index < params.OriginalCount)
+        {
+            continue;
+        }
+        while (received[nextErasure])
+        {
+            ++nextErasure;
+        }
+
+        const int n = decoder->RecoveryCount;
+        decoder->Recovery[n] = &blocks[i];
+        decoder->Erasures[n] = static_cast<uint8_t>(nextErasure++);
+
+        // A single original is copied rather than encoded, and needs no decode
+        if (params.OriginalCount > 1)
+        {
+            uint8_t w[cm256_incremental_t::MaxRows];
+            if (!decoder->ExtendDecomposition(blocks[i].Index, decoder->Erasures[n], w))
+            {
+                delete decoder;
+                return nullptr;
+            }
+
+            decoder->EliminateOriginals(&blocks[i]);
+            decoder->ForwardSubstitute();
+        }
+        ++decoder->RecoveryCount;
+    }
+
+    return decoder;
+}
+
+extern "C" int cm256_incremental_extend(
+    cm256_incremental* decoder, // Decoder from cm256_incremental_create()
+    int position,               // Position of the lost original in 'blocks'
+    cm256_block* recovery)      // Additional recovery block
+{
+    if (!decoder || !recovery)
+    {
+        return -3;
+    }
+
+    const cm256_encoder_params& params = decoder->Params;
+    if (position < 0 || position >= params.OriginalCount ||
+        decoder->Blocks[position].Index >= params.OriginalCount ||
+        decoder->Erased[position] ||
+        params.OriginalCount == 1)
+    {
+        return -1;
+    }
+
+    const int x = recovery->Index;
+    if (x < params.OriginalCount || x >= params.OriginalCount + params.RecoveryCount)
+    {
+        return -4;
+    }
+    for (int i = 0; i < decoder->RecoveryCount; ++i)
+    {
+        if (decoder->Recovery[i]->Index == x)
+        {
+            return -4;
+        }
+    }
+
+    const uint8_t y = decoder->Blocks[position].Index;
+    uint8_t w[cm256_incremental_t::MaxRows];
+    if (!decoder->ExtendDecomposition(static_cast<uint8_t>(x), y, w))
+    {
+        return -5;
+    }
+
+    // Undo the elimination of the lost original from the existing recovery blocks
+    const void* lostBlock = decoder->Blocks[position].Block;
+    for (int i = 0; i < decoder->RecoveryCount; ++i)
+    {
+        if (w[i] != 0)
+        {
+            gf256_muladd_mem(decoder->Recovery[i]->Block, w[i], lostBlock, params.BlockBytes);
+        }
+    }
+    decoder->Erased[position] = true;
+
+    const int n = decoder->RecoveryCount;
+    decoder->Recovery[n] = recovery;
+    decoder->Erasures[n] = y;
+    decoder->EliminateOriginals(recovery);
+    decoder->ForwardSubstitute();
+    ++decoder->RecoveryCount;
+
+    return 0;
+}
+
+extern "C" int cm256_incremental_finish(cm256_incremental* decoder)
+{
+    if (!decoder)
+    {
+        return -3;
+    }
+
+    const int n = decoder->RecoveryCount;
+    const int bytes = decoder->Params.BlockBytes;
+    const int maxRows = cm256_incremental_t::MaxRows;
+
+    if (decoder->Params.OriginalCount != 1)
+    {
+        // Eliminate diagonal
+        for (int i = 0; i < n; ++i)
+        {
+            uint8_t* block = static_cast<uint8_t*>(decoder->Recovery[i]->Block);
+            gf256_div_mem(block, block, decoder->Diagonal[i], bytes);
+        }
+
+        // Eliminate upper right triangle
+        for (int j = n - 1; j >= 1; --j)
+        {
+            const uint8_t* block_j = static_cast<const uint8_t*>(decoder->Recovery[j]->Block);
+            for (int i = j - 1; i >= 0; --i)
+            {
+                const uint8_t c_ij = decoder->Upper[i * maxRows + j];
+                if (c_ij != 0)
+                {
+                    gf256_muladd_mem(decoder->Recovery[i]->Block, c_ij, block_j, bytes);
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        decoder->Recovery[i]->Index = decoder->Erasures[i];
+    }
+
+    return 0;
+}
+
+extern "C" void cm256_incremental_free(cm256_incremental* decoder)
+{
+    delete decoder;
+}
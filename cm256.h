@@ -36,6 +36,13 @@
 // Library version
 #define CM256_VERSION 2
 
+// Largest OriginalCount + RecoveryCount accepted.  The block and matrix
+// arrays that cm256.cpp keeps on the stack are sized from this, so defining
+// it lower (CM256_MAX_BLOCKS in CMake) bounds stack use on small targets.
+#ifndef CM256_MAX_BLOCKS
+    #define CM256_MAX_BLOCKS 256
+#endif
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -93,6 +100,20 @@ static inline unsigned char cm256_get_original_block_index(cm256_encoder_params
     return (unsigned char)(originalBlockIndex);
 }
 
+/*
+ * Get the matrix element that multiplies an original block when producing
+ * a recovery block:
+ *
+ *     recoveryBlock = sum over j of coefficient(j) * originals[j]
+ *
+ * This allows recovery blocks to be updated in place when one original block
+ * changes, by adding coefficient * (oldData + newData) to each of them.
+ */
+extern unsigned char cm256_get_recovery_coefficient(
+    cm256_encoder_params params, // Encoder parameters
+    int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
+    int originalIndex);          // Original block index
+
 
 /*
  * Cauchy MDS GF(256) encode
@@ -139,6 +160,25 @@ extern void cm256_encode_block(
     int recoveryBlockIndex,      // Return value from cm256_get_recovery_block_index()
     void* recoveryBlock);        // Output recovery block
 
+/*
+ * Cauchy MDS GF(256) encode with copy
+ *
+ * This produces the same recovery blocks as cm256_encode(), and also copies
+ * each original block to the matching entry of 'copies', for example from
+ * an application buffer into a packet buffer.  Each original is read from
+ * memory once: a window of it is copied and then accumulated into the
+ * recovery blocks while it is still in cache.
+ *
+ * The Index fields of 'copies' are ignored.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_encode_copy(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    cm256_block* copies,         // Array of pointers to where the originals are copied
+    void* recoveryBlocks);       // Output recovery blocks end-to-end
+
 /*
  * Cauchy MDS GF(256) decode
  *
@@ -161,6 +201,231 @@ extern int cm256_decode(
     cm256_encoder_params params, // Encoder parameters
     cm256_block* blocks);        // Array of 'originalCount' blocks as described above
 
+/*
+ * Cauchy MDS GF(256) repair
+ *
+ * This regenerates every erased block of a stripe, both original data and
+ * recovery data, in a single pass over the surviving blocks.
+ *
+ * The 'blocks' array is the same as for cm256_decode(), and it is decoded
+ * in place the same way.  In addition, 'lostRecoveryCount' recovery blocks
+ * listed in 'lostRecoveryIndices' (values from cm256_get_recovery_block_index())
+ * are regenerated and stored end-to-end in 'recoveryBlocks', which should
+ * have lostRecoveryCount * blockBytes bytes available.
+ *
+ * The blocks are processed in byte windows: each window of original data is
+ * recovered and then used to compute the lost recovery rows while it is still
+ * in cache, so the survivors are read from memory once rather than once for
+ * cm256_decode() and again for each call to cm256_encode_block().
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_repair(
+    cm256_encoder_params params,              // Encoder parameters
+    cm256_block* blocks,                      // Array of 'originalCount' blocks as described above
+    int lostRecoveryCount,                    // Number of recovery blocks to regenerate
+    const unsigned char* lostRecoveryIndices, // Recovery block indices to regenerate
+    void* recoveryBlocks);                    // Output recovery blocks end-to-end
+
+
+/*
+ * Cauchy MDS GF(256) verify
+ *
+ * This checks that the recovery blocks are consistent with the originals,
+ * for example when scrubbing stored stripes.  The recovery rows are
+ * recomputed one cache-sized byte window at a time and compared in place,
+ * so no full recovery block is ever materialized.
+ *
+ * The 'recovery' array holds 'recoveryCount' blocks, each with its Index
+ * set from cm256_get_recovery_block_index().
+ *
+ * If 'mismatches' is not nullptr it receives one flag per recovery block,
+ * set to 1 if that block does not match.  Otherwise checking stops at the
+ * first mismatch.
+ *
+ * Returns 0 if everything matches, 1 on a mismatch, and negative values
+ * indicate failure.
+ */
+extern int cm256_verify(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    cm256_block* recovery,       // Array of 'recoveryCount' recovery blocks
+    unsigned char* mismatches);  // Optional per-recovery-block output flags
+
+
+//-----------------------------------------------------------------------------
+// Cached Decoder
+//
+// Stripes stored across the same set of failure domains tend to share one
+// erasure pattern, and the matrix decomposition done by cm256_decode() only
+// depends on that pattern.  A cached decoder performs the decomposition once
+// and then decodes any number of stripes with it.
+//
+// A decoder is read-only after creation, so it may be used from several
+// threads at once.
+
+typedef struct cm256_decoder_t cm256_decoder;
+
+/*
+ * Create a decoder for one erasure pattern.
+ *
+ * 'blockIndices' holds the Index of each of the 'originalCount' blocks that
+ * will be passed to cm256_decoder_decode(), in the same order.
+ *
+ * Returns nullptr on failure.
+ */
+extern cm256_decoder* cm256_decoder_create(
+    cm256_encoder_params params,        // Encoder parameters
+    const unsigned char* blockIndices); // Index of each of the 'originalCount' blocks
+
+/*
+ * Decode one stripe, with the same results as cm256_decode().
+ *
+ * The Index of each block must match the 'blockIndices' provided when the
+ * decoder was created.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_decoder_decode(
+    cm256_decoder* decoder, // Decoder from cm256_decoder_create()
+    cm256_block* blocks);   // Array of 'originalCount' blocks matching the decoder
+
+/*
+ * Decode the byte range [offset, offset + bytes) of one stripe.
+ *
+ * This allows a stripe to be decoded in pieces, or only the part of it that
+ * is needed.  The block Index values are not changed: the recovery blocks, in
+ * the order they appear in the array, receive the erased originals in
+ * increasing index order, which is what cm256_decode() reports via Index.
+ *
+ * Returns 0 on success, -1 if the range does not fit in BlockBytes, and any
+ * other code indicates failure.
+ */
+extern int cm256_decoder_decode_range(
+    cm256_decoder* decoder, // Decoder from cm256_decoder_create()
+    cm256_block* blocks,    // Array of 'originalCount' blocks matching the decoder
+    int offset,             // Byte offset into each block
+    int bytes);             // Number of bytes to decode
+
+/*
+ * Set the block Index values the way cm256_decoder_decode() does, once every
+ * byte range of the stripe has been decoded by cm256_decoder_decode_range().
+ *
+ * Call it once per stripe: afterwards the Index values no longer match the
+ * decoder.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_decoder_set_indices(
+    cm256_decoder* decoder, // Decoder from cm256_decoder_create()
+    cm256_block* blocks);   // Array of 'originalCount' blocks matching the decoder
+
+// Free a decoder from cm256_decoder_create()
+extern void cm256_decoder_free(cm256_decoder* decoder);
+
+
+//-----------------------------------------------------------------------------
+// Fragment Decoder
+//
+// Blocks larger than the MTU travel as several fragments, and a block that
+// lost one fragment would otherwise count as fully erased.  The fragment
+// decoder tracks which fragments of each block arrived, and decodes each run
+// of fragments with its own erasure pattern.  Runs with the same pattern
+// share one cached decoder.
+
+// A received block, possibly with missing fragments
+typedef struct cm256_fragment_block_t
+{
+    // Block data, 'blockBytes' long.  Only the received fragments are read.
+    const void* Block;
+
+    // One flag per fragment, nonzero if that fragment arrived.
+    // Set to nullptr if the whole block arrived.
+    const unsigned char* Received;
+
+    // Block index: 0..originalCount-1 for originals, otherwise a value from
+    // cm256_get_recovery_block_index()
+    unsigned char Index;
+} cm256_fragment_block;
+
+/*
+ * Decode original data from partially received blocks.
+ *
+ * Fragment f covers bytes [f * fragmentBytes, (f + 1) * fragmentBytes) of
+ * every block, with the last fragment being shorter if 'blockBytes' is not
+ * a multiple of 'fragmentBytes'.  Any number of blocks may be provided, in
+ * any order.
+ *
+ * The original blocks are written end-to-end to 'originals', which should
+ * have originalCount * blockBytes bytes available.  If 'recovered' is not
+ * nullptr, it receives one flag per fragment of each original (original
+ * major), set to 1 if that fragment was received or recovered.
+ *
+ * Returns 0 if every fragment was recovered, -7 if some fragments had too
+ * few survivors (the rest are still decoded), and any other code indicates
+ * failure.
+ */
+extern int cm256_decode_fragments(
+    cm256_encoder_params params,        // Encoder parameters
+    int fragmentBytes,                  // Bytes per fragment
+    const cm256_fragment_block* blocks, // Received blocks
+    int blockCount,                     // Number of received blocks
+    void* originals,                    // Output original blocks end-to-end
+    unsigned char* recovered);          // Optional per-fragment output flags
+
+
+//-----------------------------------------------------------------------------
+// Incremental Decoder
+//
+// A receiver may start decoding with N erasures and then find that one more
+// original is lost, for example when it fails a checksum.  The incremental
+// decoder keeps the recovery blocks in a partially eliminated state, and
+// extends the matrix decomposition by one row and column when an extra
+// erasure and an extra recovery block arrive.  Only the new recovery block
+// has to be eliminated against the other originals; the work already done
+// on the first N recovery blocks is kept.
+
+typedef struct cm256_incremental_t cm256_incremental;
+
+/*
+ * Start decoding a stripe.
+ *
+ * 'blocks' is an array of 'originalCount' blocks as for cm256_decode().  The
+ * received originals are eliminated from the recovery blocks right away.
+ * The array and every block must stay valid, and the originals unchanged,
+ * until cm256_incremental_finish() returns.
+ *
+ * Returns nullptr on failure.
+ */
+extern cm256_incremental* cm256_incremental_create(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks);        // Array of 'originalCount' blocks as in cm256_decode()
+
+/*
+ * Treat the original at blocks[position] as erased, and add a recovery block
+ * to replace it.  The original's data is read again to undo its elimination.
+ *
+ * Returns 0 on success, -1 if the position is not a received original, -4
+ * if the recovery block index is invalid or already used, and any other code
+ * indicates failure.
+ */
+extern int cm256_incremental_extend(
+    cm256_incremental* decoder, // Decoder from cm256_incremental_create()
+    int position,               // Position of the lost original in 'blocks'
+    cm256_block* recovery);     // Additional recovery block
+
+/*
+ * Complete the decode.  Each recovery block, including those added by
+ * cm256_incremental_extend(), then holds an original and its Index is set
+ * to that original's index.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_incremental_finish(cm256_incremental* decoder);
+
+// Free a decoder from cm256_incremental_create()
+extern void cm256_incremental_free(cm256_incremental* decoder);
+
 
 #ifdef __cplusplus
 }
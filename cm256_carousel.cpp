@@ -0,0 +1,412 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <vector>
+
+#include "cm256_carousel.h"
+
+
+//-----------------------------------------------------------------------------
+// Parameters
+
+static bool ValidateParams(const cm256_carousel_params& params, uint64_t bytes)
+{
+    return params.OriginalCount > 0 &&
+           params.OriginalCount < CM256_MAX_BLOCKS &&
+           params.BlockBytes > 0 &&
+           params.RecoveryPerCycle >= 0 &&
+           params.RecoveryPerCycle <= CM256_MAX_BLOCKS - params.OriginalCount &&
+           (params.RecoveryRows == 0 ||
+            (params.RecoveryRows >= params.RecoveryPerCycle &&
+             params.RecoveryRows <= CM256_MAX_BLOCKS - params.OriginalCount)) &&
+           bytes > 0;
+}
+
+// Number of recovery rows in the rotation
+static int GetRecoveryRows(const cm256_carousel_params& params)
+{
+    return params.RecoveryRows > 0 ? params.RecoveryRows : CM256_MAX_BLOCKS - params.OriginalCount;
+}
+
+// Encoder parameters covering every recovery row
+static cm256_encoder_params GetEncoderParams(const cm256_carousel_params& params)
+{
+    cm256_encoder_params encoderParams;
+    encoderParams.OriginalCount = params.OriginalCount;
+    encoderParams.RecoveryCount = CM256_MAX_BLOCKS - params.OriginalCount;
+    encoderParams.BlockBytes = params.BlockBytes;
+    return encoderParams;
+}
+
+static uint32_t GetSuperframeCount(const cm256_carousel_params& params, uint64_t bytes)
+{
+    const uint64_t superframeBytes = (uint64_t)params.OriginalCount * params.BlockBytes;
+    return static_cast<uint32_t>((bytes + superframeBytes - 1) / superframeBytes);
+}
+
+
+//-----------------------------------------------------------------------------
+// Sender
+
+struct cm256_carousel_t
+{
+    cm256_carousel_params Params;
+    cm256_encoder_params EncoderParams;
+    uint32_t SuperframeCount;
+
+    // Originals of every superframe end-to-end, zero-padded
+    std::vector<uint8_t> Data;
+
+    // Recovery rows of each superframe, empty until encoded
+    std::vector< std::vector< std::vector<uint8_t> > > Recovery;
+
+    // Position of the next packet: cycle, slot within the superframe, superframe
+    uint64_t Cycle;
+    int Slot;
+    uint32_t Superframe;
+
+    cm256_carousel_stats Stats;
+
+    uint8_t* GetOriginal(uint32_t superframe, int index)
+    {
+        return &Data[((size_t)superframe * Params.OriginalCount + index) * Params.BlockBytes];
+    }
+
+    // Returns the recovery row, encoding it first if needed
+    const uint8_t* GetRecovery(uint32_t superframe, int row);
+};
+
+const uint8_t* cm256_carousel_t::GetRecovery(uint32_t superframe, int row)
+{
+    std::vector<uint8_t>& block = Recovery[superframe][row];
+
+    if (block.empty())
+    {
+        cm256_block originals[CM256_MAX_BLOCKS];
+        for (int i = 0; i < Params.OriginalCount; ++i)
+        {
+            originals[i].Block = GetOriginal(superframe, i);
+            originals[i].Index = static_cast<unsigned char>(i);
+        }
+
+        block.resize(Params.BlockBytes);
+        cm256_encode_block(EncoderParams, originals, Params.OriginalCount + row, &block[0]);
+
+        Stats.RecoveryEncoded++;
+        Stats.BufferBytes += Params.BlockBytes;
+    }
+
+    return &block[0];
+}
+
+extern "C" cm256_carousel* cm256_carousel_create(
+    cm256_carousel_params params, // Carousel parameters
+    const void* data,             // Data to broadcast
+    uint64_t bytes)               // Bytes of data
+{
+    if (!ValidateParams(params, bytes) || !data || cm256_init())
+    {
+        return nullptr;
+    }
+
+    cm256_carousel* carousel = new cm256_carousel;
+    carousel->Params = params;
+    carousel->EncoderParams = GetEncoderParams(params);
+    carousel->SuperframeCount = GetSuperframeCount(params, bytes);
+    carousel->Cycle = 0;
+    carousel->Slot = 0;
+    carousel->Superframe = 0;
+    memset(&carousel->Stats, 0, sizeof(carousel->Stats));
+
+    carousel->Data.resize((size_t)carousel->SuperframeCount * params.OriginalCount * params.BlockBytes, 0);
+    memcpy(&carousel->Data[0], data, (size_t)bytes);
+    carousel->Stats.BufferBytes = carousel->Data.size();
+
+    // Encode the rows of the first cycle now; the rest follow as they come up
+    carousel->Recovery.resize(carousel->SuperframeCount);
+    for (uint32_t superframe = 0; superframe < carousel->SuperframeCount; ++superframe)
+    {
+        carousel->Recovery[superframe].resize(GetRecoveryRows(params));
+
+        for (int row = 0; row < params.RecoveryPerCycle; ++row)
+        {
+            carousel->GetRecovery(superframe, row);
+        }
+    }
+
+    return carousel;
+}
+
+extern "C" void cm256_carousel_destroy(cm256_carousel* carousel)
+{
+    delete carousel;
+}
+
+extern "C" uint32_t cm256_carousel_superframe_count(cm256_carousel* carousel)
+{
+    return carousel ? carousel->SuperframeCount : 0;
+}
+
+extern "C" int cm256_carousel_next(cm256_carousel* carousel, cm256_carousel_packet* packet)
+{
+    if (!carousel || !packet)
+    {
+        return -3;
+    }
+
+    const cm256_carousel_params& params = carousel->Params;
+    const int slot = carousel->Slot;
+
+    packet->Superframe = carousel->Superframe;
+    if (slot < params.OriginalCount)
+    {
+        packet->Index = static_cast<unsigned char>(slot);
+        packet->Block = carousel->GetOriginal(carousel->Superframe, slot);
+    }
+    else
+    {
+        // Recovery rows rotate by RecoveryPerCycle each cycle
+        const int rowCount = GetRecoveryRows(params);
+        const int firstRow = static_cast<int>((carousel->Cycle * params.RecoveryPerCycle) % rowCount);
+        const int row = (firstRow + slot - params.OriginalCount) % rowCount;
+
+        // Encode all of this cycle's new rows together while the originals are in cache
+        if (slot == params.OriginalCount)
+        {
+            for (int i = 0; i < params.RecoveryPerCycle; ++i)
+            {
+                carousel->GetRecovery(carousel->Superframe, (firstRow + i) % rowCount);
+            }
+        }
+
+        packet->Index = static_cast<unsigned char>(params.OriginalCount + row);
+        packet->Block = carousel->GetRecovery(carousel->Superframe, row);
+    }
+
+    carousel->Stats.PacketsSent++;
+
+    // Interleave: the same slot of every superframe, then the next slot
+    if (++carousel->Superframe >= carousel->SuperframeCount)
+    {
+        carousel->Superframe = 0;
+
+        if (++carousel->Slot >= params.OriginalCount + params.RecoveryPerCycle)
+        {
+            carousel->Slot = 0;
+            carousel->Cycle++;
+            carousel->Stats.Cycles++;
+        }
+    }
+
+    return 0;
+}
+
+extern "C" void cm256_carousel_get_stats(cm256_carousel* carousel, cm256_carousel_stats* stats)
+{
+    if (carousel && stats)
+    {
+        *stats = carousel->Stats;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Receiver
+
+struct CarouselReceiverSuperframe
+{
+    // Block indices received so far
+    uint8_t Received[CM256_MAX_BLOCKS];
+    int ReceivedCount;
+
+    // Recovery blocks held until the superframe can be decoded
+    std::vector< std::vector<uint8_t> > RecoveryBlocks;
+    std::vector<unsigned char> RecoveryIndices;
+
+    bool Complete;
+};
+
+struct cm256_carousel_receiver_t
+{
+    cm256_carousel_params Params;
+    cm256_encoder_params EncoderParams;
+    uint32_t SuperframeCount;
+    uint32_t CompleteCount;
+
+    // Originals of every superframe end-to-end
+    std::vector<uint8_t> Data;
+
+    std::vector<CarouselReceiverSuperframe> Superframes;
+
+    uint8_t* GetOriginal(uint32_t superframe, int index)
+    {
+        return &Data[((size_t)superframe * Params.OriginalCount + index) * Params.BlockBytes];
+    }
+
+    // Decode the missing originals of a superframe with all of its blocks in hand
+    int Decode(uint32_t superframe);
+};
+
+int cm256_carousel_receiver_t::Decode(uint32_t superframe)
+{
+    CarouselReceiverSuperframe& state = Superframes[superframe];
+
+    if (!state.RecoveryBlocks.empty())
+    {
+        cm256_block blocks[CM256_MAX_BLOCKS];
+        int count = 0;
+
+        for (int i = 0; i < Params.OriginalCount; ++i)
+        {
+            if (state.Received[i])
+            {
+                blocks[count].Block = GetOriginal(superframe, i);
+                blocks[count].Index = static_cast<unsigned char>(i);
+                ++count;
+            }
+        }
+        for (size_t i = 0; i < state.RecoveryBlocks.size(); ++i)
+        {
+            blocks[count].Block = &state.RecoveryBlocks[i][0];
+            blocks[count].Index = state.RecoveryIndices[i];
+            ++count;
+        }
+
+        const int result = cm256_decode(EncoderParams, blocks);
+        if (result)
+        {
+            return result;
+        }
+
+        // Recovered originals were decoded in place of the recovery blocks
+        for (int i = 0; i < count; ++i)
+        {
+            if (blocks[i].Block != GetOriginal(superframe, blocks[i].Index))
+            {
+                memcpy(GetOriginal(superframe, blocks[i].Index), blocks[i].Block, Params.BlockBytes);
+            }
+        }
+    }
+
+    std::vector< std::vector<uint8_t> >().swap(state.RecoveryBlocks);
+    std::vector<unsigned char>().swap(state.RecoveryIndices);
+    state.Complete = true;
+    CompleteCount++;
+
+    return 0;
+}
+
+extern "C" cm256_carousel_receiver* cm256_carousel_receiver_create(
+    cm256_carousel_params params, // Carousel parameters
+    uint64_t bytes)               // Bytes of data
+{
+    if (!ValidateParams(params, bytes) || cm256_init())
+    {
+        return nullptr;
+    }
+
+    cm256_carousel_receiver* receiver = new cm256_carousel_receiver;
+    receiver->Params = params;
+    receiver->EncoderParams = GetEncoderParams(params);
+    receiver->SuperframeCount = GetSuperframeCount(params, bytes);
+    receiver->CompleteCount = 0;
+    receiver->Data.resize((size_t)receiver->SuperframeCount * params.OriginalCount * params.BlockBytes);
+    receiver->Superframes.resize(receiver->SuperframeCount);
+
+    for (uint32_t i = 0; i < receiver->SuperframeCount; ++i)
+    {
+        CarouselReceiverSuperframe& state = receiver->Superframes[i];
+        memset(state.Received, 0, sizeof(state.Received));
+        state.ReceivedCount = 0;
+        state.Complete = false;
+    }
+
+    return receiver;
+}
+
+extern "C" void cm256_carousel_receiver_destroy(cm256_carousel_receiver* receiver)
+{
+    delete receiver;
+}
+
+extern "C" int cm256_carousel_receive(
+    cm256_carousel_receiver* receiver,
+    const cm256_carousel_packet* packet)
+{
+    if (!receiver || !packet || !packet->Block)
+    {
+        return -3;
+    }
+    const int index = packet->Index;
+    if (packet->Superframe >= receiver->SuperframeCount || index >= CM256_MAX_BLOCKS)
+    {
+        return -4;
+    }
+
+    CarouselReceiverSuperframe& state = receiver->Superframes[packet->Superframe];
+
+    if (state.Complete || state.Received[index])
+    {
+        return 2;
+    }
+
+    if (index < receiver->Params.OriginalCount)
+    {
+        memcpy(receiver->GetOriginal(packet->Superframe, index), packet->Block, receiver->Params.BlockBytes);
+    }
+    else
+    {
+        const uint8_t* block = static_cast<const uint8_t*>(packet->Block);
+        state.RecoveryBlocks.push_back(std::vector<uint8_t>(block, block + receiver->Params.BlockBytes));
+        state.RecoveryIndices.push_back(packet->Index);
+    }
+
+    state.Received[index] = 1;
+    if (++state.ReceivedCount < receiver->Params.OriginalCount)
+    {
+        return 0;
+    }
+
+    const int result = receiver->Decode(packet->Superframe);
+    return result ? result : 1;
+}
+
+extern "C" uint32_t cm256_carousel_receiver_complete_count(cm256_carousel_receiver* receiver)
+{
+    return receiver ? receiver->CompleteCount : 0;
+}
+
+extern "C" int cm256_carousel_receiver_is_complete(cm256_carousel_receiver* receiver, uint32_t superframe)
+{
+    return receiver && superframe < receiver->SuperframeCount && receiver->Superframes[superframe].Complete;
+}
+
+extern "C" const void* cm256_carousel_receiver_data(cm256_carousel_receiver* receiver)
+{
+    return receiver ? &receiver->Data[0] : nullptr;
+}
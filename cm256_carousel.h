@@ -0,0 +1,195 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_CAROUSEL_H
+#define CM256_CAROUSEL_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Carousel Broadcast
+
+    For one-way delivery over a lossy link with no feedback, the sender loops
+    over the data forever and each receiver keeps whatever arrives until it
+    has enough.  The data is split into superframes of OriginalCount blocks.
+
+    The carousel sender encodes each superframe once, when it is created, and
+    keeps the recovery blocks in memory.  Every cycle sends the originals of
+    each superframe, then RecoveryPerCycle recovery blocks.  The recovery
+    indices rotate through up to CM256_MAX_BLOCKS - OriginalCount rows from
+    cycle to cycle, so a receiver that keeps missing packets still sees new
+    recovery blocks.  Rows beyond the first RecoveryPerCycle are encoded with
+    cm256_encode_block() the first time they are sent, then kept, so once
+    every row has come up a cycle costs no encoding at all.
+
+    Within a cycle, packets are interleaved across superframes (block 0 of
+    every superframe, then block 1, ...), so a burst of losses is spread over
+    many superframes.
+
+    The receiver completes a superframe from any OriginalCount distinct
+    blocks of it, original or recovery, from any cycles.  The last superframe
+    is zero-padded by the sender and trimmed by the receiver.
+
+    The sender and receiver are not thread-safe; use one thread each.
+*/
+
+// Carousel parameters, which must match on both ends
+typedef struct cm256_carousel_params_t {
+    // Original blocks per superframe, < CM256_MAX_BLOCKS
+    int OriginalCount;
+
+    // Bytes per block
+    int BlockBytes;
+
+    // Recovery blocks sent per superframe per cycle, <= CM256_MAX_BLOCKS - OriginalCount
+    int RecoveryPerCycle;
+
+    // Recovery rows to rotate through, from RecoveryPerCycle up to
+    // CM256_MAX_BLOCKS - OriginalCount, or 0 for all of them.  Every row is kept once it
+    // is encoded, so this bounds the sender's memory.
+    int RecoveryRows;
+} cm256_carousel_params;
+
+// One packet to send, or one received
+typedef struct cm256_carousel_packet_t {
+    // Superframe number, from 0
+    uint32_t Superframe;
+
+    // Block index, as in cm256_block: an original if < OriginalCount
+    unsigned char Index;
+
+    // BlockBytes of block data.  For sent packets it points into the
+    // carousel and stays valid until the carousel is destroyed.
+    const void* Block;
+} cm256_carousel_packet;
+
+// Sender statistics
+typedef struct cm256_carousel_stats_t {
+    // Packets returned by cm256_carousel_next()
+    uint64_t PacketsSent;
+
+    // Completed cycles over all the superframes
+    uint64_t Cycles;
+
+    // Recovery blocks encoded, at creation and later on first use
+    uint64_t RecoveryEncoded;
+
+    // Bytes of block data held by the carousel
+    uint64_t BufferBytes;
+} cm256_carousel_stats;
+
+
+//-----------------------------------------------------------------------------
+// Sender
+
+typedef struct cm256_carousel_t cm256_carousel;
+
+/*
+ * Create a carousel over 'bytes' bytes of 'data', which is copied.
+ *
+ * Returns nullptr on invalid parameters or failure.
+ */
+extern cm256_carousel* cm256_carousel_create(
+    cm256_carousel_params params, // Carousel parameters
+    const void* data,             // Data to broadcast
+    uint64_t bytes);              // Bytes of data
+
+// Free a carousel
+extern void cm256_carousel_destroy(cm256_carousel* carousel);
+
+// Number of superframes the data was split into
+extern uint32_t cm256_carousel_superframe_count(cm256_carousel* carousel);
+
+/*
+ * Get the next packet to send.
+ *
+ * Returns 0 on success, -3 if an argument is null.
+ */
+extern int cm256_carousel_next(cm256_carousel* carousel, cm256_carousel_packet* packet);
+
+// Read the sender statistics
+extern void cm256_carousel_get_stats(cm256_carousel* carousel, cm256_carousel_stats* stats);
+
+
+//-----------------------------------------------------------------------------
+// Receiver
+
+typedef struct cm256_carousel_receiver_t cm256_carousel_receiver;
+
+/*
+ * Create a receiver for 'bytes' bytes of data sent with 'params'.
+ *
+ * Returns nullptr on invalid parameters or failure.
+ */
+extern cm256_carousel_receiver* cm256_carousel_receiver_create(
+    cm256_carousel_params params, // Carousel parameters
+    uint64_t bytes);              // Bytes of data
+
+// Free a receiver
+extern void cm256_carousel_receiver_destroy(cm256_carousel_receiver* receiver);
+
+/*
+ * Hand a received packet to the receiver.  The block data is copied.
+ *
+ * Returns:
+ *   0 if it was stored and its superframe is not complete yet,
+ *   1 if it completed its superframe,
+ *   2 if it was not needed: a duplicate, or its superframe is already complete,
+ *   -3 if an argument is null,
+ *   -4 if the superframe or block index is out of range,
+ *   or the error returned by cm256_decode().
+ */
+extern int cm256_carousel_receive(
+    cm256_carousel_receiver* receiver,
+    const cm256_carousel_packet* packet);
+
+// Number of superframes completed so far
+extern uint32_t cm256_carousel_receiver_complete_count(cm256_carousel_receiver* receiver);
+
+// Returns nonzero if the superframe is complete
+extern int cm256_carousel_receiver_is_complete(cm256_carousel_receiver* receiver, uint32_t superframe);
+
+/*
+ * The received data, 'bytes' long as passed to the create call.
+ *
+ * Only the ranges of completed superframes are valid.
+ */
+extern const void* cm256_carousel_receiver_data(cm256_carousel_receiver* receiver);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_CAROUSEL_H
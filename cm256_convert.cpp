@@ -0,0 +1,345 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include "cm256_convert.h"
+
+
+//-----------------------------------------------------------------------------
+// Parameters
+
+static int ValidateParams(const cm256_convert_params& params)
+{
+    if (params.StripeOriginalCount <= 0 ||
+        params.StripeRecoveryCount <= 0 ||
+        params.StripeCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.StripeCount * params.StripeOriginalCount +
+        std::max(params.StripeRecoveryCount, params.RecoveryCount) > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    return 0;
+}
+
+extern "C" cm256_encoder_params cm256_convert_wide_params(cm256_convert_params params)
+{
+    cm256_encoder_params wide;
+    wide.OriginalCount = params.StripeCount * params.StripeOriginalCount;
+    wide.RecoveryCount = params.RecoveryCount;
+    wide.BlockBytes = params.BlockBytes;
+    return wide;
+}
+
+// Wide matrix element for recovery row 'row' and original 'j' of narrow stripe 'stripe'
+static uint8_t GetCoefficient(const cm256_encoder_params& wide, int stripe, int stripeOriginalCount, int row, int j)
+{
+    return cm256_get_recovery_coefficient(wide, wide.OriginalCount + row, stripe * stripeOriginalCount + j);
+}
+
+
+//-----------------------------------------------------------------------------
+// Narrow Stripes
+
+extern "C" int cm256_convert_encode(
+    cm256_convert_params params, // Conversion parameters
+    int stripe,                  // Narrow stripe index
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks)        // Output recovery blocks end-to-end
+{
+    const int valid = ValidateParams(params);
+    if (valid)
+    {
+        return valid;
+    }
+    if (!originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+    if (stripe < 0 || stripe >= params.StripeCount)
+    {
+        return -4;
+    }
+
+    const cm256_encoder_params wide = cm256_convert_wide_params(params);
+    const int originalCount = params.StripeOriginalCount;
+    const int blockBytes = params.BlockBytes;
+
+    uint8_t* recoveryBlock = static_cast<uint8_t*>(recoveryBlocks);
+    for (int row = 0; row < params.StripeRecoveryCount; ++row, recoveryBlock += blockBytes)
+    {
+        // Row 0 of the wide matrix is all ones
+        if (row == 0)
+        {
+            const void* sources[CM256_MAX_BLOCKS];
+            for (int j = 0; j < originalCount; ++j)
+            {
+                sources[j] = originals[j].Block;
+            }
+            gf256_addset_n_mem(recoveryBlock, sources, originalCount, blockBytes);
+            continue;
+        }
+
+        for (int j = 0; j < originalCount; ++j)
+        {
+            const uint8_t y = GetCoefficient(wide, stripe, originalCount, row, j);
+
+            if (j > 0)
+            {
+                gf256_muladd_mem(recoveryBlock, y, originals[j].Block, blockBytes);
+            }
+            else if (y == 1)
+            {
+                memcpy(recoveryBlock, originals[0].Block, blockBytes);
+            }
+            else
+            {
+                gf256_mul_mem(recoveryBlock, originals[0].Block, y, blockBytes);
+            }
+        }
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_convert_decode(
+    cm256_convert_params params, // Conversion parameters
+    int stripe,                  // Narrow stripe index
+    cm256_block* blocks)         // Array of 'StripeOriginalCount' blocks
+{
+    const int valid = ValidateParams(params);
+    if (valid)
+    {
+        return valid;
+    }
+    if (!blocks)
+    {
+        return -3;
+    }
+    if (stripe < 0 || stripe >= params.StripeCount)
+    {
+        return -4;
+    }
+
+    const cm256_encoder_params wide = cm256_convert_wide_params(params);
+    const int originalCount = params.StripeOriginalCount;
+    const int blockBytes = params.BlockBytes;
+
+    // Sort the blocks into originals and recovery rows
+    uint8_t seen[CM256_MAX_BLOCKS] = {};
+    int recovery[CM256_MAX_BLOCKS]; // Positions in 'blocks' of recovery rows
+    int recoveryCount = 0;
+
+    for (int i = 0; i < originalCount; ++i)
+    {
+        const int index = blocks[i].Index;
+        if (index >= originalCount + params.StripeRecoveryCount || seen[index])
+        {
+            return -4;
+        }
+        seen[index] = 1;
+
+        if (index >= originalCount)
+        {
+            recovery[recoveryCount++] = i;
+        }
+    }
+
+    if (recoveryCount == 0)
+    {
+        return 0;
+    }
+
+    int erasures[CM256_MAX_BLOCKS];
+    int erasureCount = 0;
+    for (int j = 0; j < originalCount; ++j)
+    {
+        if (!seen[j])
+        {
+            erasures[erasureCount++] = j;
+        }
+    }
+
+    // Subtract the received originals from each recovery row, and set up the
+    // square system that is left for the erased ones
+    const int n = recoveryCount;
+    std::vector<uint8_t> matrix((size_t)n * n);
+
+    for (int r = 0; r < n; ++r)
+    {
+        cm256_block& block = blocks[recovery[r]];
+        const int row = block.Index - originalCount;
+
+        for (int i = 0; i < originalCount; ++i)
+        {
+            if (blocks[i].Index < originalCount)
+            {
+                const uint8_t y = GetCoefficient(wide, stripe, originalCount, row, blocks[i].Index);
+                gf256_muladd_mem(block.Block, y, blocks[i].Block, blockBytes);
+            }
+        }
+
+        for (int e = 0; e < n; ++e)
+        {
+            matrix[(size_t)r * n + e] = GetCoefficient(wide, stripe, originalCount, row, erasures[e]);
+        }
+    }
+
+    // Gauss-Jordan elimination, applying each row operation to the blocks too
+    for (int e = 0; e < n; ++e)
+    {
+        int pivot = e;
+        while (pivot < n && matrix[(size_t)pivot * n + e] == 0)
+        {
+            ++pivot;
+        }
+        if (pivot >= n)
+        {
+            return -10;
+        }
+        if (pivot != e)
+        {
+            std::swap_ranges(&matrix[(size_t)pivot * n], &matrix[(size_t)pivot * n] + n, &matrix[(size_t)e * n]);
+            std::swap(recovery[pivot], recovery[e]);
+        }
+
+        uint8_t* pivotRow = &matrix[(size_t)e * n];
+        void* pivotBlock = blocks[recovery[e]].Block;
+
+        const uint8_t p = pivotRow[e];
+        if (p != 1)
+        {
+            gf256_div_mem(pivotBlock, pivotBlock, p, blockBytes);
+            for (int k = e; k < n; ++k)
+            {
+                pivotRow[k] = gf256_div(pivotRow[k], p);
+            }
+        }
+
+        for (int r = 0; r < n; ++r)
+        {
+            uint8_t* otherRow = &matrix[(size_t)r * n];
+            const uint8_t y = otherRow[e];
+            if (r == e || y == 0)
+            {
+                continue;
+            }
+
+            gf256_muladd_mem(blocks[recovery[r]].Block, y, pivotBlock, blockBytes);
+            for (int k = e; k < n; ++k)
+            {
+                otherRow[k] ^= gf256_mul(y, pivotRow[k]);
+            }
+        }
+    }
+
+    for (int e = 0; e < n; ++e)
+    {
+        blocks[recovery[e]].Index = static_cast<unsigned char>(erasures[e]);
+    }
+
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Conversion
+
+extern "C" int cm256_convert(
+    cm256_convert_params params, // Conversion parameters
+    cm256_convert_read_fn read,  // Reads narrow stripe blocks
+    void* context,               // Passed to 'read'
+    void* recoveryBlocks)        // Output wide recovery blocks end-to-end
+{
+    const int valid = ValidateParams(params);
+    if (valid)
+    {
+        return valid;
+    }
+    if (!read || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    const int stripeCount = params.StripeCount;
+    const int originalCount = params.StripeOriginalCount;
+    const int blockBytes = params.BlockBytes;
+    uint8_t* output = static_cast<uint8_t*>(recoveryBlocks);
+    int result = 0;
+
+    if (params.RecoveryCount <= params.StripeRecoveryCount)
+    {
+        // Wide row i is the sum of row i of each narrow stripe
+        std::vector<uint8_t> temp((size_t)(stripeCount - 1) * blockBytes + 1);
+        const void* others[CM256_MAX_BLOCKS];
+        for (int s = 1; s < stripeCount; ++s)
+        {
+            others[s - 1] = &temp[(size_t)(s - 1) * blockBytes];
+        }
+
+        for (int row = 0; row < params.RecoveryCount && result == 0; ++row, output += blockBytes)
+        {
+            result = read(context, 0, originalCount + row, output);
+            for (int s = 1; s < stripeCount && result == 0; ++s)
+            {
+                result = read(context, s, originalCount + row, &temp[(size_t)(s - 1) * blockBytes]);
+            }
+            if (result == 0)
+            {
+                gf256_add_n_mem(output, others, stripeCount - 1, blockBytes);
+            }
+        }
+    }
+    else
+    {
+        // Too few narrow rows: read the originals and encode the wide stripe
+        const cm256_encoder_params wide = cm256_convert_wide_params(params);
+        std::vector<uint8_t> originals((size_t)wide.OriginalCount * blockBytes);
+
+        cm256_block blocks[CM256_MAX_BLOCKS];
+        for (int i = 0; i < wide.OriginalCount && result == 0; ++i)
+        {
+            blocks[i].Block = &originals[(size_t)i * blockBytes];
+            blocks[i].Index = static_cast<unsigned char>(i);
+            result = read(context, i / originalCount, i % originalCount, blocks[i].Block);
+        }
+
+        if (result == 0)
+        {
+            return cm256_encode(wide, blocks, output);
+        }
+    }
+
+    return result == 0 ? 0 : -8;
+}
@@ -0,0 +1,157 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_CONVERT_H
+#define CM256_CONVERT_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Convertible Stripes
+
+    Re-striping StripeCount narrow stripes into one wide stripe normally
+    reads every original and runs cm256_encode() for the wide shape.  The
+    narrow stripes here are instead encoded as slices of the wide code:
+
+    The wide stripe is a plain cm256 code with
+
+        OriginalCount = StripeCount * StripeOriginalCount
+        RecoveryCount = RecoveryCount
+
+    and original j of narrow stripe s is original s * StripeOriginalCount + j
+    of the wide stripe.  Recovery row i of a narrow stripe uses the matrix
+    row of wide recovery row i, restricted to the stripe's own originals.
+    Each narrow stripe is still MDS, since every square submatrix of a
+    Cauchy matrix is invertible.
+
+    Then wide recovery row i is just the XOR of row i of every narrow stripe:
+
+        wide_i = narrow_i(stripe 0) + narrow_i(stripe 1) + ...
+
+    so converting reads StripeCount * RecoveryCount recovery blocks and no
+    originals, for example 6 blocks instead of 12 for two 6+3 stripes into
+    12+3, and the originals stay where they are.
+
+    This only works while RecoveryCount <= StripeRecoveryCount.  For more
+    wide recovery rows than narrow ones (6+3 into 12+4), any linear MDS
+    conversion has to read StripeOriginalCount blocks of every narrow
+    stripe, which is no better than re-encoding, so cm256_convert() falls
+    back to reading the originals and encoding the wide stripe.  Encode the narrow stripes with as
+    many recovery rows as the widest stripe they will be converted into.
+
+    Precondition: StripeCount * StripeOriginalCount plus the larger of
+    StripeRecoveryCount and RecoveryCount is at most CM256_MAX_BLOCKS.
+*/
+
+// Conversion parameters
+typedef struct cm256_convert_params_t {
+    // Shape of each narrow stripe
+    int StripeOriginalCount;
+    int StripeRecoveryCount;
+
+    // Narrow stripes merged into one wide stripe
+    int StripeCount;
+
+    // Recovery blocks of the wide stripe
+    int RecoveryCount;
+
+    int BlockBytes;
+} cm256_convert_params;
+
+// Encoder parameters of the wide stripe, for cm256_decode() after conversion
+extern cm256_encoder_params cm256_convert_wide_params(cm256_convert_params params);
+
+/*
+ * Encode the recovery blocks of narrow stripe 'stripe'.
+ *
+ * 'originals' holds the StripeOriginalCount originals of the stripe, as for
+ * cm256_encode().  StripeRecoveryCount recovery blocks are written end-to-end
+ * to 'recoveryBlocks'.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_convert_encode(
+    cm256_convert_params params, // Conversion parameters
+    int stripe,                  // Narrow stripe index
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks);       // Output recovery blocks end-to-end
+
+/*
+ * Decode narrow stripe 'stripe' from any StripeOriginalCount of its blocks.
+ *
+ * Block indices are local to the stripe: originals are 0 to
+ * StripeOriginalCount - 1, and recovery row i is StripeOriginalCount + i.
+ * Otherwise arguments and results are the same as for cm256_decode().
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_convert_decode(
+    cm256_convert_params params, // Conversion parameters
+    int stripe,                  // Narrow stripe index
+    cm256_block* blocks);        // Array of 'StripeOriginalCount' blocks
+
+/*
+ * Callback used by cm256_convert() to read a whole block of a narrow stripe.
+ *
+ * 'blockIndex' is local to the stripe, as for cm256_convert_decode().
+ * Returns 0 on success, and any other value aborts the conversion.
+ */
+typedef int (*cm256_convert_read_fn)(
+    void* context,
+    int stripe,
+    int blockIndex,
+    void* data);
+
+/*
+ * Compute the RecoveryCount recovery blocks of the wide stripe.
+ *
+ * Reads recovery rows 0 to RecoveryCount - 1 of every narrow stripe if
+ * RecoveryCount <= StripeRecoveryCount, and every original otherwise.
+ * Writes the wide recovery blocks end-to-end to 'recoveryBlocks'.
+ *
+ * Returns 0 on success, -8 if a read failed, and any other code indicates
+ * failure.
+ */
+extern int cm256_convert(
+    cm256_convert_params params, // Conversion parameters
+    cm256_convert_read_fn read,  // Reads narrow stripe blocks
+    void* context,               // Passed to 'read'
+    void* recoveryBlocks);       // Output wide recovery blocks end-to-end
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_CONVERT_H
@@ -0,0 +1,873 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cm256_fileset.h"
+
+
+//-----------------------------------------------------------------------------
+// CRC-32
+
+struct FileSetCrcTable
+{
+    uint32_t Table[256];
+
+    FileSetCrcTable()
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for (int j = 0; j < 8; ++j)
+            {
+                crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+            }
+            Table[i] = crc;
+        }
+    }
+};
+
+// CRC-32 (IEEE 802.3) of a buffer
+static uint32_t FileSetCrc32(const void* data, size_t bytes)
+{
+    static const FileSetCrcTable crcTable;
+
+    const uint8_t* input = static_cast<const uint8_t*>(data);
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        crc = crcTable.Table[(crc ^ input[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+
+//-----------------------------------------------------------------------------
+// File I/O
+
+// Read exactly 'bytes' bytes, treating anything past the end of the file as zeroes
+static bool ReadFully(int fd, uint8_t* data, size_t bytes, uint64_t position)
+{
+    while (bytes > 0)
+    {
+        const ssize_t result = pread(fd, data, bytes, static_cast<off_t>(position));
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result < 0)
+        {
+            return false;
+        }
+        if (result == 0)
+        {
+            memset(data, 0, bytes);
+            return true;
+        }
+        data += result;
+        position += result;
+        bytes -= result;
+    }
+    return true;
+}
+
+static bool WriteFully(int fd, const uint8_t* data, size_t bytes, uint64_t position)
+{
+    while (bytes > 0)
+    {
+        const ssize_t result = pwrite(fd, data, bytes, static_cast<off_t>(position));
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return false;
+        }
+        data += result;
+        position += result;
+        bytes -= result;
+    }
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Parity File Header
+//
+// Each parity file starts with:
+//
+//     FileSetHeader
+//     uint64_t Lengths[OriginalCount]
+//     uint32_t WindowCrcs[(OriginalCount + RecoveryCount) * WindowCount]
+//     uint32_t HeaderCrc
+//
+// in host byte order, where WindowCrcs holds all windows of file 0, then all
+// windows of file 1 and so on, with the parity files after the inputs.
+// Parity windows start at the next multiple of FileSetAlignment.
+
+static const char FileSetMagic[8] = { 'C', 'M', '2', '5', '6', 'P', 'A', 'R' };
+static const uint32_t FileSetVersion = 1;
+static const uint64_t FileSetAlignment = 4096;
+
+struct FileSetHeader
+{
+    char Magic[8];
+    uint32_t Version;
+    uint32_t OriginalCount;
+    uint32_t RecoveryCount;
+    uint32_t ParityIndex;
+    uint32_t WindowBytes;
+    uint32_t Reserved;
+    uint64_t WindowCount;
+};
+
+struct FileSetLayout
+{
+    FileSetHeader Header;
+    std::vector<uint64_t> Lengths;
+    std::vector<uint32_t> WindowCrcs;
+
+    uint64_t HeaderBytes() const
+    {
+        return sizeof(FileSetHeader) + Lengths.size() * sizeof(uint64_t) +
+               WindowCrcs.size() * sizeof(uint32_t) + sizeof(uint32_t);
+    }
+
+    uint64_t DataOffset() const
+    {
+        return (HeaderBytes() + FileSetAlignment - 1) / FileSetAlignment * FileSetAlignment;
+    }
+
+    uint32_t& Crc(int file, uint64_t window)
+    {
+        return WindowCrcs[file * Header.WindowCount + window];
+    }
+
+    // Write the header for the parity file of one recovery row
+    bool Write(int fd, int parityIndex) const;
+
+    // Read and validate a header.  Returns false if it is damaged.
+    bool Read(int fd);
+
+    // True if two headers describe the same parity set
+    bool Matches(const FileSetLayout& other) const;
+};
+
+bool FileSetLayout::Write(int fd, int parityIndex) const
+{
+    std::vector<uint8_t> data(HeaderBytes());
+
+    FileSetHeader header = Header;
+    header.ParityIndex = parityIndex;
+
+    uint8_t* output = &data[0];
+    memcpy(output, &header, sizeof(header));
+    output += sizeof(header);
+    memcpy(output, &Lengths[0], Lengths.size() * sizeof(uint64_t));
+    output += Lengths.size() * sizeof(uint64_t);
+    if (!WindowCrcs.empty())
+    {
+        memcpy(output, &WindowCrcs[0], WindowCrcs.size() * sizeof(uint32_t));
+        output += WindowCrcs.size() * sizeof(uint32_t);
+    }
+
+    const uint32_t headerCrc = FileSetCrc32(&data[0], data.size() - sizeof(uint32_t));
+    memcpy(output, &headerCrc, sizeof(headerCrc));
+
+    return WriteFully(fd, &data[0], data.size(), 0);
+}
+
+bool FileSetLayout::Read(int fd)
+{
+    struct stat info;
+    if (fstat(fd, &info) != 0 ||
+        !ReadFully(fd, reinterpret_cast<uint8_t*>(&Header), sizeof(Header), 0))
+    {
+        return false;
+    }
+
+    if (memcmp(Header.Magic, FileSetMagic, sizeof(FileSetMagic)) != 0 ||
+        Header.Version != FileSetVersion ||
+        Header.OriginalCount < 1 || Header.RecoveryCount < 1 ||
+        Header.OriginalCount + Header.RecoveryCount > CM256_MAX_BLOCKS ||
+        Header.ParityIndex >= Header.RecoveryCount ||
+        Header.WindowBytes < 1 || Header.WindowBytes > INT32_MAX)
+    {
+        return false;
+    }
+
+    // Bound the tables by the file size before allocating them
+    const uint64_t fileCount = Header.OriginalCount + Header.RecoveryCount;
+    if (Header.WindowCount > static_cast<uint64_t>(info.st_size) / (fileCount * sizeof(uint32_t)))
+    {
+        return false;
+    }
+
+    Lengths.resize(Header.OriginalCount);
+    WindowCrcs.resize(fileCount * Header.WindowCount);
+
+    std::vector<uint8_t> data(HeaderBytes());
+    if (!ReadFully(fd, &data[0], data.size(), 0))
+    {
+        return false;
+    }
+
+    uint32_t headerCrc;
+    memcpy(&headerCrc, &data[data.size() - sizeof(uint32_t)], sizeof(headerCrc));
+    if (headerCrc != FileSetCrc32(&data[0], data.size() - sizeof(uint32_t)))
+    {
+        return false;
+    }
+
+    const uint8_t* input = &data[sizeof(Header)];
+    memcpy(&Lengths[0], input, Lengths.size() * sizeof(uint64_t));
+    input += Lengths.size() * sizeof(uint64_t);
+    if (!WindowCrcs.empty())
+    {
+        memcpy(&WindowCrcs[0], input, WindowCrcs.size() * sizeof(uint32_t));
+    }
+
+    // The lengths must agree with the window count
+    uint64_t longest = 0;
+    for (size_t i = 0; i < Lengths.size(); ++i)
+    {
+        longest = std::max(longest, Lengths[i]);
+    }
+    return (longest + Header.WindowBytes - 1) / Header.WindowBytes == Header.WindowCount;
+}
+
+bool FileSetLayout::Matches(const FileSetLayout& other) const
+{
+    return Header.OriginalCount == other.Header.OriginalCount &&
+           Header.RecoveryCount == other.Header.RecoveryCount &&
+           Header.WindowBytes == other.Header.WindowBytes &&
+           Header.WindowCount == other.Header.WindowCount &&
+           Lengths == other.Lengths &&
+           WindowCrcs == other.WindowCrcs;
+}
+
+
+//-----------------------------------------------------------------------------
+// Window Processing
+
+struct FileSetJob
+{
+    cm256_encoder_params Params;
+    FileSetLayout Layout;
+
+    std::vector<int> Inputs;
+
+    // Parity file descriptor and header state for each recovery row
+    std::vector<int> Parity;
+    std::vector<bool> ParityValid;
+
+    bool Repair;
+
+    std::atomic<uint64_t> NextWindow;
+    std::atomic<bool> Failed;
+
+    std::mutex ReportLock;
+    cm256_fileset_report Report;
+
+    // Byte count of an input within a window, excluding the zero padding
+    int WindowDataBytes(int input, uint64_t window) const
+    {
+        const uint64_t start = window * Params.BlockBytes;
+        const uint64_t length = Layout.Lengths[input];
+        return (length <= start) ? 0 : static_cast<int>(std::min<uint64_t>(Params.BlockBytes, length - start));
+    }
+
+    uint64_t ParityPosition(uint64_t window) const
+    {
+        return Layout.DataOffset() + window * Params.BlockBytes;
+    }
+
+    // Encode windows and fill in the CRC table
+    void CreateLoop();
+
+    // Check windows, and repair them if requested
+    void CheckLoop();
+
+    // Run a loop on 'threadCount' threads
+    void Run(void (FileSetJob::*loop)(), int threadCount);
+};
+
+void FileSetJob::Run(void (FileSetJob::*loop)(), int threadCount)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    threadCount = static_cast<int>(std::min<uint64_t>(threadCount, std::max<uint64_t>(1, Layout.Header.WindowCount)));
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; ++i)
+    {
+        threads.push_back(std::thread(loop, this));
+    }
+    (this->*loop)();
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+}
+
+void FileSetJob::CreateLoop()
+{
+    const int k = Params.OriginalCount, m = Params.RecoveryCount;
+    const int windowBytes = Params.BlockBytes;
+
+    std::vector<uint8_t> originals((size_t)k * windowBytes);
+    std::vector<uint8_t> recovery((size_t)m * windowBytes);
+    cm256_block blocks[CM256_MAX_BLOCKS];
+    uint64_t readBytes = 0, writtenBytes = 0;
+
+    for (;;)
+    {
+        const uint64_t window = NextWindow++;
+        if (window >= Layout.Header.WindowCount || Failed)
+        {
+            break;
+        }
+
+        for (int i = 0; i < k; ++i)
+        {
+            uint8_t* block = &originals[(size_t)i * windowBytes];
+            const int bytes = WindowDataBytes(i, window);
+            if (!ReadFully(Inputs[i], block, bytes, window * windowBytes))
+            {
+                Failed = true;
+            }
+            memset(block + bytes, 0, windowBytes - bytes);
+            readBytes += bytes;
+
+            blocks[i].Block = block;
+            Layout.Crc(i, window) = FileSetCrc32(block, windowBytes);
+        }
+
+        cm256_encode(Params, blocks, &recovery[0]);
+
+        for (int r = 0; r < m; ++r)
+        {
+            const uint8_t* block = &recovery[(size_t)r * windowBytes];
+            Layout.Crc(k + r, window) = FileSetCrc32(block, windowBytes);
+            if (!WriteFully(Parity[r], block, windowBytes, ParityPosition(window)))
+            {
+                Failed = true;
+            }
+            writtenBytes += windowBytes;
+        }
+    }
+
+    std::lock_guard<std::mutex> locker(ReportLock);
+    Report.ReadBytes += readBytes;
+    Report.WrittenBytes += writtenBytes;
+}
+
+void FileSetJob::CheckLoop()
+{
+    const int k = Params.OriginalCount, m = Params.RecoveryCount;
+    const int windowBytes = Params.BlockBytes;
+
+    std::vector<uint8_t> originals((size_t)k * windowBytes);
+    std::vector<uint8_t> recovery((size_t)m * windowBytes);
+    std::vector<uint8_t> encoded(windowBytes);
+    cm256_block blocks[CM256_MAX_BLOCKS];
+    bool inputGood[CM256_MAX_BLOCKS], parityGood[CM256_MAX_BLOCKS];
+
+    cm256_fileset_report report;
+    memset(&report, 0, sizeof(report));
+
+    for (;;)
+    {
+        const uint64_t window = NextWindow++;
+        if (window >= Layout.Header.WindowCount || Failed)
+        {
+            break;
+        }
+
+        int erasedCount = 0;
+        for (int i = 0; i < k; ++i)
+        {
+            uint8_t* block = &originals[(size_t)i * windowBytes];
+            inputGood[i] = false;
+            if (Inputs[i] >= 0)
+            {
+                // Read the whole window so trailing garbage fails the CRC
+                if (!ReadFully(Inputs[i], block, windowBytes, window * windowBytes))
+                {
+                    Failed = true;
+                    break;
+                }
+                report.ReadBytes += windowBytes;
+                inputGood[i] = FileSetCrc32(block, windowBytes) == Layout.Crc(i, window);
+            }
+            erasedCount += !inputGood[i];
+        }
+
+        int goodParityCount = 0, badParityCount = 0;
+        for (int r = 0; r < m; ++r)
+        {
+            uint8_t* block = &recovery[(size_t)r * windowBytes];
+            parityGood[r] = false;
+            if (Parity[r] >= 0 && ParityValid[r])
+            {
+                if (!ReadFully(Parity[r], block, windowBytes, ParityPosition(window)))
+                {
+                    Failed = true;
+                    break;
+                }
+                report.ReadBytes += windowBytes;
+                parityGood[r] = FileSetCrc32(block, windowBytes) == Layout.Crc(k + r, window);
+            }
+            goodParityCount += parityGood[r];
+            badParityCount += !parityGood[r];
+        }
+        if (Failed)
+        {
+            break;
+        }
+
+        report.DamagedWindows += erasedCount;
+        report.DamagedParityWindows += badParityCount;
+
+        if (erasedCount > goodParityCount)
+        {
+            ++report.UnrecoverableWindows;
+            continue;
+        }
+        if (!Repair)
+        {
+            continue;
+        }
+
+        if (erasedCount > 0)
+        {
+            // Fill the erased inputs with intact parity and decode in place
+            int nextParity = 0;
+            for (int i = 0; i < k; ++i)
+            {
+                blocks[i].Block = &originals[(size_t)i * windowBytes];
+                blocks[i].Index = static_cast<unsigned char>(i);
+                if (inputGood[i])
+                {
+                    continue;
+                }
+                while (!parityGood[nextParity])
+                {
+                    ++nextParity;
+                }
+                memcpy(blocks[i].Block, &recovery[(size_t)nextParity * windowBytes], windowBytes);
+                blocks[i].Index = cm256_get_recovery_block_index(Params, nextParity++);
+            }
+
+            if (cm256_decode(Params, blocks) != 0)
+            {
+                ++report.UnrecoverableWindows;
+                continue;
+            }
+
+            // Check every recovered window before writing any of them
+            bool recovered = true;
+            for (int i = 0; i < k; ++i)
+            {
+                const int index = blocks[i].Index;
+                recovered &= inputGood[index] ||
+                    FileSetCrc32(blocks[i].Block, windowBytes) == Layout.Crc(index, window);
+            }
+            if (!recovered)
+            {
+                ++report.UnrecoverableWindows;
+                continue;
+            }
+
+            for (int i = 0; i < k; ++i)
+            {
+                const int index = blocks[i].Index;
+                if (inputGood[index])
+                {
+                    continue;
+                }
+
+                const uint8_t* block = static_cast<const uint8_t*>(blocks[i].Block);
+
+                const int bytes = WindowDataBytes(index, window);
+                if (!WriteFully(Inputs[index], block, bytes, window * windowBytes))
+                {
+                    Failed = true;
+                }
+                report.WrittenBytes += bytes;
+                ++report.RepairedWindows;
+            }
+
+            // Put the originals back in order for re-encoding parity
+            cm256_block ordered[CM256_MAX_BLOCKS];
+            for (int i = 0; i < k; ++i)
+            {
+                ordered[blocks[i].Index].Block = blocks[i].Block;
+                ordered[blocks[i].Index].Index = blocks[i].Index;
+            }
+            memcpy(blocks, ordered, k * sizeof(cm256_block));
+        }
+        else
+        {
+            for (int i = 0; i < k; ++i)
+            {
+                blocks[i].Block = &originals[(size_t)i * windowBytes];
+                blocks[i].Index = static_cast<unsigned char>(i);
+            }
+        }
+
+        for (int r = 0; r < m; ++r)
+        {
+            if (parityGood[r] || Parity[r] < 0)
+            {
+                continue;
+            }
+
+            cm256_encode_block(Params, blocks, cm256_get_recovery_block_index(Params, r), &encoded[0]);
+            if (!WriteFully(Parity[r], &encoded[0], windowBytes, ParityPosition(window)))
+            {
+                Failed = true;
+            }
+            report.WrittenBytes += windowBytes;
+            ++report.RepairedWindows;
+        }
+    }
+
+    std::lock_guard<std::mutex> locker(ReportLock);
+    Report.DamagedWindows += report.DamagedWindows;
+    Report.DamagedParityWindows += report.DamagedParityWindows;
+    Report.UnrecoverableWindows += report.UnrecoverableWindows;
+    Report.RepairedWindows += report.RepairedWindows;
+    Report.ReadBytes += report.ReadBytes;
+    Report.WrittenBytes += report.WrittenBytes;
+}
+
+static void CloseFiles(const std::vector<int>& fds)
+{
+    for (size_t i = 0; i < fds.size(); ++i)
+    {
+        if (fds[i] >= 0)
+        {
+            close(fds[i]);
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// API
+
+extern "C" int cm256_fileset_create(
+    const char* const* inputPaths,  // Input files, in a fixed order
+    int inputCount,                 // Number of input files
+    const char* const* parityPaths, // Parity files to write
+    int parityCount,                // Number of parity files
+    cm256_fileset_params params)    // Window size and threads
+{
+    if (inputCount <= 0 || parityCount <= 0 || params.WindowBytes < 0 || params.ThreadCount < 0)
+    {
+        return -1;
+    }
+    if (inputCount + parityCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if (!inputPaths || !parityPaths)
+    {
+        return -3;
+    }
+    if (cm256_init())
+    {
+        return -5;
+    }
+
+    FileSetJob job;
+    job.Params.OriginalCount = inputCount;
+    job.Params.RecoveryCount = parityCount;
+    job.Params.BlockBytes = params.WindowBytes ? params.WindowBytes : CM256_FILESET_WINDOW_BYTES;
+    job.Repair = false;
+    job.NextWindow = 0;
+    job.Failed = false;
+    memset(&job.Report, 0, sizeof(job.Report));
+
+    FileSetLayout& layout = job.Layout;
+    memcpy(layout.Header.Magic, FileSetMagic, sizeof(FileSetMagic));
+    layout.Header.Version = FileSetVersion;
+    layout.Header.OriginalCount = inputCount;
+    layout.Header.RecoveryCount = parityCount;
+    layout.Header.ParityIndex = 0;
+    layout.Header.WindowBytes = job.Params.BlockBytes;
+    layout.Header.Reserved = 0;
+
+    uint64_t longest = 0;
+    for (int i = 0; i < inputCount; ++i)
+    {
+        struct stat info;
+        const int fd = open(inputPaths[i], O_RDONLY);
+        job.Inputs.push_back(fd);
+        if (fd < 0 || fstat(fd, &info) != 0)
+        {
+            CloseFiles(job.Inputs);
+            return -8;
+        }
+        layout.Lengths.push_back(static_cast<uint64_t>(info.st_size));
+        longest = std::max(longest, layout.Lengths.back());
+    }
+
+    layout.Header.WindowCount = (longest + job.Params.BlockBytes - 1) / job.Params.BlockBytes;
+    layout.WindowCrcs.resize((size_t)(inputCount + parityCount) * layout.Header.WindowCount);
+
+    for (int r = 0; r < parityCount; ++r)
+    {
+        const int fd = open(parityPaths[r], O_RDWR | O_CREAT | O_TRUNC, 0644);
+        job.Parity.push_back(fd);
+        if (fd < 0)
+        {
+            job.Failed = true;
+        }
+    }
+
+    if (!job.Failed)
+    {
+        job.Run(&FileSetJob::CreateLoop, params.ThreadCount);
+    }
+
+    // The header goes last, so an interrupted create leaves no valid parity
+    const uint64_t parityBytes = layout.DataOffset() + layout.Header.WindowCount * job.Params.BlockBytes;
+    for (int r = 0; !job.Failed && r < parityCount; ++r)
+    {
+        if (ftruncate(job.Parity[r], static_cast<off_t>(parityBytes)) != 0 ||
+            !layout.Write(job.Parity[r], r))
+        {
+            job.Failed = true;
+        }
+    }
+
+    CloseFiles(job.Inputs);
+    CloseFiles(job.Parity);
+
+    return job.Failed ? -8 : 0;
+}
+
+extern "C" int cm256_fileset_info(
+    const char* parityPath, // Parity file
+    int* inputCount,        // Output: number of input files
+    int* parityCount)       // Output: number of parity files
+{
+    if (!parityPath || !inputCount || !parityCount)
+    {
+        return -3;
+    }
+
+    const int fd = open(parityPath, O_RDONLY);
+    if (fd < 0)
+    {
+        return -8;
+    }
+
+    FileSetLayout layout;
+    const bool valid = layout.Read(fd);
+    close(fd);
+    if (!valid)
+    {
+        return -9;
+    }
+
+    *inputCount = layout.Header.OriginalCount;
+    *parityCount = layout.Header.RecoveryCount;
+    return 0;
+}
+
+extern "C" int cm256_fileset_check(
+    const char* const* inputPaths,  // Input files, in the original order
+    int inputCount,                 // Number of input files
+    const char* const* parityPaths, // Parity files, in any order
+    int parityCount,                // Number of parity files
+    int threadCount,                // Windows processed in parallel, or 0
+    int repair,                     // Non-zero to repair damage
+    cm256_fileset_report* report)   // Output: results, or null
+{
+    if (inputCount <= 0 || parityCount <= 0 || threadCount < 0)
+    {
+        return -1;
+    }
+    if (inputCount + parityCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if (!inputPaths || !parityPaths)
+    {
+        return -3;
+    }
+    if (cm256_init())
+    {
+        return -5;
+    }
+
+    FileSetJob job;
+    job.Repair = repair != 0;
+    job.NextWindow = 0;
+    job.Failed = false;
+    memset(&job.Report, 0, sizeof(job.Report));
+
+    // Read every parity header, keeping the first intact one as the reference
+    const int openFlags = job.Repair ? O_RDWR : O_RDONLY;
+    std::vector<int> parityFds(parityCount, -1);
+    std::vector<FileSetLayout> layouts(parityCount);
+    std::vector<bool> layoutValid(parityCount, false);
+    int reference = -1;
+    for (int p = 0; p < parityCount; ++p)
+    {
+        parityFds[p] = open(parityPaths[p], openFlags);
+        if (parityFds[p] < 0 && job.Repair)
+        {
+            parityFds[p] = open(parityPaths[p], O_RDWR | O_CREAT, 0644);
+        }
+        layoutValid[p] = parityFds[p] >= 0 && layouts[p].Read(parityFds[p]);
+        if (layoutValid[p] && reference < 0)
+        {
+            reference = p;
+        }
+    }
+    if (reference < 0)
+    {
+        CloseFiles(parityFds);
+        return -9;
+    }
+
+    job.Layout = layouts[reference];
+    const FileSetHeader& header = job.Layout.Header;
+    if ((int)header.OriginalCount != inputCount || (int)header.RecoveryCount < parityCount)
+    {
+        CloseFiles(parityFds);
+        return -1;
+    }
+
+    job.Params.OriginalCount = header.OriginalCount;
+    job.Params.RecoveryCount = header.RecoveryCount;
+    job.Params.BlockBytes = header.WindowBytes;
+
+    // Place each parity file at its recovery row.  Damaged headers take the
+    // rows no intact header claimed, in order, so a repair can rewrite them.
+    const int m = header.RecoveryCount;
+    job.Parity.assign(m, -1);
+    job.ParityValid.assign(m, false);
+    std::vector<int> unplaced;
+    for (int p = 0; p < parityCount; ++p)
+    {
+        const int row = layouts[p].Header.ParityIndex;
+        if (layoutValid[p] && layouts[p].Matches(job.Layout) && !job.ParityValid[row])
+        {
+            job.Parity[row] = parityFds[p];
+            job.ParityValid[row] = true;
+        }
+        else
+        {
+            unplaced.push_back(parityFds[p]);
+        }
+    }
+    for (int r = 0, u = 0; r < m && u < (int)unplaced.size(); ++r)
+    {
+        if (!job.ParityValid[r])
+        {
+            job.Parity[r] = unplaced[u++];
+        }
+    }
+
+    int damagedFiles = 0;
+    for (int i = 0; i < inputCount; ++i)
+    {
+        int fd = open(inputPaths[i], openFlags);
+        if (fd < 0 && job.Repair)
+        {
+            fd = open(inputPaths[i], O_RDWR | O_CREAT, 0644);
+        }
+
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0 || (uint64_t)info.st_size != job.Layout.Lengths[i])
+        {
+            ++damagedFiles;
+        }
+        job.Inputs.push_back(fd);
+    }
+
+    job.Run(&FileSetJob::CheckLoop, threadCount);
+
+    if (job.Repair && !job.Failed)
+    {
+        for (int i = 0; i < inputCount; ++i)
+        {
+            if (job.Inputs[i] >= 0 && ftruncate(job.Inputs[i], static_cast<off_t>(job.Layout.Lengths[i])) != 0)
+            {
+                job.Failed = true;
+            }
+        }
+
+        const uint64_t parityBytes = job.Layout.DataOffset() + header.WindowCount * job.Params.BlockBytes;
+        for (int r = 0; r < m; ++r)
+        {
+            if (job.Parity[r] < 0 || job.ParityValid[r])
+            {
+                continue;
+            }
+            if (ftruncate(job.Parity[r], static_cast<off_t>(parityBytes)) != 0 ||
+                !job.Layout.Write(job.Parity[r], r))
+            {
+                job.Failed = true;
+            }
+        }
+    }
+
+    CloseFiles(job.Inputs);
+    CloseFiles(parityFds);
+
+    job.Report.WindowCount = header.WindowCount;
+    job.Report.DamagedFiles = damagedFiles;
+    if (report)
+    {
+        *report = job.Report;
+    }
+
+    if (job.Failed)
+    {
+        return -8;
+    }
+    return (job.Repair && job.Report.UnrecoverableWindows > 0) ? -10 : 0;
+}
@@ -0,0 +1,147 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_FILESET_H
+#define CM256_FILESET_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Parity Sets over Files
+
+    Protects a set of OriginalCount large files with RecoveryCount parity
+    files, in the spirit of Par2.  Each file is treated as one original
+    block, split into aligned windows of WindowBytes:
+
+        window w of every file = [w * WindowBytes, (w + 1) * WindowBytes)
+
+    Window w of each parity file holds the cm256_encode() of window w of
+    every input, where files shorter than the longest one are padded with
+    zeroes.  Only one window of each file is held in memory per thread, so
+    memory use is ThreadCount * (OriginalCount + RecoveryCount) * WindowBytes
+    however large the files are, and threads work on different windows.
+
+    Every parity file starts with a header recording the file lengths, its
+    recovery row and a CRC-32 of every window of every file.  Verifying or
+    repairing checks each window against its CRC, so damage is repaired at
+    window granularity: a file with one bad window costs one erasure in that
+    window only, and a missing file is erased in all of them.
+*/
+
+// Default bytes per window
+#define CM256_FILESET_WINDOW_BYTES 1048576
+
+// Parity set parameters
+typedef struct cm256_fileset_params_t {
+    // Bytes per window, or 0 for the default
+    int WindowBytes;
+
+    // Windows processed in parallel, or 0 for one per hardware thread
+    int ThreadCount;
+} cm256_fileset_params;
+
+// Results of a verify or repair
+typedef struct cm256_fileset_report_t {
+    uint64_t WindowCount;
+
+    // Input windows that were missing or failed their CRC
+    uint64_t DamagedWindows;
+
+    // Parity windows that were missing or failed their CRC
+    uint64_t DamagedParityWindows;
+
+    // Windows with more damage than the intact parity can repair
+    uint64_t UnrecoverableWindows;
+
+    // Input and parity windows rewritten by a repair
+    uint64_t RepairedWindows;
+
+    // Input files that were missing or had the wrong length
+    int DamagedFiles;
+
+    uint64_t ReadBytes;
+    uint64_t WrittenBytes;
+} cm256_fileset_report;
+
+/*
+ * Compute 'parityCount' parity files for 'inputCount' input files.
+ *
+ * Returns 0 on success, -1 for invalid parameters, -2 if there are more than
+ * CM256_MAX_BLOCKS files, -3 for null pointers and -8 on an I/O error.
+ */
+extern int cm256_fileset_create(
+    const char* const* inputPaths,  // Input files, in a fixed order
+    int inputCount,                 // Number of input files
+    const char* const* parityPaths, // Parity files to write
+    int parityCount,                // Number of parity files
+    cm256_fileset_params params);   // Window size and threads
+
+/*
+ * Read the file counts recorded in a parity file.
+ *
+ * Returns 0 on success, -3 for null pointers, -8 if the file cannot be read
+ * and -9 if it is not a valid parity file.
+ */
+extern int cm256_fileset_info(
+    const char* parityPath, // Parity file
+    int* inputCount,        // Output: number of input files
+    int* parityCount);      // Output: number of parity files
+
+/*
+ * Check a set of files against its parity, and rewrite the damaged windows
+ * of the inputs and the parity if 'repair' is non-zero.
+ *
+ * The inputs must be in the order given to cm256_fileset_create(), and the
+ * parity files may be given in any order.  Missing files are recreated by a
+ * repair, and inputs are truncated to their recorded lengths.
+ *
+ * Returns 0 on success, including when damage was only reported; -10 if a
+ * repair left unrecoverable windows; and the other codes of
+ * cm256_fileset_create() and cm256_fileset_info().  'report' may be null.
+ */
+extern int cm256_fileset_check(
+    const char* const* inputPaths,  // Input files, in the original order
+    int inputCount,                 // Number of input files
+    const char* const* parityPaths, // Parity files, in any order
+    int parityCount,                // Number of parity files
+    int threadCount,                // Windows processed in parallel, or 0
+    int repair,                     // Non-zero to repair damage
+    cm256_fileset_report* report);  // Output: results, or null
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_FILESET_H
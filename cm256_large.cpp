@@ -0,0 +1,237 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "cm256_large.h"
+
+
+//-----------------------------------------------------------------------------
+// Windows
+
+// Bytes of all blocks to keep in cache while processing one window
+static const size_t LargeWorkingSetBytes = 256 * 1024;
+
+// Pick a byte window so that one window of each block fits in the working set
+static int GetLargeWindowBytes(int blockCount, size_t blockBytes)
+{
+    size_t windowBytes = (LargeWorkingSetBytes / blockCount) & ~static_cast<size_t>(63);
+    if (windowBytes < 1024)
+    {
+        windowBytes = 1024;
+    }
+    if (windowBytes > blockBytes)
+    {
+        windowBytes = blockBytes;
+    }
+    return static_cast<int>(windowBytes);
+}
+
+static int ValidateLargeParams(cm256_large_params params)
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes == 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    return 0;
+}
+
+/*
+    Split [0, blockBytes) into one contiguous range per thread, with range
+    boundaries on window boundaries, and call process(start, end) for each
+    range on its own thread.
+*/
+template<class Process>
+static void RunLargeRanges(size_t blockBytes, int windowBytes, int threadCount, const Process& process)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    if (threadCount <= 0)
+    {
+        threadCount = 1;
+    }
+
+    const size_t windowCount = (blockBytes + windowBytes - 1) / windowBytes;
+    if (static_cast<size_t>(threadCount) > windowCount)
+    {
+        threadCount = static_cast<int>(windowCount);
+    }
+
+    std::vector<std::thread> threads;
+    size_t start = 0;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        const size_t windows = windowCount * (i + 1) / threadCount - windowCount * i / threadCount;
+        size_t end = start + windows * windowBytes;
+        if (end > blockBytes)
+        {
+            end = blockBytes;
+        }
+
+        if (i == threadCount - 1)
+        {
+            process(start, end);
+        }
+        else
+        {
+            threads.push_back(std::thread(process, start, end));
+        }
+        start = end;
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Encoder
+
+extern "C" int cm256_encode_large(
+    cm256_large_params params, // Encoder parameters
+    cm256_block* originals,    // Array of pointers to original blocks
+    void* recoveryBlocks,      // Output recovery blocks end-to-end
+    int threadCount)           // Number of threads, or 0 for automatic
+{
+    const int result = ValidateLargeParams(params);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    const int windowBytes = GetLargeWindowBytes(params.OriginalCount + params.RecoveryCount, params.BlockBytes);
+    uint8_t* recovery = static_cast<uint8_t*>(recoveryBlocks);
+
+    RunLargeRanges(params.BlockBytes, windowBytes, threadCount, [&](size_t start, size_t end) {
+        cm256_encoder_params windowParams;
+        windowParams.OriginalCount = params.OriginalCount;
+        windowParams.RecoveryCount = params.RecoveryCount;
+
+        cm256_block windowOriginals[CM256_MAX_BLOCKS];
+        for (size_t offset = start; offset < end; offset += windowBytes)
+        {
+            windowParams.BlockBytes = static_cast<int>(std::min<size_t>(windowBytes, end - offset));
+
+            for (int i = 0; i < params.OriginalCount; ++i)
+            {
+                windowOriginals[i].Block = static_cast<uint8_t*>(originals[i].Block) + offset;
+                windowOriginals[i].Index = originals[i].Index;
+            }
+
+            for (int row = 0; row < params.RecoveryCount; ++row)
+            {
+                cm256_encode_block(windowParams, windowOriginals, params.OriginalCount + row,
+                                   recovery + row * params.BlockBytes + offset);
+            }
+        }
+    });
+
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Decoder
+
+extern "C" int cm256_decode_large(
+    cm256_large_params params, // Encoder parameters
+    cm256_block* blocks,       // Array of 'originalCount' blocks as in cm256_decode()
+    int threadCount)           // Number of threads, or 0 for automatic
+{
+    const int result = ValidateLargeParams(params);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!blocks)
+    {
+        return -3;
+    }
+
+    const int windowBytes = GetLargeWindowBytes(params.OriginalCount, params.BlockBytes);
+
+    cm256_encoder_params windowParams;
+    windowParams.OriginalCount = params.OriginalCount;
+    windowParams.RecoveryCount = params.RecoveryCount;
+    windowParams.BlockBytes = windowBytes;
+
+    // If there is only one block, it is the same block repeated
+    if (params.OriginalCount == 1)
+    {
+        blocks[0].Index = 0;
+        return 0;
+    }
+
+    // One decomposition serves every window
+    unsigned char indices[CM256_MAX_BLOCKS];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        indices[i] = blocks[i].Index;
+    }
+    cm256_decoder* decoder = cm256_decoder_create(windowParams, indices);
+    if (!decoder)
+    {
+        return -5;
+    }
+
+    RunLargeRanges(params.BlockBytes, windowBytes, threadCount, [&](size_t start, size_t end) {
+        cm256_block windowBlocks[CM256_MAX_BLOCKS];
+        for (size_t offset = start; offset < end; offset += windowBytes)
+        {
+            for (int i = 0; i < params.OriginalCount; ++i)
+            {
+                windowBlocks[i].Block = static_cast<uint8_t*>(blocks[i].Block) + offset;
+                windowBlocks[i].Index = blocks[i].Index;
+            }
+
+            cm256_decoder_decode_range(decoder, windowBlocks, 0, static_cast<int>(std::min<size_t>(windowBytes, end - offset)));
+        }
+    });
+
+    // Report recovered indices the way cm256_decode() does
+    const int indexResult = cm256_decoder_set_indices(decoder, blocks);
+    cm256_decoder_free(decoder);
+
+    return indexResult;
+}
@@ -0,0 +1,96 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_LARGE_H
+#define CM256_LARGE_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Large Block Encoder
+
+    cm256_encoder_params.BlockBytes is an int, which limits blocks to 2 GiB.
+    The large block functions take a size_t block size and work through the
+    blocks one window at a time, sized so that a window of every block stays
+    in cache, on one or more threads.  Each thread takes a contiguous range
+    of the blocks so its reads stay sequential.
+
+    The size_t variants of the gf256_*_mem() operations are in gf256.h.
+*/
+
+// Encoder parameters for blocks of any size
+typedef struct cm256_large_params_t {
+    // Original block count < 256
+    int OriginalCount;
+
+    // Recovery block count < 256
+    int RecoveryCount;
+
+    // Number of bytes per block (all blocks are the same size in bytes)
+    size_t BlockBytes;
+} cm256_large_params;
+
+/*
+ * Cauchy MDS GF(256) encode of large blocks.
+ *
+ * The inputs and output are the same as for cm256_encode().
+ * 'threadCount' includes the calling thread; pass 0 to use one thread per
+ * hardware thread.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_encode_large(
+    cm256_large_params params, // Encoder parameters
+    cm256_block* originals,    // Array of pointers to original blocks
+    void* recoveryBlocks,      // Output recovery blocks end-to-end
+    int threadCount);          // Number of threads, or 0 for automatic
+
+/*
+ * Cauchy MDS GF(256) decode of large blocks.
+ *
+ * The inputs and results are the same as for cm256_decode().
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_decode_large(
+    cm256_large_params params, // Encoder parameters
+    cm256_block* blocks,       // Array of 'originalCount' blocks as in cm256_decode()
+    int threadCount);          // Number of threads, or 0 for automatic
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_LARGE_H
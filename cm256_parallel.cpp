@@ -0,0 +1,339 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cm256_parallel.h"
+
+
+//-----------------------------------------------------------------------------
+// Barrier
+
+// Blocks each thread until all of them have arrived
+class ParallelBarrier
+{
+public:
+    explicit ParallelBarrier(int threadCount)
+        : ThreadCount(threadCount)
+        , Waiting(0)
+        , Generation(0)
+    {
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> locker(Lock);
+        const unsigned generation = Generation;
+        if (++Waiting >= ThreadCount)
+        {
+            Waiting = 0;
+            ++Generation;
+            Condition.notify_all();
+            return;
+        }
+        while (generation == Generation)
+        {
+            Condition.wait(locker);
+        }
+    }
+
+private:
+    std::mutex Lock;
+    std::condition_variable Condition;
+    int ThreadCount;
+    int Waiting;
+    unsigned Generation;
+};
+
+
+//-----------------------------------------------------------------------------
+// Byte Range Split
+
+static void EncodeByteSlice(
+    cm256_encoder_params params,
+    const cm256_block* originals,
+    uint8_t* recoveryBlocks,
+    int offset,
+    int bytes)
+{
+    cm256_block slice[CM256_MAX_BLOCKS];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        slice[i].Block = static_cast<uint8_t*>(originals[i].Block) + offset;
+        slice[i].Index = originals[i].Index;
+    }
+
+    cm256_encoder_params sliceParams = params;
+    sliceParams.BlockBytes = bytes;
+
+    for (int row = 0; row < params.RecoveryCount; ++row)
+    {
+        cm256_encode_block(sliceParams, slice, params.OriginalCount + row,
+                           recoveryBlocks + (size_t)row * params.BlockBytes + offset);
+    }
+}
+
+static void EncodeByBytes(
+    cm256_encoder_params params,
+    const cm256_block* originals,
+    uint8_t* recoveryBlocks,
+    int threadCount)
+{
+    // Keep slices on cache line boundaries
+    int sliceBytes = (params.BlockBytes + threadCount - 1) / threadCount;
+    sliceBytes = (sliceBytes + 63) & ~63;
+
+    std::vector<std::thread> threads;
+    for (int offset = sliceBytes; offset < params.BlockBytes; offset += sliceBytes)
+    {
+        const int bytes = params.BlockBytes - offset < sliceBytes ? params.BlockBytes - offset : sliceBytes;
+        threads.push_back(std::thread(EncodeByteSlice, params, originals, recoveryBlocks, offset, bytes));
+    }
+
+    EncodeByteSlice(params, originals, recoveryBlocks, 0,
+                    params.BlockBytes < sliceBytes ? params.BlockBytes : sliceBytes);
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Column Split
+
+struct ColumnSplit
+{
+    cm256_encoder_params Params;
+    const cm256_block* Originals;
+    int ThreadCount;
+    int ColumnsPerThread;
+
+    // Partial recovery blocks for each thread, end-to-end
+    std::vector<uint8_t*> Partials;
+
+    ParallelBarrier* Barrier;
+
+    void Run(int thread);
+};
+
+void ColumnSplit::Run(int thread)
+{
+    const int blockBytes = Params.BlockBytes;
+    const int first = thread * ColumnsPerThread;
+    const int last = first + ColumnsPerThread < Params.OriginalCount ? first + ColumnsPerThread : Params.OriginalCount;
+    uint8_t* partial = Partials[thread];
+
+    // Multiply this thread's originals into its partial recovery blocks
+    for (int row = 0; row < Params.RecoveryCount; ++row)
+    {
+        uint8_t* out = partial + (size_t)row * blockBytes;
+        const int recoveryIndex = Params.OriginalCount + row;
+
+        // The first row is all ones, so its partial is the parity of the columns
+        if (row == 0)
+        {
+            const void* sources[CM256_MAX_BLOCKS];
+            for (int j = first; j < last; ++j)
+            {
+                sources[j - first] = Originals[j].Block;
+            }
+
+            gf256_addset_n_mem(out, sources, last - first, blockBytes);
+            continue;
+        }
+
+        for (int j = first; j < last; ++j)
+        {
+            const uint8_t* in = static_cast<const uint8_t*>(Originals[j].Block);
+            const uint8_t y = cm256_get_recovery_coefficient(Params, recoveryIndex, j);
+
+            if (j == first)
+            {
+                if (y == 1)
+                {
+                    memcpy(out, in, blockBytes);
+                }
+                else
+                {
+                    gf256_mul_mem(out, in, y, blockBytes);
+                }
+            }
+            else if (y == 1)
+            {
+                gf256_add_mem(out, in, blockBytes);
+            }
+            else
+            {
+                gf256_muladd_mem(out, y, in, blockBytes);
+            }
+        }
+    }
+
+    // XOR the partials together three at a time, ending in thread 0's output
+    for (int stride = 1; stride < ThreadCount; stride *= 3)
+    {
+        Barrier->Wait();
+
+        if (thread % (stride * 3) != 0 || thread + stride >= ThreadCount)
+        {
+            continue;
+        }
+
+        const uint8_t* a = Partials[thread + stride];
+        const uint8_t* b = thread + 2 * stride < ThreadCount ? Partials[thread + 2 * stride] : nullptr;
+
+        for (int row = 0; row < Params.RecoveryCount; ++row)
+        {
+            const size_t rowOffset = (size_t)row * blockBytes;
+            if (b)
+            {
+                gf256_add2_mem(partial + rowOffset, a + rowOffset, b + rowOffset, blockBytes);
+            }
+            else
+            {
+                gf256_add_mem(partial + rowOffset, a + rowOffset, blockBytes);
+            }
+        }
+    }
+}
+
+static void EncodeByColumns(
+    cm256_encoder_params params,
+    const cm256_block* originals,
+    uint8_t* recoveryBlocks,
+    int threadCount)
+{
+    ColumnSplit split;
+    split.Params = params;
+    split.Originals = originals;
+    split.ColumnsPerThread = (params.OriginalCount + threadCount - 1) / threadCount;
+    split.ThreadCount = (params.OriginalCount + split.ColumnsPerThread - 1) / split.ColumnsPerThread;
+
+    // Thread 0 accumulates straight into the output
+    const size_t partialBytes = (size_t)params.RecoveryCount * params.BlockBytes;
+    uint8_t* scratch = new uint8_t[partialBytes * (split.ThreadCount - 1)];
+    split.Partials.push_back(recoveryBlocks);
+    for (int i = 1; i < split.ThreadCount; ++i)
+    {
+        split.Partials.push_back(scratch + partialBytes * (i - 1));
+    }
+
+    ParallelBarrier barrier(split.ThreadCount);
+    split.Barrier = &barrier;
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < split.ThreadCount; ++i)
+    {
+        threads.push_back(std::thread(&ColumnSplit::Run, &split, i));
+    }
+
+    split.Run(0);
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    delete[] scratch;
+}
+
+
+//-----------------------------------------------------------------------------
+// Parallel Encoder
+
+extern "C" int cm256_encode_parallel(
+    cm256_encoder_params params,      // Encoder params
+    cm256_block* originals,           // Array of pointers to original blocks
+    void* recoveryBlocks,             // Output recovery blocks end-to-end
+    int threadCount,                  // Number of threads, or 0 for automatic
+    cm256_parallel_strategy strategy) // How to split the work
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0 ||
+        threadCount < 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if (!originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+        if (threadCount <= 0)
+        {
+            threadCount = 1;
+        }
+    }
+
+    if (strategy == CM256_PARALLEL_AUTO)
+    {
+        if (params.BlockBytes / threadCount >= CM256_PARALLEL_MIN_SLICE_BYTES)
+        {
+            strategy = CM256_PARALLEL_BYTES;
+        }
+        else if (params.OriginalCount >= 2 * threadCount)
+        {
+            strategy = CM256_PARALLEL_COLUMNS;
+        }
+        else
+        {
+            threadCount = 1;
+        }
+    }
+
+    uint8_t* recovery = static_cast<uint8_t*>(recoveryBlocks);
+
+    if (threadCount <= 1 || params.OriginalCount == 1)
+    {
+        return cm256_encode(params, originals, recoveryBlocks);
+    }
+
+    if (strategy == CM256_PARALLEL_COLUMNS)
+    {
+        EncodeByColumns(params, originals, recovery, threadCount);
+    }
+    else
+    {
+        EncodeByBytes(params, originals, recovery, threadCount);
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_PARALLEL_H
+#define CM256_PARALLEL_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Parallel Encoder
+
+    cm256_encode() runs on one thread.  The parallel encoder splits the work
+    across several threads in one of two ways:
+
+    + Byte ranges: Each thread encodes all recovery rows for its own slice of
+      the block bytes.  This needs no extra memory, but each slice has to be
+      large enough to keep the SIMD kernels busy.
+
+    + Columns: Each thread multiplies its own slice of the originals into
+      partial recovery blocks with gf256_muladd_mem(), and the partials are
+      then combined with a parallel XOR tree.  This works for the many small
+      blocks common in packet FEC, at the cost of one set of partial recovery
+      blocks per extra thread.
+
+    CM256_PARALLEL_AUTO splits by bytes when the slices would be at least
+    CM256_PARALLEL_MIN_SLICE_BYTES, and by columns otherwise.
+*/
+
+// Smallest byte slice per thread that the automatic strategy will split by
+#define CM256_PARALLEL_MIN_SLICE_BYTES 8192
+
+typedef enum cm256_parallel_strategy_t {
+    CM256_PARALLEL_AUTO,    // Pick based on the block size
+    CM256_PARALLEL_BYTES,   // Split each block into byte ranges
+    CM256_PARALLEL_COLUMNS  // Split the originals, then XOR-reduce
+} cm256_parallel_strategy;
+
+/*
+ * Cauchy MDS GF(256) encode on several threads.
+ *
+ * The inputs and output are the same as for cm256_encode().
+ * 'threadCount' includes the calling thread; pass 0 to use one thread per
+ * hardware thread.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_encode_parallel(
+    cm256_encoder_params params,       // Encoder parameters
+    cm256_block* originals,            // Array of pointers to original blocks
+    void* recoveryBlocks,              // Output recovery blocks end-to-end
+    int threadCount,                   // Number of threads, or 0 for automatic
+    cm256_parallel_strategy strategy); // How to split the work
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_PARALLEL_H
@@ -0,0 +1,327 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cm256_piggyback.h"
+
+
+//-----------------------------------------------------------------------------
+// Groups
+
+// Recovery row whose second half carries the piggyback of original j
+static int GetPiggybackRow(const cm256_encoder_params& params, int originalIndex)
+{
+    return 1 + (originalIndex * (params.RecoveryCount - 1)) / params.OriginalCount;
+}
+
+// Add the piggyback for a recovery row: the XOR of the first halves in its group
+static void AddPiggyback(
+    const cm256_encoder_params& params,
+    const cm256_block* halves, // First halves of the originals, by original index
+    int row,
+    uint8_t* output,
+    int halfBytes)
+{
+    if (row < 1)
+    {
+        return;
+    }
+
+    const void* group[CM256_MAX_BLOCKS];
+    int groupCount = 0;
+
+    for (int j = 0; j < params.OriginalCount; ++j)
+    {
+        if (GetPiggybackRow(params, j) == row)
+        {
+            group[groupCount++] = halves[j].Block;
+        }
+    }
+
+    gf256_add_n_mem(output, group, groupCount, halfBytes);
+}
+
+static bool ValidateParams(const cm256_encoder_params& params)
+{
+    return params.OriginalCount > 0 &&
+           params.RecoveryCount > 0 &&
+           params.BlockBytes > 0 &&
+           params.BlockBytes % 2 == 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Encoder
+
+extern "C" int cm256_piggyback_encode(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks)        // Output recovery blocks end-to-end
+{
+    if (!ValidateParams(params))
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if (!originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    const int halfBytes = params.BlockBytes / 2;
+    cm256_encoder_params halfParams = params;
+    halfParams.BlockBytes = halfBytes;
+
+    cm256_block first[CM256_MAX_BLOCKS], second[CM256_MAX_BLOCKS];
+    for (int j = 0; j < params.OriginalCount; ++j)
+    {
+        first[j].Block = originals[j].Block;
+        first[j].Index = static_cast<unsigned char>(j);
+        second[j].Block = static_cast<uint8_t*>(originals[j].Block) + halfBytes;
+        second[j].Index = static_cast<unsigned char>(j);
+    }
+
+    uint8_t* recoveryBlock = static_cast<uint8_t*>(recoveryBlocks);
+    for (int row = 0; row < params.RecoveryCount; ++row, recoveryBlock += params.BlockBytes)
+    {
+        cm256_encode_block(halfParams, first, params.OriginalCount + row, recoveryBlock);
+        cm256_encode_block(halfParams, second, params.OriginalCount + row, recoveryBlock + halfBytes);
+        AddPiggyback(params, first, row, recoveryBlock + halfBytes, halfBytes);
+    }
+
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Decoder
+
+extern "C" int cm256_piggyback_decode(
+    cm256_encoder_params params, // Encoder params
+    cm256_block* blocks)         // Array of 'originalCount' blocks as described above
+{
+    if (!ValidateParams(params))
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if (!blocks)
+    {
+        return -3;
+    }
+
+    const int halfBytes = params.BlockBytes / 2;
+    cm256_encoder_params halfParams = params;
+    halfParams.BlockBytes = halfBytes;
+
+    // The first halves are a plain Cauchy code
+    cm256_block halves[CM256_MAX_BLOCKS];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        halves[i] = blocks[i];
+    }
+
+    int result = cm256_decode(halfParams, halves);
+    if (result)
+    {
+        return result;
+    }
+
+    // Every first half is now known
+    cm256_block first[CM256_MAX_BLOCKS];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        first[halves[i].Index].Block = blocks[i].Block;
+    }
+
+    // Strip the piggybacks from the second halves and decode them with the same pattern
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        uint8_t* second = static_cast<uint8_t*>(blocks[i].Block) + halfBytes;
+        halves[i].Block = second;
+        halves[i].Index = blocks[i].Index;
+
+        if (blocks[i].Index >= params.OriginalCount)
+        {
+            AddPiggyback(params, first, blocks[i].Index - params.OriginalCount, second, halfBytes);
+        }
+    }
+
+    result = cm256_decode(halfParams, halves);
+    if (result)
+    {
+        return result;
+    }
+
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Index = halves[i].Index;
+    }
+
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Repair
+
+extern "C" int cm256_piggyback_repair(
+    cm256_encoder_params params,  // Encoder params
+    int lostIndex,                // Index of the lost block
+    cm256_piggyback_read_fn read, // Reads from surviving blocks
+    void* context,                // Passed to 'read'
+    void* block)                  // Output block, blockBytes long
+{
+    if (!ValidateParams(params))
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if (!read || !block)
+    {
+        return -3;
+    }
+    if (lostIndex < 0 || lostIndex >= params.OriginalCount + params.RecoveryCount)
+    {
+        return -4;
+    }
+
+    const int originalCount = params.OriginalCount;
+    const int blockBytes = params.BlockBytes;
+    const int halfBytes = blockBytes / 2;
+    cm256_encoder_params halfParams = params;
+    halfParams.BlockBytes = halfBytes;
+
+    uint8_t* output = static_cast<uint8_t*>(block);
+    int result = 0;
+
+    // Lost original with piggybacks available
+    if (lostIndex < originalCount && params.RecoveryCount >= 2)
+    {
+        const int row = GetPiggybackRow(params, lostIndex);
+        uint8_t* secondHalves = new uint8_t[(size_t)originalCount * halfBytes + halfBytes];
+        uint8_t* temp = secondHalves + (size_t)originalCount * halfBytes;
+        uint8_t* lostSecond = secondHalves + (size_t)lostIndex * halfBytes;
+
+        cm256_block second[CM256_MAX_BLOCKS];
+        for (int j = 0; j < originalCount; ++j)
+        {
+            second[j].Block = secondHalves + (size_t)j * halfBytes;
+            second[j].Index = static_cast<unsigned char>(j);
+        }
+
+        // b_lost = second half of recovery 0 + the other b halves
+        const void* others[CM256_MAX_BLOCKS];
+        int otherCount = 0;
+
+        result = read(context, originalCount, halfBytes, halfBytes, lostSecond);
+        for (int j = 0; j < originalCount && result == 0; ++j)
+        {
+            if (j != lostIndex)
+            {
+                result = read(context, j, halfBytes, halfBytes, second[j].Block);
+                others[otherCount++] = second[j].Block;
+            }
+        }
+        if (result == 0)
+        {
+            gf256_add_n_mem(lostSecond, others, otherCount, halfBytes);
+        }
+
+        // a_lost = second half of recovery 'row' + f_row(b) + the other a halves in the group
+        if (result == 0)
+        {
+            cm256_encode_block(halfParams, second, originalCount + row, output);
+            result = read(context, originalCount + row, halfBytes, halfBytes, temp);
+            gf256_add_mem(output, temp, halfBytes);
+        }
+        for (int j = 0; j < originalCount && result == 0; ++j)
+        {
+            if (j != lostIndex && GetPiggybackRow(params, j) == row)
+            {
+                result = read(context, j, 0, halfBytes, temp);
+                gf256_add_mem(output, temp, halfBytes);
+            }
+        }
+
+        memcpy(output + halfBytes, lostSecond, halfBytes);
+        delete[] secondHalves;
+    }
+    else if (lostIndex < originalCount)
+    {
+        // Single recovery block: it is the parity of the originals
+        uint8_t* temp = new uint8_t[blockBytes];
+
+        result = read(context, originalCount, 0, blockBytes, output);
+        for (int j = 0; j < originalCount && result == 0; ++j)
+        {
+            if (j != lostIndex)
+            {
+                result = read(context, j, 0, blockBytes, temp);
+                gf256_add_mem(output, temp, blockBytes);
+            }
+        }
+
+        delete[] temp;
+    }
+    else
+    {
+        // Lost recovery block: re-encode its row from the originals
+        uint8_t* originalData = new uint8_t[(size_t)originalCount * blockBytes];
+
+        cm256_block first[CM256_MAX_BLOCKS], second[CM256_MAX_BLOCKS];
+        for (int j = 0; j < originalCount && result == 0; ++j)
+        {
+            first[j].Block = originalData + (size_t)j * blockBytes;
+            first[j].Index = static_cast<unsigned char>(j);
+            second[j].Block = originalData + (size_t)j * blockBytes + halfBytes;
+            second[j].Index = static_cast<unsigned char>(j);
+
+            result = read(context, j, 0, blockBytes, first[j].Block);
+        }
+
+        if (result == 0)
+        {
+            cm256_encode_block(halfParams, first, lostIndex, output);
+            cm256_encode_block(halfParams, second, lostIndex, output + halfBytes);
+            AddPiggyback(params, first, lostIndex - originalCount, output + halfBytes, halfBytes);
+        }
+
+        delete[] originalData;
+    }
+
+    return result == 0 ? 0 : -8;
+}
@@ -0,0 +1,131 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_PIGGYBACK_H
+#define CM256_PIGGYBACK_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Piggybacked Codes
+
+    Repairing one lost original with cm256_decode() reads OriginalCount whole
+    blocks.  The piggybacked layer (after Hitchhiker-XOR) cuts that down while
+    keeping the code MDS:
+
+    Each block is split into two halves, or substripes, a and b.  Both are
+    encoded with the Cauchy code as usual, so the first half of recovery
+    block i is f_i(a) and the second half is f_i(b).  The originals are then
+    divided into RecoveryCount - 1 groups, and the XOR of the first halves in
+    group i is added to the second half of recovery block i:
+
+        recovery_i = [ f_i(a), f_i(b) + XOR of a_j for j in group i ]
+
+    Recovery block 0 carries no piggyback, and since its row is all ones it
+    is the plain parity of the b halves.
+
+    To repair original j in group i:
+
+        b_j    = (second half of recovery 0) + XOR of the other b halves
+        a_j    = (second half of recovery i) + f_i(b) + XOR of the other a
+                 halves in group i
+
+    This reads OriginalCount + |group i| half blocks instead of OriginalCount
+    whole blocks, saving 1/2 - 1/(2 * (RecoveryCount - 1)) of the repair
+    traffic: 25% for m = 3, 33% for m = 4, 37.5% for m = 5.
+
+    Any OriginalCount blocks still decode everything: the a halves form a
+    plain Cauchy code, and once they are known the piggybacks can be removed
+    from the b halves.
+
+    BlockBytes must be even.
+*/
+
+/*
+ * Encode recovery blocks with piggybacks.
+ *
+ * Arguments are the same as for cm256_encode().
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_piggyback_encode(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks);       // Output recovery blocks end-to-end
+
+/*
+ * Decode originals from any OriginalCount blocks of a piggybacked stripe.
+ *
+ * Arguments and results are the same as for cm256_decode().
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_piggyback_decode(
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks);        // Array of 'originalCount' blocks as described above
+
+/*
+ * Callback used by cm256_piggyback_repair() to read part of a surviving block.
+ *
+ * Reads 'bytes' bytes at 'offset' of block 'blockIndex' into 'data'.
+ * Returns 0 on success, and any other value aborts the repair.
+ */
+typedef int (*cm256_piggyback_read_fn)(
+    void* context,
+    int blockIndex,
+    int offset,
+    int bytes,
+    void* data);
+
+/*
+ * Regenerate one lost block, original or recovery, of a piggybacked stripe.
+ *
+ * Only the parts of the surviving blocks that are needed are read through
+ * 'read'.  The other blocks must all be available.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_piggyback_repair(
+    cm256_encoder_params params,  // Encoder parameters
+    int lostIndex,                // Index of the lost block
+    cm256_piggyback_read_fn read, // Reads from surviving blocks
+    void* context,                // Passed to 'read'
+    void* block);                 // Output block, blockBytes long
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_PIGGYBACK_H
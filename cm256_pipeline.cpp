@@ -0,0 +1,527 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cm256_pipeline.h"
+
+
+static uint64_t GetUsec()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void AddStage(cm256_pipeline_stage& stage, uint64_t start, uint64_t end)
+{
+    const uint64_t usec = end > start ? end - start : 0;
+    stage.Count++;
+    stage.TotalUsec += usec;
+    stage.MaxUsec = std::max(stage.MaxUsec, usec);
+}
+
+
+//-----------------------------------------------------------------------------
+// Buffer Pool
+
+// Lock-free stack of fixed-size buffers.  The head packs the top index with
+// a counter that changes on every update, so a pop cannot be fooled by the
+// same buffer being popped and pushed back in between (ABA).
+class PipelinePool
+{
+public:
+    PipelinePool() : BlockBytes(0), Count(0), Next(nullptr), Head(0), FreeCount(0) {}
+    ~PipelinePool() { delete[] Next; }
+
+    void Initialize(int count, int blockBytes)
+    {
+        BlockBytes = blockBytes;
+        Count = count;
+        Storage.resize((size_t)count * blockBytes);
+        Next = new std::atomic<uint32_t>[count];
+        for (int i = 0; i < count; ++i)
+        {
+            Next[i].store(i + 1 < count ? static_cast<uint32_t>(i + 1) : kEmpty, std::memory_order_relaxed);
+        }
+        Head.store(0, std::memory_order_release);
+        FreeCount.store(count, std::memory_order_release);
+    }
+
+    uint8_t* Acquire()
+    {
+        uint64_t head = Head.load(std::memory_order_acquire);
+        for (;;)
+        {
+            const uint32_t index = static_cast<uint32_t>(head);
+            if (index == kEmpty)
+            {
+                return nullptr;
+            }
+
+            const uint32_t next = Next[index].load(std::memory_order_relaxed);
+            const uint64_t replacement = (((head >> 32) + 1) << 32) | next;
+            if (Head.compare_exchange_weak(head, replacement, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                FreeCount.fetch_sub(1, std::memory_order_relaxed);
+                return &Storage[(size_t)index * BlockBytes];
+            }
+        }
+    }
+
+    // Returns false if the buffer is not from this pool
+    bool Release(void* buffer)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(buffer);
+        if (Storage.empty() || p < &Storage[0] || p >= &Storage[0] + Storage.size() ||
+            (size_t)(p - &Storage[0]) % BlockBytes != 0)
+        {
+            return false;
+        }
+        const uint32_t index = static_cast<uint32_t>((size_t)(p - &Storage[0]) / BlockBytes);
+
+        uint64_t head = Head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Next[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            const uint64_t replacement = (((head >> 32) + 1) << 32) | index;
+            if (Head.compare_exchange_weak(head, replacement, std::memory_order_release, std::memory_order_relaxed))
+            {
+                FreeCount.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    uint64_t GetFreeCount() const
+    {
+        return FreeCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    static const uint32_t kEmpty = 0xffffffff;
+
+    int BlockBytes;
+    int Count;
+    std::vector<uint8_t> Storage;
+    std::atomic<uint32_t>* Next;
+
+    // Counter in the high 32 bits, top index in the low 32 bits
+    std::atomic<uint64_t> Head;
+    std::atomic<uint64_t> FreeCount;
+};
+
+
+//-----------------------------------------------------------------------------
+// Pipeline
+
+enum PipelineSlotState
+{
+    SlotEmpty,     // No packets yet
+    SlotReceiving, // Reassembling
+    SlotQueued,    // Complete, waiting for a worker
+    SlotDecoding,  // Being decoded
+    SlotDone       // Waiting for delivery
+};
+
+// One superframe in flight
+struct PipelineSlot
+{
+    uint64_t Superframe;
+    PipelineSlotState State;
+
+    // Blocks received so far, and which indices they are
+    cm256_block Blocks[CM256_MAX_BLOCKS];
+    int Count;
+    uint8_t Have[CM256_MAX_BLOCKS];
+
+    // Decoded originals end-to-end
+    std::vector<uint8_t> Output;
+    int Result;
+
+    // Stage timestamps
+    uint64_t FirstUsec;
+    uint64_t CompleteUsec;
+    uint64_t DecodeStartUsec;
+    uint64_t DecodeEndUsec;
+};
+
+struct cm256_pipeline_t
+{
+    cm256_pipeline_params Params;
+    cm256_pipeline_deliver_fn Deliver;
+    void* Context;
+
+    PipelinePool Pool;
+    std::atomic<uint64_t> PoolEmpty;
+
+    std::mutex Lock;
+    std::condition_variable WorkCondition;    // Work queued, or terminating
+    std::condition_variable DeliverCondition; // Head slot done, or terminating
+    std::condition_variable SpaceCondition;   // Head advanced
+
+    // Slot for superframe s is Slots[s % Window], for Head <= s < Head + Window
+    std::vector<PipelineSlot> Slots;
+    std::deque<PipelineSlot*> WorkQueue;
+
+    // Next superframe to deliver, and one past the newest one submitted
+    uint64_t Head;
+    uint64_t End;
+
+    bool Terminated;
+    std::vector<std::thread> Workers;
+    std::thread Deliverer;
+
+    cm256_pipeline_stats Stats;
+
+    PipelineSlot& GetSlot(uint64_t superframe)
+    {
+        return Slots[superframe % Params.Window];
+    }
+
+    // Give up on superframes in [Head, limit) that are still missing blocks.  Lock held.
+    void Abandon(uint64_t limit);
+
+    void ReleaseBlocks(PipelineSlot& slot);
+    void WorkerLoop();
+    void DeliverLoop();
+};
+
+void cm256_pipeline_t::ReleaseBlocks(PipelineSlot& slot)
+{
+    for (int i = 0; i < slot.Count; ++i)
+    {
+        Pool.Release(slot.Blocks[i].Block);
+    }
+    slot.Count = 0;
+}
+
+void cm256_pipeline_t::Abandon(uint64_t limit)
+{
+    for (uint64_t superframe = Head; superframe < limit; ++superframe)
+    {
+        PipelineSlot& slot = GetSlot(superframe);
+
+        if (slot.State == SlotEmpty || slot.State == SlotReceiving)
+        {
+            ReleaseBlocks(slot);
+            slot.Superframe = superframe;
+            slot.State = SlotDone;
+            slot.Result = -7;
+        }
+    }
+
+    DeliverCondition.notify_one();
+}
+
+void cm256_pipeline_t::WorkerLoop()
+{
+    cm256_encoder_params encoderParams;
+    encoderParams.OriginalCount = Params.OriginalCount;
+    encoderParams.RecoveryCount = Params.RecoveryCount;
+    encoderParams.BlockBytes = Params.BlockBytes;
+
+    std::unique_lock<std::mutex> locker(Lock);
+
+    for (;;)
+    {
+        WorkCondition.wait(locker, [this] { return Terminated || !WorkQueue.empty(); });
+        if (WorkQueue.empty())
+        {
+            return;
+        }
+
+        PipelineSlot& slot = *WorkQueue.front();
+        WorkQueue.pop_front();
+        slot.State = SlotDecoding;
+        slot.DecodeStartUsec = GetUsec();
+        locker.unlock();
+
+        // Decode in place in the packet buffers, then gather into the output
+        const int result = cm256_decode(encoderParams, slot.Blocks);
+        if (result == 0)
+        {
+            for (int i = 0; i < Params.OriginalCount; ++i)
+            {
+                memcpy(&slot.Output[(size_t)slot.Blocks[i].Index * Params.BlockBytes],
+                       slot.Blocks[i].Block, Params.BlockBytes);
+            }
+        }
+        ReleaseBlocks(slot);
+
+        locker.lock();
+        slot.Result = result;
+        slot.DecodeEndUsec = GetUsec();
+        slot.State = SlotDone;
+        DeliverCondition.notify_one();
+    }
+}
+
+void cm256_pipeline_t::DeliverLoop()
+{
+    std::unique_lock<std::mutex> locker(Lock);
+
+    for (;;)
+    {
+        DeliverCondition.wait(locker, [this] { return Terminated || GetSlot(Head).State == SlotDone; });
+
+        PipelineSlot& slot = GetSlot(Head);
+        if (slot.State != SlotDone)
+        {
+            return;
+        }
+
+        locker.unlock();
+        Deliver(Context, Head, slot.Result == 0 ? &slot.Output[0] : nullptr, slot.Result);
+        const uint64_t deliveredUsec = GetUsec();
+        locker.lock();
+
+        if (slot.Result == 0)
+        {
+            Stats.Delivered++;
+            AddStage(Stats.Reassembly, slot.FirstUsec, slot.CompleteUsec);
+            AddStage(Stats.Queue, slot.CompleteUsec, slot.DecodeStartUsec);
+            AddStage(Stats.Decode, slot.DecodeStartUsec, slot.DecodeEndUsec);
+            AddStage(Stats.Reorder, slot.DecodeEndUsec, deliveredUsec);
+        }
+        else
+        {
+            Stats.Failed++;
+        }
+
+        slot.State = SlotEmpty;
+        Head++;
+        SpaceCondition.notify_all();
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// API
+
+extern "C" cm256_pipeline* cm256_pipeline_create(
+    cm256_pipeline_params params,      // Pipeline parameters
+    cm256_pipeline_deliver_fn deliver, // Delivery callback
+    void* context)                     // Passed to 'deliver'
+{
+    if (params.PoolBlocks == 0)
+    {
+        params.PoolBlocks = params.Window * (params.OriginalCount + params.RecoveryCount);
+    }
+    if (params.WorkerCount <= 0)
+    {
+        params.WorkerCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+    if (params.OriginalCount <= 0 || params.RecoveryCount <= 0 ||
+        params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS ||
+        params.BlockBytes <= 0 || params.Window <= 0 ||
+        params.PoolBlocks < params.OriginalCount ||
+        !deliver || cm256_init())
+    {
+        return nullptr;
+    }
+
+    cm256_pipeline* pipeline = new cm256_pipeline;
+    pipeline->Params = params;
+    pipeline->Deliver = deliver;
+    pipeline->Context = context;
+    pipeline->Pool.Initialize(params.PoolBlocks, params.BlockBytes);
+    pipeline->PoolEmpty = 0;
+    pipeline->Head = 0;
+    pipeline->End = 0;
+    pipeline->Terminated = false;
+    memset(&pipeline->Stats, 0, sizeof(pipeline->Stats));
+
+    pipeline->Slots.resize(params.Window);
+    for (int i = 0; i < params.Window; ++i)
+    {
+        PipelineSlot& slot = pipeline->Slots[i];
+        slot.State = SlotEmpty;
+        slot.Count = 0;
+        slot.Output.resize((size_t)params.OriginalCount * params.BlockBytes);
+    }
+
+    for (int i = 0; i < params.WorkerCount; ++i)
+    {
+        pipeline->Workers.push_back(std::thread(&cm256_pipeline_t::WorkerLoop, pipeline));
+    }
+    pipeline->Deliverer = std::thread(&cm256_pipeline_t::DeliverLoop, pipeline);
+
+    return pipeline;
+}
+
+extern "C" void cm256_pipeline_destroy(cm256_pipeline* pipeline)
+{
+    if (!pipeline)
+    {
+        return;
+    }
+
+    cm256_pipeline_flush(pipeline);
+
+    {
+        std::lock_guard<std::mutex> locker(pipeline->Lock);
+        pipeline->Terminated = true;
+    }
+    pipeline->WorkCondition.notify_all();
+    pipeline->DeliverCondition.notify_all();
+
+    for (size_t i = 0; i < pipeline->Workers.size(); ++i)
+    {
+        pipeline->Workers[i].join();
+    }
+    pipeline->Deliverer.join();
+
+    delete pipeline;
+}
+
+extern "C" void* cm256_pipeline_acquire(cm256_pipeline* pipeline)
+{
+    if (!pipeline)
+    {
+        return nullptr;
+    }
+
+    uint8_t* buffer = pipeline->Pool.Acquire();
+    if (!buffer)
+    {
+        pipeline->PoolEmpty.fetch_add(1, std::memory_order_relaxed);
+    }
+    return buffer;
+}
+
+extern "C" void cm256_pipeline_release(cm256_pipeline* pipeline, void* buffer)
+{
+    if (pipeline && buffer)
+    {
+        pipeline->Pool.Release(buffer);
+    }
+}
+
+extern "C" int cm256_pipeline_submit(
+    cm256_pipeline* pipeline,
+    uint64_t superframe, // Superframe number
+    int blockIndex,      // Block index, as in cm256_block
+    void* buffer)        // Block data
+{
+    if (!pipeline || !buffer)
+    {
+        return -3;
+    }
+    const cm256_pipeline_params& params = pipeline->Params;
+    if (blockIndex < 0 || blockIndex >= params.OriginalCount + params.RecoveryCount)
+    {
+        return -4;
+    }
+
+    std::unique_lock<std::mutex> locker(pipeline->Lock);
+
+    // Make room: give up on the oldest superframes, or wait for them to be delivered
+    while (superframe >= pipeline->Head + params.Window)
+    {
+        const uint64_t head = pipeline->Head;
+        pipeline->Abandon(std::min(superframe - params.Window + 1, head + params.Window));
+        pipeline->SpaceCondition.wait(locker, [pipeline, head] { return pipeline->Head != head; });
+    }
+
+    if (superframe < pipeline->Head)
+    {
+        pipeline->Stats.ExtraPackets++;
+        locker.unlock();
+        pipeline->Pool.Release(buffer);
+        return 2;
+    }
+
+    pipeline->End = std::max(pipeline->End, superframe + 1);
+
+    PipelineSlot& slot = pipeline->GetSlot(superframe);
+    if (slot.State == SlotEmpty)
+    {
+        slot.Superframe = superframe;
+        slot.State = SlotReceiving;
+        slot.Count = 0;
+        memset(slot.Have, 0, sizeof(slot.Have));
+        slot.FirstUsec = GetUsec();
+    }
+
+    if (slot.State != SlotReceiving || slot.Have[blockIndex])
+    {
+        pipeline->Stats.ExtraPackets++;
+        locker.unlock();
+        pipeline->Pool.Release(buffer);
+        return 2;
+    }
+
+    slot.Blocks[slot.Count].Block = buffer;
+    slot.Blocks[slot.Count].Index = static_cast<unsigned char>(blockIndex);
+    slot.Have[blockIndex] = 1;
+
+    if (++slot.Count < params.OriginalCount)
+    {
+        return 0;
+    }
+
+    slot.State = SlotQueued;
+    slot.CompleteUsec = GetUsec();
+    pipeline->WorkQueue.push_back(&slot);
+    pipeline->WorkCondition.notify_one();
+    return 1;
+}
+
+extern "C" void cm256_pipeline_flush(cm256_pipeline* pipeline)
+{
+    if (!pipeline)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> locker(pipeline->Lock);
+
+    pipeline->Abandon(pipeline->End);
+    pipeline->SpaceCondition.wait(locker, [pipeline] { return pipeline->Head >= pipeline->End; });
+}
+
+extern "C" void cm256_pipeline_get_stats(cm256_pipeline* pipeline, cm256_pipeline_stats* stats)
+{
+    if (!pipeline || !stats)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> locker(pipeline->Lock);
+    *stats = pipeline->Stats;
+    stats->PoolEmpty = pipeline->PoolEmpty.load(std::memory_order_relaxed);
+    stats->PoolFree = pipeline->Pool.GetFreeCount();
+}
@@ -0,0 +1,186 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_PIPELINE_H
+#define CM256_PIPELINE_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Receive Pipeline
+
+    Decoding inline on the receive thread means one slow superframe holds up
+    every superframe behind it.  The pipeline splits receiving into stages:
+
+    + Reassembly, on the caller's receive thread: packets are received into
+      buffers taken from a lock-free pool and handed over with
+      cm256_pipeline_submit(), without copying.
+
+    + Decode, on worker threads: once OriginalCount distinct blocks of a
+      superframe are in, it is queued and decoded by the next free worker,
+      so several superframes decode in parallel.
+
+    + Delivery, on a delivery thread: a reorder buffer hands superframes to
+      the callback strictly in superframe order, whatever order they finish
+      decoding in.  Packet buffers go back to the pool once a superframe is
+      decoded.
+
+    At most Window superframes are in flight.  A packet for a superframe
+    past the window gives up on the oldest superframes that are still
+    reassembling; they are delivered as failed, in order.  If the oldest
+    superframes are still decoding or waiting to be delivered, the receive
+    thread waits for them instead.
+
+    Superframes are numbered from 0 without gaps.  The reorder buffer starts
+    at superframe 0.
+
+    Per-stage latency is kept for reassembly (first packet to last needed
+    packet), queueing (complete to decode start), decoding, and reordering
+    (decoded to delivered).
+*/
+
+// Pipeline parameters
+typedef struct cm256_pipeline_params_t {
+    // Code parameters, as in cm256_encoder_params
+    int OriginalCount;
+    int RecoveryCount;
+    int BlockBytes;
+
+    // Decode threads, or 0 for one per hardware thread
+    int WorkerCount;
+
+    // Superframes in flight, from the first packet to delivery
+    int Window;
+
+    // Packet buffers in the pool, or 0 for Window * (OriginalCount + RecoveryCount)
+    int PoolBlocks;
+} cm256_pipeline_params;
+
+// Latency of one stage
+typedef struct cm256_pipeline_stage_t {
+    uint64_t Count;
+    uint64_t TotalUsec;
+    uint64_t MaxUsec;
+} cm256_pipeline_stage;
+
+// Pipeline statistics
+typedef struct cm256_pipeline_stats_t {
+    // Superframes delivered with data, and delivered as failed
+    uint64_t Delivered;
+    uint64_t Failed;
+
+    // Packets for superframes already complete or delivered, or duplicates
+    uint64_t ExtraPackets;
+
+    // cm256_pipeline_acquire() calls that found the pool empty
+    uint64_t PoolEmpty;
+
+    // Buffers in the pool right now
+    uint64_t PoolFree;
+
+    cm256_pipeline_stage Reassembly;
+    cm256_pipeline_stage Queue;
+    cm256_pipeline_stage Decode;
+    cm256_pipeline_stage Reorder;
+} cm256_pipeline_stats;
+
+/*
+ * Delivery callback, called on the delivery thread in superframe order.
+ *
+ * On success 'result' is 0 and 'data' holds the OriginalCount originals
+ * end-to-end, valid until the callback returns.  Otherwise 'data' is nullptr
+ * and 'result' is -7 if too few blocks arrived, or the error returned by
+ * cm256_decode().
+ */
+typedef void (*cm256_pipeline_deliver_fn)(
+    void* context,
+    uint64_t superframe,
+    const void* data,
+    int result);
+
+typedef struct cm256_pipeline_t cm256_pipeline;
+
+// Create a pipeline and start its threads.  RecoveryCount must be at least
+// 1, as for cm256_decode().  Returns nullptr on failure.
+extern cm256_pipeline* cm256_pipeline_create(
+    cm256_pipeline_params params,      // Pipeline parameters
+    cm256_pipeline_deliver_fn deliver, // Delivery callback
+    void* context);                    // Passed to 'deliver'
+
+// Flush the pipeline, stop its threads and free it
+extern void cm256_pipeline_destroy(cm256_pipeline* pipeline);
+
+/*
+ * Take a BlockBytes packet buffer from the pool.  Lock-free.
+ *
+ * Returns nullptr if the pool is empty.
+ */
+extern void* cm256_pipeline_acquire(cm256_pipeline* pipeline);
+
+// Return an unused buffer to the pool.  Lock-free.
+extern void cm256_pipeline_release(cm256_pipeline* pipeline, void* buffer);
+
+/*
+ * Hand a received block to the pipeline.  The pipeline owns 'buffer' from
+ * now on, which must come from cm256_pipeline_acquire().  Call from one
+ * thread.
+ *
+ * Returns:
+ *   0 if it was stored and its superframe is not complete yet,
+ *   1 if it completed its superframe, which is now queued for decoding,
+ *   2 if it was not needed and the buffer went back to the pool,
+ *   -3 if an argument is null,
+ *   -4 if the block index is out of range; the buffer is not taken.
+ */
+extern int cm256_pipeline_submit(
+    cm256_pipeline* pipeline,
+    uint64_t superframe, // Superframe number
+    int blockIndex,      // Block index, as in cm256_block
+    void* buffer);       // Block data
+
+/*
+ * Give up on every superframe up to the newest one submitted that is still
+ * missing blocks, and wait until all of them have been delivered.
+ */
+extern void cm256_pipeline_flush(cm256_pipeline* pipeline);
+
+// Read the pipeline statistics
+extern void cm256_pipeline_get_stats(cm256_pipeline* pipeline, cm256_pipeline_stats* stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_PIPELINE_H
@@ -0,0 +1,194 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <thread>
+#include <vector>
+
+#include "cm256_progressive.h"
+
+
+//-----------------------------------------------------------------------------
+// Row Encoder
+
+struct cm256_row_encoder_t
+{
+    cm256_encoder_params Params;
+    std::vector<cm256_block> Originals;
+    uint8_t* RecoveryBlocks;
+    std::vector<unsigned char> Rows;
+    cm256_row_callback Callback;
+    void* Context;
+
+    std::thread Worker;
+
+    // Encode Rows[first, last) in order
+    void EncodeRows(size_t first, size_t last);
+};
+
+void cm256_row_encoder_t::EncodeRows(size_t first, size_t last)
+{
+    for (size_t i = first; i < last; ++i)
+    {
+        const int row = Rows[i];
+        uint8_t* recoveryBlock = RecoveryBlocks + (size_t)row * Params.BlockBytes;
+
+        cm256_encode_block(Params, &Originals[0], cm256_get_recovery_block_index(Params, row), recoveryBlock);
+
+        if (Callback)
+        {
+            Callback(Context, row, recoveryBlock);
+        }
+    }
+}
+
+// Validate the inputs and fill in an encoder.  Returns 0 on success.
+static int InitializeRowEncoder(
+    cm256_row_encoder& encoder,
+    cm256_encoder_params params,
+    cm256_block* originals,
+    void* recoveryBlocks,
+    const unsigned char* rowOrder,
+    int rowCount,
+    cm256_row_callback callback,
+    void* context)
+{
+    if (params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.BlockBytes <= 0)
+    {
+        return -1;
+    }
+    if (params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS)
+    {
+        return -2;
+    }
+    if (!originals || !recoveryBlocks)
+    {
+        return -3;
+    }
+
+    if (!rowOrder)
+    {
+        rowCount = params.RecoveryCount;
+    }
+    if (rowCount < 0 || rowCount > params.RecoveryCount)
+    {
+        return -1;
+    }
+
+    bool listed[CM256_MAX_BLOCKS] = {};
+    for (int i = 0; i < rowCount; ++i)
+    {
+        const int row = rowOrder ? rowOrder[i] : i;
+        if (row >= params.RecoveryCount || listed[row])
+        {
+            return -4;
+        }
+        listed[row] = true;
+        encoder.Rows.push_back(static_cast<unsigned char>(row));
+    }
+
+    encoder.Params = params;
+    encoder.Originals.assign(originals, originals + params.OriginalCount);
+    encoder.RecoveryBlocks = static_cast<uint8_t*>(recoveryBlocks);
+    encoder.Callback = callback;
+    encoder.Context = context;
+    return 0;
+}
+
+extern "C" int cm256_encode_rows(
+    cm256_encoder_params params,   // Encoder parameters
+    cm256_block* originals,        // Array of pointers to original blocks
+    void* recoveryBlocks,          // Output recovery blocks end-to-end
+    const unsigned char* rowOrder, // Rows in the order to encode them, or nullptr
+    int rowCount,                  // Number of rows in 'rowOrder'
+    cm256_row_callback callback,   // Called as each row completes, or nullptr
+    void* context)                 // Passed to 'callback'
+{
+    cm256_row_encoder encoder;
+    const int result = InitializeRowEncoder(encoder, params, originals, recoveryBlocks,
+                                            rowOrder, rowCount, callback, context);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    encoder.EncodeRows(0, encoder.Rows.size());
+    return 0;
+}
+
+extern "C" cm256_row_encoder* cm256_encode_rows_start(
+    cm256_encoder_params params,   // Encoder parameters
+    cm256_block* originals,        // Array of pointers to original blocks
+    void* recoveryBlocks,          // Output recovery blocks end-to-end
+    const unsigned char* rowOrder, // Rows in the order to encode them, or nullptr
+    int rowCount,                  // Number of rows in 'rowOrder'
+    int syncRows,                  // Rows to encode before returning
+    cm256_row_callback callback,   // Called as each row completes, or nullptr
+    void* context)                 // Passed to 'callback'
+{
+    if (syncRows < 0)
+    {
+        return nullptr;
+    }
+
+    cm256_row_encoder* encoder = new cm256_row_encoder;
+    if (InitializeRowEncoder(*encoder, params, originals, recoveryBlocks,
+                             rowOrder, rowCount, callback, context) != 0)
+    {
+        delete encoder;
+        return nullptr;
+    }
+
+    const size_t rows = encoder->Rows.size();
+    const size_t first = (static_cast<size_t>(syncRows) < rows) ? syncRows : rows;
+    encoder->EncodeRows(0, first);
+
+    if (first < rows)
+    {
+        encoder->Worker = std::thread(&cm256_row_encoder_t::EncodeRows, encoder, first, rows);
+    }
+
+    return encoder;
+}
+
+extern "C" int cm256_encode_rows_finish(cm256_row_encoder* encoder)
+{
+    if (!encoder)
+    {
+        return -3;
+    }
+
+    if (encoder->Worker.joinable())
+    {
+        encoder->Worker.join();
+    }
+
+    delete encoder;
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_PROGRESSIVE_H
+#define CM256_PROGRESSIVE_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Row-Progressive Encoder
+
+    cm256_encode() returns only after every recovery block is computed, so a
+    sender cannot transmit any of them until the slowest is done.  The
+    progressive encoder computes recovery rows one at a time, in an order
+    chosen by the caller, and reports each row as soon as it is complete.
+
+    Row 0 is the XOR of the originals and is the cheapest to compute, so the
+    default order (0, 1, 2, ...) already puts it first.
+
+    cm256_encode_rows_start() can compute the first rows on the calling
+    thread and leave the rest to a worker thread, so the caller can start
+    sending while the remaining rows are encoded.
+*/
+
+/*
+ * Called when recovery row 'row' is complete.  'recoveryBlock' points at
+ * its BlockBytes of data, which are not touched again by the encoder.
+ */
+typedef void (*cm256_row_callback)(void* context, int row, const void* recoveryBlock);
+
+/*
+ * Encode recovery rows in the given order, calling 'callback' after each.
+ *
+ * The inputs and output are the same as for cm256_encode(), and row r is
+ * written at recoveryBlocks + r * BlockBytes.  'rowOrder' lists 'rowCount'
+ * distinct rows in [0, RecoveryCount); pass nullptr to encode every row in
+ * order.  Rows not listed are not computed.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_encode_rows(
+    cm256_encoder_params params,   // Encoder parameters
+    cm256_block* originals,        // Array of pointers to original blocks
+    void* recoveryBlocks,          // Output recovery blocks end-to-end
+    const unsigned char* rowOrder, // Rows in the order to encode them, or nullptr
+    int rowCount,                  // Number of rows in 'rowOrder'
+    cm256_row_callback callback,   // Called as each row completes, or nullptr
+    void* context);                // Passed to 'callback'
+
+typedef struct cm256_row_encoder_t cm256_row_encoder;
+
+/*
+ * Encode the first 'syncRows' rows of 'rowOrder' on the calling thread, and
+ * the rest on a worker thread.  Callbacks for the remaining rows run on the
+ * worker thread.
+ *
+ * The originals and recovery blocks must stay valid until
+ * cm256_encode_rows_finish() returns.  Returns nullptr on invalid input.
+ */
+extern cm256_row_encoder* cm256_encode_rows_start(
+    cm256_encoder_params params,   // Encoder parameters
+    cm256_block* originals,        // Array of pointers to original blocks
+    void* recoveryBlocks,          // Output recovery blocks end-to-end
+    const unsigned char* rowOrder, // Rows in the order to encode them, or nullptr
+    int rowCount,                  // Number of rows in 'rowOrder'
+    int syncRows,                  // Rows to encode before returning
+    cm256_row_callback callback,   // Called as each row completes, or nullptr
+    void* context);                // Passed to 'callback'
+
+/*
+ * Wait for the worker thread to encode the remaining rows, and free the
+ * encoder.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_encode_rows_finish(cm256_row_encoder* encoder);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_PROGRESSIVE_H
@@ -0,0 +1,267 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "cm256_read_cache.h"
+
+
+//-----------------------------------------------------------------------------
+// Cache Entries
+
+struct ReadCacheKey
+{
+    uint64_t Stripe;
+    int OriginalIndex;
+    int Offset;
+    int Bytes;
+
+    bool operator==(const ReadCacheKey& other) const
+    {
+        return Stripe == other.Stripe &&
+               OriginalIndex == other.OriginalIndex &&
+               Offset == other.Offset &&
+               Bytes == other.Bytes;
+    }
+};
+
+struct ReadCacheKeyHash
+{
+    size_t operator()(const ReadCacheKey& key) const
+    {
+        uint64_t h = key.Stripe * 0x9E3779B97F4A7C15ULL;
+        h ^= ((uint64_t)key.OriginalIndex << 48) ^ ((uint64_t)key.Offset << 20) ^ (uint64_t)key.Bytes;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+};
+
+struct ReadCacheEntry
+{
+    std::vector<uint8_t> Data;
+
+    // Set once the fill completes, with its result
+    bool Ready;
+    int Result;
+
+    // Position in the LRU list once cached
+    std::list<ReadCacheKey>::iterator Lru;
+    bool InLru;
+};
+
+typedef std::shared_ptr<ReadCacheEntry> ReadCacheEntryPtr;
+
+
+//-----------------------------------------------------------------------------
+// Read Cache
+
+struct cm256_read_cache_t
+{
+    cm256_read_cache_params Params;
+
+    std::mutex Lock;
+    std::condition_variable FillComplete;
+
+    std::unordered_map<ReadCacheKey, ReadCacheEntryPtr, ReadCacheKeyHash> Entries;
+
+    // Most recently used at the front
+    std::list<ReadCacheKey> Lru;
+
+    cm256_read_cache_stats Stats;
+
+    // Drop an entry from the map, and from the LRU list if it is cached.  Caller holds the lock.
+    void Remove(const ReadCacheKey& key, const ReadCacheEntryPtr& entry);
+};
+
+void cm256_read_cache_t::Remove(const ReadCacheKey& key, const ReadCacheEntryPtr& entry)
+{
+    if (entry->InLru)
+    {
+        Lru.erase(entry->Lru);
+        entry->InLru = false;
+        Stats.CachedBytes -= entry->Data.size();
+        --Stats.CachedRanges;
+    }
+    Entries.erase(key);
+}
+
+extern "C" cm256_read_cache* cm256_read_cache_create(cm256_read_cache_params params)
+{
+    cm256_read_cache* cache = new cm256_read_cache;
+    cache->Params = params;
+    memset(&cache->Stats, 0, sizeof(cache->Stats));
+    return cache;
+}
+
+extern "C" void cm256_read_cache_destroy(cm256_read_cache* cache)
+{
+    delete cache;
+}
+
+extern "C" int cm256_read_cache_get(
+    cm256_read_cache* cache,
+    uint64_t stripe,               // Stripe identifier
+    int originalIndex,             // Original block within the stripe
+    int offset,                    // Byte offset within the block
+    int bytes,                     // Bytes to read
+    void* data,                    // Output buffer
+    cm256_read_cache_fill_fn fill, // Recovers the range on a miss
+    void* context)                 // Passed to 'fill'
+{
+    if (!cache || !data || !fill || offset < 0 || bytes <= 0)
+    {
+        return -1;
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const ReadCacheKey key = { stripe, originalIndex, offset, bytes };
+
+    std::unique_lock<std::mutex> locker(cache->Lock);
+
+    std::unordered_map<ReadCacheKey, ReadCacheEntryPtr, ReadCacheKeyHash>::iterator it = cache->Entries.find(key);
+    if (it != cache->Entries.end())
+    {
+        // Keep a reference in case the entry is invalidated or evicted while waiting
+        ReadCacheEntryPtr entry = it->second;
+        const bool joined = !entry->Ready;
+
+        while (!entry->Ready)
+        {
+            cache->FillComplete.wait(locker);
+        }
+
+        if (entry->Result == 0)
+        {
+            memcpy(data, &entry->Data[0], bytes);
+
+            if (entry->InLru)
+            {
+                cache->Lru.splice(cache->Lru.begin(), cache->Lru, entry->Lru);
+            }
+        }
+
+        const uint64_t usec = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (joined)
+        {
+            ++cache->Stats.Joins;
+            cache->Stats.JoinUsec += usec;
+        }
+        else
+        {
+            ++cache->Stats.Hits;
+            cache->Stats.HitUsec += usec;
+        }
+        return entry->Result;
+    }
+
+    // Publish the in-flight entry so later requests wait on it
+    ReadCacheEntryPtr entry = std::make_shared<ReadCacheEntry>();
+    entry->Ready = false;
+    entry->Result = 0;
+    entry->InLru = false;
+    entry->Data.resize(bytes);
+    cache->Entries[key] = entry;
+
+    // Decode without holding the lock
+    locker.unlock();
+    const int result = fill(context, stripe, originalIndex, offset, bytes, &entry->Data[0]);
+    if (result == 0)
+    {
+        memcpy(data, &entry->Data[0], bytes);
+    }
+    locker.lock();
+
+    entry->Ready = true;
+    entry->Result = result;
+
+    // Cache it unless it failed, was invalidated meanwhile, or can never fit
+    it = cache->Entries.find(key);
+    const bool current = (it != cache->Entries.end() && it->second == entry);
+    if (current)
+    {
+        if (result != 0 || (uint64_t)bytes > cache->Params.MaxBytes)
+        {
+            cache->Entries.erase(it);
+        }
+        else
+        {
+            cache->Lru.push_front(key);
+            entry->Lru = cache->Lru.begin();
+            entry->InLru = true;
+            cache->Stats.CachedBytes += bytes;
+            ++cache->Stats.CachedRanges;
+
+            // Evict least recently used ranges
+            while (cache->Stats.CachedBytes > cache->Params.MaxBytes)
+            {
+                const ReadCacheKey victim = cache->Lru.back();
+                cache->Remove(victim, cache->Entries[victim]);
+                ++cache->Stats.Evictions;
+            }
+        }
+    }
+
+    ++cache->Stats.Misses;
+    cache->Stats.MissUsec += std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    locker.unlock();
+    cache->FillComplete.notify_all();
+
+    return result;
+}
+
+extern "C" void cm256_read_cache_invalidate(cm256_read_cache* cache, uint64_t stripe)
+{
+    std::lock_guard<std::mutex> locker(cache->Lock);
+
+    std::unordered_map<ReadCacheKey, ReadCacheEntryPtr, ReadCacheKeyHash>::iterator it = cache->Entries.begin();
+    while (it != cache->Entries.end())
+    {
+        std::unordered_map<ReadCacheKey, ReadCacheEntryPtr, ReadCacheKeyHash>::iterator next = it;
+        ++next;
+        if (it->first.Stripe == stripe)
+        {
+            // In-flight decodes still complete for their waiters, but are not cached
+            cache->Remove(it->first, it->second);
+        }
+        it = next;
+    }
+}
+
+extern "C" void cm256_read_cache_get_stats(cm256_read_cache* cache, cm256_read_cache_stats* stats)
+{
+    std::lock_guard<std::mutex> locker(cache->Lock);
+    *stats = cache->Stats;
+}
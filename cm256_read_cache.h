@@ -0,0 +1,133 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_READ_CACHE_H
+#define CM256_READ_CACHE_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Degraded-Read Cache
+
+    While a device is down, many clients tend to read the same lost blocks,
+    and each read would otherwise decode the same stripe again.  The read
+    cache keeps recovered data keyed by (stripe, original index, byte range):
+
+    + Single flight: concurrent requests for a range that is being decoded
+      wait for that decode instead of starting their own.
+
+    + Memory is bounded by MaxBytes, evicting the least recently used ranges.
+
+    The decode itself is done by a caller-provided fill function, so the
+    cache can sit in front of cm256_decode(), a cm256_decoder, a volume or
+    a piggybacked repair.  Calls are thread-safe.
+*/
+
+// Cache parameters
+typedef struct cm256_read_cache_params_t {
+    // Maximum bytes of recovered data to keep
+    uint64_t MaxBytes;
+} cm256_read_cache_params;
+
+// Cache statistics
+typedef struct cm256_read_cache_stats_t {
+    // Requests served from the cache, by a decode started for another
+    // request, or by their own decode
+    uint64_t Hits;
+    uint64_t Joins;
+    uint64_t Misses;
+
+    // Ranges evicted to stay under MaxBytes
+    uint64_t Evictions;
+
+    // Data currently cached
+    uint64_t CachedBytes;
+    uint64_t CachedRanges;
+
+    // Total request latency for each outcome, in microseconds
+    uint64_t HitUsec;
+    uint64_t JoinUsec;
+    uint64_t MissUsec;
+} cm256_read_cache_stats;
+
+/*
+ * Fill function called on a miss to recover 'bytes' bytes at 'offset' of
+ * original 'originalIndex' in stripe 'stripe' into 'data'.
+ *
+ * Returns 0 on success.  Other values are passed back to every request
+ * waiting on this range, and nothing is cached.
+ */
+typedef int (*cm256_read_cache_fill_fn)(
+    void* context,
+    uint64_t stripe,
+    int originalIndex,
+    int offset,
+    int bytes,
+    void* data);
+
+typedef struct cm256_read_cache_t cm256_read_cache;
+
+// Create a cache.  Returns nullptr on failure.
+extern cm256_read_cache* cm256_read_cache_create(cm256_read_cache_params params);
+
+// Free a cache.  No requests may be in progress.
+extern void cm256_read_cache_destroy(cm256_read_cache* cache);
+
+/*
+ * Read a recovered byte range, decoding it with 'fill' on a miss.
+ *
+ * Returns 0 on success, or the value returned by the failed fill.
+ */
+extern int cm256_read_cache_get(
+    cm256_read_cache* cache,
+    uint64_t stripe,               // Stripe identifier
+    int originalIndex,             // Original block within the stripe
+    int offset,                    // Byte offset within the block
+    int bytes,                     // Bytes to read
+    void* data,                    // Output buffer
+    cm256_read_cache_fill_fn fill, // Recovers the range on a miss
+    void* context);                // Passed to 'fill'
+
+// Drop all ranges of a stripe, for example after it is rewritten or rebuilt
+extern void cm256_read_cache_invalidate(cm256_read_cache* cache, uint64_t stripe);
+
+// Read the cache statistics
+extern void cm256_read_cache_get_stats(cm256_read_cache* cache, cm256_read_cache_stats* stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_READ_CACHE_H
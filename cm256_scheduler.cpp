@@ -0,0 +1,440 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cm256_scheduler.h"
+
+typedef std::chrono::steady_clock SchedulerClock;
+
+static uint64_t ElapsedUsec(SchedulerClock::time_point start, SchedulerClock::time_point end)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
+
+
+//-----------------------------------------------------------------------------
+// Jobs
+
+struct cm256_job_t
+{
+    cm256_priority Priority;
+    cm256_encoder_params Params;
+
+    // Encode: copy of the original block pointers, and the recovery output
+    cm256_block Originals[CM256_MAX_BLOCKS];
+    uint8_t* RecoveryBlocks;
+
+    // Decode: caller blocks, and a decoder for their erasure pattern
+    cm256_block* Blocks;
+    cm256_decoder* Decoder;
+
+    int SliceBytes;
+    int SliceCount;
+    int NextSlice;
+    int CompletedSlices;
+
+    bool Done;
+    int Result;
+
+    SchedulerClock::time_point Submitted;
+
+    // Process the byte window of one slice
+    int RunSlice(int slice);
+
+    // Report recovered indices the way cm256_decode() does
+    void SetRecoveredIndices();
+};
+
+int cm256_job_t::RunSlice(int slice)
+{
+    const int offset = slice * SliceBytes;
+    const int bytes = std::min(SliceBytes, Params.BlockBytes - offset);
+
+    if (Decoder)
+    {
+        return cm256_decoder_decode_range(Decoder, Blocks, offset, bytes);
+    }
+
+    cm256_encoder_params sliceParams = Params;
+    sliceParams.BlockBytes = bytes;
+
+    cm256_block sliceOriginals[CM256_MAX_BLOCKS];
+    for (int i = 0; i < Params.OriginalCount; ++i)
+    {
+        sliceOriginals[i].Block = static_cast<uint8_t*>(Originals[i].Block) + offset;
+        sliceOriginals[i].Index = Originals[i].Index;
+    }
+
+    uint8_t* recoveryBlock = RecoveryBlocks + offset;
+    for (int row = 0; row < Params.RecoveryCount; ++row, recoveryBlock += Params.BlockBytes)
+    {
+        cm256_encode_block(sliceParams, sliceOriginals, Params.OriginalCount + row, recoveryBlock);
+    }
+    return 0;
+}
+
+void cm256_job_t::SetRecoveredIndices()
+{
+    // A single original block is decoded without a decoder
+    if (!Decoder)
+    {
+        Blocks[0].Index = 0;
+        return;
+    }
+
+    cm256_decoder_set_indices(Decoder, Blocks);
+}
+
+
+//-----------------------------------------------------------------------------
+// Scheduler
+
+struct cm256_scheduler_t
+{
+    cm256_scheduler_params Params;
+
+    std::mutex Lock;
+    std::condition_variable WorkReady;
+    std::condition_variable JobDone;
+    bool Stopping;
+
+    // Jobs with slices left to start, per class in submission order
+    std::deque<cm256_job*> Queues[CM256_PRIORITY_COUNT];
+
+    // Worker time used by each class in the current share window
+    SchedulerClock::time_point WindowStart;
+    uint64_t WindowUsec;
+    uint64_t UsedUsec[CM256_PRIORITY_COUNT];
+    uint64_t BudgetUsec[CM256_PRIORITY_COUNT];
+
+    cm256_scheduler_stats Stats;
+
+    std::vector<std::thread> Workers;
+
+    void WorkerLoop();
+
+    // Queue a prepared job.  Returns the job.
+    cm256_job* Submit(cm256_job* job);
+
+    // Finish a job once its last slice completes.  Caller holds the lock.
+    void Complete(cm256_job* job);
+};
+
+void cm256_scheduler_t::WorkerLoop()
+{
+    std::unique_lock<std::mutex> locker(Lock);
+
+    while (!Stopping)
+    {
+        const SchedulerClock::time_point now = SchedulerClock::now();
+        if (ElapsedUsec(WindowStart, now) >= WindowUsec)
+        {
+            WindowStart = now;
+            memset(UsedUsec, 0, sizeof(UsedUsec));
+        }
+
+        // Take the next slice from the highest priority class within its share
+        cm256_job* job = nullptr;
+        int slice = 0;
+        bool throttled = false;
+        for (int c = 0; c < CM256_PRIORITY_COUNT; ++c)
+        {
+            if (Queues[c].empty())
+            {
+                continue;
+            }
+            if (UsedUsec[c] >= BudgetUsec[c])
+            {
+                ++Stats.Classes[c].Throttled;
+                throttled = true;
+                continue;
+            }
+
+            job = Queues[c].front();
+            slice = job->NextSlice++;
+            if (job->NextSlice >= job->SliceCount)
+            {
+                Queues[c].pop_front();
+            }
+            break;
+        }
+
+        if (!job)
+        {
+            if (throttled)
+            {
+                WorkReady.wait_until(locker, WindowStart + std::chrono::microseconds(WindowUsec));
+            }
+            else
+            {
+                WorkReady.wait(locker);
+            }
+            continue;
+        }
+
+        locker.unlock();
+        const SchedulerClock::time_point start = SchedulerClock::now();
+        const int result = job->RunSlice(slice);
+        const uint64_t usec = ElapsedUsec(start, SchedulerClock::now());
+        locker.lock();
+
+        UsedUsec[job->Priority] += usec;
+        cm256_scheduler_class_stats& stats = Stats.Classes[job->Priority];
+        ++stats.Slices;
+        stats.BusyUsec += usec;
+
+        if (result != 0 && job->Result == 0)
+        {
+            job->Result = result;
+        }
+        if (++job->CompletedSlices >= job->SliceCount)
+        {
+            Complete(job);
+        }
+    }
+}
+
+cm256_job* cm256_scheduler_t::Submit(cm256_job* job)
+{
+    job->NextSlice = 0;
+    job->CompletedSlices = 0;
+    job->Done = false;
+    job->Result = 0;
+    job->SliceBytes = Params.SliceBytes;
+    job->SliceCount = (job->Params.BlockBytes + job->SliceBytes - 1) / job->SliceBytes;
+    job->Submitted = SchedulerClock::now();
+
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+
+        // A decode of a single original block has nothing to compute
+        if (job->Blocks && !job->Decoder)
+        {
+            Complete(job);
+            return job;
+        }
+
+        Queues[job->Priority].push_back(job);
+    }
+    WorkReady.notify_all();
+
+    return job;
+}
+
+void cm256_scheduler_t::Complete(cm256_job* job)
+{
+    if (job->Blocks && job->Result == 0)
+    {
+        job->SetRecoveredIndices();
+    }
+
+    const uint64_t latency = ElapsedUsec(job->Submitted, SchedulerClock::now());
+    cm256_scheduler_class_stats& stats = Stats.Classes[job->Priority];
+    ++stats.Jobs;
+    stats.TotalLatencyUsec += latency;
+    stats.MaxLatencyUsec = std::max(stats.MaxLatencyUsec, latency);
+
+    job->Done = true;
+    JobDone.notify_all();
+}
+
+extern "C" cm256_scheduler* cm256_scheduler_create(cm256_scheduler_params params)
+{
+    if (params.WorkerCount < 0 || params.SliceBytes < 0 || params.ShareWindowMsec < 0)
+    {
+        return nullptr;
+    }
+    for (int c = 0; c < CM256_PRIORITY_COUNT; ++c)
+    {
+        if (params.SharePercent[c] <= 0 || params.SharePercent[c] > 100)
+        {
+            return nullptr;
+        }
+    }
+
+    if (params.WorkerCount == 0)
+    {
+        params.WorkerCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    if (params.SliceBytes == 0)
+    {
+        params.SliceBytes = CM256_SCHEDULER_SLICE_BYTES;
+    }
+    if (params.ShareWindowMsec == 0)
+    {
+        params.ShareWindowMsec = 100;
+    }
+
+    cm256_scheduler* scheduler = new cm256_scheduler;
+    scheduler->Params = params;
+    scheduler->Stopping = false;
+    memset(&scheduler->Stats, 0, sizeof(scheduler->Stats));
+
+    scheduler->WindowStart = SchedulerClock::now();
+    scheduler->WindowUsec = static_cast<uint64_t>(params.ShareWindowMsec) * 1000;
+    for (int c = 0; c < CM256_PRIORITY_COUNT; ++c)
+    {
+        scheduler->UsedUsec[c] = 0;
+
+        // A full share is never throttled
+        scheduler->BudgetUsec[c] = (params.SharePercent[c] >= 100) ? UINT64_MAX :
+            scheduler->WindowUsec * params.WorkerCount * params.SharePercent[c] / 100;
+    }
+
+    for (int i = 0; i < params.WorkerCount; ++i)
+    {
+        scheduler->Workers.push_back(std::thread(&cm256_scheduler_t::WorkerLoop, scheduler));
+    }
+
+    return scheduler;
+}
+
+extern "C" void cm256_scheduler_destroy(cm256_scheduler* scheduler)
+{
+    if (!scheduler)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> locker(scheduler->Lock);
+        scheduler->Stopping = true;
+    }
+    scheduler->WorkReady.notify_all();
+
+    for (size_t i = 0; i < scheduler->Workers.size(); ++i)
+    {
+        scheduler->Workers[i].join();
+    }
+
+    delete scheduler;
+}
+
+static bool ValidJobParams(cm256_scheduler* scheduler, cm256_priority priority, cm256_encoder_params params)
+{
+    return scheduler &&
+           priority >= 0 && priority < CM256_PRIORITY_COUNT &&
+           params.OriginalCount > 0 &&
+           params.RecoveryCount > 0 &&
+           params.BlockBytes > 0 &&
+           params.OriginalCount + params.RecoveryCount <= CM256_MAX_BLOCKS;
+}
+
+extern "C" cm256_job* cm256_scheduler_encode(
+    cm256_scheduler* scheduler,  // Scheduler from cm256_scheduler_create()
+    cm256_priority priority,     // Priority class
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks)        // Output recovery blocks end-to-end
+{
+    if (!ValidJobParams(scheduler, priority, params) || !originals || !recoveryBlocks)
+    {
+        return nullptr;
+    }
+
+    cm256_job* job = new cm256_job;
+    job->Priority = priority;
+    job->Params = params;
+    memcpy(job->Originals, originals, params.OriginalCount * sizeof(cm256_block));
+    job->RecoveryBlocks = static_cast<uint8_t*>(recoveryBlocks);
+    job->Blocks = nullptr;
+    job->Decoder = nullptr;
+
+    return scheduler->Submit(job);
+}
+
+extern "C" cm256_job* cm256_scheduler_decode(
+    cm256_scheduler* scheduler,  // Scheduler from cm256_scheduler_create()
+    cm256_priority priority,     // Priority class
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks)         // Array of 'originalCount' blocks as in cm256_decode()
+{
+    if (!ValidJobParams(scheduler, priority, params) || !blocks)
+    {
+        return nullptr;
+    }
+
+    cm256_job* job = new cm256_job;
+    job->Priority = priority;
+    job->Params = params;
+    job->RecoveryBlocks = nullptr;
+    job->Blocks = blocks;
+    job->Decoder = nullptr;
+
+    if (params.OriginalCount > 1)
+    {
+        unsigned char indices[CM256_MAX_BLOCKS];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            indices[i] = blocks[i].Index;
+        }
+
+        job->Decoder = cm256_decoder_create(params, indices);
+        if (!job->Decoder)
+        {
+            delete job;
+            return nullptr;
+        }
+    }
+
+    return scheduler->Submit(job);
+}
+
+extern "C" int cm256_scheduler_wait(cm256_scheduler* scheduler, cm256_job* job)
+{
+    if (!scheduler || !job)
+    {
+        return -3;
+    }
+
+    {
+        std::unique_lock<std::mutex> locker(scheduler->Lock);
+        while (!job->Done)
+        {
+            scheduler->JobDone.wait(locker);
+        }
+    }
+
+    const int result = job->Result;
+    cm256_decoder_free(job->Decoder);
+    delete job;
+    return result;
+}
+
+extern "C" void cm256_scheduler_get_stats(cm256_scheduler* scheduler, cm256_scheduler_stats* stats)
+{
+    std::lock_guard<std::mutex> locker(scheduler->Lock);
+    *stats = scheduler->Stats;
+}
@@ -0,0 +1,155 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_SCHEDULER_H
+#define CM256_SCHEDULER_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    FEC Job Scheduler
+
+    Foreground degraded reads and background rebuilds compete for the same
+    cores, and a burst of large rebuild decodes holds up the small decodes
+    that reads are waiting for.  The scheduler runs encode and decode jobs
+    on a pool of worker threads:
+
+    + Jobs are split into byte windows of SliceBytes, and a worker picks the
+      next window from the highest priority class with work each time.  A
+      long job therefore yields to a latency-sensitive one between windows.
+
+    + Each class may be limited to a share of the worker time, measured over
+      ShareWindowMsec.  A class that used up its share waits for the next
+      window even if workers are idle, leaving that CPU to the application.
+
+    Windows of one job may run on several workers at once.
+*/
+
+// Priority classes, highest first
+typedef enum cm256_priority_t {
+    CM256_PRIORITY_LATENCY, // Foreground reads waiting on a decode
+    CM256_PRIORITY_NORMAL,  // Writes waiting on an encode
+    CM256_PRIORITY_BULK,    // Rebuild and scrub
+
+    CM256_PRIORITY_COUNT
+} cm256_priority;
+
+// Default byte window per slice
+#define CM256_SCHEDULER_SLICE_BYTES 16384
+
+// Scheduler parameters
+typedef struct cm256_scheduler_params_t {
+    // Number of worker threads, or 0 for one per hardware thread
+    int WorkerCount;
+
+    // Bytes of each block processed per slice, or 0 for the default
+    int SliceBytes;
+
+    // Percent of the total worker time each class may use (1-100)
+    int SharePercent[CM256_PRIORITY_COUNT];
+
+    // Period over which the shares are measured, or 0 for 100 msec
+    int ShareWindowMsec;
+} cm256_scheduler_params;
+
+// Statistics for one priority class
+typedef struct cm256_scheduler_class_stats_t {
+    uint64_t Jobs;
+    uint64_t Slices;
+
+    // Worker time spent on slices
+    uint64_t BusyUsec;
+
+    // Time from submission to completion, in microseconds
+    uint64_t TotalLatencyUsec;
+    uint64_t MaxLatencyUsec;
+
+    // Times a worker skipped this class because it used up its share
+    uint64_t Throttled;
+} cm256_scheduler_class_stats;
+
+typedef struct cm256_scheduler_stats_t {
+    cm256_scheduler_class_stats Classes[CM256_PRIORITY_COUNT];
+} cm256_scheduler_stats;
+
+typedef struct cm256_scheduler_t cm256_scheduler;
+typedef struct cm256_job_t cm256_job;
+
+// Start a scheduler and its workers.  Returns nullptr on failure.
+extern cm256_scheduler* cm256_scheduler_create(cm256_scheduler_params params);
+
+// Stop the workers and free the scheduler.  All jobs must have been waited on.
+extern void cm256_scheduler_destroy(cm256_scheduler* scheduler);
+
+/*
+ * Queue an encode with the same inputs and output as cm256_encode().
+ *
+ * The buffers must stay valid until cm256_scheduler_wait() returns.
+ * Returns nullptr on invalid input.
+ */
+extern cm256_job* cm256_scheduler_encode(
+    cm256_scheduler* scheduler,  // Scheduler from cm256_scheduler_create()
+    cm256_priority priority,     // Priority class
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* originals,      // Array of pointers to original blocks
+    void* recoveryBlocks);       // Output recovery blocks end-to-end
+
+/*
+ * Queue a decode with the same inputs and results as cm256_decode().
+ *
+ * The blocks must stay valid until cm256_scheduler_wait() returns.
+ * Returns nullptr on invalid input.
+ */
+extern cm256_job* cm256_scheduler_decode(
+    cm256_scheduler* scheduler,  // Scheduler from cm256_scheduler_create()
+    cm256_priority priority,     // Priority class
+    cm256_encoder_params params, // Encoder parameters
+    cm256_block* blocks);        // Array of 'originalCount' blocks as in cm256_decode()
+
+/*
+ * Wait for a job to complete and free it.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_scheduler_wait(cm256_scheduler* scheduler, cm256_job* job);
+
+// Read the scheduler statistics
+extern void cm256_scheduler_get_stats(cm256_scheduler* scheduler, cm256_scheduler_stats* stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_SCHEDULER_H
@@ -0,0 +1,932 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#include "cm256_store.h"
+
+
+//-----------------------------------------------------------------------------
+// Segment Layout
+
+/*
+    Each segment is laid out as:
+
+        [StoreHeader] [StoreSlot x SlotCount] [Chunk data x SlotCount]
+
+    The header carries the store parameters and the state of every segment,
+    so any surviving segment can describe the whole store.
+
+    Each slot records the value length and a sequence counter that is odd
+    while a put is writing the slot.  The counter is updated in every segment
+    that a put writes to, and readers take it from the first healthy segment.
+*/
+
+static const uint32_t StoreMagic = 0x43533235; // "CS25"
+static const uint32_t StoreVersion = 1;
+
+enum SegmentStates
+{
+    SegmentHealthy = 0,
+    SegmentLost = 1,
+    SegmentRebuilding = 2
+};
+
+struct StoreHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    cm256_store_params Params;
+    uint32_t SegmentIndex;
+    uint32_t Reserved;
+
+    // State of every segment, replicated in each header
+    uint8_t SegmentState[256];
+};
+
+struct StoreSlot
+{
+    // Odd while a put is writing the slot
+    uint32_t Sequence;
+
+    // Length of the value in bytes
+    uint32_t Bytes;
+};
+
+static size_t AlignUp64(size_t bytes)
+{
+    return (bytes + 63) & ~(size_t)63;
+}
+
+static size_t GetSlotsOffset()
+{
+    return AlignUp64(sizeof(StoreHeader));
+}
+
+static size_t GetDataOffset(const cm256_store_params& params)
+{
+    return GetSlotsOffset() + AlignUp64(sizeof(StoreSlot) * (size_t)params.SlotCount);
+}
+
+static size_t GetSegmentBytes(const cm256_store_params& params)
+{
+    return GetDataOffset(params) + (size_t)params.ChunkBytes * params.SlotCount;
+}
+
+static void GetSegmentName(const char* name, int segment, char* segmentName, size_t size)
+{
+    snprintf(segmentName, size, "/%s-%d", name, segment);
+}
+
+static uint8_t LoadState(const StoreHeader* header, int segment)
+{
+    return __atomic_load_n(&header->SegmentState[segment], __ATOMIC_ACQUIRE);
+}
+
+static void StoreState(StoreHeader* header, int segment, uint8_t state)
+{
+    __atomic_store_n(&header->SegmentState[segment], state, __ATOMIC_RELEASE);
+}
+
+
+//-----------------------------------------------------------------------------
+// Store Handle
+
+struct cm256_store_t
+{
+    char Name[200];
+    cm256_store_params Params;
+    cm256_encoder_params Codec;
+    size_t SegmentBytes;
+    int SegmentCount;
+
+    // Mapped segments, or nullptr if not mapped in this process
+    uint8_t* Segments[256];
+
+    // Protects the mappings, scratch buffers and cached decoder
+    std::mutex Lock;
+
+    // Scratch for decoding: one chunk per original plus a zero chunk
+    uint8_t* Scratch;
+    uint8_t* ZeroChunk;
+
+    // Decoder cached for the last erasure pattern seen
+    cm256_decoder* Decoder;
+    uint8_t DecoderIndices[256];
+
+    // Background rebuild.  RebuildPending is protected by Lock and stays set
+    // until cm256_store_rebuild_wait() has joined the thread, so only the
+    // waiter touches RebuildThread while it is set.
+    std::thread RebuildThread;
+    int RebuildResult;
+    bool RebuildPending;
+
+    // Serializes cm256_store_rebuild_wait() callers
+    std::mutex RebuildWaitLock;
+
+    cm256_store_stats Stats;
+
+    StoreHeader* Header(int segment)
+    {
+        return reinterpret_cast<StoreHeader*>(Segments[segment]);
+    }
+    StoreSlot* Slot(int segment, int slot)
+    {
+        return reinterpret_cast<StoreSlot*>(Segments[segment] + GetSlotsOffset()) + slot;
+    }
+    uint8_t* Chunk(int segment, int slot)
+    {
+        return Segments[segment] + GetDataOffset(Params) + (size_t)Params.ChunkBytes * slot;
+    }
+
+    // Map or unmap segments to match the shared segment states
+    void SyncSegments();
+
+    // First mapped segment in the given state, or -1
+    int FindSegment(uint8_t state);
+
+    // Gather pointers to all original chunks of a slot, decoding if needed.
+    // The caller holds the lock.  Returns false if too many segments are lost.
+    bool GatherOriginals(int slot, const uint8_t* originals[CM256_MAX_BLOCKS], bool* degraded);
+
+    // Regenerate one slot of a segment being rebuilt.  The caller holds the lock.
+    int RebuildSlot(int segment, int slot);
+
+    // Mark a segment lost again after a failed rebuild.  The caller holds the lock.
+    void AbandonRebuild(int segment);
+
+    // Rebuild every slot of a segment
+    int Rebuild(int segment);
+};
+
+static uint8_t* MapSegment(const char* name, int segment, size_t bytes, bool create)
+{
+    char segmentName[256];
+    GetSegmentName(name, segment, segmentName, sizeof(segmentName));
+
+    int fd;
+    if (create)
+    {
+        shm_unlink(segmentName);
+        fd = shm_open(segmentName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    else
+    {
+        fd = shm_open(segmentName, O_RDWR, 0600);
+    }
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    if (create && ftruncate(fd, (off_t)bytes) != 0)
+    {
+        close(fd);
+        shm_unlink(segmentName);
+        return nullptr;
+    }
+
+    void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    return static_cast<uint8_t*>(data);
+}
+
+static cm256_store* AllocateStore(const char* name, const cm256_store_params& params)
+{
+    cm256_store* store = new cm256_store;
+
+    snprintf(store->Name, sizeof(store->Name), "%s", name);
+    store->Params = params;
+    store->Codec.OriginalCount = params.OriginalCount;
+    store->Codec.RecoveryCount = params.RecoveryCount;
+    store->Codec.BlockBytes = params.ChunkBytes;
+    store->SegmentBytes = GetSegmentBytes(params);
+    store->SegmentCount = params.OriginalCount + params.RecoveryCount;
+    for (int i = 0; i < 256; ++i)
+    {
+        store->Segments[i] = nullptr;
+    }
+    store->Scratch = new uint8_t[(size_t)params.ChunkBytes * (params.OriginalCount + 1)];
+    store->ZeroChunk = store->Scratch + (size_t)params.ChunkBytes * params.OriginalCount;
+    memset(store->ZeroChunk, 0, params.ChunkBytes);
+    store->Decoder = nullptr;
+    store->RebuildResult = 0;
+    store->RebuildPending = false;
+    memset(&store->Stats, 0, sizeof(store->Stats));
+    store->Stats.SegmentBytes = (uint64_t)store->SegmentBytes * store->SegmentCount;
+    store->Stats.CapacityBytes = (uint64_t)params.ChunkBytes * params.OriginalCount * params.SlotCount;
+
+    return store;
+}
+
+static bool ValidateParams(const cm256_store_params& params)
+{
+    return params.OriginalCount > 0 &&
+           params.RecoveryCount > 0 &&
+           params.OriginalCount + params.RecoveryCount <= CM256_MAX_BLOCKS &&
+           params.ChunkBytes > 0 &&
+           params.SlotCount > 0 &&
+           (uint64_t)params.ChunkBytes * params.OriginalCount <= 0x7fffffff;
+}
+
+extern "C" cm256_store* cm256_store_create(const char* name, cm256_store_params params)
+{
+    if (!name || !ValidateParams(params) || cm256_init())
+    {
+        return nullptr;
+    }
+
+    cm256_store* store = AllocateStore(name, params);
+
+    for (int i = 0; i < store->SegmentCount; ++i)
+    {
+        store->Segments[i] = MapSegment(name, i, store->SegmentBytes, true);
+        if (!store->Segments[i])
+        {
+            cm256_store_unlink(store);
+            cm256_store_close(store);
+            return nullptr;
+        }
+
+        // Shared memory is zero-filled, so only the header needs to be written
+        StoreHeader* header = store->Header(i);
+        header->Magic = StoreMagic;
+        header->Version = StoreVersion;
+        header->Params = params;
+        header->SegmentIndex = i;
+    }
+
+    return store;
+}
+
+extern "C" cm256_store* cm256_store_open(const char* name)
+{
+    if (!name || cm256_init())
+    {
+        return nullptr;
+    }
+
+    // Find any surviving segment to read the parameters from
+    for (int i = 0; i < 256; ++i)
+    {
+        uint8_t* segment = MapSegment(name, i, sizeof(StoreHeader), false);
+        if (!segment)
+        {
+            continue;
+        }
+
+        const StoreHeader* header = reinterpret_cast<const StoreHeader*>(segment);
+        const cm256_store_params params = header->Params;
+        const bool valid = header->Magic == StoreMagic &&
+                           header->Version == StoreVersion &&
+                           ValidateParams(params);
+        munmap(segment, sizeof(StoreHeader));
+
+        if (!valid)
+        {
+            return nullptr;
+        }
+
+        // Map every segment that exists and then drop the ones marked lost
+        cm256_store* store = AllocateStore(name, params);
+        for (int j = i; j < store->SegmentCount; ++j)
+        {
+            store->Segments[j] = MapSegment(name, j, store->SegmentBytes, false);
+        }
+        if (store->FindSegment(SegmentHealthy) < 0)
+        {
+            cm256_store_close(store);
+            return nullptr;
+        }
+        store->SyncSegments();
+        return store;
+    }
+
+    return nullptr;
+}
+
+extern "C" void cm256_store_close(cm256_store* store)
+{
+    if (!store)
+    {
+        return;
+    }
+
+    cm256_store_rebuild_wait(store);
+
+    for (int i = 0; i < store->SegmentCount; ++i)
+    {
+        if (store->Segments[i])
+        {
+            munmap(store->Segments[i], store->SegmentBytes);
+        }
+    }
+    cm256_decoder_free(store->Decoder);
+    delete[] store->Scratch;
+    delete store;
+}
+
+extern "C" void cm256_store_unlink(cm256_store* store)
+{
+    if (!store)
+    {
+        return;
+    }
+
+    for (int i = 0; i < store->SegmentCount; ++i)
+    {
+        char segmentName[256];
+        GetSegmentName(store->Name, i, segmentName, sizeof(segmentName));
+        shm_unlink(segmentName);
+    }
+}
+
+extern "C" cm256_store_params cm256_store_get_params(cm256_store* store)
+{
+    return store->Params;
+}
+
+int cm256_store_t::FindSegment(uint8_t state)
+{
+    for (int i = 0; i < SegmentCount; ++i)
+    {
+        if (Segments[i] && LoadState(Header(i), i) == state)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void cm256_store_t::SyncSegments()
+{
+    const int reference = FindSegment(SegmentHealthy);
+    if (reference < 0)
+    {
+        return;
+    }
+    const StoreHeader* header = Header(reference);
+
+    for (int i = 0; i < SegmentCount; ++i)
+    {
+        const uint8_t state = LoadState(header, i);
+
+        if (state == SegmentLost && Segments[i])
+        {
+            munmap(Segments[i], SegmentBytes);
+            Segments[i] = nullptr;
+        }
+        else if (state != SegmentLost && !Segments[i])
+        {
+            // Segment was rebuilt by another process
+            Segments[i] = MapSegment(Name, i, SegmentBytes, false);
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Put / Get
+
+extern "C" int cm256_store_put(cm256_store* store, int slot, const void* data, int bytes)
+{
+    const cm256_store_params& params = store->Params;
+
+    if (slot < 0 || slot >= params.SlotCount || bytes < 0 ||
+        bytes > params.ChunkBytes * params.OriginalCount || (!data && bytes > 0))
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> locker(store->Lock);
+    store->SyncSegments();
+
+    // Segments that receive the write: healthy ones and any being rebuilt
+    int targets[CM256_MAX_BLOCKS];
+    int targetCount = 0;
+    for (int i = 0; i < store->SegmentCount; ++i)
+    {
+        if (store->Segments[i] && LoadState(store->Header(i), i) != SegmentLost)
+        {
+            targets[targetCount++] = i;
+        }
+    }
+    if (targetCount < params.OriginalCount)
+    {
+        return -2;
+    }
+
+    // Split the value into chunks, padding the last one with zeroes
+    const uint8_t* value = static_cast<const uint8_t*>(data);
+    cm256_block originals[CM256_MAX_BLOCKS];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        const int offset = i * params.ChunkBytes;
+        const int remaining = bytes - offset;
+
+        if (remaining >= params.ChunkBytes)
+        {
+            originals[i].Block = const_cast<uint8_t*>(value + offset);
+        }
+        else if (remaining > 0)
+        {
+            uint8_t* padded = store->Scratch;
+            memcpy(padded, value + offset, remaining);
+            memset(padded + remaining, 0, params.ChunkBytes - remaining);
+            originals[i].Block = padded;
+        }
+        else
+        {
+            originals[i].Block = store->ZeroChunk;
+        }
+    }
+
+    // Mark the slot as being written
+    for (int i = 0; i < targetCount; ++i)
+    {
+        __atomic_add_fetch(&store->Slot(targets[i], slot)->Sequence, 1, __ATOMIC_SEQ_CST);
+    }
+
+    // A rebuild in another process may have started since the targets were
+    // picked.  The states are read again only after the slot is marked busy,
+    // so either this put sees the new segment, or the rebuild sees the busy
+    // slot and copies it again afterwards.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    store->SyncSegments();
+    for (int i = 0; i < store->SegmentCount; ++i)
+    {
+        if (!store->Segments[i] || LoadState(store->Header(i), i) == SegmentLost ||
+            std::find(targets, targets + targetCount, i) != targets + targetCount)
+        {
+            continue;
+        }
+
+        targets[targetCount++] = i;
+        __atomic_add_fetch(&store->Slot(i, slot)->Sequence, 1, __ATOMIC_SEQ_CST);
+    }
+
+    for (int i = 0; i < targetCount; ++i)
+    {
+        const int segment = targets[i];
+        uint8_t* chunk = store->Chunk(segment, slot);
+
+        if (segment < params.OriginalCount)
+        {
+            memcpy(chunk, originals[segment].Block, params.ChunkBytes);
+        }
+        else
+        {
+            cm256_encode_block(store->Codec, originals, segment, chunk);
+        }
+        store->Slot(segment, slot)->Bytes = bytes;
+    }
+
+    // Publish the new value
+    for (int i = 0; i < targetCount; ++i)
+    {
+        __atomic_add_fetch(&store->Slot(targets[i], slot)->Sequence, 1, __ATOMIC_SEQ_CST);
+    }
+
+    ++store->Stats.Puts;
+    return 0;
+}
+
+bool cm256_store_t::GatherOriginals(int slot, const uint8_t* originals[CM256_MAX_BLOCKS], bool* degraded)
+{
+    const int originalCount = Params.OriginalCount;
+
+    // Pick the healthy originals and fill erasures with healthy recovery segments
+    cm256_block blocks[CM256_MAX_BLOCKS];
+    uint8_t indices[CM256_MAX_BLOCKS];
+    int nextRecovery = originalCount;
+    int recoveryUsed = 0;
+
+    for (int i = 0; i < originalCount; ++i)
+    {
+        if (Segments[i] && LoadState(Header(i), i) == SegmentHealthy)
+        {
+            originals[i] = Chunk(i, slot);
+            blocks[i].Block = const_cast<uint8_t*>(originals[i]);
+            blocks[i].Index = static_cast<uint8_t>(i);
+            continue;
+        }
+
+        while (nextRecovery < SegmentCount &&
+               (!Segments[nextRecovery] || LoadState(Header(nextRecovery), nextRecovery) != SegmentHealthy))
+        {
+            ++nextRecovery;
+        }
+        if (nextRecovery >= SegmentCount)
+        {
+            return false;
+        }
+
+        // Decoding happens in place, so work on a copy of the recovery chunk
+        uint8_t* copy = Scratch + (size_t)Params.ChunkBytes * recoveryUsed++;
+        memcpy(copy, Chunk(nextRecovery, slot), Params.ChunkBytes);
+        blocks[i].Block = copy;
+        blocks[i].Index = static_cast<uint8_t>(nextRecovery++);
+    }
+
+    *degraded = (recoveryUsed > 0);
+    if (!*degraded)
+    {
+        return true;
+    }
+
+    for (int i = 0; i < originalCount; ++i)
+    {
+        indices[i] = blocks[i].Index;
+    }
+
+    // Reuse the decomposition while the erasure pattern is unchanged
+    if (!Decoder || memcmp(indices, DecoderIndices, originalCount) != 0)
+    {
+        cm256_decoder_free(Decoder);
+        Decoder = cm256_decoder_create(Codec, indices);
+        memcpy(DecoderIndices, indices, originalCount);
+        if (!Decoder)
+        {
+            return false;
+        }
+    }
+
+    if (cm256_decoder_decode(Decoder, blocks))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < originalCount; ++i)
+    {
+        originals[blocks[i].Index] = static_cast<const uint8_t*>(blocks[i].Block);
+    }
+    return true;
+}
+
+extern "C" int cm256_store_get(cm256_store* store, int slot, void* data, int maxBytes)
+{
+    const cm256_store_params& params = store->Params;
+
+    if (slot < 0 || slot >= params.SlotCount || (!data && maxBytes > 0))
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> locker(store->Lock);
+    store->SyncSegments();
+
+    const int reference = store->FindSegment(SegmentHealthy);
+    if (reference < 0)
+    {
+        return -2;
+    }
+    const StoreSlot* referenceSlot = store->Slot(reference, slot);
+
+    for (;;)
+    {
+        const uint32_t sequence = __atomic_load_n(&referenceSlot->Sequence, __ATOMIC_SEQ_CST);
+        if (sequence & 1)
+        {
+            // A put is in progress
+            ++store->Stats.ReadRetries;
+            std::this_thread::yield();
+            continue;
+        }
+
+        const int bytes = static_cast<int>(referenceSlot->Bytes);
+        if (bytes > maxBytes)
+        {
+            return -4;
+        }
+
+        const uint8_t* originals[CM256_MAX_BLOCKS];
+        bool degraded = false;
+        if (!store->GatherOriginals(slot, originals, &degraded))
+        {
+            return -3;
+        }
+
+        uint8_t* output = static_cast<uint8_t*>(data);
+        for (int i = 0, offset = 0; offset < bytes; ++i, offset += params.ChunkBytes)
+        {
+            const int remaining = bytes - offset;
+            memcpy(output + offset, originals[i], remaining < params.ChunkBytes ? remaining : params.ChunkBytes);
+        }
+
+        if (__atomic_load_n(&referenceSlot->Sequence, __ATOMIC_SEQ_CST) != sequence)
+        {
+            // A put raced with the read
+            ++store->Stats.ReadRetries;
+            continue;
+        }
+
+        ++store->Stats.Gets;
+        if (degraded)
+        {
+            ++store->Stats.DegradedGets;
+        }
+        return bytes;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Failure and Rebuild
+
+extern "C" int cm256_store_drop_segment(cm256_store* store, int segment)
+{
+    if (segment < 0 || segment >= store->SegmentCount)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> locker(store->Lock);
+    store->SyncSegments();
+
+    for (int i = 0; i < store->SegmentCount; ++i)
+    {
+        if (store->Segments[i])
+        {
+            StoreState(store->Header(i), segment, SegmentLost);
+        }
+    }
+
+    if (store->Segments[segment])
+    {
+        munmap(store->Segments[segment], store->SegmentBytes);
+        store->Segments[segment] = nullptr;
+    }
+
+    char segmentName[256];
+    GetSegmentName(store->Name, segment, segmentName, sizeof(segmentName));
+    shm_unlink(segmentName);
+
+    return 0;
+}
+
+int cm256_store_t::RebuildSlot(int segment, int slot)
+{
+    const int reference = FindSegment(SegmentHealthy);
+    if (reference < 0 || !Segments[segment])
+    {
+        return -2;
+    }
+    const StoreSlot* referenceSlot = Slot(reference, slot);
+    StoreSlot* rebuiltSlot = Slot(segment, slot);
+
+    for (;;)
+    {
+        const uint32_t sequence = __atomic_load_n(&referenceSlot->Sequence, __ATOMIC_SEQ_CST);
+        if (sequence & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const uint32_t bytes = referenceSlot->Bytes;
+
+        const uint8_t* originals[CM256_MAX_BLOCKS];
+        bool degraded = false;
+        if (!GatherOriginals(slot, originals, &degraded))
+        {
+            return -3;
+        }
+
+        uint8_t* chunk = Chunk(segment, slot);
+        if (segment < Params.OriginalCount)
+        {
+            memcpy(chunk, originals[segment], Params.ChunkBytes);
+        }
+        else
+        {
+            cm256_block blocks[CM256_MAX_BLOCKS];
+            for (int i = 0; i < Params.OriginalCount; ++i)
+            {
+                blocks[i].Block = const_cast<uint8_t*>(originals[i]);
+            }
+            cm256_encode_block(Codec, blocks, segment, chunk);
+        }
+        rebuiltSlot->Bytes = bytes;
+        __atomic_store_n(&rebuiltSlot->Sequence, sequence, __ATOMIC_SEQ_CST);
+
+        // If a put raced with the rebuild then regenerate the slot
+        if (__atomic_load_n(&referenceSlot->Sequence, __ATOMIC_SEQ_CST) == sequence)
+        {
+            break;
+        }
+    }
+
+    ++Stats.RebuiltSlots;
+    return 0;
+}
+
+void cm256_store_t::AbandonRebuild(int segment)
+{
+    for (int i = 0; i < SegmentCount; ++i)
+    {
+        if (Segments[i])
+        {
+            StoreState(Header(i), segment, SegmentLost);
+        }
+    }
+
+    if (Segments[segment])
+    {
+        munmap(Segments[segment], SegmentBytes);
+        Segments[segment] = nullptr;
+    }
+
+    char segmentName[256];
+    GetSegmentName(Name, segment, segmentName, sizeof(segmentName));
+    shm_unlink(segmentName);
+}
+
+int cm256_store_t::Rebuild(int segment)
+{
+    for (int slot = 0; slot < Params.SlotCount; ++slot)
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+        SyncSegments();
+
+        const int result = RebuildSlot(segment, slot);
+        if (result)
+        {
+            AbandonRebuild(segment);
+            return result;
+        }
+    }
+
+    // Before promoting the segment, check every slot against the reference
+    // and regenerate any that a put changed behind the first pass
+    for (bool repaired = true; repaired;)
+    {
+        repaired = false;
+
+        for (int slot = 0; slot < Params.SlotCount; ++slot)
+        {
+            std::lock_guard<std::mutex> locker(Lock);
+            SyncSegments();
+
+            const int reference = FindSegment(SegmentHealthy);
+            if (reference < 0 || !Segments[segment])
+            {
+                AbandonRebuild(segment);
+                return -2;
+            }
+
+            const StoreSlot* referenceSlot = Slot(reference, slot);
+            uint32_t sequence;
+            while ((sequence = __atomic_load_n(&referenceSlot->Sequence, __ATOMIC_SEQ_CST)) & 1)
+            {
+                std::this_thread::yield();
+            }
+            if (__atomic_load_n(&Slot(segment, slot)->Sequence, __ATOMIC_SEQ_CST) == sequence)
+            {
+                continue;
+            }
+
+            const int result = RebuildSlot(segment, slot);
+            if (result)
+            {
+                AbandonRebuild(segment);
+                return result;
+            }
+            repaired = true;
+        }
+    }
+
+    std::lock_guard<std::mutex> locker(Lock);
+    for (int i = 0; i < SegmentCount; ++i)
+    {
+        if (Segments[i])
+        {
+            StoreState(Header(i), segment, SegmentHealthy);
+        }
+    }
+    return 0;
+}
+
+extern "C" int cm256_store_rebuild(cm256_store* store, int segment)
+{
+    if (!store || segment < 0 || segment >= store->SegmentCount)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> locker(store->Lock);
+
+    // One rebuild per handle until it has been waited for
+    if (store->RebuildPending)
+    {
+        return -1;
+    }
+
+    store->SyncSegments();
+
+    const int reference = store->FindSegment(SegmentHealthy);
+    if (reference < 0 || store->Segments[segment] ||
+        LoadState(store->Header(reference), segment) != SegmentLost)
+    {
+        return -2;
+    }
+
+    uint8_t* mapped = MapSegment(store->Name, segment, store->SegmentBytes, true);
+    if (!mapped)
+    {
+        return -3;
+    }
+    store->Segments[segment] = mapped;
+
+    StoreHeader* header = store->Header(segment);
+    memcpy(header, store->Header(reference), sizeof(StoreHeader));
+    header->SegmentIndex = segment;
+
+    // Puts from every process now also write to the new segment
+    for (int i = 0; i < store->SegmentCount; ++i)
+    {
+        if (store->Segments[i])
+        {
+            StoreState(store->Header(i), segment, SegmentRebuilding);
+        }
+    }
+
+    // Pairs with the fence in cm256_store_put(): the state is visible
+    // before the rebuild reads any slot sequence
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // The thread takes the lock once this returns
+    store->RebuildPending = true;
+    store->RebuildResult = 0;
+    store->RebuildThread = std::thread([store, segment]() {
+        store->RebuildResult = store->Rebuild(segment);
+    });
+
+    return 0;
+}
+
+extern "C" int cm256_store_rebuild_wait(cm256_store* store)
+{
+    if (!store)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> waitLocker(store->RebuildWaitLock);
+    {
+        std::lock_guard<std::mutex> locker(store->Lock);
+        if (!store->RebuildPending)
+        {
+            return store->RebuildResult;
+        }
+    }
+
+    // The rebuild thread needs the lock, so join without it
+    store->RebuildThread.join();
+
+    std::lock_guard<std::mutex> locker(store->Lock);
+    store->RebuildPending = false;
+    return store->RebuildResult;
+}
+
+extern "C" void cm256_store_get_stats(cm256_store* store, cm256_store_stats* stats)
+{
+    std::lock_guard<std::mutex> locker(store->Lock);
+    *stats = store->Stats;
+}
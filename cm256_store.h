@@ -0,0 +1,168 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_STORE_H
+#define CM256_STORE_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Erasure-Coded Shared Memory Object Store
+
+    Values are striped across OriginalCount + RecoveryCount POSIX shared memory
+    segments, one per failure domain, instead of being replicated.  Each value
+    is split into OriginalCount chunks of ChunkBytes bytes, and cm256_encode()
+    produces RecoveryCount recovery chunks, so the memory overhead is
+    (OriginalCount + RecoveryCount) / OriginalCount rather than 3x for triple
+    replication.
+
+    Reads are served from the original segments.  When a segment is lost the
+    value is decoded from any OriginalCount surviving segments, and a lost
+    segment can be rebuilt in the background while the store stays online.
+
+    Segment health is replicated in the header of every segment, so all
+    processes that open the store agree on which segments are usable.
+
+    Each value slot is guarded by a sequence counter: readers never block and
+    retry if a put raced with them.  Puts to the same slot must be serialized
+    by the caller.  A store handle may be shared by the threads of a process.
+
+    This component requires POSIX shared memory (shm_open / mmap).
+*/
+
+// Store parameters
+typedef struct cm256_store_params_t {
+    // Number of segments holding original data
+    int OriginalCount;
+
+    // Number of segments holding recovery data,
+    // OriginalCount + RecoveryCount <= CM256_MAX_BLOCKS
+    int RecoveryCount;
+
+    // Bytes of each value stored in each segment.
+    // Values may hold up to OriginalCount * ChunkBytes bytes.
+    int ChunkBytes;
+
+    // Number of value slots
+    int SlotCount;
+} cm256_store_params;
+
+// Per-handle statistics
+typedef struct cm256_store_stats_t {
+    uint64_t Puts;
+    uint64_t Gets;
+
+    // Gets that had to decode because an original segment was lost
+    uint64_t DegradedGets;
+
+    // Reads that raced with a put and were retried
+    uint64_t ReadRetries;
+
+    // Slots regenerated by rebuilds started from this handle
+    uint64_t RebuiltSlots;
+
+    // Shared memory used by all segments
+    uint64_t SegmentBytes;
+
+    // Value bytes the store can hold
+    uint64_t CapacityBytes;
+} cm256_store_stats;
+
+typedef struct cm256_store_t cm256_store;
+
+// Create the segments of a new store, replacing any store with the same name.
+// Returns nullptr on failure.
+extern cm256_store* cm256_store_create(const char* name, cm256_store_params params);
+
+// Open a store created by another process.
+// Returns nullptr on failure.
+extern cm256_store* cm256_store_open(const char* name);
+
+// Close a store handle, waiting for any background rebuild to finish
+extern void cm256_store_close(cm256_store* store);
+
+// Remove the segments of the store from the system; open handles stay valid
+extern void cm256_store_unlink(cm256_store* store);
+
+// Read the store parameters
+extern cm256_store_params cm256_store_get_params(cm256_store* store);
+
+/*
+ * Store a value of 'bytes' bytes in a slot, replacing the previous value.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_store_put(cm256_store* store, int slot, const void* data, int bytes);
+
+/*
+ * Read the value in a slot into 'data', which has 'maxBytes' bytes available.
+ *
+ * Returns the length of the value on success, and a negative code on failure.
+ */
+extern int cm256_store_get(cm256_store* store, int slot, void* data, int maxBytes);
+
+/*
+ * Simulate the loss of a failure domain: the segment is marked lost for all
+ * processes and its shared memory is released.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_store_drop_segment(cm256_store* store, int segment);
+
+/*
+ * Start rebuilding a lost segment on a background thread.
+ *
+ * Every slot is regenerated from the surviving segments using one cached
+ * matrix decomposition for the whole rebuild.  Reads and puts may continue
+ * while the rebuild runs.  Only one rebuild per handle may run at a time:
+ * this returns -1 until the previous one has been waited for.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_store_rebuild(cm256_store* store, int segment);
+
+// Wait for the background rebuild to finish.
+// Returns 0 if it succeeded, and any other code indicates failure.  A failed
+// rebuild leaves the segment lost, so it can be started again.
+extern int cm256_store_rebuild_wait(cm256_store* store);
+
+// Read the handle statistics
+extern void cm256_store_get_stats(cm256_store* store, cm256_store_stats* stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_STORE_H
@@ -0,0 +1,431 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cm256_stripe_cache.h"
+
+
+//-----------------------------------------------------------------------------
+// Dirty Stripe
+
+// Byte range [Start, End) within a stripe
+struct DirtyRange
+{
+    int Start;
+    int End;
+};
+
+struct DirtyStripe
+{
+    // Buffered stripe data, valid only within the dirty ranges
+    uint8_t* Data;
+
+    // Sorted, non-overlapping dirty ranges
+    std::vector<DirtyRange> Ranges;
+    int DirtyBytes;
+
+    // When the stripe first became dirty
+    std::chrono::steady_clock::time_point Since;
+
+    // Mark [start, end) dirty, merging with overlapping or adjacent ranges
+    void AddRange(int start, int end);
+};
+
+void DirtyStripe::AddRange(int start, int end)
+{
+    std::vector<DirtyRange> merged;
+    merged.reserve(Ranges.size() + 1);
+
+    size_t i = 0;
+    while (i < Ranges.size() && Ranges[i].End < start)
+    {
+        merged.push_back(Ranges[i++]);
+    }
+    while (i < Ranges.size() && Ranges[i].Start <= end)
+    {
+        if (Ranges[i].Start < start)
+        {
+            start = Ranges[i].Start;
+        }
+        if (Ranges[i].End > end)
+        {
+            end = Ranges[i].End;
+        }
+        ++i;
+    }
+    DirtyRange range = { start, end };
+    merged.push_back(range);
+    while (i < Ranges.size())
+    {
+        merged.push_back(Ranges[i++]);
+    }
+
+    Ranges.swap(merged);
+
+    DirtyBytes = 0;
+    for (size_t j = 0; j < Ranges.size(); ++j)
+    {
+        DirtyBytes += Ranges[j].End - Ranges[j].Start;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Stripe Cache
+
+struct cm256_stripe_cache_t
+{
+    cm256_volume* Volume;
+    cm256_volume_params VolumeParams;
+    cm256_encoder_params Codec;
+    cm256_stripe_cache_params Params;
+    int StripeBytes;
+
+    std::mutex Lock;
+    std::map<uint64_t, DirtyStripe> Stripes;
+
+    // Scratch for recovery units and old data
+    uint8_t* RecoveryData;
+    uint8_t* OldData;
+
+    // Flush timer
+    std::thread Timer;
+    std::condition_variable TimerCondition;
+    bool Stopping;
+
+    cm256_stripe_cache_stats Stats;
+
+    // Write one dirty stripe to the volume and forget it.  On failure the stripe
+    // stays dirty and is retried after another interval.  Caller holds the lock.
+    bool FlushStripe(std::map<uint64_t, DirtyStripe>::iterator it);
+
+    void TimerLoop();
+};
+
+bool cm256_stripe_cache_t::FlushStripe(std::map<uint64_t, DirtyStripe>::iterator it)
+{
+    const uint64_t stripe = it->first;
+    DirtyStripe& entry = it->second;
+    const int unit = VolumeParams.StripeUnit;
+    const uint64_t stripeOffset = stripe * StripeBytes;
+    bool success = true;
+
+    // Delta updates read the old data and every recovery unit for each dirty byte,
+    // while completing the stripe reads only the clean bytes
+    const int cleanBytes = StripeBytes - entry.DirtyBytes;
+    const int64_t deltaReadBytes = (int64_t)entry.DirtyBytes * (1 + VolumeParams.RecoveryCount);
+    uint64_t* counter;
+
+    if (cleanBytes == 0 || cleanBytes < deltaReadBytes)
+    {
+        if (cleanBytes > 0)
+        {
+            // Fill in the clean gaps from the volume
+            int position = 0;
+            for (size_t i = 0; i <= entry.Ranges.size() && success; ++i)
+            {
+                const int gapEnd = i < entry.Ranges.size() ? entry.Ranges[i].Start : StripeBytes;
+                if (gapEnd > position)
+                {
+                    success = cm256_volume_pread(Volume, entry.Data + position,
+                                                 gapEnd - position, stripeOffset + position) == 0;
+                }
+                if (i < entry.Ranges.size())
+                {
+                    position = entry.Ranges[i].End;
+                }
+            }
+            counter = &Stats.CompletedStripeFlushes;
+        }
+        else
+        {
+            counter = &Stats.FullStripeFlushes;
+        }
+
+        // Encode the whole stripe once
+        cm256_block originals[CM256_MAX_BLOCKS];
+        for (int i = 0; i < VolumeParams.OriginalCount; ++i)
+        {
+            originals[i].Block = entry.Data + (size_t)i * unit;
+        }
+        success = success &&
+                  cm256_encode(Codec, originals, RecoveryData) == 0 &&
+                  cm256_volume_write_stripes(Volume, stripe, 1, entry.Data, RecoveryData) == 0;
+    }
+    else
+    {
+        // Apply each dirty range column by column
+        for (size_t i = 0; i < entry.Ranges.size() && success; ++i)
+        {
+            int start = entry.Ranges[i].Start;
+            const int end = entry.Ranges[i].End;
+
+            while (start < end && success)
+            {
+                const int column = start / unit;
+                const int columnEnd = (column + 1) * unit < end ? (column + 1) * unit : end;
+                const int bytes = columnEnd - start;
+
+                success = cm256_volume_pread(Volume, OldData, bytes, stripeOffset + start) == 0 &&
+                          cm256_volume_write_delta(Volume, stripe, column, start - column * unit, bytes,
+                                                   OldData, entry.Data + start) == 0;
+                start = columnEnd;
+            }
+        }
+        counter = &Stats.DeltaStripeFlushes;
+    }
+
+    if (!success)
+    {
+        // Keep the only copy of the data.  Ranges already applied by a delta
+        // update read back as unchanged on the retry and cost nothing.
+        ++Stats.FlushErrors;
+        entry.Since = std::chrono::steady_clock::now();
+        return false;
+    }
+
+    ++*counter;
+    delete[] entry.Data;
+    Stripes.erase(it);
+    return true;
+}
+
+void cm256_stripe_cache_t::TimerLoop()
+{
+    const std::chrono::milliseconds interval(Params.FlushIntervalMsec);
+
+    // Half the interval rounds down to nothing at 1 ms, which would spin
+    const std::chrono::milliseconds wait = std::max(interval / 2, std::chrono::milliseconds(1));
+
+    std::unique_lock<std::mutex> locker(Lock);
+    while (!Stopping)
+    {
+        TimerCondition.wait_for(locker, wait);
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (std::map<uint64_t, DirtyStripe>::iterator it = Stripes.begin(); it != Stripes.end();)
+        {
+            std::map<uint64_t, DirtyStripe>::iterator next = it;
+            ++next;
+            if (now - it->second.Since >= interval && FlushStripe(it))
+            {
+                ++Stats.TimerFlushes;
+            }
+            it = next;
+        }
+    }
+}
+
+extern "C" cm256_stripe_cache* cm256_stripe_cache_create(cm256_volume* volume, cm256_stripe_cache_params params)
+{
+    if (!volume || params.MaxDirtyStripes <= 0 || params.FlushIntervalMsec < 0)
+    {
+        return nullptr;
+    }
+
+    cm256_stripe_cache* cache = new cm256_stripe_cache;
+    cache->Volume = volume;
+    cache->VolumeParams = cm256_volume_get_params(volume);
+    cache->Codec.OriginalCount = cache->VolumeParams.OriginalCount;
+    cache->Codec.RecoveryCount = cache->VolumeParams.RecoveryCount;
+    cache->Codec.BlockBytes = cache->VolumeParams.StripeUnit;
+    cache->Params = params;
+    cache->StripeBytes = cache->VolumeParams.StripeUnit * cache->VolumeParams.OriginalCount;
+    cache->RecoveryData = new uint8_t[(size_t)cache->VolumeParams.StripeUnit * (cache->VolumeParams.RecoveryCount + 1)];
+    cache->OldData = cache->RecoveryData + (size_t)cache->VolumeParams.StripeUnit * cache->VolumeParams.RecoveryCount;
+    cache->Stopping = false;
+    memset(&cache->Stats, 0, sizeof(cache->Stats));
+
+    if (params.FlushIntervalMsec > 0)
+    {
+        cache->Timer = std::thread(&cm256_stripe_cache_t::TimerLoop, cache);
+    }
+
+    return cache;
+}
+
+extern "C" void cm256_stripe_cache_destroy(cm256_stripe_cache* cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> locker(cache->Lock);
+        cache->Stopping = true;
+    }
+    cache->TimerCondition.notify_all();
+    if (cache->Timer.joinable())
+    {
+        cache->Timer.join();
+    }
+
+    cm256_stripe_cache_flush(cache);
+
+    // Stripes that still cannot be written are dropped
+    for (std::map<uint64_t, DirtyStripe>::iterator it = cache->Stripes.begin(); it != cache->Stripes.end(); ++it)
+    {
+        delete[] it->second.Data;
+    }
+
+    delete[] cache->RecoveryData;
+    delete cache;
+}
+
+extern "C" int cm256_stripe_cache_write(cm256_stripe_cache* cache, const void* data, uint64_t bytes, uint64_t offset)
+{
+    const uint64_t volumeBytes = cm256_volume_size(cache->Volume);
+    if (!data || offset > volumeBytes || bytes > volumeBytes - offset)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> locker(cache->Lock);
+    const uint8_t* input = static_cast<const uint8_t*>(data);
+
+    cache->Stats.UserWriteBytes += bytes;
+
+    while (bytes > 0)
+    {
+        const uint64_t stripe = offset / cache->StripeBytes;
+        const int stripeOffset = static_cast<int>(offset % cache->StripeBytes);
+        const int stripeBytes = (uint64_t)(cache->StripeBytes - stripeOffset) < bytes ?
+            cache->StripeBytes - stripeOffset : static_cast<int>(bytes);
+
+        std::map<uint64_t, DirtyStripe>::iterator it = cache->Stripes.find(stripe);
+        if (it == cache->Stripes.end())
+        {
+            DirtyStripe entry;
+            entry.Data = new uint8_t[cache->StripeBytes];
+            entry.DirtyBytes = 0;
+            entry.Since = std::chrono::steady_clock::now();
+            it = cache->Stripes.insert(std::make_pair(stripe, entry)).first;
+        }
+
+        memcpy(it->second.Data + stripeOffset, input, stripeBytes);
+        it->second.AddRange(stripeOffset, stripeOffset + stripeBytes);
+
+        input += stripeBytes;
+        offset += stripeBytes;
+        bytes -= stripeBytes;
+    }
+
+    // Flush the oldest stripes under memory pressure.  A failed stripe stays
+    // buffered and the cache may run over the limit until the volume recovers.
+    while ((int)cache->Stripes.size() > cache->Params.MaxDirtyStripes)
+    {
+        std::map<uint64_t, DirtyStripe>::iterator oldest = cache->Stripes.begin();
+        for (std::map<uint64_t, DirtyStripe>::iterator it = cache->Stripes.begin(); it != cache->Stripes.end(); ++it)
+        {
+            if (it->second.Since < oldest->second.Since)
+            {
+                oldest = it;
+            }
+        }
+
+        if (!cache->FlushStripe(oldest))
+        {
+            return -2;
+        }
+        ++cache->Stats.PressureFlushes;
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_stripe_cache_read(cm256_stripe_cache* cache, void* data, uint64_t bytes, uint64_t offset)
+{
+    std::lock_guard<std::mutex> locker(cache->Lock);
+
+    if (cm256_volume_pread(cache->Volume, data, bytes, offset))
+    {
+        return -1;
+    }
+
+    // Overlay buffered writes
+    uint8_t* output = static_cast<uint8_t*>(data);
+    const uint64_t end = offset + bytes;
+
+    std::map<uint64_t, DirtyStripe>::iterator it = cache->Stripes.lower_bound(offset / cache->StripeBytes);
+    for (; it != cache->Stripes.end() && it->first * cache->StripeBytes < end; ++it)
+    {
+        const uint64_t stripeOffset = it->first * cache->StripeBytes;
+
+        for (size_t i = 0; i < it->second.Ranges.size(); ++i)
+        {
+            uint64_t start = stripeOffset + it->second.Ranges[i].Start;
+            uint64_t stop = stripeOffset + it->second.Ranges[i].End;
+            if (start < offset)
+            {
+                start = offset;
+            }
+            if (stop > end)
+            {
+                stop = end;
+            }
+            if (start < stop)
+            {
+                memcpy(output + (start - offset), it->second.Data + (start - stripeOffset), (size_t)(stop - start));
+            }
+        }
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_stripe_cache_flush(cm256_stripe_cache* cache)
+{
+    std::lock_guard<std::mutex> locker(cache->Lock);
+
+    int result = 0;
+    for (std::map<uint64_t, DirtyStripe>::iterator it = cache->Stripes.begin(); it != cache->Stripes.end();)
+    {
+        std::map<uint64_t, DirtyStripe>::iterator next = it;
+        ++next;
+        if (!cache->FlushStripe(it))
+        {
+            result = -2;
+        }
+        it = next;
+    }
+    return result;
+}
+
+extern "C" void cm256_stripe_cache_get_stats(cm256_stripe_cache* cache, cm256_stripe_cache_stats* stats)
+{
+    std::lock_guard<std::mutex> locker(cache->Lock);
+    *stats = cache->Stats;
+}
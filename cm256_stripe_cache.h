@@ -0,0 +1,131 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_STRIPE_CACHE_H
+#define CM256_STRIPE_CACHE_H
+
+#include "cm256_volume.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Write-Back Stripe Cache
+
+    Small writes to an erasure-coded volume each cost a read-modify-write of
+    the recovery units.  The stripe cache buffers writes per stripe and only
+    touches the volume when a stripe is flushed:
+
+    + Stripes that were completely overwritten are encoded once with
+      cm256_encode() and written as a whole.
+
+    + Stripes that are mostly dirty are completed by reading the clean
+      ranges, and then encoded and written as a whole.
+
+    + Otherwise each dirty range is applied with a delta update, which adds
+      the change in data multiplied by each column's Cauchy coefficient to
+      the recovery units.
+
+    Stripes are flushed when more than MaxDirtyStripes are buffered (oldest
+    first), when they have been dirty for FlushIntervalMsec, or on request.
+
+    Reads through the cache see buffered writes.  Calls are thread-safe.
+*/
+
+// Cache parameters
+typedef struct cm256_stripe_cache_params_t {
+    // Flush the oldest stripes once more than this many are dirty
+    int MaxDirtyStripes;
+
+    // Flush stripes that have been dirty for this long, or 0 to disable the timer
+    int FlushIntervalMsec;
+} cm256_stripe_cache_params;
+
+// Cache statistics
+typedef struct cm256_stripe_cache_stats_t {
+    // Bytes written by the user
+    uint64_t UserWriteBytes;
+
+    // Stripes flushed by how they were written to the volume
+    uint64_t FullStripeFlushes;
+    uint64_t CompletedStripeFlushes;
+    uint64_t DeltaStripeFlushes;
+
+    // Flushes by trigger
+    uint64_t PressureFlushes;
+    uint64_t TimerFlushes;
+
+    // Flushes that failed, leaving the stripe dirty to be retried
+    uint64_t FlushErrors;
+} cm256_stripe_cache_stats;
+
+typedef struct cm256_stripe_cache_t cm256_stripe_cache;
+
+// Create a cache in front of a volume, which must outlive it.
+// Returns nullptr on failure.
+extern cm256_stripe_cache* cm256_stripe_cache_create(cm256_volume* volume, cm256_stripe_cache_params params);
+
+// Flush all dirty stripes and free the cache.  Stripes that still cannot be
+// written are dropped, so call cm256_stripe_cache_flush() first to check.
+extern void cm256_stripe_cache_destroy(cm256_stripe_cache* cache);
+
+/*
+ * Buffer a write of 'bytes' bytes at 'offset'.
+ *
+ * Returns 0 on success, and any other code indicates failure.  The data is
+ * buffered even if a pressure flush fails.
+ */
+extern int cm256_stripe_cache_write(cm256_stripe_cache* cache, const void* data, uint64_t bytes, uint64_t offset);
+
+/*
+ * Read 'bytes' bytes at 'offset', including buffered writes.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_stripe_cache_read(cm256_stripe_cache* cache, void* data, uint64_t bytes, uint64_t offset);
+
+/*
+ * Write all dirty stripes to the volume, retrying any that failed to flush
+ * earlier.  Stripes that fail stay dirty.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_stripe_cache_flush(cm256_stripe_cache* cache);
+
+// Read the cache statistics
+extern void cm256_stripe_cache_get_stats(cm256_stripe_cache* cache, cm256_stripe_cache_stats* stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_STRIPE_CACHE_H
@@ -0,0 +1,719 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mutex>
+
+#include "cm256_volume.h"
+
+
+//-----------------------------------------------------------------------------
+// Volume
+
+struct cm256_volume_t
+{
+    cm256_volume_params Params;
+    cm256_encoder_params Codec;
+    int DeviceCount;
+    uint64_t StripeBytes;
+
+    // File descriptor for each device, or -1 if the device failed
+    int Devices[CM256_MAX_BLOCKS];
+    int FailedCount;
+
+    // Serializes all operations
+    std::mutex Lock;
+
+    // Scratch space: data units, recovery units and one spare unit
+    uint8_t* StripeData;
+    uint8_t* RecoveryData;
+    uint8_t* SpareUnit;
+
+    // Decoders cached by stripe rotation, reset whenever a device fails
+    cm256_decoder* Decoders[CM256_MAX_BLOCKS];
+
+    cm256_volume_stats Stats;
+
+    // Device holding a column of a stripe
+    int GetDevice(uint64_t stripe, int column) const
+    {
+        return static_cast<int>((column + stripe) % DeviceCount);
+    }
+
+    bool IsColumnHealthy(uint64_t stripe, int column) const
+    {
+        return Devices[GetDevice(stripe, column)] >= 0;
+    }
+
+    void FailDevice(int device);
+
+    bool ReadUnit(uint64_t stripe, int column, void* data, int bytes, int offset);
+    bool WriteUnit(uint64_t stripe, int column, const void* data, int bytes, int offset);
+
+    // Read [offset, offset + bytes) of every data column into StripeData,
+    // decoding the columns stored on failed devices
+    bool ReadStripeColumns(uint64_t stripe, int offset, int bytes);
+
+    // Write all data and recovery units of a stripe from the given buffers
+    bool WriteFullStripe(uint64_t stripe, const uint8_t* data, const uint8_t* recovery);
+
+    // Update [stripeOffset, stripeOffset + bytes) of one stripe
+    bool WriteStripe(uint64_t stripe, const uint8_t* data, int stripeOffset, int bytes);
+
+    // Update one data column range given its old contents
+    bool WriteDelta(uint64_t stripe, int column, int offset, int bytes,
+                    uint8_t* delta, const uint8_t* newData);
+};
+
+void cm256_volume_t::FailDevice(int device)
+{
+    if (Devices[device] < 0)
+    {
+        return;
+    }
+
+    close(Devices[device]);
+    Devices[device] = -1;
+    ++FailedCount;
+
+    // Erasure patterns changed
+    for (int i = 0; i < DeviceCount; ++i)
+    {
+        cm256_decoder_free(Decoders[i]);
+        Decoders[i] = nullptr;
+    }
+}
+
+bool cm256_volume_t::ReadUnit(uint64_t stripe, int column, void* data, int bytes, int offset)
+{
+    const int device = GetDevice(stripe, column);
+    uint8_t* output = static_cast<uint8_t*>(data);
+    off_t position = static_cast<off_t>(stripe * Params.StripeUnit + offset);
+
+    while (bytes > 0)
+    {
+        if (Devices[device] < 0)
+        {
+            return false;
+        }
+
+        const ssize_t result = pread(Devices[device], output, bytes, position);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result < 0)
+        {
+            FailDevice(device);
+            return false;
+        }
+        if (result == 0)
+        {
+            // Reading past the end of a short file returns zeroes
+            memset(output, 0, bytes);
+            return true;
+        }
+
+        Stats.DeviceReadBytes += result;
+        output += result;
+        position += result;
+        bytes -= static_cast<int>(result);
+    }
+
+    return true;
+}
+
+bool cm256_volume_t::WriteUnit(uint64_t stripe, int column, const void* data, int bytes, int offset)
+{
+    const int device = GetDevice(stripe, column);
+    const uint8_t* input = static_cast<const uint8_t*>(data);
+    off_t position = static_cast<off_t>(stripe * Params.StripeUnit + offset);
+
+    while (bytes > 0)
+    {
+        if (Devices[device] < 0)
+        {
+            // Writes to failed devices are dropped
+            return true;
+        }
+
+        const ssize_t result = pwrite(Devices[device], input, bytes, position);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            FailDevice(device);
+            return FailedCount <= Params.RecoveryCount;
+        }
+
+        Stats.DeviceWriteBytes += result;
+        input += result;
+        position += result;
+        bytes -= static_cast<int>(result);
+    }
+
+    return true;
+}
+
+bool cm256_volume_t::ReadStripeColumns(uint64_t stripe, int offset, int bytes)
+{
+    const int originalCount = Params.OriginalCount;
+    const int unit = Params.StripeUnit;
+
+    for (;;)
+    {
+        // Pick the healthy data columns and fill the rest with recovery columns
+        cm256_block blocks[CM256_MAX_BLOCKS];
+        uint8_t indices[CM256_MAX_BLOCKS];
+        int nextRecovery = originalCount;
+        int recoveryUsed = 0;
+        bool success = true;
+
+        for (int column = 0; column < originalCount && success; ++column)
+        {
+            uint8_t* target = StripeData + (size_t)column * unit + offset;
+
+            if (IsColumnHealthy(stripe, column))
+            {
+                blocks[column].Block = target;
+                blocks[column].Index = static_cast<uint8_t>(column);
+                success = ReadUnit(stripe, column, target, bytes, offset);
+                continue;
+            }
+
+            while (nextRecovery < DeviceCount && !IsColumnHealthy(stripe, nextRecovery))
+            {
+                ++nextRecovery;
+            }
+            if (nextRecovery >= DeviceCount)
+            {
+                return false;
+            }
+
+            uint8_t* recovery = RecoveryData + (size_t)recoveryUsed++ * unit + offset;
+            blocks[column].Block = recovery;
+            blocks[column].Index = static_cast<uint8_t>(nextRecovery);
+            success = ReadUnit(stripe, nextRecovery++, recovery, bytes, offset);
+        }
+
+        if (!success)
+        {
+            // A device failed during the read, so try again with the new pattern
+            if (FailedCount > Params.RecoveryCount)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        if (recoveryUsed == 0)
+        {
+            return true;
+        }
+
+        ++Stats.DegradedReads;
+
+        // The erasure pattern only depends on the rotation of the stripe
+        const int rotation = static_cast<int>(stripe % DeviceCount);
+        if (!Decoders[rotation])
+        {
+            for (int i = 0; i < originalCount; ++i)
+            {
+                indices[i] = blocks[i].Index;
+            }
+            Decoders[rotation] = cm256_decoder_create(Codec, indices);
+            if (!Decoders[rotation])
+            {
+                return false;
+            }
+        }
+
+        // Decode only the requested range, relative to the block pointers
+        for (int i = 0; i < originalCount; ++i)
+        {
+            blocks[i].Block = static_cast<uint8_t*>(blocks[i].Block) - offset;
+        }
+        if (cm256_decoder_decode_range(Decoders[rotation], blocks, offset, bytes))
+        {
+            return false;
+        }
+
+        // Recovery blocks hold the erased columns in increasing order
+        for (int column = 0, i = 0; column < originalCount; ++column)
+        {
+            if (blocks[column].Index < originalCount)
+            {
+                continue;
+            }
+
+            // Find the next erased column
+            while (IsColumnHealthy(stripe, i))
+            {
+                ++i;
+            }
+            memcpy(StripeData + (size_t)i * unit + offset,
+                   static_cast<uint8_t*>(blocks[column].Block) + offset, bytes);
+            ++i;
+        }
+
+        return true;
+    }
+}
+
+bool cm256_volume_t::WriteFullStripe(uint64_t stripe, const uint8_t* data, const uint8_t* recovery)
+{
+    const int unit = Params.StripeUnit;
+
+    for (int column = 0; column < DeviceCount; ++column)
+    {
+        const uint8_t* source = column < Params.OriginalCount ?
+            data + (size_t)column * unit :
+            recovery + (size_t)(column - Params.OriginalCount) * unit;
+
+        if (!WriteUnit(stripe, column, source, unit, 0))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool cm256_volume_t::WriteDelta(uint64_t stripe, int column, int offset, int bytes,
+                                uint8_t* delta, const uint8_t* newData)
+{
+    // delta = old + new
+    gf256_add_mem(delta, newData, bytes);
+
+    if (!WriteUnit(stripe, column, newData, bytes, offset))
+    {
+        return false;
+    }
+
+    // recovery += coefficient * delta
+    for (int row = Params.OriginalCount; row < DeviceCount; ++row)
+    {
+        if (!IsColumnHealthy(stripe, row))
+        {
+            continue;
+        }
+
+        uint8_t* recovery = RecoveryData;
+        if (!ReadUnit(stripe, row, recovery, bytes, offset))
+        {
+            if (FailedCount > Params.RecoveryCount)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        gf256_muladd_mem(recovery, cm256_get_recovery_coefficient(Codec, row, column), delta, bytes);
+
+        if (!WriteUnit(stripe, row, recovery, bytes, offset))
+        {
+            return false;
+        }
+    }
+
+    ++Stats.DeltaWrites;
+    return true;
+}
+
+bool cm256_volume_t::WriteStripe(uint64_t stripe, const uint8_t* data, int stripeOffset, int bytes)
+{
+    const int originalCount = Params.OriginalCount;
+    const int unit = Params.StripeUnit;
+
+    // Whole stripe: encode straight from the caller's data
+    if (stripeOffset == 0 && bytes == (int)StripeBytes)
+    {
+        cm256_block originals[CM256_MAX_BLOCKS];
+        for (int i = 0; i < originalCount; ++i)
+        {
+            originals[i].Block = const_cast<uint8_t*>(data + (size_t)i * unit);
+        }
+        if (cm256_encode(Codec, originals, RecoveryData))
+        {
+            return false;
+        }
+
+        ++Stats.FullStripeWrites;
+        return WriteFullStripe(stripe, data, RecoveryData);
+    }
+
+    const int firstColumn = stripeOffset / unit;
+    const int lastColumn = (stripeOffset + bytes - 1) / unit;
+
+    bool healthy = true;
+    for (int column = 0; column < DeviceCount; ++column)
+    {
+        healthy &= IsColumnHealthy(stripe, column);
+    }
+
+    // Delta update reads the old data and each recovery unit for the columns written,
+    // while reconstruct-write reads the whole stripe of data
+    const uint64_t deltaReadBytes = (uint64_t)bytes * (1 + Params.RecoveryCount);
+    const uint64_t reconstructReadBytes = StripeBytes;
+
+    if (healthy && deltaReadBytes <= reconstructReadBytes)
+    {
+        for (int column = firstColumn; column <= lastColumn; ++column)
+        {
+            const int columnStart = column * unit;
+            const int start = stripeOffset > columnStart ? stripeOffset : columnStart;
+            const int end = (stripeOffset + bytes < columnStart + unit) ? stripeOffset + bytes : columnStart + unit;
+
+            if (!ReadUnit(stripe, column, SpareUnit, end - start, start - columnStart))
+            {
+                // Device failed, so fall back to reconstruct-write for the remainder
+                healthy = false;
+                break;
+            }
+
+            if (!WriteDelta(stripe, column, start - columnStart, end - start,
+                            SpareUnit, data + (start - stripeOffset)))
+            {
+                return false;
+            }
+        }
+
+        if (healthy)
+        {
+            return true;
+        }
+    }
+
+    // Reconstruct-write: read the stripe, patch it and encode it again.
+    // This also covers degraded stripes, where old data may not be readable.
+    if (!ReadStripeColumns(stripe, 0, unit))
+    {
+        return false;
+    }
+    memcpy(StripeData + stripeOffset, data, bytes);
+
+    cm256_block originals[CM256_MAX_BLOCKS];
+    for (int i = 0; i < originalCount; ++i)
+    {
+        originals[i].Block = StripeData + (size_t)i * unit;
+    }
+    if (cm256_encode(Codec, originals, RecoveryData))
+    {
+        return false;
+    }
+
+    for (int column = firstColumn; column <= lastColumn; ++column)
+    {
+        if (!WriteUnit(stripe, column, StripeData + (size_t)column * unit, unit, 0))
+        {
+            return false;
+        }
+    }
+    for (int row = 0; row < Params.RecoveryCount; ++row)
+    {
+        if (!WriteUnit(stripe, originalCount + row, RecoveryData + (size_t)row * unit, unit, 0))
+        {
+            return false;
+        }
+    }
+
+    ++Stats.ReconstructWrites;
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// API
+
+extern "C" cm256_volume* cm256_volume_open(
+    const char* const* paths,
+    cm256_volume_params params,
+    int create)
+{
+    if (!paths ||
+        params.OriginalCount <= 0 ||
+        params.RecoveryCount <= 0 ||
+        params.OriginalCount + params.RecoveryCount > CM256_MAX_BLOCKS ||
+        params.StripeUnit <= 0 ||
+        (uint64_t)params.StripeUnit * params.OriginalCount > 0x7fffffff ||
+        cm256_init())
+    {
+        return nullptr;
+    }
+
+    cm256_volume* volume = new cm256_volume;
+    volume->Params = params;
+    volume->Codec.OriginalCount = params.OriginalCount;
+    volume->Codec.RecoveryCount = params.RecoveryCount;
+    volume->Codec.BlockBytes = params.StripeUnit;
+    volume->DeviceCount = params.OriginalCount + params.RecoveryCount;
+    volume->StripeBytes = (uint64_t)params.StripeUnit * params.OriginalCount;
+    volume->FailedCount = 0;
+    memset(&volume->Stats, 0, sizeof(volume->Stats));
+
+    const size_t unit = params.StripeUnit;
+    volume->StripeData = new uint8_t[unit * (volume->DeviceCount + 1)];
+    volume->RecoveryData = volume->StripeData + unit * params.OriginalCount;
+    volume->SpareUnit = volume->RecoveryData + unit * params.RecoveryCount;
+
+    for (int i = 0; i < CM256_MAX_BLOCKS; ++i)
+    {
+        volume->Devices[i] = -1;
+        volume->Decoders[i] = nullptr;
+    }
+
+    const off_t deviceBytes = static_cast<off_t>(params.StripeCount * params.StripeUnit);
+
+    for (int i = 0; i < volume->DeviceCount; ++i)
+    {
+        int fd = open(paths[i], O_RDWR | (create ? O_CREAT : 0), 0644);
+
+        struct stat info;
+        if (fd >= 0 && create && fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+            info.st_size < deviceBytes && ftruncate(fd, deviceBytes) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+
+        volume->Devices[i] = fd;
+        if (fd < 0)
+        {
+            ++volume->FailedCount;
+        }
+    }
+
+    if (volume->FailedCount > params.RecoveryCount)
+    {
+        cm256_volume_close(volume);
+        return nullptr;
+    }
+
+    return volume;
+}
+
+extern "C" void cm256_volume_close(cm256_volume* volume)
+{
+    if (!volume)
+    {
+        return;
+    }
+
+    for (int i = 0; i < volume->DeviceCount; ++i)
+    {
+        if (volume->Devices[i] >= 0)
+        {
+            close(volume->Devices[i]);
+        }
+        cm256_decoder_free(volume->Decoders[i]);
+    }
+    delete[] volume->StripeData;
+    delete volume;
+}
+
+extern "C" uint64_t cm256_volume_size(cm256_volume* volume)
+{
+    return volume->StripeBytes * volume->Params.StripeCount;
+}
+
+extern "C" cm256_volume_params cm256_volume_get_params(cm256_volume* volume)
+{
+    return volume->Params;
+}
+
+extern "C" int cm256_volume_pread(cm256_volume* volume, void* data, uint64_t bytes, uint64_t offset)
+{
+    if (!data || offset > cm256_volume_size(volume) || bytes > cm256_volume_size(volume) - offset)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> locker(volume->Lock);
+    const int unit = volume->Params.StripeUnit;
+    uint8_t* output = static_cast<uint8_t*>(data);
+
+    volume->Stats.UserReadBytes += bytes;
+
+    while (bytes > 0)
+    {
+        const uint64_t stripe = offset / volume->StripeBytes;
+        const int stripeOffset = static_cast<int>(offset % volume->StripeBytes);
+        const int stripeBytes = (uint64_t)(volume->StripeBytes - stripeOffset) < bytes ?
+            static_cast<int>(volume->StripeBytes - stripeOffset) : static_cast<int>(bytes);
+
+        const int firstColumn = stripeOffset / unit;
+        const int lastColumn = (stripeOffset + stripeBytes - 1) / unit;
+
+        // Read directly from healthy devices
+        bool degraded = false;
+        for (int column = firstColumn; column <= lastColumn && !degraded; ++column)
+        {
+            const int columnStart = column * unit;
+            const int start = stripeOffset > columnStart ? stripeOffset : columnStart;
+            const int end = (stripeOffset + stripeBytes < columnStart + unit) ? stripeOffset + stripeBytes : columnStart + unit;
+
+            degraded = !volume->IsColumnHealthy(stripe, column) ||
+                       !volume->ReadUnit(stripe, column, output + (start - stripeOffset), end - start, start - columnStart);
+        }
+
+        if (degraded)
+        {
+            if (volume->FailedCount > volume->Params.RecoveryCount)
+            {
+                return -2;
+            }
+
+            // Decode the part of each column that was requested
+            const int rangeStart = lastColumn > firstColumn ? 0 : stripeOffset - firstColumn * unit;
+            const int rangeEnd = lastColumn > firstColumn ? unit : rangeStart + stripeBytes;
+            if (!volume->ReadStripeColumns(stripe, rangeStart, rangeEnd - rangeStart))
+            {
+                return -2;
+            }
+            memcpy(output, volume->StripeData + stripeOffset, stripeBytes);
+        }
+
+        output += stripeBytes;
+        offset += stripeBytes;
+        bytes -= stripeBytes;
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_volume_pwrite(cm256_volume* volume, const void* data, uint64_t bytes, uint64_t offset)
+{
+    if (!data || offset > cm256_volume_size(volume) || bytes > cm256_volume_size(volume) - offset)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> locker(volume->Lock);
+    const uint8_t* input = static_cast<const uint8_t*>(data);
+
+    volume->Stats.UserWriteBytes += bytes;
+
+    while (bytes > 0)
+    {
+        const uint64_t stripe = offset / volume->StripeBytes;
+        const int stripeOffset = static_cast<int>(offset % volume->StripeBytes);
+        const int stripeBytes = (uint64_t)(volume->StripeBytes - stripeOffset) < bytes ?
+            static_cast<int>(volume->StripeBytes - stripeOffset) : static_cast<int>(bytes);
+
+        if (!volume->WriteStripe(stripe, input, stripeOffset, stripeBytes))
+        {
+            return -2;
+        }
+
+        input += stripeBytes;
+        offset += stripeBytes;
+        bytes -= stripeBytes;
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_volume_write_stripes(cm256_volume* volume, uint64_t stripe, uint64_t stripeCount,
+                                          const void* data, const void* recovery)
+{
+    if (!data || !recovery ||
+        stripe > volume->Params.StripeCount || stripeCount > volume->Params.StripeCount - stripe)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> locker(volume->Lock);
+    const uint8_t* input = static_cast<const uint8_t*>(data);
+    const uint8_t* recoveryInput = static_cast<const uint8_t*>(recovery);
+    const size_t recoveryBytes = (size_t)volume->Params.StripeUnit * volume->Params.RecoveryCount;
+
+    for (uint64_t i = 0; i < stripeCount; ++i)
+    {
+        if (!volume->WriteFullStripe(stripe + i, input, recoveryInput))
+        {
+            return -2;
+        }
+
+        volume->Stats.UserWriteBytes += volume->StripeBytes;
+        ++volume->Stats.FullStripeWrites;
+        input += volume->StripeBytes;
+        recoveryInput += recoveryBytes;
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_volume_write_delta(cm256_volume* volume, uint64_t stripe, int column,
+                                        int offset, int bytes, const void* oldData, const void* newData)
+{
+    const int unit = volume->Params.StripeUnit;
+
+    if (!oldData || !newData || stripe >= volume->Params.StripeCount ||
+        column < 0 || column >= volume->Params.OriginalCount ||
+        offset < 0 || bytes < 0 || offset > unit || bytes > unit - offset)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> locker(volume->Lock);
+
+    volume->Stats.UserWriteBytes += bytes;
+
+    memcpy(volume->SpareUnit, oldData, bytes);
+    if (!volume->WriteDelta(stripe, column, offset, bytes, volume->SpareUnit,
+                            static_cast<const uint8_t*>(newData)))
+    {
+        return -2;
+    }
+
+    return 0;
+}
+
+extern "C" int cm256_volume_fail_device(cm256_volume* volume, int device)
+{
+    if (device < 0 || device >= volume->DeviceCount)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> locker(volume->Lock);
+    volume->FailDevice(device);
+    return 0;
+}
+
+extern "C" void cm256_volume_get_stats(cm256_volume* volume, cm256_volume_stats* stats)
+{
+    std::lock_guard<std::mutex> locker(volume->Lock);
+    *stats = volume->Stats;
+}
@@ -0,0 +1,177 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM256_VOLUME_H
+#define CM256_VOLUME_H
+
+#include "cm256.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Erasure-Coded Virtual Volume
+
+    A volume presents OriginalCount + RecoveryCount backing files (or block
+    devices) as one linear address space, like a software RAID with any
+    number of parity devices.
+
+    The address space is divided into stripes of OriginalCount * StripeUnit
+    bytes.  Each stripe stores one StripeUnit on every device, and the device
+    holding each column rotates from stripe to stripe so parity updates are
+    spread over all devices:
+
+        device = (column + stripe) % (OriginalCount + RecoveryCount)
+
+    Columns [0, OriginalCount) hold data and the remaining columns hold the
+    recovery units produced by cm256_encode().
+
+    Writes covering whole stripes are encoded directly.  Partial stripe
+    writes either update the recovery units in place with the difference
+    between the old and new data (multiplied by each column's Cauchy
+    coefficient), or read the rest of the stripe and re-encode it, whichever
+    reads fewer bytes.  Reads that touch a failed device decode the requested
+    byte range from the surviving devices.
+
+    Calls on one volume are serialized internally.
+*/
+
+// Volume parameters
+typedef struct cm256_volume_params_t {
+    // Number of data devices
+    int OriginalCount;
+
+    // Number of parity devices, OriginalCount + RecoveryCount <= CM256_MAX_BLOCKS
+    int RecoveryCount;
+
+    // Bytes stored on each device per stripe
+    int StripeUnit;
+
+    // Number of stripes in the volume
+    uint64_t StripeCount;
+} cm256_volume_params;
+
+// Volume statistics
+typedef struct cm256_volume_stats_t {
+    // Bytes requested by the user
+    uint64_t UserReadBytes;
+    uint64_t UserWriteBytes;
+
+    // Bytes transferred to and from the backing devices
+    uint64_t DeviceReadBytes;
+    uint64_t DeviceWriteBytes;
+
+    // Stripe updates by write strategy
+    uint64_t FullStripeWrites;
+    uint64_t DeltaWrites;
+    uint64_t ReconstructWrites;
+
+    // Stripe reads that had to decode
+    uint64_t DegradedReads;
+} cm256_volume_stats;
+
+typedef struct cm256_volume_t cm256_volume;
+
+/*
+ * Open a volume over OriginalCount + RecoveryCount backing paths.
+ *
+ * If 'create' is non-zero the files are created and sized as needed.
+ * Paths that cannot be opened are treated as failed devices, as long as at
+ * least OriginalCount of them are available.
+ *
+ * Returns nullptr on failure.
+ */
+extern cm256_volume* cm256_volume_open(
+    const char* const* paths,   // Array of OriginalCount + RecoveryCount paths
+    cm256_volume_params params, // Volume parameters
+    int create);                // Create the backing files if non-zero
+
+// Close the volume
+extern void cm256_volume_close(cm256_volume* volume);
+
+// Size of the volume in bytes
+extern uint64_t cm256_volume_size(cm256_volume* volume);
+
+// Read the volume parameters
+extern cm256_volume_params cm256_volume_get_params(cm256_volume* volume);
+
+/*
+ * Read 'bytes' bytes at 'offset' into 'data'.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_volume_pread(cm256_volume* volume, void* data, uint64_t bytes, uint64_t offset);
+
+/*
+ * Write 'bytes' bytes from 'data' at 'offset'.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_volume_pwrite(cm256_volume* volume, const void* data, uint64_t bytes, uint64_t offset);
+
+/*
+ * Write whole stripes that the caller has already encoded.
+ *
+ * 'stripe' is the first stripe and 'stripeCount' stripes are written.
+ * 'data' holds stripeCount * OriginalCount * StripeUnit bytes of volume data
+ * and 'recovery' holds the stripeCount * RecoveryCount recovery units,
+ * stripe by stripe, as produced by cm256_encode() with BlockBytes = StripeUnit.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_volume_write_stripes(cm256_volume* volume, uint64_t stripe, uint64_t stripeCount,
+                                      const void* data, const void* recovery);
+
+/*
+ * Apply a small write to one data column of a stripe by updating the
+ * recovery units with the change, given the old contents of the range.
+ *
+ * 'column' is the data column, [offset, offset + bytes) is the range within
+ * the StripeUnit, 'oldData' is what the range currently holds and 'newData'
+ * is what it should hold.  This avoids reading the old data from the device.
+ *
+ * Returns 0 on success, and any other code indicates failure.
+ */
+extern int cm256_volume_write_delta(cm256_volume* volume, uint64_t stripe, int column,
+                                    int offset, int bytes, const void* oldData, const void* newData);
+
+// Mark a device as failed, as if it returned an I/O error
+extern int cm256_volume_fail_device(cm256_volume* volume, int device);
+
+// Read the volume statistics
+extern void cm256_volume_get_stats(cm256_volume* volume, cm256_volume_stats* stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // CM256_VOLUME_H
@@ -313,8 +313,8 @@ extern "C" int gf256_init_(int version)
 //-----------------------------------------------------------------------------
 // Operations
 
-extern "C" void gf256_add_mem(void * GF256_RESTRICT vx,
-                              const void * GF256_RESTRICT vy, int bytes)
+static void simd_add_mem(void * GF256_RESTRICT vx,
+                         const void * GF256_RESTRICT vy, int bytes)
 {
     GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128*>(vx);
     const GF256_M128 * GF256_RESTRICT y16 = reinterpret_cast<const GF256_M128*>(vy);
@@ -397,8 +397,8 @@ extern "C" void gf256_add_mem(void * GF256_RESTRICT vx,
     }
 }
 
-extern "C" void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
-                               const void * GF256_RESTRICT vy, int bytes)
+static void simd_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                          const void * GF256_RESTRICT vy, int bytes)
 {
     GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128*>(vz);
     const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128*>(vx);
@@ -464,8 +464,8 @@ extern "C" void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_REST
     }
 }
 
-extern "C" void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
-                                 const void * GF256_RESTRICT vy, int bytes)
+static void simd_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                            const void * GF256_RESTRICT vy, int bytes)
 {
     GF256_M128 * GF256_RESTRICT z16 = reinterpret_cast<GF256_M128*>(vz);
     const GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<const GF256_M128*>(vx);
@@ -552,15 +552,113 @@ extern "C" void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RE
     }
 }
 
-extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
-                                 const void * GF256_RESTRICT vx, int bytes)
+// Prefetch distance for the multi-source XOR, in bytes ahead of the loads
+static const int kAddNPrefetchBytes = 256;
+
+// Sources summed per pass: more streams than this thrash the L1 cache and
+// the hardware prefetchers, so larger counts are split into several passes
+static const int kAddNBatch = 8;
+
+// z[] = (accumulate ? z[] : 0) + x_0[] + ... + x_(count-1)[]
+static GF256_FORCE_INLINE void gf256_add_n_mem_impl(void * GF256_RESTRICT vz, const void * const * vx,
+                                                    int count, int bytes, bool accumulate)
+{
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * const * x1 = reinterpret_cast<const uint8_t * const *>(vx);
+    const int first = accumulate ? 0 : 1;
+    int offset = 0;
+
+    // Handle multiples of 64 bytes: sum every source into registers, then store once
+    for (; offset + 64 <= bytes; offset += 64)
+    {
+        const uint8_t * start = accumulate ? z1 + offset : x1[0] + offset;
+        GF256_M128 s0 = _mm_loadu_si128(reinterpret_cast<const GF256_M128*>(start));
+        GF256_M128 s1 = _mm_loadu_si128(reinterpret_cast<const GF256_M128*>(start + 16));
+        GF256_M128 s2 = _mm_loadu_si128(reinterpret_cast<const GF256_M128*>(start + 32));
+        GF256_M128 s3 = _mm_loadu_si128(reinterpret_cast<const GF256_M128*>(start + 48));
+
+        for (int i = first; i < count; ++i)
+        {
+            const GF256_M128 * x16 = reinterpret_cast<const GF256_M128*>(x1[i] + offset);
+            GF256_PREFETCH(x1[i] + offset + kAddNPrefetchBytes);
+
+            s0 = _mm_xor_si128(s0, _mm_loadu_si128(x16));
+            s1 = _mm_xor_si128(s1, _mm_loadu_si128(x16 + 1));
+            s2 = _mm_xor_si128(s2, _mm_loadu_si128(x16 + 2));
+            s3 = _mm_xor_si128(s3, _mm_loadu_si128(x16 + 3));
+        }
+
+        GF256_M128 * z16 = reinterpret_cast<GF256_M128*>(z1 + offset);
+        _mm_storeu_si128(z16, s0);
+        _mm_storeu_si128(z16 + 1, s1);
+        _mm_storeu_si128(z16 + 2, s2);
+        _mm_storeu_si128(z16 + 3, s3);
+    }
+
+    // Handle multiples of 16 bytes
+    for (; offset + 16 <= bytes; offset += 16)
+    {
+        const uint8_t * start = accumulate ? z1 + offset : x1[0] + offset;
+        GF256_M128 s0 = _mm_loadu_si128(reinterpret_cast<const GF256_M128*>(start));
+
+        for (int i = first; i < count; ++i)
+        {
+            s0 = _mm_xor_si128(s0, _mm_loadu_si128(reinterpret_cast<const GF256_M128*>(x1[i] + offset)));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<GF256_M128*>(z1 + offset), s0);
+    }
+
+    // Handle final bytes
+    for (; offset < bytes; ++offset)
+    {
+        uint8_t s = accumulate ? z1[offset] : x1[0][offset];
+
+        for (int i = first; i < count; ++i)
+        {
+            s ^= x1[i][offset];
+        }
+
+        z1[offset] = s;
+    }
+}
+
+static void simd_addset_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                              int count, int bytes)
+{
+    if (count <= 0)
+    {
+        memset(vz, 0, bytes);
+        return;
+    }
+
+    // First pass sets z, later passes accumulate into it
+    for (int i = 0; i < count; i += kAddNBatch)
+    {
+        const int batch = (count - i < kAddNBatch) ? count - i : kAddNBatch;
+        gf256_add_n_mem_impl(vz, vx + i, batch, bytes, i > 0);
+    }
+}
+
+static void simd_add_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                           int count, int bytes)
+{
+    for (int i = 0; i < count; i += kAddNBatch)
+    {
+        const int batch = (count - i < kAddNBatch) ? count - i : kAddNBatch;
+        gf256_add_n_mem_impl(vz, vx + i, batch, bytes, true);
+    }
+}
+
+static void simd_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
+                            const void * GF256_RESTRICT vx, int bytes)
 {
     // Use a single if-statement to handle special cases
     if (y <= 1)
     {
         if (y == 1)
         {
-            gf256_add_mem(vz, vx, bytes);
+            simd_add_mem(vz, vx, bytes);
         }
         return;
     }
@@ -641,7 +739,7 @@ extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
     }
 }
 
-extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+static void simd_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
 {
     // Use a single if-statement to handle special cases
     if (y <= 1)
@@ -727,6 +825,317 @@ extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTR
     }
 }
 
+extern "C" const gf256_kernels gf256_native_kernels = {
+#if defined(USE_NEON)
+    "neon",
+#else
+    "ssse3",
+#endif
+    nullptr,
+    simd_add_mem,
+    simd_add2_mem,
+    simd_addset_mem,
+    simd_add_n_mem,
+    simd_addset_n_mem,
+    simd_muladd_mem,
+    simd_mul_mem
+};
+
+#if defined(GF256_HAS_AVX2)
+
+//-----------------------------------------------------------------------------
+// AVX2 Operations
+//
+// Same algorithms as above on 32-byte registers.  The tables are the SSSE3
+// ones broadcast to both lanes, since _mm256_shuffle_epi8 looks up within
+// each 128-bit lane.  Tails shorter than a register use the SSSE3 kernels.
+
+#define GF256_AVX2 __attribute__((target("avx2")))
+
+static int avx2_supported()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static GF256_AVX2 void avx2_add_mem(void * GF256_RESTRICT vx,
+                                    const void * GF256_RESTRICT vy, int bytes)
+{
+    __m256i * GF256_RESTRICT x32 = reinterpret_cast<__m256i *>(vx);
+    const __m256i * GF256_RESTRICT y32 = reinterpret_cast<const __m256i *>(vy);
+
+    // Handle multiples of 128 bytes
+    while (bytes >= 128)
+    {
+        const __m256i x0 = _mm256_xor_si256(_mm256_loadu_si256(x32), _mm256_loadu_si256(y32));
+        const __m256i x1 = _mm256_xor_si256(_mm256_loadu_si256(x32 + 1), _mm256_loadu_si256(y32 + 1));
+        const __m256i x2 = _mm256_xor_si256(_mm256_loadu_si256(x32 + 2), _mm256_loadu_si256(y32 + 2));
+        const __m256i x3 = _mm256_xor_si256(_mm256_loadu_si256(x32 + 3), _mm256_loadu_si256(y32 + 3));
+
+        _mm256_storeu_si256(x32, x0);
+        _mm256_storeu_si256(x32 + 1, x1);
+        _mm256_storeu_si256(x32 + 2, x2);
+        _mm256_storeu_si256(x32 + 3, x3);
+
+        x32 += 4;
+        y32 += 4;
+        bytes -= 128;
+    }
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        _mm256_storeu_si256(x32, _mm256_xor_si256(_mm256_loadu_si256(x32), _mm256_loadu_si256(y32)));
+
+        x32++;
+        y32++;
+        bytes -= 32;
+    }
+
+    simd_add_mem(x32, y32, bytes);
+}
+
+static GF256_AVX2 void avx2_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                     const void * GF256_RESTRICT vy, int bytes)
+{
+    __m256i * GF256_RESTRICT z32 = reinterpret_cast<__m256i *>(vz);
+    const __m256i * GF256_RESTRICT x32 = reinterpret_cast<const __m256i *>(vx);
+    const __m256i * GF256_RESTRICT y32 = reinterpret_cast<const __m256i *>(vy);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        const __m256i z0 = _mm256_xor_si256(_mm256_loadu_si256(z32),
+            _mm256_xor_si256(_mm256_loadu_si256(x32), _mm256_loadu_si256(y32)));
+        const __m256i z1 = _mm256_xor_si256(_mm256_loadu_si256(z32 + 1),
+            _mm256_xor_si256(_mm256_loadu_si256(x32 + 1), _mm256_loadu_si256(y32 + 1)));
+
+        _mm256_storeu_si256(z32, z0);
+        _mm256_storeu_si256(z32 + 1, z1);
+
+        x32 += 2;
+        y32 += 2;
+        z32 += 2;
+        bytes -= 64;
+    }
+
+    simd_add2_mem(z32, x32, y32, bytes);
+}
+
+static GF256_AVX2 void avx2_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                       const void * GF256_RESTRICT vy, int bytes)
+{
+    __m256i * GF256_RESTRICT z32 = reinterpret_cast<__m256i *>(vz);
+    const __m256i * GF256_RESTRICT x32 = reinterpret_cast<const __m256i *>(vx);
+    const __m256i * GF256_RESTRICT y32 = reinterpret_cast<const __m256i *>(vy);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        _mm256_storeu_si256(z32, _mm256_xor_si256(_mm256_loadu_si256(x32), _mm256_loadu_si256(y32)));
+        _mm256_storeu_si256(z32 + 1, _mm256_xor_si256(_mm256_loadu_si256(x32 + 1), _mm256_loadu_si256(y32 + 1)));
+
+        x32 += 2;
+        y32 += 2;
+        z32 += 2;
+        bytes -= 64;
+    }
+
+    simd_addset_mem(z32, x32, y32, bytes);
+}
+
+// z[] = (accumulate ? z[] : 0) + x_0[] + ... + x_(count-1)[], over whole 128-byte strips
+// Returns the number of bytes handled
+static GF256_AVX2 int avx2_add_n_mem_strips(void * GF256_RESTRICT vz, const void * const * vx,
+                                            int count, int bytes, bool accumulate)
+{
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * const * x1 = reinterpret_cast<const uint8_t * const *>(vx);
+    const int first = accumulate ? 0 : 1;
+    int offset = 0;
+
+    for (; offset + 128 <= bytes; offset += 128)
+    {
+        const __m256i * start = reinterpret_cast<const __m256i *>(accumulate ? z1 + offset : x1[0] + offset);
+        __m256i s0 = _mm256_loadu_si256(start);
+        __m256i s1 = _mm256_loadu_si256(start + 1);
+        __m256i s2 = _mm256_loadu_si256(start + 2);
+        __m256i s3 = _mm256_loadu_si256(start + 3);
+
+        for (int i = first; i < count; ++i)
+        {
+            const __m256i * x32 = reinterpret_cast<const __m256i *>(x1[i] + offset);
+            GF256_PREFETCH(x1[i] + offset + kAddNPrefetchBytes);
+            GF256_PREFETCH(x1[i] + offset + kAddNPrefetchBytes + 64);
+
+            s0 = _mm256_xor_si256(s0, _mm256_loadu_si256(x32));
+            s1 = _mm256_xor_si256(s1, _mm256_loadu_si256(x32 + 1));
+            s2 = _mm256_xor_si256(s2, _mm256_loadu_si256(x32 + 2));
+            s3 = _mm256_xor_si256(s3, _mm256_loadu_si256(x32 + 3));
+        }
+
+        __m256i * z32 = reinterpret_cast<__m256i *>(z1 + offset);
+        _mm256_storeu_si256(z32, s0);
+        _mm256_storeu_si256(z32 + 1, s1);
+        _mm256_storeu_si256(z32 + 2, s2);
+        _mm256_storeu_si256(z32 + 3, s3);
+    }
+
+    return offset;
+}
+
+// Runs the AVX2 strips and hands the tail to the SSSE3 kernel
+static GF256_AVX2 void avx2_add_n_mem_batch(void * GF256_RESTRICT vz, const void * const * vx,
+                                            int count, int bytes, bool accumulate)
+{
+    const int done = avx2_add_n_mem_strips(vz, vx, count, bytes, accumulate);
+    if (done >= bytes)
+    {
+        return;
+    }
+
+    const void* tails[kAddNBatch];
+    for (int i = 0; i < count; ++i)
+    {
+        tails[i] = reinterpret_cast<const uint8_t *>(vx[i]) + done;
+    }
+
+    gf256_add_n_mem_impl(reinterpret_cast<uint8_t *>(vz) + done, tails, count, bytes - done, accumulate);
+}
+
+static void avx2_addset_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                              int count, int bytes)
+{
+    if (count <= 0)
+    {
+        memset(vz, 0, bytes);
+        return;
+    }
+
+    // First pass sets z, later passes accumulate into it
+    for (int i = 0; i < count; i += kAddNBatch)
+    {
+        const int batch = (count - i < kAddNBatch) ? count - i : kAddNBatch;
+        avx2_add_n_mem_batch(vz, vx + i, batch, bytes, i > 0);
+    }
+}
+
+static void avx2_add_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                           int count, int bytes)
+{
+    for (int i = 0; i < count; i += kAddNBatch)
+    {
+        const int batch = (count - i < kAddNBatch) ? count - i : kAddNBatch;
+        avx2_add_n_mem_batch(vz, vx + i, batch, bytes, true);
+    }
+}
+
+static GF256_AVX2 void avx2_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
+                                       const void * GF256_RESTRICT vx, int bytes)
+{
+    // Use a single if-statement to handle special cases
+    if (y <= 1)
+    {
+        if (y == 1)
+        {
+            avx2_add_mem(vz, vx, bytes);
+        }
+        return;
+    }
+
+    // Partial product tables, one copy per lane
+    const __m256i table_lo_y = _mm256_broadcastsi128_si256(_mm_load_si128(GF256Ctx.MM256_TABLE_LO_Y + y));
+    const __m256i table_hi_y = _mm256_broadcastsi128_si256(_mm_load_si128(GF256Ctx.MM256_TABLE_HI_Y + y));
+
+    const __m256i clr_mask = _mm256_set1_epi8(0x0f);
+
+    __m256i * GF256_RESTRICT z32 = reinterpret_cast<__m256i *>(vz);
+    const __m256i * GF256_RESTRICT x32 = reinterpret_cast<const __m256i *>(vx);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        __m256i x0 = _mm256_loadu_si256(x32);
+        __m256i x1 = _mm256_loadu_si256(x32 + 1);
+        __m256i l0 = _mm256_and_si256(x0, clr_mask);
+        __m256i l1 = _mm256_and_si256(x1, clr_mask);
+        x0 = _mm256_srli_epi64(x0, 4);
+        x1 = _mm256_srli_epi64(x1, 4);
+        __m256i h0 = _mm256_and_si256(x0, clr_mask);
+        __m256i h1 = _mm256_and_si256(x1, clr_mask);
+        l0 = _mm256_shuffle_epi8(table_lo_y, l0);
+        l1 = _mm256_shuffle_epi8(table_lo_y, l1);
+        h0 = _mm256_shuffle_epi8(table_hi_y, h0);
+        h1 = _mm256_shuffle_epi8(table_hi_y, h1);
+        const __m256i p0 = _mm256_xor_si256(l0, h0);
+        const __m256i p1 = _mm256_xor_si256(l1, h1);
+
+        _mm256_storeu_si256(z32, _mm256_xor_si256(p0, _mm256_loadu_si256(z32)));
+        _mm256_storeu_si256(z32 + 1, _mm256_xor_si256(p1, _mm256_loadu_si256(z32 + 1)));
+
+        x32 += 2;
+        z32 += 2;
+        bytes -= 64;
+    }
+
+    simd_muladd_mem(z32, y, x32, bytes);
+}
+
+static GF256_AVX2 void avx2_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                    uint8_t y, int bytes)
+{
+    // Use a single if-statement to handle special cases
+    if (y <= 1)
+    {
+        if (y == 0)
+        {
+            memset(vz, 0, bytes);
+        }
+        return;
+    }
+
+    // Partial product tables, one copy per lane
+    const __m256i table_lo_y = _mm256_broadcastsi128_si256(_mm_load_si128(GF256Ctx.MM256_TABLE_LO_Y + y));
+    const __m256i table_hi_y = _mm256_broadcastsi128_si256(_mm_load_si128(GF256Ctx.MM256_TABLE_HI_Y + y));
+
+    const __m256i clr_mask = _mm256_set1_epi8(0x0f);
+
+    __m256i * GF256_RESTRICT z32 = reinterpret_cast<__m256i *>(vz);
+    const __m256i * GF256_RESTRICT x32 = reinterpret_cast<const __m256i *>(vx);
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        __m256i x0 = _mm256_loadu_si256(x32);
+        __m256i l0 = _mm256_and_si256(x0, clr_mask);
+        x0 = _mm256_srli_epi64(x0, 4);
+        __m256i h0 = _mm256_and_si256(x0, clr_mask);
+        l0 = _mm256_shuffle_epi8(table_lo_y, l0);
+        h0 = _mm256_shuffle_epi8(table_hi_y, h0);
+        _mm256_storeu_si256(z32, _mm256_xor_si256(l0, h0));
+
+        x32++;
+        z32++;
+        bytes -= 32;
+    }
+
+    simd_mul_mem(z32, x32, y, bytes);
+}
+
+extern "C" const gf256_kernels gf256_avx2_kernels = {
+    "avx2",
+    avx2_supported,
+    avx2_add_mem,
+    avx2_add2_mem,
+    avx2_addset_mem,
+    avx2_add_n_mem,
+    avx2_addset_n_mem,
+    avx2_muladd_mem,
+    avx2_mul_mem
+};
+
+#endif // GF256_HAS_AVX2
+
 extern "C" void gf256_memswap(void * GF256_RESTRICT vx, void * GF256_RESTRICT vy, int bytes)
 {
     GF256_M128 * GF256_RESTRICT x16 = reinterpret_cast<GF256_M128*>(vx);
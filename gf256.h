@@ -60,6 +60,9 @@
     // Compiler-specific alignment keyword
     #define GF256_ALIGNED __declspec(align(16))
 
+    // Compiler-specific cache prefetch hint
+    #define GF256_PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+
     // Compiler-specific SSE headers
     #include <tmmintrin.h> // SSE3: _mm_shuffle_epi8
     #include <emmintrin.h> // SSE2
@@ -78,9 +81,15 @@
     // Compiler-specific alignment keyword
     #define GF256_ALIGNED __attribute__((align(16)))
 
+    // Compiler-specific cache prefetch hint
+    #define GF256_PREFETCH(p) __builtin_prefetch(p)
+
     // Compiler-specific SSE headers
     #include <x86intrin.h>
 
+    // AVX2 kernels are built alongside SSSE3 and used if the CPU supports them
+    #define GF256_HAS_AVX2
+
 #endif
 
 #elif defined(USE_NEON)
@@ -99,6 +108,28 @@
     // Compiler-specific alignment keyword
     #define GF256_ALIGNED __attribute__((align(16)))
 
+    // Compiler-specific cache prefetch hint
+    #define GF256_PREFETCH(p) __builtin_prefetch(p)
+
+#elif defined(USE_VECEXT)
+
+    // Compiler-specific 128-bit SIMD register keyword
+    // GCC/Clang vector extension type, see gf256_vector.cpp
+    typedef uint8_t gf256_vec16 __attribute__((vector_size(16)));
+    #define GF256_M128 gf256_vec16
+
+    // Compiler-specific C++11 restrict keyword
+    #define GF256_RESTRICT __restrict__
+
+    // Compiler-specific force inline keyword
+    #define GF256_FORCE_INLINE __attribute__((always_inline)) inline
+
+    // Compiler-specific alignment keyword
+    #define GF256_ALIGNED __attribute__((align(16)))
+
+    // Compiler-specific cache prefetch hint
+    #define GF256_PREFETCH(p) __builtin_prefetch(p)
+
 #elif defined(NO_SIMD)
 
     // Compiler-specific 128-bit SIMD register keyword
@@ -114,8 +145,13 @@
     // Compiler-specific alignment keyword
     #define GF256_ALIGNED __attribute__((align(16)))
 
+    // Compiler-specific cache prefetch hint
+    #define GF256_PREFETCH(p) __builtin_prefetch(p)
+
 #endif
 
+// Sources include this header (directly or through cm256.h) after the
+// standard headers, since the fallback below would break them
 #ifndef nullptr
     #define nullptr NULL
 #endif
@@ -135,12 +171,37 @@ extern "C" {
 // This struct should be aligned in memory, meaning that a pointer to it should
 // have the low 4 bits cleared.  To achieve this simply tag the gf256_ctx object
 // with the GF256_ALIGNED macro provided above.
+//
+// Small Footprint:
+// Defining GF256_SMALL (USE_SIMD=SMALL in CMake) keeps only the Log/Exp tables,
+// about 1.5 KB instead of 141 KB.  Multiplication then takes three table reads,
+// and the bulk operations build 32 bytes of nibble tables per call and run
+// the scalar kernels without backend dispatch.
+
+#if defined(GF256_SMALL) && !defined(NO_SIMD)
+    #error "GF256_SMALL requires NO_SIMD"
+#endif
 
 #ifdef _MSC_VER
     #pragma warning(push)
     #pragma warning(disable: 4324) // warning C4324: 'gf256_ctx' : structure was padded due to __declspec(align())
 #endif
 
+#if defined(GF256_SMALL)
+
+// Log/Exp tables only, for memory-tight targets: see the math operations below
+struct gf256_ctx // 1,544 bytes
+{
+    // Polynomial used
+    unsigned Polynomial;
+
+    // Log/Exp tables
+    uint16_t GF256_LOG_TABLE[256];
+    uint8_t GF256_EXP_TABLE[512 * 2 + 1];
+};
+
+#else
+
 struct gf256_ctx // 141,072 bytes
 {
     // Polynomial used
@@ -162,6 +223,8 @@ struct gf256_ctx // 141,072 bytes
     GF256_M128 MM256_TABLE_HI_Y[256];
 };
 
+#endif // GF256_SMALL
+
 #ifdef _MSC_VER
     #pragma warning(pop)
 #endif
@@ -202,6 +265,33 @@ static GF256_FORCE_INLINE uint8_t gf256_add(uint8_t x, uint8_t y)
     return x ^ y;
 }
 
+#if defined(GF256_SMALL)
+
+// return x * y
+// log(0) is 512, so any product with zero lands in the zeroed top of the exp table.
+static GF256_FORCE_INLINE uint8_t gf256_mul(uint8_t x, uint8_t y)
+{
+    return GF256Ctx.GF256_EXP_TABLE[GF256Ctx.GF256_LOG_TABLE[x] + GF256Ctx.GF256_LOG_TABLE[y]];
+}
+
+// return x / y, or 0 for y = 0
+static GF256_FORCE_INLINE uint8_t gf256_div(uint8_t x, uint8_t y)
+{
+    if (y == 0)
+    {
+        return 0;
+    }
+    return GF256Ctx.GF256_EXP_TABLE[GF256Ctx.GF256_LOG_TABLE[x] + 255 - GF256Ctx.GF256_LOG_TABLE[y]];
+}
+
+// return 1 / x, or 0 for x = 0
+static GF256_FORCE_INLINE uint8_t gf256_inv(uint8_t x)
+{
+    return gf256_div(1, x);
+}
+
+#else
+
 // return x * y
 // For repeated multiplication by a constant, it is faster to put the constant in y.
 static GF256_FORCE_INLINE uint8_t gf256_mul(uint8_t x, uint8_t y)
@@ -222,6 +312,8 @@ static GF256_FORCE_INLINE uint8_t gf256_inv(uint8_t x)
     return GF256Ctx.GF256_INV_TABLE[x];
 }
 
+#endif // GF256_SMALL
+
 // Performs "x[] += y[]" bulk memory XOR operation
 extern void gf256_add_mem(void * GF256_RESTRICT vx,
                           const void * GF256_RESTRICT vy, int bytes);
@@ -234,6 +326,17 @@ extern void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT
 extern void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
                              const void * GF256_RESTRICT vy, int bytes);
 
+// Performs "z[] = x_0[] + x_1[] + ... + x_(count-1)[]" bulk memory operation
+// Each source is read once and z is written once, so this is faster than a
+// chain of gf256_add_mem() calls when summing many blocks.  With count = 0
+// the output is cleared.
+extern void gf256_addset_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                               int count, int bytes);
+
+// Performs "z[] += x_0[] + x_1[] + ... + x_(count-1)[]" bulk memory operation
+extern void gf256_add_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                            int count, int bytes);
+
 // Performs "z[] += x[] * y" bulk memory operation
 extern void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
                              const void * GF256_RESTRICT vx, int bytes);
@@ -247,10 +350,193 @@ static GF256_FORCE_INLINE void gf256_div_mem(void * GF256_RESTRICT vz,
                                              const void * GF256_RESTRICT vx, uint8_t y, int bytes)
 {
     // Multiply by inverse
-    gf256_mul_mem(vz, vx, GF256Ctx.GF256_INV_TABLE[y], bytes);
+    gf256_mul_mem(vz, vx, gf256_inv(y), bytes);
 }
 
 
+//-----------------------------------------------------------------------------
+// Large Buffer Operations
+//
+// The bulk operations above take an int byte count.  These variants accept
+// a size_t and pass the buffer to them in chunks of GF256_LARGE_CHUNK_BYTES,
+// which is large enough that the per-call setup does not matter.
+
+// Bytes per call to the int-sized operations, a multiple of 64
+#define GF256_LARGE_CHUNK_BYTES (1 << 30)
+
+static inline int gf256_large_chunk(size_t bytes)
+{
+    return (bytes > GF256_LARGE_CHUNK_BYTES) ? GF256_LARGE_CHUNK_BYTES : (int)bytes;
+}
+
+// Performs "x[] += y[]" bulk memory XOR operation
+static inline void gf256_add_mem_large(void * GF256_RESTRICT vx,
+                                       const void * GF256_RESTRICT vy, size_t bytes)
+{
+    uint8_t * GF256_RESTRICT x = (uint8_t*)vx;
+    const uint8_t * GF256_RESTRICT y = (const uint8_t*)vy;
+    while (bytes > 0)
+    {
+        const int chunk = gf256_large_chunk(bytes);
+        gf256_add_mem(x, y, chunk);
+        x += chunk, y += chunk, bytes -= chunk;
+    }
+}
+
+// Performs "z[] += x[] + y[]" bulk memory operation
+static inline void gf256_add2_mem_large(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                        const void * GF256_RESTRICT vy, size_t bytes)
+{
+    uint8_t * GF256_RESTRICT z = (uint8_t*)vz;
+    const uint8_t * GF256_RESTRICT x = (const uint8_t*)vx;
+    const uint8_t * GF256_RESTRICT y = (const uint8_t*)vy;
+    while (bytes > 0)
+    {
+        const int chunk = gf256_large_chunk(bytes);
+        gf256_add2_mem(z, x, y, chunk);
+        z += chunk, x += chunk, y += chunk, bytes -= chunk;
+    }
+}
+
+// Performs "z[] = x[] + y[]" bulk memory operation
+static inline void gf256_addset_mem_large(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                          const void * GF256_RESTRICT vy, size_t bytes)
+{
+    uint8_t * GF256_RESTRICT z = (uint8_t*)vz;
+    const uint8_t * GF256_RESTRICT x = (const uint8_t*)vx;
+    const uint8_t * GF256_RESTRICT y = (const uint8_t*)vy;
+    while (bytes > 0)
+    {
+        const int chunk = gf256_large_chunk(bytes);
+        gf256_addset_mem(z, x, y, chunk);
+        z += chunk, x += chunk, y += chunk, bytes -= chunk;
+    }
+}
+
+// Performs "z[] += x[] * y" bulk memory operation
+static inline void gf256_muladd_mem_large(void * GF256_RESTRICT vz, uint8_t y,
+                                          const void * GF256_RESTRICT vx, size_t bytes)
+{
+    uint8_t * GF256_RESTRICT z = (uint8_t*)vz;
+    const uint8_t * GF256_RESTRICT x = (const uint8_t*)vx;
+    while (bytes > 0)
+    {
+        const int chunk = gf256_large_chunk(bytes);
+        gf256_muladd_mem(z, y, x, chunk);
+        z += chunk, x += chunk, bytes -= chunk;
+    }
+}
+
+// Performs "z[] = x[] * y" bulk memory operation
+static inline void gf256_mul_mem_large(void * GF256_RESTRICT vz,
+                                       const void * GF256_RESTRICT vx, uint8_t y, size_t bytes)
+{
+    uint8_t * GF256_RESTRICT z = (uint8_t*)vz;
+    const uint8_t * GF256_RESTRICT x = (const uint8_t*)vx;
+    while (bytes > 0)
+    {
+        const int chunk = gf256_large_chunk(bytes);
+        gf256_mul_mem(z, x, y, chunk);
+        z += chunk, x += chunk, bytes -= chunk;
+    }
+}
+
+
+#if !defined(GF256_SMALL)
+
+//-----------------------------------------------------------------------------
+// Backend Selection
+//
+// Besides the backend chosen with USE_SIMD, every build contains the portable
+// scalar kernels of gf256_nosimd.cpp, and x86 GCC/Clang builds also contain
+// AVX2 kernels.  The bulk memory operations above dispatch on the size of the
+// call to one backend per size class.  By default every class uses the
+// USE_SIMD backend, as before.
+//
+// gf256_backend_autoselect() runs each backend the CPU supports on
+// representative block sizes, checks its output against the scalar kernels,
+// and selects the fastest verified backend for each size class.  Call it once
+// at startup after gf256_init(), before other threads use the kernels.
+//
+// GF256_SMALL builds have only the scalar kernels and leave this API out.
+
+// Size classes, by bytes per call
+#define GF256_SIZE_SMALL  0 // Up to GF256_SIZE_SMALL_MAX bytes, e.g. one packet
+#define GF256_SIZE_MEDIUM 1 // Up to GF256_SIZE_MEDIUM_MAX bytes
+#define GF256_SIZE_LARGE  2 // Anything larger
+#define GF256_SIZE_CLASS_COUNT 3
+
+#define GF256_SIZE_SMALL_MAX 2048
+#define GF256_SIZE_MEDIUM_MAX 65536
+
+static GF256_FORCE_INLINE int gf256_size_class(int bytes)
+{
+    return bytes <= GF256_SIZE_SMALL_MAX ? GF256_SIZE_SMALL :
+           bytes <= GF256_SIZE_MEDIUM_MAX ? GF256_SIZE_MEDIUM : GF256_SIZE_LARGE;
+}
+
+// Bulk memory kernels of one backend
+typedef struct gf256_kernels_t
+{
+    // Backend name: "scalar", "ssse3", "neon", "vecext" or "avx2"
+    const char* Name;
+
+    // Returns nonzero if the CPU can run these kernels, or nullptr if it always can
+    int (*Supported)(void);
+
+    void (*AddMem)(void * GF256_RESTRICT vx, const void * GF256_RESTRICT vy, int bytes);
+    void (*Add2Mem)(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                    const void * GF256_RESTRICT vy, int bytes);
+    void (*AddsetMem)(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                      const void * GF256_RESTRICT vy, int bytes);
+    void (*AddNMem)(void * GF256_RESTRICT vz, const void * const * vx, int count, int bytes);
+    void (*AddsetNMem)(void * GF256_RESTRICT vz, const void * const * vx, int count, int bytes);
+    void (*MuladdMem)(void * GF256_RESTRICT vz, uint8_t y, const void * GF256_RESTRICT vx, int bytes);
+    void (*MulMem)(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes);
+} gf256_kernels;
+
+// Result of the self-test for one backend
+typedef struct gf256_backend_info_t
+{
+    // Backend name, see gf256_kernels
+    const char* Name;
+
+    // Nonzero if the CPU can run this backend
+    int Supported;
+
+    // 1 if the output matched the scalar kernels, 0 if it did not,
+    // -1 if gf256_backend_autoselect() has not been run
+    int Verified;
+
+    // Measured throughput per size class in MB/s, 0 if not measured
+    double MBps[GF256_SIZE_CLASS_COUNT];
+} gf256_backend_info;
+
+// Number of backends compiled into the library
+extern int gf256_backend_count(void);
+
+// Fill in the info for backend 'index' in [0, gf256_backend_count())
+// Returns 0 on success, or -1 if the index is out of range.
+extern int gf256_get_backend_info(int index, gf256_backend_info* info);
+
+// Self-test every supported backend and select the fastest verified one for
+// each size class.  Each backend is timed for about 'benchmarkUsec' per size
+// class; pass 0 for the default of 2 milliseconds.
+// Returns 0 on success, -1 if gf256_init() failed, or -2 if the default
+// backend did not match the scalar kernels (it is then not selected).
+extern int gf256_backend_autoselect(int benchmarkUsec);
+
+// Name of the backend selected for a size class, or nullptr if out of range
+extern const char* gf256_backend_selected(int sizeClass);
+
+// Use the named backend for every size class, e.g. for A/B comparisons.
+// Returns 0 on success, or -1 if there is no such backend or the CPU cannot
+// run it.
+extern int gf256_backend_force(const char* name);
+
+#endif // GF256_SMALL
+
+
 //-----------------------------------------------------------------------------
 // Misc Operations
 
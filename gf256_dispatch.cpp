@@ -0,0 +1,441 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <chrono>
+#include <vector>
+
+#include "gf256.h"
+
+
+//-----------------------------------------------------------------------------
+// Backends
+
+// Portable reference kernels, gf256_nosimd.cpp
+extern "C" const gf256_kernels gf256_scalar_kernels;
+
+#if !defined(NO_SIMD)
+// Kernels of the USE_SIMD backend
+extern "C" const gf256_kernels gf256_native_kernels;
+#endif
+
+#if defined(GF256_HAS_AVX2)
+// AVX2 kernels, gf256.cpp
+extern "C" const gf256_kernels gf256_avx2_kernels;
+#endif
+
+static const gf256_kernels* const Backends[] = {
+    &gf256_scalar_kernels,
+#if !defined(NO_SIMD)
+    &gf256_native_kernels,
+#endif
+#if defined(GF256_HAS_AVX2)
+    &gf256_avx2_kernels,
+#endif
+};
+
+static const int BackendCount = static_cast<int>(sizeof(Backends) / sizeof(Backends[0]));
+
+// The USE_SIMD backend, used until another one is selected
+#if defined(NO_SIMD)
+static const gf256_kernels* const DefaultBackend = &gf256_scalar_kernels;
+#else
+static const gf256_kernels* const DefaultBackend = &gf256_native_kernels;
+#endif
+
+// Backend used for each size class
+static const gf256_kernels* Selected[GF256_SIZE_CLASS_COUNT] = {
+    DefaultBackend, DefaultBackend, DefaultBackend
+};
+
+// Self-test results by backend index, -1 until checked
+static int Verified[sizeof(Backends) / sizeof(Backends[0])];
+static double MBps[sizeof(Backends) / sizeof(Backends[0])][GF256_SIZE_CLASS_COUNT];
+static bool ResultsInitialized = false;
+
+static void InitializeResults()
+{
+    if (!ResultsInitialized)
+    {
+        for (int i = 0; i < BackendCount; ++i)
+        {
+            Verified[i] = -1;
+        }
+        ResultsInitialized = true;
+    }
+}
+
+static bool IsSupported(const gf256_kernels* kernels)
+{
+    return !kernels->Supported || kernels->Supported() != 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Dispatch
+
+extern "C" void gf256_add_mem(void * GF256_RESTRICT vx,
+                              const void * GF256_RESTRICT vy, int bytes)
+{
+    Selected[gf256_size_class(bytes)]->AddMem(vx, vy, bytes);
+}
+
+extern "C" void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                               const void * GF256_RESTRICT vy, int bytes)
+{
+    Selected[gf256_size_class(bytes)]->Add2Mem(vz, vx, vy, bytes);
+}
+
+extern "C" void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                 const void * GF256_RESTRICT vy, int bytes)
+{
+    Selected[gf256_size_class(bytes)]->AddsetMem(vz, vx, vy, bytes);
+}
+
+extern "C" void gf256_add_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                                int count, int bytes)
+{
+    Selected[gf256_size_class(bytes)]->AddNMem(vz, vx, count, bytes);
+}
+
+extern "C" void gf256_addset_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                                   int count, int bytes)
+{
+    Selected[gf256_size_class(bytes)]->AddsetNMem(vz, vx, count, bytes);
+}
+
+extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
+                                 const void * GF256_RESTRICT vx, int bytes)
+{
+    Selected[gf256_size_class(bytes)]->MuladdMem(vz, y, vx, bytes);
+}
+
+extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    Selected[gf256_size_class(bytes)]->MulMem(vz, vx, y, bytes);
+}
+
+
+//-----------------------------------------------------------------------------
+// Self-Test
+
+static const uint8_t TestFactors[] = { 0, 1, 2, 3, 0x8e, 0xff };
+static const int TestFactorCount = static_cast<int>(sizeof(TestFactors));
+static const int TestCounts[] = { 1, 2, 3, 8, 9, 17 };
+static const int TestCountCount = static_cast<int>(sizeof(TestCounts) / sizeof(TestCounts[0]));
+static const int TestOpCount = 3 + 2 * TestFactorCount + 2 * TestCountCount;
+static const int TestMaxSources = 17;
+
+// Deterministic test data
+static void FillPattern(std::vector<uint8_t>& data, uint32_t seed)
+{
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = static_cast<uint8_t>(seed >> 16);
+    }
+}
+
+// Run test operation 'op' in [0, TestOpCount) with one backend
+static void RunTestOp(const gf256_kernels* kernels, int op, uint8_t* z, const void* const* x, int bytes)
+{
+    if (op == 0)
+    {
+        kernels->AddMem(z, x[0], bytes);
+        return;
+    }
+    if (op == 1)
+    {
+        kernels->Add2Mem(z, x[0], x[1], bytes);
+        return;
+    }
+    if (op == 2)
+    {
+        kernels->AddsetMem(z, x[0], x[1], bytes);
+        return;
+    }
+    op -= 3;
+
+    if (op < TestFactorCount)
+    {
+        kernels->MuladdMem(z, TestFactors[op], x[0], bytes);
+        return;
+    }
+    op -= TestFactorCount;
+
+    if (op < TestFactorCount)
+    {
+        // mul_mem by one leaves the output alone and is only used in-place
+        if (TestFactors[op] != 1)
+        {
+            kernels->MulMem(z, x[0], TestFactors[op], bytes);
+        }
+        return;
+    }
+    op -= TestFactorCount;
+
+    if (op < TestCountCount)
+    {
+        kernels->AddNMem(z, x, TestCounts[op], bytes);
+        return;
+    }
+    op -= TestCountCount;
+
+    kernels->AddsetNMem(z, x, TestCounts[op], bytes);
+}
+
+// Returns true if every kernel matches the scalar kernels, including the bytes
+// around the output
+static bool VerifyBackend(const gf256_kernels* kernels)
+{
+    static const int lengths[] = { 0, 1, 3, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129, 1296, 4099 };
+    static const int kMaxBytes = 4099;
+    static const int kSlack = 64;
+
+    std::vector<uint8_t> sources((size_t)TestMaxSources * (kMaxBytes + kSlack));
+    FillPattern(sources, 1);
+
+    std::vector<uint8_t> expected(kMaxBytes + kSlack), actual(kMaxBytes + kSlack);
+
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l)
+    {
+        const int bytes = lengths[l];
+
+        // Aligned, then misaligned sources and output
+        for (int align = 0; align < 2; ++align)
+        {
+            const void* x[TestMaxSources];
+            for (int i = 0; i < TestMaxSources; ++i)
+            {
+                x[i] = &sources[(size_t)i * (kMaxBytes + kSlack) + align * (i + 1)];
+            }
+            const int zOffset = align * 3;
+
+            for (int op = 0; op < TestOpCount; ++op)
+            {
+                FillPattern(expected, 77 + op);
+                FillPattern(actual, 77 + op);
+
+                RunTestOp(&gf256_scalar_kernels, op, &expected[zOffset], x, bytes);
+                RunTestOp(kernels, op, &actual[zOffset], x, bytes);
+
+                if (memcmp(&expected[0], &actual[0], expected.size()) != 0)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Benchmark
+
+// Block size timed for each size class
+static const int BenchmarkBytes[GF256_SIZE_CLASS_COUNT] = { 1296, 16384, 1048576 };
+
+// Originals per benchmark round
+static const int kBenchmarkSources = 8;
+
+static const int kDefaultBenchmarkUsec = 2000;
+
+// Time one recovery row over kBenchmarkSources originals, plus the parity row.
+// Returns MB/s of input
+static double BenchmarkBackend(const gf256_kernels* kernels, int bytes, int usec,
+                               std::vector<uint8_t>& data, std::vector<uint8_t>& output)
+{
+    const void* x[kBenchmarkSources];
+    for (int i = 0; i < kBenchmarkSources; ++i)
+    {
+        x[i] = &data[(size_t)i * bytes];
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start;
+    long long rounds = 0, elapsed = 0;
+
+    // The first round warms up the caches and is not counted
+    for (int round = -1; elapsed < usec; ++round)
+    {
+        if (round == 0)
+        {
+            start = Clock::now();
+        }
+
+        kernels->MulMem(&output[0], x[0], static_cast<uint8_t>(round | 2), bytes);
+        for (int i = 1; i < kBenchmarkSources; ++i)
+        {
+            kernels->MuladdMem(&output[0], static_cast<uint8_t>(round + i + 2), x[i], bytes);
+        }
+        kernels->AddsetNMem(&output[bytes], x, kBenchmarkSources, bytes);
+
+        if (round >= 0)
+        {
+            ++rounds;
+            elapsed = (long long)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        }
+    }
+
+    if (elapsed <= 0)
+    {
+        elapsed = 1;
+    }
+
+    return 2. * kBenchmarkSources * bytes * rounds / elapsed;
+}
+
+
+//-----------------------------------------------------------------------------
+// Selection
+
+extern "C" int gf256_backend_autoselect(int benchmarkUsec)
+{
+    if (gf256_init())
+    {
+        return -1;
+    }
+    if (benchmarkUsec <= 0)
+    {
+        benchmarkUsec = kDefaultBenchmarkUsec;
+    }
+
+    InitializeResults();
+
+    for (int i = 0; i < BackendCount; ++i)
+    {
+        for (int c = 0; c < GF256_SIZE_CLASS_COUNT; ++c)
+        {
+            MBps[i][c] = 0.;
+        }
+
+        if (!IsSupported(Backends[i]))
+        {
+            Verified[i] = 0;
+            continue;
+        }
+
+        Verified[i] = (Backends[i] == &gf256_scalar_kernels || VerifyBackend(Backends[i])) ? 1 : 0;
+    }
+
+    for (int c = 0; c < GF256_SIZE_CLASS_COUNT; ++c)
+    {
+        const int bytes = BenchmarkBytes[c];
+        std::vector<uint8_t> data((size_t)kBenchmarkSources * bytes), output((size_t)2 * bytes);
+        FillPattern(data, 3);
+
+        int best = -1;
+        for (int i = 0; i < BackendCount; ++i)
+        {
+            if (Verified[i] != 1)
+            {
+                continue;
+            }
+
+            MBps[i][c] = BenchmarkBackend(Backends[i], bytes, benchmarkUsec, data, output);
+            if (best < 0 || MBps[i][c] > MBps[best][c])
+            {
+                best = i;
+            }
+        }
+
+        Selected[c] = Backends[best];
+    }
+
+    for (int i = 0; i < BackendCount; ++i)
+    {
+        if (Backends[i] == DefaultBackend && Verified[i] != 1)
+        {
+            return -2;
+        }
+    }
+
+    return 0;
+}
+
+extern "C" const char* gf256_backend_selected(int sizeClass)
+{
+    if (sizeClass < 0 || sizeClass >= GF256_SIZE_CLASS_COUNT)
+    {
+        return nullptr;
+    }
+
+    return Selected[sizeClass]->Name;
+}
+
+extern "C" int gf256_backend_force(const char* name)
+{
+    if (!name)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < BackendCount; ++i)
+    {
+        if (strcmp(Backends[i]->Name, name) == 0 && IsSupported(Backends[i]))
+        {
+            for (int c = 0; c < GF256_SIZE_CLASS_COUNT; ++c)
+            {
+                Selected[c] = Backends[i];
+            }
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+
+//-----------------------------------------------------------------------------
+// Introspection
+
+extern "C" int gf256_backend_count(void)
+{
+    return BackendCount;
+}
+
+extern "C" int gf256_get_backend_info(int index, gf256_backend_info* info)
+{
+    if (index < 0 || index >= BackendCount || !info)
+    {
+        return -1;
+    }
+
+    InitializeResults();
+
+    info->Name = Backends[index]->Name;
+    info->Supported = IsSupported(Backends[index]) ? 1 : 0;
+    info->Verified = Verified[index];
+    for (int c = 0; c < GF256_SIZE_CLASS_COUNT; ++c)
+    {
+        info->MBps[c] = MBps[index][c];
+    }
+
+    return 0;
+}
@@ -97,6 +97,8 @@ static void gf256_explog_init()
 }
 
 
+#if !defined(GF256_SMALL)
+
 //-----------------------------------------------------------------------------
 // Multiply and Divide Tables
 
@@ -152,6 +154,8 @@ static void gf256_inv_init()
     }
 }
 
+#endif // GF256_SMALL
+
 
 //-----------------------------------------------------------------------------
 // Initialization
@@ -185,18 +189,26 @@ extern "C" int gf256_init_(int version)
 
     gf255_poly_init(DefaultPolynomialIndex);
     gf256_explog_init();
+#if !defined(GF256_SMALL)
     gf256_muldiv_init();
     gf256_inv_init();
+#endif
 
     return 0;
 }
 
+#endif // NO_SIMD
+
 
 //-----------------------------------------------------------------------------
 // Operations
+//
+// These kernels are built into every configuration: they are the reference
+// that gf256_backend_autoselect() checks the other backends against, and the
+// only kernels of a GF256_SMALL build.
 
-extern "C" void gf256_add_mem(void * GF256_RESTRICT vx,
-                              const void * GF256_RESTRICT vy, int bytes)
+static void scalar_add_mem(void * GF256_RESTRICT vx,
+                           const void * GF256_RESTRICT vy, int bytes)
 {
     uint8_t * GF256_RESTRICT x1 = reinterpret_cast<uint8_t *>(vx);
     const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(vy);
@@ -212,8 +224,8 @@ extern "C" void gf256_add_mem(void * GF256_RESTRICT vx,
     }
 }
 
-extern "C" void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
-                               const void * GF256_RESTRICT vy, int bytes)
+static void scalar_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                            const void * GF256_RESTRICT vy, int bytes)
 {
     uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(vz);
     const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t *>(vx);
@@ -231,8 +243,8 @@ extern "C" void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_REST
     }
 }
 
-extern "C" void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
-                                 const void * GF256_RESTRICT vy, int bytes)
+static void scalar_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                              const void * GF256_RESTRICT vy, int bytes)
 {
     uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(vz);
     const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t *>(vx);
@@ -250,21 +262,125 @@ extern "C" void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RE
     }
 }
 
-extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
-                                 const void * GF256_RESTRICT vx, int bytes)
+// Sources summed per pass: more streams than this thrash the L1 cache and
+// the hardware prefetchers, so larger counts are split into several passes
+static const int kAddNBatch = 8;
+
+// z[] = (accumulate ? z[] : 0) + x_0[] + ... + x_(count-1)[]
+static GF256_FORCE_INLINE void gf256_add_n_mem_impl(void * GF256_RESTRICT vz, const void * const * vx,
+                                                    int count, int bytes, bool accumulate)
+{
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * const * x1 = reinterpret_cast<const uint8_t * const *>(vx);
+    const int first = accumulate ? 0 : 1;
+    int offset = 0;
+
+    // Handle multiples of 32 bytes: sum every source into four words, then store once
+    for (; offset + 32 <= bytes; offset += 32)
+    {
+        uint64_t s[4];
+        memcpy(s, accumulate ? z1 + offset : x1[0] + offset, 32);
+
+        for (int i = first; i < count; ++i)
+        {
+            uint64_t x[4];
+            memcpy(x, x1[i] + offset, 32);
+            s[0] ^= x[0];
+            s[1] ^= x[1];
+            s[2] ^= x[2];
+            s[3] ^= x[3];
+        }
+
+        memcpy(z1 + offset, s, 32);
+    }
+
+    // Handle final bytes
+    for (; offset < bytes; ++offset)
+    {
+        uint8_t s = accumulate ? z1[offset] : x1[0][offset];
+
+        for (int i = first; i < count; ++i)
+        {
+            s ^= x1[i][offset];
+        }
+
+        z1[offset] = s;
+    }
+}
+
+static void scalar_addset_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                                int count, int bytes)
+{
+    if (count <= 0)
+    {
+        memset(vz, 0, bytes);
+        return;
+    }
+
+    // First pass sets z, later passes accumulate into it
+    for (int i = 0; i < count; i += kAddNBatch)
+    {
+        const int batch = (count - i < kAddNBatch) ? count - i : kAddNBatch;
+        gf256_add_n_mem_impl(vz, vx + i, batch, bytes, i > 0);
+    }
+}
+
+static void scalar_add_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                             int count, int bytes)
+{
+    for (int i = 0; i < count; i += kAddNBatch)
+    {
+        const int batch = (count - i < kAddNBatch) ? count - i : kAddNBatch;
+        gf256_add_n_mem_impl(vz, vx + i, batch, bytes, true);
+    }
+}
+
+#if defined(GF256_SMALL)
+
+// Products of y with every low nibble and every high nibble, so that
+// x * y = lo[x & 15] + hi[x >> 4].  Built for each call in place of the
+// 64 KB multiply table.
+static void scalar_nibble_tables(uint8_t y, uint8_t lo[16], uint8_t hi[16])
+{
+    for (int x = 0; x < 16; ++x)
+    {
+        lo[x] = gf256_mul(static_cast<uint8_t>(x), y);
+        hi[x] = gf256_mul(static_cast<uint8_t>(x << 4), y);
+    }
+}
+
+#endif // GF256_SMALL
+
+static void scalar_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
+                              const void * GF256_RESTRICT vx, int bytes)
 {
     // Use a single if-statement to handle special cases
     if (y <= 1)
     {
         if (y == 1)
         {
-            gf256_add_mem(vz, vx, bytes);
+            scalar_add_mem(vz, vx, bytes);
         }
         return;
     }
 
     uint8_t * GF256_RESTRICT z8 = reinterpret_cast<uint8_t*>(vz);
     const uint8_t * GF256_RESTRICT x8 = reinterpret_cast<const uint8_t*>(vx);
+
+#if defined(GF256_SMALL)
+    uint8_t lo[16], hi[16];
+    scalar_nibble_tables(y, lo, hi);
+
+    // Handle bytes
+    while (bytes)
+    {
+        z8[0] ^= lo[x8[0] & 15] ^ hi[x8[0] >> 4];
+
+        x8++;
+        z8++;
+        bytes--;
+    }
+#else
     const uint8_t * GF256_RESTRICT table = GF256Ctx.GF256_MUL_TABLE + ((unsigned)y << 8);
 
     // Handle bytes
@@ -276,9 +392,10 @@ extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
         z8++;
         bytes--;
     }
+#endif
 }
 
-extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+static void scalar_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
 {
     // Use a single if-statement to handle special cases
     if (y <= 1)
@@ -292,6 +409,21 @@ extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTR
 
     uint8_t * GF256_RESTRICT z8 = reinterpret_cast<uint8_t*>(vz);
     const uint8_t * GF256_RESTRICT x8 = reinterpret_cast<const uint8_t*>(vx);
+
+#if defined(GF256_SMALL)
+    uint8_t lo[16], hi[16];
+    scalar_nibble_tables(y, lo, hi);
+
+    // Handle bytes
+    while (bytes)
+    {
+        z8[0] = lo[x8[0] & 15] ^ hi[x8[0] >> 4];
+
+        x8++;
+        z8++;
+        bytes--;
+    }
+#else
     const uint8_t * GF256_RESTRICT table = GF256Ctx.GF256_MUL_TABLE + ((unsigned)y << 8);
 
     // Handle bytes
@@ -303,8 +435,73 @@ extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTR
         z8++;
         bytes--;
     }
+#endif
+}
+
+#if defined(GF256_SMALL)
+
+// Small builds leave out backend selection (gf256_dispatch.cpp) and bind the
+// bulk operations straight to the scalar kernels
+
+extern "C" void gf256_add_mem(void * GF256_RESTRICT vx,
+                              const void * GF256_RESTRICT vy, int bytes)
+{
+    scalar_add_mem(vx, vy, bytes);
+}
+
+extern "C" void gf256_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                               const void * GF256_RESTRICT vy, int bytes)
+{
+    scalar_add2_mem(vz, vx, vy, bytes);
+}
+
+extern "C" void gf256_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                                 const void * GF256_RESTRICT vy, int bytes)
+{
+    scalar_addset_mem(vz, vx, vy, bytes);
+}
+
+extern "C" void gf256_add_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                                int count, int bytes)
+{
+    scalar_add_n_mem(vz, vx, count, bytes);
+}
+
+extern "C" void gf256_addset_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                                   int count, int bytes)
+{
+    scalar_addset_n_mem(vz, vx, count, bytes);
 }
 
+extern "C" void gf256_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
+                                 const void * GF256_RESTRICT vx, int bytes)
+{
+    scalar_muladd_mem(vz, y, vx, bytes);
+}
+
+extern "C" void gf256_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    scalar_mul_mem(vz, vx, y, bytes);
+}
+
+#else
+
+extern "C" const gf256_kernels gf256_scalar_kernels = {
+    "scalar",
+    nullptr,
+    scalar_add_mem,
+    scalar_add2_mem,
+    scalar_addset_mem,
+    scalar_add_n_mem,
+    scalar_addset_n_mem,
+    scalar_muladd_mem,
+    scalar_mul_mem
+};
+
+#endif // GF256_SMALL
+
+#if defined(NO_SIMD)
+
 extern "C" void gf256_memswap(void * GF256_RESTRICT vx, void * GF256_RESTRICT vy, int bytes)
 {
     uint8_t * GF256_RESTRICT x1 = reinterpret_cast<uint8_t *>(vx);
@@ -0,0 +1,640 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "gf256.h"
+
+#if defined(USE_VECEXT)
+
+// Context object for GF(256) math
+gf256_ctx GF256Ctx;
+static bool Initialized = false;
+
+
+//-----------------------------------------------------------------------------
+// Generator Polynomial
+
+// There are only 16 irreducible polynomials for GF(256)
+static const int GF256_GEN_POLY_COUNT = 16;
+static const uint8_t GF256_GEN_POLY[GF256_GEN_POLY_COUNT] = {
+    0x8e, 0x95, 0x96, 0xa6, 0xaf, 0xb1, 0xb2, 0xb4,
+    0xb8, 0xc3, 0xc6, 0xd4, 0xe1, 0xe7, 0xf3, 0xfa,
+};
+
+static const int DefaultPolynomialIndex = 3;
+
+// Select which polynomial to use
+static void gf255_poly_init(int polynomialIndex)
+{
+    if (polynomialIndex < 0 || polynomialIndex >= GF256_GEN_POLY_COUNT)
+    {
+        polynomialIndex = 0;
+    }
+
+    GF256Ctx.Polynomial = (GF256_GEN_POLY[polynomialIndex] << 1) | 1;
+}
+
+
+//-----------------------------------------------------------------------------
+// Exponential and Log Tables
+
+// Construct EXP and LOG tables from polynomial
+static void gf256_explog_init()
+{
+    unsigned poly = GF256Ctx.Polynomial;
+    uint8_t* exptab = GF256Ctx.GF256_EXP_TABLE;
+    uint16_t* logtab = GF256Ctx.GF256_LOG_TABLE;
+
+    logtab[0] = 512;
+    exptab[0] = 1;
+    for (unsigned jj = 1; jj < 255; ++jj)
+    {
+        unsigned next = (unsigned)exptab[jj - 1] * 2;
+        if (next >= 256) next ^= poly;
+
+        exptab[jj] = static_cast<uint8_t>( next );
+        logtab[exptab[jj]] = static_cast<uint16_t>( jj );
+    }
+
+    exptab[255] = exptab[0];
+    logtab[exptab[255]] = 255;
+
+    for (unsigned jj = 256; jj < 2 * 255; ++jj)
+    {
+        exptab[jj] = exptab[jj % 255];
+    }
+
+    exptab[2 * 255] = 1;
+
+    for (unsigned jj = 2 * 255 + 1; jj < 4 * 255; ++jj)
+    {
+        exptab[jj] = 0;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Multiply and Divide Tables
+
+// Initialize MUL and DIV tables using LOG and EXP tables
+static void gf256_muldiv_init()
+{
+    // Allocate table memory 65KB x 2
+    uint8_t* m = GF256Ctx.GF256_MUL_TABLE;
+    uint8_t* d = GF256Ctx.GF256_DIV_TABLE;
+
+    // Unroll y = 0 subtable
+    for (int x = 0; x < 256; ++x)
+    {
+        m[x] = d[x] = 0;
+    }
+
+    // For each other y value,
+    for (int y = 1; y < 256; ++y)
+    {
+        // Calculate log(y) for mult and 255 - log(y) for div
+        const uint8_t log_y = static_cast<uint8_t>(GF256Ctx.GF256_LOG_TABLE[y]);
+        const uint8_t log_yn = 255 - log_y;
+
+        // Next subtable
+        m += 256;
+        d += 256;
+
+        // Unroll x = 0
+        m[0] = 0;
+        d[0] = 0;
+
+        // Calculate x * y, x / y
+        for (int x = 1; x < 256; ++x)
+        {
+            uint16_t log_x = GF256Ctx.GF256_LOG_TABLE[x];
+
+            m[x] = GF256Ctx.GF256_EXP_TABLE[log_x + log_y];
+            d[x] = GF256Ctx.GF256_EXP_TABLE[log_x + log_yn];
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Inverse Table
+
+// Initialize INV table using DIV table
+static void gf256_inv_init()
+{
+    for (int x = 0; x < 256; ++x)
+    {
+        GF256Ctx.GF256_INV_TABLE[x] = gf256_div(1, static_cast<uint8_t>(x));
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Portable Vectors
+//
+// GCC and Clang vector extensions let the compiler pick the instructions for
+// the target, so this backend needs no intrinsics to run with SIMD on any
+// architecture the compiler can vectorize for.
+//
+// Multiplication uses the same nibble table method as gf256.cpp: each byte is
+// split into its low and high 4 bits, which index 16-byte tables of partial
+// products that are combined with XOR.  GCC's __builtin_shuffle() with a
+// variable mask becomes a single byte shuffle (PSHUFB, VTBL, VPERM, ...)
+// where the target has one.  Clang only offers constant shuffles, so there
+// the lookup is written per lane and left to the auto-vectorizer.
+
+// Targets where the compiler has a native variable byte shuffle.  Elsewhere it
+// would expand the shuffle into a lane-by-lane loop, which is slower than the
+// full multiplication table, so only the XOR kernels are vectorized.
+#if defined(__SSSE3__) || defined(__ARM_NEON) || defined(__ARM_NEON__) || \
+    defined(__aarch64__) || defined(__ALTIVEC__) || defined(__wasm_simd128__)
+    #define GF256_VEC_SHUFFLE
+#endif
+
+// Performs "r[i] = table[index[i] & 15]" for each lane
+static GF256_FORCE_INLINE GF256_M128 gf256_vec_lookup(GF256_M128 table, GF256_M128 index)
+{
+#if defined(__clang__)
+    GF256_M128 result;
+    for (int i = 0; i < 16; ++i)
+    {
+        result[i] = table[index[i] & 15];
+    }
+    return result;
+#else
+    return __builtin_shuffle(table, index);
+#endif
+}
+
+// Performs "r[i] = y * x[i]" for each lane using the nibble tables for y
+static GF256_FORCE_INLINE GF256_M128 gf256_vec_mul(GF256_M128 table_lo_y, GF256_M128 table_hi_y, GF256_M128 x)
+{
+    // Shift in 64-bit lanes since few targets have an 8-bit shift
+    typedef uint64_t gf256_vec2x64 __attribute__((vector_size(16)));
+    const GF256_M128 hi = (GF256_M128)((gf256_vec2x64)x >> 4);
+
+    return gf256_vec_lookup(table_lo_y, x & 0x0f) ^ gf256_vec_lookup(table_hi_y, hi & 0x0f);
+}
+
+static GF256_FORCE_INLINE GF256_M128 gf256_vec_loadu(const void* p)
+{
+    GF256_M128 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static GF256_FORCE_INLINE void gf256_vec_storeu(void* p, GF256_M128 v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+// Initialize the MM256 tables using gf256_mul()
+static void gf256_muladd_mem_init()
+{
+    for (int y = 0; y < 256; ++y)
+    {
+        // TABLE_LO_Y maps 0..15 to 8-bit partial product based on y.
+        for (unsigned char x = 0; x < 16; ++x)
+        {
+            GF256Ctx.MM256_TABLE_LO_Y[y][x] = gf256_mul(x, static_cast<uint8_t>( y ));
+            GF256Ctx.MM256_TABLE_HI_Y[y][x] = gf256_mul(x << 4, static_cast<uint8_t>( y ));
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Initialization
+
+static unsigned char LittleEndianTestData[4] = { 4, 3, 2, 1 };
+static bool IsLittleEndian()
+{
+    return 0x01020304 == *reinterpret_cast<uint32_t*>(LittleEndianTestData);
+}
+
+extern "C" int gf256_init_(int version)
+{
+    if (version != GF256_VERSION)
+    {
+        // User's header does not match library version.
+        return -1;
+    }
+
+    // Avoid multiple initialization
+    if (Initialized)
+    {
+        return 0;
+    }
+    Initialized = true;
+
+    if (!IsLittleEndian())
+    {
+        // Architecture is not supported (code won't work without mods).
+        return -2;
+    }
+
+    gf255_poly_init(DefaultPolynomialIndex);
+    gf256_explog_init();
+    gf256_muldiv_init();
+    gf256_inv_init();
+    gf256_muladd_mem_init();
+
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Operations
+
+static void vec_add_mem(void * GF256_RESTRICT vx,
+                        const void * GF256_RESTRICT vy, int bytes)
+{
+    uint8_t * GF256_RESTRICT x1 = reinterpret_cast<uint8_t *>(vx);
+    const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(vy);
+
+    // Handle multiples of 64 bytes
+    while (bytes >= 64)
+    {
+        const GF256_M128 x0 = gf256_vec_loadu(x1) ^ gf256_vec_loadu(y1);
+        const GF256_M128 x16 = gf256_vec_loadu(x1 + 16) ^ gf256_vec_loadu(y1 + 16);
+        const GF256_M128 x32 = gf256_vec_loadu(x1 + 32) ^ gf256_vec_loadu(y1 + 32);
+        const GF256_M128 x48 = gf256_vec_loadu(x1 + 48) ^ gf256_vec_loadu(y1 + 48);
+        gf256_vec_storeu(x1, x0);
+        gf256_vec_storeu(x1 + 16, x16);
+        gf256_vec_storeu(x1 + 32, x32);
+        gf256_vec_storeu(x1 + 48, x48);
+
+        x1 += 64;
+        y1 += 64;
+        bytes -= 64;
+    }
+
+    // Handle multiples of 16 bytes
+    while (bytes >= 16)
+    {
+        gf256_vec_storeu(x1, gf256_vec_loadu(x1) ^ gf256_vec_loadu(y1));
+
+        x1 += 16;
+        y1 += 16;
+        bytes -= 16;
+    }
+
+    // Handle final bytes
+    while (bytes)
+    {
+        x1[0] ^= y1[0];
+
+        x1++;
+        y1++;
+        bytes--;
+    }
+}
+
+static void vec_add2_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                         const void * GF256_RESTRICT vy, int bytes)
+{
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t *>(vx);
+    const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(vy);
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        const GF256_M128 z0 = gf256_vec_loadu(z1) ^ gf256_vec_loadu(x1) ^ gf256_vec_loadu(y1);
+        const GF256_M128 z16 = gf256_vec_loadu(z1 + 16) ^ gf256_vec_loadu(x1 + 16) ^ gf256_vec_loadu(y1 + 16);
+        gf256_vec_storeu(z1, z0);
+        gf256_vec_storeu(z1 + 16, z16);
+
+        x1 += 32;
+        y1 += 32;
+        z1 += 32;
+        bytes -= 32;
+    }
+
+    // Handle final bytes
+    while (bytes)
+    {
+        z1[0] ^= x1[0] ^ y1[0];
+
+        x1++;
+        y1++;
+        z1++;
+        bytes--;
+    }
+}
+
+static void vec_addset_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx,
+                           const void * GF256_RESTRICT vy, int bytes)
+{
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * GF256_RESTRICT x1 = reinterpret_cast<const uint8_t *>(vx);
+    const uint8_t * GF256_RESTRICT y1 = reinterpret_cast<const uint8_t *>(vy);
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        gf256_vec_storeu(z1, gf256_vec_loadu(x1) ^ gf256_vec_loadu(y1));
+        gf256_vec_storeu(z1 + 16, gf256_vec_loadu(x1 + 16) ^ gf256_vec_loadu(y1 + 16));
+
+        x1 += 32;
+        y1 += 32;
+        z1 += 32;
+        bytes -= 32;
+    }
+
+    // Handle final bytes
+    while (bytes)
+    {
+        z1[0] = x1[0] ^ y1[0];
+
+        x1++;
+        y1++;
+        z1++;
+        bytes--;
+    }
+}
+
+// Prefetch distance for the multi-source XOR, in bytes ahead of the loads
+static const int kAddNPrefetchBytes = 256;
+
+// Sources summed per pass: more streams than this thrash the L1 cache and
+// the hardware prefetchers, so larger counts are split into several passes
+static const int kAddNBatch = 8;
+
+// z[] = (accumulate ? z[] : 0) + x_0[] + ... + x_(count-1)[]
+static GF256_FORCE_INLINE void gf256_add_n_mem_impl(void * GF256_RESTRICT vz, const void * const * vx,
+                                                    int count, int bytes, bool accumulate)
+{
+    uint8_t * GF256_RESTRICT z1 = reinterpret_cast<uint8_t *>(vz);
+    const uint8_t * const * x1 = reinterpret_cast<const uint8_t * const *>(vx);
+    const int first = accumulate ? 0 : 1;
+    int offset = 0;
+
+    // Handle multiples of 64 bytes: sum every source into registers, then store once
+    for (; offset + 64 <= bytes; offset += 64)
+    {
+        const uint8_t * start = accumulate ? z1 + offset : x1[0] + offset;
+        GF256_M128 s0 = gf256_vec_loadu(start);
+        GF256_M128 s1 = gf256_vec_loadu(start + 16);
+        GF256_M128 s2 = gf256_vec_loadu(start + 32);
+        GF256_M128 s3 = gf256_vec_loadu(start + 48);
+
+        for (int i = first; i < count; ++i)
+        {
+            const uint8_t * x = x1[i] + offset;
+            GF256_PREFETCH(x + kAddNPrefetchBytes);
+
+            s0 ^= gf256_vec_loadu(x);
+            s1 ^= gf256_vec_loadu(x + 16);
+            s2 ^= gf256_vec_loadu(x + 32);
+            s3 ^= gf256_vec_loadu(x + 48);
+        }
+
+        gf256_vec_storeu(z1 + offset, s0);
+        gf256_vec_storeu(z1 + offset + 16, s1);
+        gf256_vec_storeu(z1 + offset + 32, s2);
+        gf256_vec_storeu(z1 + offset + 48, s3);
+    }
+
+    // Handle multiples of 16 bytes
+    for (; offset + 16 <= bytes; offset += 16)
+    {
+        GF256_M128 s0 = gf256_vec_loadu(accumulate ? z1 + offset : x1[0] + offset);
+
+        for (int i = first; i < count; ++i)
+        {
+            s0 ^= gf256_vec_loadu(x1[i] + offset);
+        }
+
+        gf256_vec_storeu(z1 + offset, s0);
+    }
+
+    // Handle final bytes
+    for (; offset < bytes; ++offset)
+    {
+        uint8_t s = accumulate ? z1[offset] : x1[0][offset];
+
+        for (int i = first; i < count; ++i)
+        {
+            s ^= x1[i][offset];
+        }
+
+        z1[offset] = s;
+    }
+}
+
+static void vec_addset_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                             int count, int bytes)
+{
+    if (count <= 0)
+    {
+        memset(vz, 0, bytes);
+        return;
+    }
+
+    // First pass sets z, later passes accumulate into it
+    for (int i = 0; i < count; i += kAddNBatch)
+    {
+        const int batch = (count - i < kAddNBatch) ? count - i : kAddNBatch;
+        gf256_add_n_mem_impl(vz, vx + i, batch, bytes, i > 0);
+    }
+}
+
+static void vec_add_n_mem(void * GF256_RESTRICT vz, const void * const * vx,
+                          int count, int bytes)
+{
+    for (int i = 0; i < count; i += kAddNBatch)
+    {
+        const int batch = (count - i < kAddNBatch) ? count - i : kAddNBatch;
+        gf256_add_n_mem_impl(vz, vx + i, batch, bytes, true);
+    }
+}
+
+static void vec_muladd_mem(void * GF256_RESTRICT vz, uint8_t y,
+                           const void * GF256_RESTRICT vx, int bytes)
+{
+    // Use a single if-statement to handle special cases
+    if (y <= 1)
+    {
+        if (y == 1)
+        {
+            vec_add_mem(vz, vx, bytes);
+        }
+        return;
+    }
+
+    uint8_t * GF256_RESTRICT z8 = reinterpret_cast<uint8_t*>(vz);
+    const uint8_t * GF256_RESTRICT x8 = reinterpret_cast<const uint8_t*>(vx);
+
+#if defined(GF256_VEC_SHUFFLE)
+    // Partial product tables; see above
+    const GF256_M128 table_lo_y = GF256Ctx.MM256_TABLE_LO_Y[y];
+    const GF256_M128 table_hi_y = GF256Ctx.MM256_TABLE_HI_Y[y];
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        const GF256_M128 x0 = gf256_vec_loadu(x8);
+        const GF256_M128 x16 = gf256_vec_loadu(x8 + 16);
+        const GF256_M128 p0 = gf256_vec_mul(table_lo_y, table_hi_y, x0);
+        const GF256_M128 p16 = gf256_vec_mul(table_lo_y, table_hi_y, x16);
+        gf256_vec_storeu(z8, gf256_vec_loadu(z8) ^ p0);
+        gf256_vec_storeu(z8 + 16, gf256_vec_loadu(z8 + 16) ^ p16);
+
+        x8 += 32;
+        z8 += 32;
+        bytes -= 32;
+    }
+
+    // Handle a block of 16 bytes
+    if (bytes >= 16)
+    {
+        const GF256_M128 x0 = gf256_vec_loadu(x8);
+        const GF256_M128 p0 = gf256_vec_mul(table_lo_y, table_hi_y, x0);
+        gf256_vec_storeu(z8, gf256_vec_loadu(z8) ^ p0);
+
+        x8 += 16;
+        z8 += 16;
+        bytes -= 16;
+    }
+#endif // GF256_VEC_SHUFFLE
+
+    const uint8_t * GF256_RESTRICT table = GF256Ctx.GF256_MUL_TABLE + ((unsigned)y << 8);
+
+    // Handle final bytes
+    while (bytes)
+    {
+        z8[0] ^= table[x8[0]];
+
+        x8++;
+        z8++;
+        bytes--;
+    }
+}
+
+static void vec_mul_mem(void * GF256_RESTRICT vz, const void * GF256_RESTRICT vx, uint8_t y, int bytes)
+{
+    // Use a single if-statement to handle special cases
+    if (y <= 1)
+    {
+        if (y == 0)
+        {
+            memset(vz, 0, bytes);
+        }
+        return;
+    }
+
+    uint8_t * GF256_RESTRICT z8 = reinterpret_cast<uint8_t*>(vz);
+    const uint8_t * GF256_RESTRICT x8 = reinterpret_cast<const uint8_t*>(vx);
+
+#if defined(GF256_VEC_SHUFFLE)
+    // Partial product tables; see above
+    const GF256_M128 table_lo_y = GF256Ctx.MM256_TABLE_LO_Y[y];
+    const GF256_M128 table_hi_y = GF256Ctx.MM256_TABLE_HI_Y[y];
+
+    // Handle multiples of 32 bytes
+    while (bytes >= 32)
+    {
+        const GF256_M128 x0 = gf256_vec_loadu(x8);
+        const GF256_M128 x16 = gf256_vec_loadu(x8 + 16);
+        gf256_vec_storeu(z8, gf256_vec_mul(table_lo_y, table_hi_y, x0));
+        gf256_vec_storeu(z8 + 16, gf256_vec_mul(table_lo_y, table_hi_y, x16));
+
+        x8 += 32;
+        z8 += 32;
+        bytes -= 32;
+    }
+
+    // Handle a block of 16 bytes
+    if (bytes >= 16)
+    {
+        const GF256_M128 x0 = gf256_vec_loadu(x8);
+        gf256_vec_storeu(z8, gf256_vec_mul(table_lo_y, table_hi_y, x0));
+
+        x8 += 16;
+        z8 += 16;
+        bytes -= 16;
+    }
+#endif // GF256_VEC_SHUFFLE
+
+    const uint8_t * GF256_RESTRICT table = GF256Ctx.GF256_MUL_TABLE + ((unsigned)y << 8);
+
+    // Handle final bytes
+    while (bytes)
+    {
+        z8[0] = table[x8[0]];
+
+        x8++;
+        z8++;
+        bytes--;
+    }
+}
+
+extern "C" const gf256_kernels gf256_native_kernels = {
+    "vecext",
+    nullptr,
+    vec_add_mem,
+    vec_add2_mem,
+    vec_addset_mem,
+    vec_add_n_mem,
+    vec_addset_n_mem,
+    vec_muladd_mem,
+    vec_mul_mem
+};
+
+extern "C" void gf256_memswap(void * GF256_RESTRICT vx, void * GF256_RESTRICT vy, int bytes)
+{
+    uint8_t * GF256_RESTRICT x1 = reinterpret_cast<uint8_t *>(vx);
+    uint8_t * GF256_RESTRICT y1 = reinterpret_cast<uint8_t *>(vy);
+
+    // Handle blocks of 16 bytes
+    while (bytes >= 16)
+    {
+        const GF256_M128 x0 = gf256_vec_loadu(x1);
+        const GF256_M128 y0 = gf256_vec_loadu(y1);
+        gf256_vec_storeu(x1, y0);
+        gf256_vec_storeu(y1, x0);
+
+        x1 += 16;
+        y1 += 16;
+        bytes -= 16;
+    }
+
+    // Handle final bytes
+    while (bytes)
+    {
+        uint8_t temp = x1[0];
+        x1[0] = y1[0];
+        y1[0] = temp;
+
+        x1++;
+        y1++;
+        bytes--;
+    }
+}
+
+#endif
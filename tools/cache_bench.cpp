@@ -0,0 +1,209 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Write amplification benchmark for the write-back stripe cache.
+
+    Usage: cache_bench [key=value ...]
+
+        dir=.          Directory for the backing files
+        k=8 m=2        Data and parity device counts
+        unit=65536     Stripe unit in bytes
+        size=64        Volume size in MiB
+        bs=4096        Write size in bytes
+        dirty=64       Maximum dirty stripes held by the cache
+        hot=0          Restrict random writes to this many MiB, or 0 for all
+
+    Writes the volume once sequentially and once at random offsets, both
+    directly and through the cache, and reports device bytes per user byte
+    and CPU time per MB for each.
+*/
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "../cm256_stripe_cache.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+static long long getCpuUSecs()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (long long) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000L +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static std::string getOption(int argc, char** argv, const char* key, const char* defaultValue)
+{
+    const size_t keyLength = strlen(key);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], key, keyLength) == 0 && argv[i][keyLength] == '=')
+        {
+            return argv[i] + keyLength + 1;
+        }
+    }
+    return defaultValue;
+}
+
+int main(int argc, char** argv)
+{
+    const std::string dir = getOption(argc, argv, "dir", ".");
+    const int blockSize = atoi(getOption(argc, argv, "bs", "4096").c_str());
+    const int maxDirty = atoi(getOption(argc, argv, "dirty", "64").c_str());
+    const uint64_t sizeBytes = strtoull(getOption(argc, argv, "size", "64").c_str(), nullptr, 10) << 20;
+    const uint64_t hotBytes = strtoull(getOption(argc, argv, "hot", "0").c_str(), nullptr, 10) << 20;
+
+    cm256_volume_params params;
+    params.OriginalCount = atoi(getOption(argc, argv, "k", "8").c_str());
+    params.RecoveryCount = atoi(getOption(argc, argv, "m", "2").c_str());
+    params.StripeUnit = atoi(getOption(argc, argv, "unit", "65536").c_str());
+    params.StripeCount = sizeBytes / ((uint64_t)params.StripeUnit * params.OriginalCount);
+
+    std::vector<std::string> paths;
+    std::vector<const char*> pathPointers;
+    for (int i = 0; i < params.OriginalCount + params.RecoveryCount; ++i)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "/cache_bench.%d", i);
+        paths.push_back(dir + name);
+    }
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        pathPointers.push_back(paths[i].c_str());
+    }
+
+    cm256_volume* volume = cm256_volume_open(&pathPointers[0], params, 1);
+    if (!volume || params.StripeCount == 0 || blockSize <= 0)
+    {
+        std::cerr << "Failed to open volume" << std::endl;
+        return 1;
+    }
+
+    const uint64_t volumeBytes = cm256_volume_size(volume);
+    const uint64_t blockCount = volumeBytes / blockSize;
+    const uint64_t hotCount = (hotBytes > 0 && hotBytes < volumeBytes) ? hotBytes / blockSize : blockCount;
+
+    std::vector<uint8_t> buffer(blockSize);
+    for (int i = 0; i < blockSize; ++i)
+    {
+        buffer[i] = (uint8_t)(i * 7);
+    }
+
+    std::cout << "k=" << params.OriginalCount << " m=" << params.RecoveryCount
+              << " unit=" << params.StripeUnit << " bs=" << blockSize
+              << " dirty=" << maxDirty << std::endl;
+
+    int failures = 0;
+
+    for (int pattern = 0; pattern < 2; ++pattern)
+    {
+        for (int cached = 0; cached < 2; ++cached)
+        {
+            cm256_stripe_cache* cache = nullptr;
+            if (cached)
+            {
+                cm256_stripe_cache_params cacheParams;
+                cacheParams.MaxDirtyStripes = maxDirty;
+                cacheParams.FlushIntervalMsec = 0;
+                cache = cm256_stripe_cache_create(volume, cacheParams);
+            }
+
+            cm256_volume_stats before;
+            cm256_volume_get_stats(volume, &before);
+
+            srand(1);
+            const long long cpu0 = getCpuUSecs();
+            const long long t0 = getUSecs();
+
+            for (uint64_t i = 0; i < blockCount; ++i)
+            {
+                uint64_t block = i;
+                if (pattern == 1)
+                {
+                    block = (((uint64_t)rand() << 31) ^ (uint64_t)rand()) % hotCount;
+                }
+
+                const int result = cache ?
+                    cm256_stripe_cache_write(cache, &buffer[0], blockSize, block * blockSize) :
+                    cm256_volume_pwrite(volume, &buffer[0], blockSize, block * blockSize);
+                failures += (result != 0);
+            }
+
+            cm256_stripe_cache_stats cacheStats;
+            memset(&cacheStats, 0, sizeof(cacheStats));
+            if (cache)
+            {
+                failures += (cm256_stripe_cache_flush(cache) != 0);
+                cm256_stripe_cache_get_stats(cache, &cacheStats);
+                cm256_stripe_cache_destroy(cache);
+            }
+
+            const long long usecs = getUSecs() - t0;
+            const long long cpuUsecs = getCpuUSecs() - cpu0;
+
+            cm256_volume_stats after;
+            cm256_volume_get_stats(volume, &after);
+
+            const double userBytes = (double)blockCount * blockSize;
+
+            std::cout << (pattern ? "  randwrite" : "  write") << (cached ? " cached: " : " direct: ")
+                      << "bw=" << userBytes / usecs << " MB/s"
+                      << " device read/user byte=" << (after.DeviceReadBytes - before.DeviceReadBytes) / userBytes
+                      << " device write/user byte=" << (after.DeviceWriteBytes - before.DeviceWriteBytes) / userBytes
+                      << " cpu=" << cpuUsecs / (userBytes / 1000000.) << " usec/MB" << std::endl;
+            if (cache)
+            {
+                std::cout << "    flushes: full=" << cacheStats.FullStripeFlushes
+                          << " completed=" << cacheStats.CompletedStripeFlushes
+                          << " delta=" << cacheStats.DeltaStripeFlushes << std::endl;
+            }
+        }
+    }
+
+    cm256_volume_close(volume);
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        unlink(paths[i].c_str());
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Carousel broadcast benchmark.
+
+    Usage: carousel_bench [megabytes]
+
+    Compares sender CPU per cycle for the carousel, which encodes each
+    recovery row once, with calling cm256_encode() for every superframe every
+    cycle.  Then, for several random loss rates, reports how many packets a
+    receiver that joins at a random point has to hear to complete every
+    superframe, relative to the number of original blocks.
+*/
+
+#include <iostream>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include "../cm256_carousel.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+int main(int argc, char** argv)
+{
+    const int megabytes = argc > 1 ? atoi(argv[1]) : 16;
+
+    if (cm256_init() || megabytes <= 0)
+    {
+        return 1;
+    }
+
+    cm256_carousel_params params;
+    params.OriginalCount = 64;
+    params.BlockBytes = 1296;
+    params.RecoveryPerCycle = 16;
+    params.RecoveryRows = 64;
+
+    const uint64_t bytes = (uint64_t)megabytes << 20;
+    std::vector<uint8_t> data((size_t)bytes);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    long long t0 = getUSecs();
+    cm256_carousel* carousel = cm256_carousel_create(params, &data[0], bytes);
+    const long long createUsecs = getUSecs() - t0;
+    if (!carousel)
+    {
+        return 1;
+    }
+
+    const uint32_t superframeCount = cm256_carousel_superframe_count(carousel);
+    const uint64_t packetsPerCycle = (uint64_t)superframeCount * (params.OriginalCount + params.RecoveryPerCycle);
+    const int cycles = 4;
+
+    // Carousel: walk the schedule, touching each packet as a sender would.
+    // The first cycles encode rows as they come up, after that nothing is encoded
+    const int warmCycles = params.RecoveryRows / params.RecoveryPerCycle;
+    unsigned checksum = 0;
+    long long carouselUsecs[2];
+    for (int phase = 0; phase < 2; ++phase)
+    {
+        t0 = getUSecs();
+        for (uint64_t i = 0; i < packetsPerCycle * (phase ? cycles : warmCycles); ++i)
+        {
+            cm256_carousel_packet packet;
+            cm256_carousel_next(carousel, &packet);
+            checksum += static_cast<const uint8_t*>(packet.Block)[0];
+        }
+        carouselUsecs[phase] = getUSecs() - t0;
+    }
+
+    // Re-encoding every superframe every cycle
+    cm256_encoder_params encoderParams;
+    encoderParams.OriginalCount = params.OriginalCount;
+    encoderParams.RecoveryCount = params.RecoveryPerCycle;
+    encoderParams.BlockBytes = params.BlockBytes;
+
+    std::vector<uint8_t> padded((size_t)superframeCount * params.OriginalCount * params.BlockBytes, 0);
+    memcpy(&padded[0], &data[0], (size_t)bytes);
+    std::vector<uint8_t> recovery((size_t)params.RecoveryPerCycle * params.BlockBytes);
+
+    t0 = getUSecs();
+    for (int cycle = 0; cycle < cycles; ++cycle)
+    {
+        for (uint32_t superframe = 0; superframe < superframeCount; ++superframe)
+        {
+            cm256_block blocks[256];
+            for (int i = 0; i < params.OriginalCount; ++i)
+            {
+                blocks[i].Block = &padded[((size_t)superframe * params.OriginalCount + i) * params.BlockBytes];
+                blocks[i].Index = (unsigned char)i;
+            }
+            cm256_encode(encoderParams, blocks, &recovery[0]);
+            checksum += recovery[0];
+        }
+    }
+    const long long encodeUsecs = getUSecs() - t0;
+
+    cm256_carousel_stats stats;
+    cm256_carousel_get_stats(carousel, &stats);
+
+    std::cout << megabytes << " MB, k=" << params.OriginalCount << " recovery/cycle=" << params.RecoveryPerCycle
+              << " rows=" << params.RecoveryRows << " bytes=" << params.BlockBytes << ", " << superframeCount << " superframes" << std::endl;
+    std::cout << "  create " << createUsecs / 1000. << " ms, sender cpu per cycle: carousel "
+              << carouselUsecs[0] / 1000. / warmCycles << " ms while rows are encoded, "
+              << carouselUsecs[1] / 1000. / cycles << " ms after; re-encode "
+              << encodeUsecs / 1000. / cycles << " ms; buffer " << stats.BufferBytes / 1048576. << " MB"
+              << (checksum == 0xffffffff ? " " : "") << std::endl;
+
+    static const int lossPercents[] = { 5, 10, 20, 40 };
+    for (size_t l = 0; l < sizeof(lossPercents) / sizeof(lossPercents[0]); ++l)
+    {
+        cm256_carousel_receiver* receiver = cm256_carousel_receiver_create(params, bytes);
+        if (!receiver)
+        {
+            return 1;
+        }
+
+        // Join at a random point in the schedule
+        uint32_t seed = 1000 + (uint32_t)l;
+        for (uint32_t skip = rand() % (uint32_t)packetsPerCycle; skip > 0; --skip)
+        {
+            cm256_carousel_packet packet;
+            cm256_carousel_next(carousel, &packet);
+        }
+
+        uint64_t heard = 0;
+        while (cm256_carousel_receiver_complete_count(receiver) < superframeCount)
+        {
+            cm256_carousel_packet packet;
+            cm256_carousel_next(carousel, &packet);
+
+            seed = seed * 1103515245 + 12345;
+            if ((int)((seed >> 16) % 100) < lossPercents[l])
+            {
+                continue;
+            }
+
+            ++heard;
+            if (cm256_carousel_receive(receiver, &packet) < 0)
+            {
+                std::cout << "  receive FAILED" << std::endl;
+                return 1;
+            }
+        }
+
+        const bool ok = memcmp(cm256_carousel_receiver_data(receiver), &data[0], (size_t)bytes) == 0;
+        std::cout << "  loss " << lossPercents[l] << "%: heard " << heard << " packets, "
+                  << (double)heard / ((double)superframeCount * params.OriginalCount)
+                  << "x the originals" << (ok ? "" : " FAILED") << std::endl;
+
+        cm256_carousel_receiver_destroy(receiver);
+    }
+
+    cm256_carousel_destroy(carousel);
+    return 0;
+}
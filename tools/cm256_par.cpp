@@ -0,0 +1,194 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Par2-style parity files for a set of large files.
+
+    Usage: cm256_par create par=BASE [m=2] [window=1048576] [threads=0] file0 ... fileN
+           cm256_par verify par=BASE [threads=0] file0 ... fileN
+           cm256_par repair par=BASE [threads=0] file0 ... fileN
+
+    create writes m parity files BASE.p0 ... BASE.p(m-1) protecting the input
+    files, streaming one window of every file at a time on each thread.
+    verify checks each window of the files and parity against the CRCs in the
+    parity headers, and repair rewrites missing or damaged windows.  The files
+    must be listed in the same order every time.
+
+    Exits with 0 if the set is intact or was repaired, 1 if damage was found
+    or could not be repaired, and 2 on error.
+*/
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <string>
+#include <vector>
+
+#include "../cm256_fileset.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+static std::string getOption(int argc, char** argv, const char* key, const char* defaultValue)
+{
+    const size_t keyLength = strlen(key);
+    for (int i = 2; i < argc; ++i)
+    {
+        if (strncmp(argv[i], key, keyLength) == 0 && argv[i][keyLength] == '=')
+        {
+            return argv[i] + keyLength + 1;
+        }
+    }
+    return defaultValue;
+}
+
+static bool isOption(const char* arg)
+{
+    static const char* const options[] = { "par=", "m=", "window=", "threads=" };
+    for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); ++i)
+    {
+        if (strncmp(arg, options[i], strlen(options[i])) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::string parityPath(const std::string& base, int index)
+{
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".p%d", index);
+    return base + suffix;
+}
+
+int main(int argc, char** argv)
+{
+    const std::string command = argc > 1 ? argv[1] : "";
+    const std::string base = getOption(argc, argv, "par", "");
+    const int threads = atoi(getOption(argc, argv, "threads", "0").c_str());
+
+    std::vector<const char*> inputs;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (!isOption(argv[i]))
+        {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    if ((command != "create" && command != "verify" && command != "repair") ||
+        base.empty() || inputs.empty() || threads < 0)
+    {
+        std::cerr << "Usage: cm256_par create|verify|repair par=BASE [m=2] [window=1048576] [threads=0] file0 ... fileN" << std::endl;
+        return 2;
+    }
+
+    int m = atoi(getOption(argc, argv, "m", "2").c_str());
+    if (command != "create")
+    {
+        // Any intact parity file records the parity count
+        int k = 0;
+        m = 0;
+        for (int i = 0; i < 256 && m == 0; ++i)
+        {
+            if (cm256_fileset_info(parityPath(base, i).c_str(), &k, &m) != 0)
+            {
+                m = 0;
+            }
+        }
+        if (m == 0)
+        {
+            std::cerr << "No intact parity files found for " << base << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<std::string> parityNames;
+    std::vector<const char*> parity;
+    for (int i = 0; i < m; ++i)
+    {
+        parityNames.push_back(parityPath(base, i));
+    }
+    for (int i = 0; i < m; ++i)
+    {
+        parity.push_back(parityNames[i].c_str());
+    }
+
+    const long long t0 = getUSecs();
+
+    if (command == "create")
+    {
+        cm256_fileset_params params;
+        params.WindowBytes = atoi(getOption(argc, argv, "window", "0").c_str());
+        params.ThreadCount = threads;
+
+        const int result = cm256_fileset_create(&inputs[0], (int)inputs.size(), &parity[0], m, params);
+        if (result != 0)
+        {
+            std::cerr << "Create failed: " << result << std::endl;
+            return 2;
+        }
+
+        std::cout << "Wrote " << m << " parity files for " << inputs.size() << " files in "
+                  << (getUSecs() - t0) / 1000 << " msec" << std::endl;
+        return 0;
+    }
+
+    cm256_fileset_report report;
+    const int result = cm256_fileset_check(&inputs[0], (int)inputs.size(), &parity[0], m, threads,
+                                           command == "repair", &report);
+    if (result != 0 && result != -10)
+    {
+        std::cerr << command << " failed: " << result << std::endl;
+        return 2;
+    }
+
+    const long long usecs = getUSecs() - t0;
+    std::cout << report.WindowCount << " windows: " << report.DamagedWindows << " damaged input windows ("
+              << report.DamagedFiles << " missing or resized files), " << report.DamagedParityWindows
+              << " damaged parity windows, " << report.UnrecoverableWindows << " unrecoverable" << std::endl;
+    std::cout << "Read " << report.ReadBytes << " bytes (" << (double)report.ReadBytes / usecs << " MB/s), wrote "
+              << report.WrittenBytes << " bytes, repaired " << report.RepairedWindows << " windows" << std::endl;
+
+    if (report.UnrecoverableWindows > 0)
+    {
+        return 1;
+    }
+    if (command == "verify" && (report.DamagedWindows > 0 || report.DamagedParityWindows > 0 || report.DamagedFiles > 0))
+    {
+        return 1;
+    }
+    return 0;
+}
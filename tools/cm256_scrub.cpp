@@ -0,0 +1,433 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Background scrubber for K+M shard files.
+
+    Usage: cm256_scrub k=K m=M block=BYTES [options] shard0 ... shard(K+M-1)
+
+        k, m           Original and recovery shard counts
+        block=65536    Bytes per block; stripe s is stored at s * block
+        layout=shard   shard: file i holds block i of every stripe
+                       volume: block c of stripe s is in file (c + s) % (k + m),
+                       matching cm256_volume
+        chunk=4        MiB read from each shard per request
+        rate=0         Throttle to this many MB/s of shard reads, 0 for no limit
+        cpu=0          Throttle to this percentage of one CPU, 0 for no limit
+        checkpoint=    File to resume from and record progress in
+
+    Each chunk is read from every shard with one large sequential read, and
+    each stripe is checked with cm256_verify(), which never materializes the
+    recovery blocks.  For stripes that do not match, the scrubber tries to
+    locate a single bad block from the pattern of recovery mismatches.
+
+    Exits with 0 if all stripes match, 1 if mismatches were found and 2 on
+    error.  A resumed scrub counts the mismatches found before it stopped.
+*/
+
+#include <iostream>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "../cm256.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+static long long getCpuUSecs()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (long long) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000L +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static std::string getOption(int argc, char** argv, const char* key, const char* defaultValue)
+{
+    const size_t keyLength = strlen(key);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], key, keyLength) == 0 && argv[i][keyLength] == '=')
+        {
+            return argv[i] + keyLength + 1;
+        }
+    }
+    return defaultValue;
+}
+
+// Read exactly 'bytes' bytes, treating anything past the end of the file as zeroes
+static bool readFully(int fd, uint8_t* data, size_t bytes, off_t position)
+{
+    while (bytes > 0)
+    {
+        const ssize_t result = pread(fd, data, bytes, position);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        if (result == 0)
+        {
+            memset(data, 0, bytes);
+            return true;
+        }
+        data += result;
+        position += result;
+        bytes -= result;
+    }
+    return true;
+}
+
+/*
+    The checkpoint holds the next stripe to scrub and the number of bad stripes
+    found so far, followed by their indices, so a resumed scrub still reports
+    the mismatches found before it was interrupted.
+*/
+static uint64_t loadCheckpoint(const std::string& path, std::vector<uint64_t>& badList)
+{
+    uint64_t stripe = 0;
+    FILE* file = path.empty() ? nullptr : fopen(path.c_str(), "r");
+    if (file)
+    {
+        unsigned long long value = 0, badCount = 0;
+        if (fscanf(file, "%llu", &value) == 1)
+        {
+            stripe = value;
+        }
+        if (fscanf(file, "%llu", &badCount) == 1)
+        {
+            for (unsigned long long i = 0; i < badCount && fscanf(file, "%llu", &value) == 1; ++i)
+            {
+                badList.push_back(value);
+            }
+        }
+        fclose(file);
+    }
+    return stripe;
+}
+
+static void saveCheckpoint(const std::string& path, uint64_t stripe, const std::vector<uint64_t>& badList)
+{
+    if (path.empty())
+    {
+        return;
+    }
+
+    // Replace the checkpoint atomically so a crash never leaves it half written
+    const std::string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "w");
+    if (file)
+    {
+        fprintf(file, "%llu %llu\n", (unsigned long long)stripe, (unsigned long long)badList.size());
+        for (size_t i = 0; i < badList.size(); ++i)
+        {
+            fprintf(file, "%llu\n", (unsigned long long)badList[i]);
+        }
+        fclose(file);
+        rename(temp.c_str(), path.c_str());
+    }
+}
+
+/*
+    Find the one block that explains every mismatch in a stripe, if there is one.
+
+    If only original j is bad, by an error e, each recovery row r is off by
+    c_rj * e, so dividing each row's syndrome by c_rj gives the same e for all
+    rows.  If only a recovery block is bad, only its own row is off.
+
+    Returns the block index, or -1 if no single block explains the syndromes.
+*/
+static int locateBadBlock(cm256_encoder_params params, cm256_block* originals,
+                          const cm256_block* recovery, const unsigned char* mismatches)
+{
+    const int m = params.RecoveryCount;
+
+    int mismatchCount = 0, mismatchRow = -1;
+    for (int r = 0; r < m; ++r)
+    {
+        if (mismatches[r])
+        {
+            ++mismatchCount;
+            mismatchRow = r;
+        }
+    }
+    if (mismatchCount == 1 && m > 1)
+    {
+        return recovery[mismatchRow].Index;
+    }
+    if (mismatchCount != m)
+    {
+        return -1;
+    }
+
+    // With one recovery row any original could explain it
+    if (m == 1)
+    {
+        return -1;
+    }
+
+    // Compute the syndromes; this only happens for bad stripes
+    std::vector<uint8_t> syndromes((size_t)m * params.BlockBytes);
+    for (int r = 0; r < m; ++r)
+    {
+        uint8_t* syndrome = &syndromes[(size_t)r * params.BlockBytes];
+        cm256_encode_block(params, originals, recovery[r].Index, syndrome);
+        gf256_add_mem(syndrome, recovery[r].Block, params.BlockBytes);
+    }
+
+    for (int j = 0; j < params.OriginalCount; ++j)
+    {
+        uint8_t coefficients[256];
+        for (int r = 0; r < m; ++r)
+        {
+            coefficients[r] = cm256_get_recovery_coefficient(params, recovery[r].Index, j);
+        }
+
+        bool explains = true;
+        for (int i = 0; explains && i < params.BlockBytes; ++i)
+        {
+            const uint8_t e = gf256_div(syndromes[i], coefficients[0]);
+            for (int r = 1; explains && r < m; ++r)
+            {
+                explains = syndromes[(size_t)r * params.BlockBytes + i] == gf256_mul(e, coefficients[r]);
+            }
+        }
+        if (explains)
+        {
+            return j;
+        }
+    }
+
+    return -1;
+}
+
+int main(int argc, char** argv)
+{
+    cm256_encoder_params params;
+    params.OriginalCount = atoi(getOption(argc, argv, "k", "0").c_str());
+    params.RecoveryCount = atoi(getOption(argc, argv, "m", "0").c_str());
+    params.BlockBytes = atoi(getOption(argc, argv, "block", "65536").c_str());
+
+    const bool volumeLayout = getOption(argc, argv, "layout", "shard") == "volume";
+    const int chunkBytes = atoi(getOption(argc, argv, "chunk", "4").c_str()) << 20;
+    const double rate = atof(getOption(argc, argv, "rate", "0").c_str());
+    const double cpuShare = atof(getOption(argc, argv, "cpu", "0").c_str()) / 100.;
+    const std::string checkpoint = getOption(argc, argv, "checkpoint", "");
+
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strchr(argv[i], '='))
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    const int shardCount = params.OriginalCount + params.RecoveryCount;
+    if (cm256_init() || params.OriginalCount <= 0 || params.RecoveryCount <= 0 ||
+        shardCount > CM256_MAX_BLOCKS || params.BlockBytes <= 0 || (int)paths.size() != shardCount)
+    {
+        std::cerr << "Usage: cm256_scrub k=K m=M block=BYTES [layout=shard|volume] [chunk=MiB]"
+                  << " [rate=MB/s] [cpu=percent] [checkpoint=path] shard0 ... shard(K+M-1)" << std::endl;
+        return 2;
+    }
+
+    std::vector<int> files(shardCount);
+    uint64_t stripeCount = 0;
+    for (int i = 0; i < shardCount; ++i)
+    {
+        files[i] = open(paths[i].c_str(), O_RDONLY);
+        struct stat st;
+        if (files[i] < 0 || fstat(files[i], &st) != 0)
+        {
+            std::cerr << "Failed to open " << paths[i] << std::endl;
+            return 2;
+        }
+        posix_fadvise(files[i], 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        const uint64_t stripes = ((uint64_t)st.st_size + params.BlockBytes - 1) / params.BlockBytes;
+        if (stripes > stripeCount)
+        {
+            stripeCount = stripes;
+        }
+    }
+
+    int chunkStripes = chunkBytes / params.BlockBytes;
+    if (chunkStripes < 1)
+    {
+        chunkStripes = 1;
+    }
+
+    std::vector<uint8_t> chunk((size_t)shardCount * chunkStripes * params.BlockBytes);
+    std::vector<unsigned char> mismatches(params.RecoveryCount);
+
+    std::vector<uint64_t> badList;
+    const uint64_t firstStripe = loadCheckpoint(checkpoint, badList);
+    if (firstStripe > 0)
+    {
+        std::cerr << "Resuming at stripe " << firstStripe << " with " << badList.size() << " bad stripes";
+        for (size_t i = 0; i < badList.size(); ++i)
+        {
+            std::cerr << (i == 0 ? ": " : " ") << badList[i];
+        }
+        std::cerr << std::endl;
+    }
+
+    uint64_t badStripes = 0, bytesRead = 0;
+    const long long t0 = getUSecs();
+    const long long cpu0 = getCpuUSecs();
+
+    for (uint64_t stripe = firstStripe; stripe < stripeCount; stripe += chunkStripes)
+    {
+        const int stripes = stripeCount - stripe < (uint64_t)chunkStripes ? (int)(stripeCount - stripe) : chunkStripes;
+        const size_t shardBytes = (size_t)stripes * params.BlockBytes;
+
+        // One large sequential read per shard
+        for (int i = 0; i < shardCount; ++i)
+        {
+            if (!readFully(files[i], &chunk[i * shardBytes], shardBytes, (off_t)(stripe * params.BlockBytes)))
+            {
+                std::cerr << "Read failed on " << paths[i] << std::endl;
+                return 2;
+            }
+        }
+        bytesRead += shardBytes * shardCount;
+
+        for (int s = 0; s < stripes; ++s)
+        {
+            const uint64_t stripeIndex = stripe + s;
+            cm256_block originals[256], recovery[256];
+
+            for (int c = 0; c < shardCount; ++c)
+            {
+                const int shard = volumeLayout ? (int)((c + stripeIndex) % shardCount) : c;
+                uint8_t* block = &chunk[shard * shardBytes + (size_t)s * params.BlockBytes];
+
+                if (c < params.OriginalCount)
+                {
+                    originals[c].Block = block;
+                    originals[c].Index = (unsigned char)c;
+                }
+                else
+                {
+                    recovery[c - params.OriginalCount].Block = block;
+                    recovery[c - params.OriginalCount].Index = (unsigned char)c;
+                }
+            }
+
+            if (cm256_verify(params, originals, recovery, &mismatches[0]) == 0)
+            {
+                continue;
+            }
+
+            ++badStripes;
+            badList.push_back(stripeIndex);
+            std::cout << "stripe " << stripeIndex << ": recovery mismatch in blocks";
+            for (int r = 0; r < params.RecoveryCount; ++r)
+            {
+                if (mismatches[r])
+                {
+                    std::cout << " " << params.OriginalCount + r;
+                }
+            }
+
+            const int bad = locateBadBlock(params, originals, recovery, &mismatches[0]);
+            if (bad >= 0)
+            {
+                const int shard = volumeLayout ? (int)((bad + stripeIndex) % shardCount) : bad;
+                std::cout << "; bad block " << bad << " in " << paths[shard] << std::endl;
+            }
+            else
+            {
+                std::cout << "; more than one bad block" << std::endl;
+            }
+        }
+
+        saveCheckpoint(checkpoint, stripe + stripes, badList);
+
+        // Sleep until both the read rate and the CPU share are back under their limits
+        const long long elapsed = getUSecs() - t0;
+        long long target = elapsed;
+        if (rate > 0)
+        {
+            const long long rateTarget = (long long)(bytesRead / rate);
+            if (rateTarget > target)
+            {
+                target = rateTarget;
+            }
+        }
+        if (cpuShare > 0)
+        {
+            const long long cpuTarget = (long long)((getCpuUSecs() - cpu0) / cpuShare);
+            if (cpuTarget > target)
+            {
+                target = cpuTarget;
+            }
+        }
+        if (target > elapsed)
+        {
+            usleep((useconds_t)(target - elapsed));
+        }
+    }
+
+    const long long usecs = getUSecs() - t0;
+    const long long cpuUsecs = getCpuUSecs() - cpu0;
+
+    std::cerr << "Scrubbed " << stripeCount - firstStripe << " stripes, " << badStripes << " bad (" << badList.size() << " in total), "
+              << (usecs > 0 ? bytesRead / (double)usecs : 0.) << " MB/s, cpu "
+              << (usecs > 0 ? 100. * cpuUsecs / usecs : 0.) << "%" << std::endl;
+
+    // A finished scrub starts over next time
+    if (!checkpoint.empty())
+    {
+        unlink(checkpoint.c_str());
+    }
+
+    for (int i = 0; i < shardCount; ++i)
+    {
+        close(files[i]);
+    }
+
+    return badList.empty() ? 0 : 1;
+}
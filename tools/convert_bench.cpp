@@ -0,0 +1,159 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Stripe conversion benchmark.
+
+    Usage: convert_bench [blockBytes]
+
+    For several narrow-to-wide shapes, compares cm256_convert() with reading
+    every original and running cm256_encode() for the wide stripe, reporting
+    the blocks read and the CPU time of each.
+*/
+
+#include <iostream>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include "../cm256_convert.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+struct Stripes
+{
+    cm256_convert_params Params;
+    std::vector<uint8_t> Data; // Each narrow stripe's originals then recovery blocks, end-to-end
+    uint64_t BytesRead;
+};
+
+static uint8_t* getBlock(Stripes* stripes, int stripe, int blockIndex)
+{
+    const cm256_convert_params& params = stripes->Params;
+    const int stripeBlocks = params.StripeOriginalCount + params.StripeRecoveryCount;
+    return &stripes->Data[((size_t)stripe * stripeBlocks + blockIndex) * params.BlockBytes];
+}
+
+static int readStripe(void* context, int stripe, int blockIndex, void* data)
+{
+    Stripes* stripes = static_cast<Stripes*>(context);
+    memcpy(data, getBlock(stripes, stripe, blockIndex), stripes->Params.BlockBytes);
+    stripes->BytesRead += stripes->Params.BlockBytes;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    const int blockBytes = argc > 1 ? atoi(argv[1]) : 1048576;
+
+    if (cm256_init() || blockBytes <= 0)
+    {
+        return 1;
+    }
+
+    static const int configs[][4] = {
+        // StripeOriginalCount, StripeRecoveryCount, StripeCount, RecoveryCount
+        { 6, 3, 2, 3 },
+        { 6, 4, 2, 4 },
+        { 6, 3, 2, 4 },
+        { 10, 4, 2, 4 },
+        { 8, 4, 4, 4 },
+        { 4, 2, 4, 2 },
+    };
+
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); ++c)
+    {
+        Stripes stripes;
+        cm256_convert_params& params = stripes.Params;
+        params.StripeOriginalCount = configs[c][0];
+        params.StripeRecoveryCount = configs[c][1];
+        params.StripeCount = configs[c][2];
+        params.RecoveryCount = configs[c][3];
+        params.BlockBytes = blockBytes;
+
+        const cm256_encoder_params wide = cm256_convert_wide_params(params);
+        const int stripeBlocks = params.StripeOriginalCount + params.StripeRecoveryCount;
+
+        stripes.Data.resize((size_t)params.StripeCount * stripeBlocks * blockBytes);
+        for (size_t i = 0; i < stripes.Data.size(); ++i)
+        {
+            stripes.Data[i] = (uint8_t)(i * 31 + 7);
+        }
+
+        cm256_block blocks[256];
+        for (int s = 0; s < params.StripeCount; ++s)
+        {
+            for (int j = 0; j < params.StripeOriginalCount; ++j)
+            {
+                blocks[j].Block = getBlock(&stripes, s, j);
+                blocks[j].Index = (unsigned char)j;
+            }
+            cm256_convert_encode(params, s, blocks, getBlock(&stripes, s, params.StripeOriginalCount));
+        }
+
+        std::vector<uint8_t> converted((size_t)wide.RecoveryCount * blockBytes);
+        std::vector<uint8_t> encoded((size_t)wide.RecoveryCount * blockBytes);
+        std::vector<uint8_t> originals((size_t)wide.OriginalCount * blockBytes);
+
+        // Conversion
+        stripes.BytesRead = 0;
+        long long t0 = getUSecs();
+        int failures = cm256_convert(params, readStripe, &stripes, &converted[0]) != 0;
+        const long long convertUsecs = getUSecs() - t0;
+        const double convertBlocks = (double)stripes.BytesRead / blockBytes;
+
+        // Full re-encode: read every original and encode the wide stripe
+        stripes.BytesRead = 0;
+        t0 = getUSecs();
+        for (int i = 0; i < wide.OriginalCount; ++i)
+        {
+            blocks[i].Block = &originals[(size_t)i * blockBytes];
+            blocks[i].Index = (unsigned char)i;
+            readStripe(&stripes, i / params.StripeOriginalCount, i % params.StripeOriginalCount, blocks[i].Block);
+        }
+        failures += cm256_encode(wide, blocks, &encoded[0]) != 0;
+        const long long encodeUsecs = getUSecs() - t0;
+        const double encodeBlocks = (double)stripes.BytesRead / blockBytes;
+
+        failures += converted != encoded;
+
+        std::cout << params.StripeCount << " x " << params.StripeOriginalCount << "+" << params.StripeRecoveryCount
+                  << " -> " << wide.OriginalCount << "+" << wide.RecoveryCount
+                  << " bytes=" << blockBytes << ": reads " << convertBlocks << " blocks vs " << encodeBlocks
+                  << ", cpu " << convertUsecs << " usec vs " << encodeUsecs << " usec"
+                  << (failures ? " FAILED" : "") << std::endl;
+    }
+
+    return 0;
+}
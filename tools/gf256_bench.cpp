@@ -0,0 +1,259 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Benchmark for the GF(256) bulk memory kernels of the configured backend.
+
+    Usage: gf256_bench
+
+    Build with -DUSE_SIMD=SSSE3, NEON, VECEXT, SMALL or NONE to compare backends.
+    Prints the backend self-test results and the backend selected for each
+    size class (except with SMALL, which has no backend selection), then reports MB/s of input for each kernel and for
+    cm256_encode(), compares the multi-source XOR with a chain of pairwise
+    XORs for parity of k blocks, and compares cm256_encode_copy() with a copy
+    followed by cm256_encode().
+*/
+
+#include <iostream>
+#include <sys/time.h>
+
+#include <vector>
+
+#include "../cm256.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+static const char* getBackendName()
+{
+#if defined(USE_SIMD)
+    return "ssse3";
+#elif defined(USE_NEON)
+    return "neon";
+#elif defined(USE_VECEXT)
+    return "vecext";
+#elif defined(GF256_SMALL)
+    return "small";
+#else
+    return "nosimd";
+#endif
+}
+
+int main()
+{
+    if (cm256_init())
+    {
+        return 1;
+    }
+
+    std::cout << "backend=" << getBackendName() << std::endl;
+
+#if !defined(GF256_SMALL)
+    // Self-test every compiled-in backend and select one per size class
+    const int selectResult = gf256_backend_autoselect(0);
+    static const char* classNames[GF256_SIZE_CLASS_COUNT] = { "small", "medium", "large" };
+
+    for (int i = 0; i < gf256_backend_count(); ++i)
+    {
+        gf256_backend_info info;
+        gf256_get_backend_info(i, &info);
+
+        std::cout << "  " << info.Name << ": supported=" << info.Supported << " verified=" << info.Verified;
+        for (int c = 0; c < GF256_SIZE_CLASS_COUNT; ++c)
+        {
+            std::cout << " " << classNames[c] << "=" << info.MBps[c] << " MB/s";
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "  selected:";
+    for (int c = 0; c < GF256_SIZE_CLASS_COUNT; ++c)
+    {
+        std::cout << " " << classNames[c] << "=" << gf256_backend_selected(c);
+    }
+    std::cout << (selectResult ? " (default backend FAILED self-test)" : "") << std::endl;
+#endif // GF256_SMALL
+
+    static const int sizes[3] = { 1296, 16384, 1048576 };
+    static const char* kernels[4] = { "add_mem", "add2_mem", "mul_mem", "muladd_mem" };
+
+    for (int s = 0; s < 3; ++s)
+    {
+        const int bytes = sizes[s];
+        std::vector<uint8_t> x(bytes), y(bytes), z(bytes);
+        for (int i = 0; i < bytes; ++i)
+        {
+            x[i] = (uint8_t)(i * 13 + 1);
+            y[i] = (uint8_t)(i * 7 + 3);
+        }
+
+        const int iterations = (256 << 20) / bytes;
+
+        std::cout << "bytes=" << bytes << ":";
+        for (int k = 0; k < 4; ++k)
+        {
+            const long long t0 = getUSecs();
+            for (int i = 0; i < iterations; ++i)
+            {
+                switch (k)
+                {
+                case 0: gf256_add_mem(&z[0], &x[0], bytes); break;
+                case 1: gf256_add2_mem(&z[0], &x[0], &y[0], bytes); break;
+                case 2: gf256_mul_mem(&z[0], &x[0], (uint8_t)(i | 2), bytes); break;
+                default: gf256_muladd_mem(&z[0], (uint8_t)(i | 2), &x[0], bytes); break;
+                }
+            }
+            const long long usecs = getUSecs() - t0;
+
+            std::cout << " " << kernels[k] << "=" << (double)bytes * iterations / usecs << " MB/s";
+        }
+        std::cout << std::endl;
+    }
+
+    // Parity of k blocks: chained addset/add versus one multi-source XOR
+    static const int parityCounts[3] = { 4, 16, 64 };
+
+    for (int s = 0; s < 3; ++s)
+    {
+        const int bytes = sizes[s];
+
+        for (int c = 0; c < 3; ++c)
+        {
+            const int count = parityCounts[c];
+            std::vector<uint8_t> data((size_t)count * bytes), z(bytes);
+            std::vector<const void*> sources(count);
+            for (size_t i = 0; i < data.size(); ++i)
+            {
+                data[i] = (uint8_t)(i * 13 + 1);
+            }
+            for (int j = 0; j < count; ++j)
+            {
+                sources[j] = &data[(size_t)j * bytes];
+            }
+
+            const int iterations = (int)((512LL << 20) / data.size()) + 1;
+            double rates[2];
+
+            for (int k = 0; k < 2; ++k)
+            {
+                const long long t0 = getUSecs();
+                for (int i = 0; i < iterations; ++i)
+                {
+                    if (k == 0)
+                    {
+                        gf256_addset_mem(&z[0], sources[0], sources[1], bytes);
+                        for (int j = 2; j < count; ++j)
+                        {
+                            gf256_add_mem(&z[0], sources[j], bytes);
+                        }
+                    }
+                    else
+                    {
+                        gf256_addset_n_mem(&z[0], &sources[0], count, bytes);
+                    }
+                }
+                const long long usecs = getUSecs() - t0;
+                rates[k] = (double)data.size() * iterations / usecs;
+            }
+
+            std::cout << "parity k=" << count << " bytes=" << bytes << ": add chain="
+                      << rates[0] << " MB/s addset_n=" << rates[1] << " MB/s" << std::endl;
+        }
+    }
+
+    // Whole encoder
+    cm256_encoder_params params;
+    params.OriginalCount = 100;
+    params.RecoveryCount = 10;
+    params.BlockBytes = 1296;
+
+    std::vector<uint8_t> originalData(params.OriginalCount * params.BlockBytes, 0x5a);
+    std::vector<uint8_t> recoveryData(params.RecoveryCount * params.BlockBytes);
+    cm256_block blocks[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = &originalData[i * params.BlockBytes];
+        blocks[i].Index = cm256_get_original_block_index(params, i);
+    }
+
+    const int iterations = 2000;
+    const long long t0 = getUSecs();
+    for (int i = 0; i < iterations; ++i)
+    {
+        cm256_encode(params, blocks, &recoveryData[0]);
+    }
+    const long long usecs = getUSecs() - t0;
+
+    std::cout << "cm256_encode k=100 m=10 bytes=1296: "
+              << (double)originalData.size() * iterations / usecs << " MB/s" << std::endl;
+
+    // Copy into packet buffers, then encode, versus the fused cm256_encode_copy()
+    params.OriginalCount = 10;
+    params.RecoveryCount = 2;
+    params.BlockBytes = 1048576;
+
+    std::vector<uint8_t> sourceData(params.OriginalCount * params.BlockBytes, 0x5a);
+    std::vector<uint8_t> packetData(params.OriginalCount * params.BlockBytes);
+    std::vector<uint8_t> parityData(params.RecoveryCount * params.BlockBytes);
+    cm256_block sources[256], packets[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        sources[i].Block = &sourceData[i * params.BlockBytes];
+        sources[i].Index = cm256_get_original_block_index(params, i);
+        packets[i].Block = &packetData[i * params.BlockBytes];
+        packets[i].Index = sources[i].Index;
+    }
+
+    for (int fused = 0; fused < 2; ++fused)
+    {
+        const int copyIterations = 50;
+        const long long c0 = getUSecs();
+        for (int i = 0; i < copyIterations; ++i)
+        {
+            if (fused)
+            {
+                cm256_encode_copy(params, sources, packets, &parityData[0]);
+            }
+            else
+            {
+                memcpy(&packetData[0], &sourceData[0], sourceData.size());
+                cm256_encode(params, packets, &parityData[0]);
+            }
+        }
+        const long long copyUsecs = getUSecs() - c0;
+
+        std::cout << (fused ? "cm256_encode_copy" : "memcpy + cm256_encode") << " k=10 m=2 bytes=1048576: "
+                  << (double)sourceData.size() * copyIterations / copyUsecs << " MB/s" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Large block encode and decode benchmark.
+
+    Usage: large_bench [stripeMiB] [threads] [k] [m]
+
+    Encodes and decodes one stripe whose originals total 'stripeMiB' MiB
+    (default 4096) with cm256_encode_large() and cm256_decode_large(), and
+    compares the encode against splitting the blocks into 64 MiB calls to
+    cm256_encode().  Blocks may be larger than 2 GiB.
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include "../cm256_large.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t stripeMiB = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4096;
+    const int threads = argc > 2 ? atoi(argv[2]) : 0;
+
+    cm256_large_params params;
+    params.OriginalCount = argc > 3 ? atoi(argv[3]) : 8;
+    params.RecoveryCount = argc > 4 ? atoi(argv[4]) : 2;
+    params.BlockBytes = (stripeMiB << 20) / params.OriginalCount & ~(size_t)63;
+
+    if (cm256_init() || params.BlockBytes == 0 || params.RecoveryCount > params.OriginalCount)
+    {
+        return 1;
+    }
+
+    std::cout << "k=" << params.OriginalCount << " m=" << params.RecoveryCount << " blocks of "
+              << params.BlockBytes << " bytes, " << threads << " threads (0 = automatic)" << std::endl;
+
+    std::vector<uint8_t> originalData(params.OriginalCount * params.BlockBytes);
+    std::vector<uint8_t> recoveryData(params.RecoveryCount * params.BlockBytes);
+    for (size_t i = 0; i < originalData.size(); i += 4096)
+    {
+        originalData[i] = (uint8_t)(i >> 12);
+    }
+
+    cm256_block blocks[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = &originalData[i * params.BlockBytes];
+        blocks[i].Index = (unsigned char)i;
+    }
+
+    const double stripeMB = (double)params.OriginalCount * params.BlockBytes / 1000000.;
+
+    // Split into 64 MiB cm256_encode() calls
+    {
+        const size_t splitBytes = (size_t)64 << 20;
+        std::vector<uint8_t> split(params.RecoveryCount * splitBytes);
+        const long long t0 = getUSecs();
+        for (size_t offset = 0; offset < params.BlockBytes; offset += splitBytes)
+        {
+            cm256_encoder_params splitParams;
+            splitParams.OriginalCount = params.OriginalCount;
+            splitParams.RecoveryCount = params.RecoveryCount;
+            splitParams.BlockBytes = (int)std::min(splitBytes, params.BlockBytes - offset);
+
+            cm256_block splitBlocks[256];
+            for (int i = 0; i < params.OriginalCount; ++i)
+            {
+                splitBlocks[i].Block = (uint8_t*)blocks[i].Block + offset;
+            }
+            cm256_encode(splitParams, splitBlocks, &split[0]);
+
+            // Scatter the rows into place, as a caller splitting the blocks would
+            for (int r = 0; r < params.RecoveryCount; ++r)
+            {
+                memcpy(&recoveryData[r * params.BlockBytes + offset], &split[r * splitParams.BlockBytes],
+                       splitParams.BlockBytes);
+            }
+        }
+        const long long usecs = getUSecs() - t0;
+        std::cout << "64 MiB cm256_encode calls: " << stripeMB / usecs * 1000. << " GB/s" << std::endl;
+    }
+
+    long long t0 = getUSecs();
+    if (cm256_encode_large(params, blocks, &recoveryData[0], threads))
+    {
+        return 1;
+    }
+    long long usecs = getUSecs() - t0;
+    std::cout << "cm256_encode_large:        " << stripeMB / usecs * 1000. << " GB/s" << std::endl;
+
+    // Lose the first RecoveryCount originals, keeping copies to check against
+    std::vector<uint8_t> lost(originalData.begin(), originalData.begin() + params.RecoveryCount * params.BlockBytes);
+    for (int i = 0; i < params.RecoveryCount; ++i)
+    {
+        blocks[i].Block = &recoveryData[i * params.BlockBytes];
+        blocks[i].Index = (unsigned char)(params.OriginalCount + i);
+    }
+
+    t0 = getUSecs();
+    if (cm256_decode_large(params, blocks, threads))
+    {
+        return 1;
+    }
+    usecs = getUSecs() - t0;
+
+    bool success = true;
+    for (int i = 0; i < params.RecoveryCount; ++i)
+    {
+        success &= blocks[i].Index == i && memcmp(blocks[i].Block, &lost[i * params.BlockBytes], params.BlockBytes) == 0;
+    }
+    std::cout << "cm256_decode_large:        " << stripeMB / usecs * 1000. << " GB/s"
+              << (success ? "" : " FAILED") << std::endl;
+
+    return success ? 0 : 1;
+}
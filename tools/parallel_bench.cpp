@@ -0,0 +1,131 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Benchmark for the parallel encoder.
+
+    Usage: parallel_bench [threads]
+
+    Encodes packet-sized and storage-sized stripes with cm256_encode() and
+    with each cm256_encode_parallel() strategy, and reports MB/s of original
+    data for each.
+*/
+
+#include <iostream>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include "../cm256_parallel.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+int main(int argc, char** argv)
+{
+    const int threadCount = argc > 1 ? atoi(argv[1]) : 4;
+
+    if (cm256_init())
+    {
+        return 1;
+    }
+
+    static const int configs[][3] = {
+        // OriginalCount, RecoveryCount, BlockBytes
+        { 200, 8, 1024 },
+        { 200, 32, 1024 },
+        { 200, 8, 2048 },
+        { 100, 20, 1296 },
+        { 10, 4, 1048576 },
+    };
+
+    static const char* names[3] = { "auto", "bytes", "columns" };
+
+    std::cout << "threads=" << threadCount << std::endl;
+
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); ++c)
+    {
+        cm256_encoder_params params;
+        params.OriginalCount = configs[c][0];
+        params.RecoveryCount = configs[c][1];
+        params.BlockBytes = configs[c][2];
+
+        std::vector<uint8_t> originalData((size_t)params.OriginalCount * params.BlockBytes);
+        std::vector<uint8_t> recoveryData((size_t)params.RecoveryCount * params.BlockBytes);
+        for (size_t i = 0; i < originalData.size(); ++i)
+        {
+            originalData[i] = (uint8_t)(i * 31 + 7);
+        }
+
+        cm256_block blocks[256];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            blocks[i].Block = &originalData[(size_t)i * params.BlockBytes];
+            blocks[i].Index = cm256_get_original_block_index(params, i);
+        }
+
+        // Repeat enough to process about 256 MB
+        int iterations = (int)((256 << 20) / originalData.size());
+        if (iterations < 4)
+        {
+            iterations = 4;
+        }
+
+        std::cout << "k=" << params.OriginalCount << " m=" << params.RecoveryCount
+                  << " bytes=" << params.BlockBytes << ":";
+
+        for (int mode = -1; mode < 3; ++mode)
+        {
+            const long long t0 = getUSecs();
+            for (int i = 0; i < iterations; ++i)
+            {
+                if (mode < 0)
+                {
+                    cm256_encode(params, blocks, &recoveryData[0]);
+                }
+                else
+                {
+                    cm256_encode_parallel(params, blocks, &recoveryData[0], threadCount,
+                                          static_cast<cm256_parallel_strategy>(mode));
+                }
+            }
+            const long long usecs = getUSecs() - t0;
+
+            std::cout << " " << (mode < 0 ? "serial" : names[mode]) << "="
+                      << (double)originalData.size() * iterations / usecs << " MB/s";
+        }
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
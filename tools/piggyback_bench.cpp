@@ -0,0 +1,152 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Repair traffic and CPU benchmark for piggybacked codes.
+
+    Usage: piggyback_bench [blockBytes]
+
+    For several stripe shapes, repairs each original in turn and reports the
+    bytes read and CPU time per repair, compared with reading OriginalCount
+    blocks and running cm256_decode().
+*/
+
+#include <iostream>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include "../cm256_piggyback.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+struct Stripe
+{
+    cm256_encoder_params Params;
+    std::vector<uint8_t> Data; // Originals then recovery blocks, end-to-end
+    uint64_t BytesRead;
+};
+
+static int readStripe(void* context, int blockIndex, int offset, int bytes, void* data)
+{
+    Stripe* stripe = static_cast<Stripe*>(context);
+    memcpy(data, &stripe->Data[(size_t)blockIndex * stripe->Params.BlockBytes + offset], bytes);
+    stripe->BytesRead += bytes;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    const int blockBytes = argc > 1 ? atoi(argv[1]) : 1048576;
+
+    if (cm256_init() || blockBytes <= 0 || blockBytes % 2 != 0)
+    {
+        return 1;
+    }
+
+    static const int configs[][2] = {
+        // OriginalCount, RecoveryCount
+        { 6, 3 },
+        { 10, 4 },
+        { 12, 4 },
+        { 20, 5 },
+        { 10, 6 },
+    };
+
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); ++c)
+    {
+        Stripe stripe;
+        stripe.Params.OriginalCount = configs[c][0];
+        stripe.Params.RecoveryCount = configs[c][1];
+        stripe.Params.BlockBytes = blockBytes;
+
+        const cm256_encoder_params& params = stripe.Params;
+        const int blockCount = params.OriginalCount + params.RecoveryCount;
+        stripe.Data.resize((size_t)blockCount * blockBytes);
+        for (size_t i = 0; i < stripe.Data.size(); ++i)
+        {
+            stripe.Data[i] = (uint8_t)(i * 31 + 7);
+        }
+
+        cm256_block blocks[256];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            blocks[i].Block = &stripe.Data[(size_t)i * blockBytes];
+            blocks[i].Index = (unsigned char)i;
+        }
+        cm256_piggyback_encode(params, blocks, &stripe.Data[(size_t)params.OriginalCount * blockBytes]);
+
+        std::vector<uint8_t> repaired(blockBytes);
+        std::vector<uint8_t> received((size_t)params.OriginalCount * blockBytes);
+
+        // Piggybacked repair of each original
+        stripe.BytesRead = 0;
+        int failures = 0;
+        long long t0 = getUSecs();
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            failures += cm256_piggyback_repair(params, i, readStripe, &stripe, &repaired[0]) != 0;
+            failures += memcmp(&repaired[0], &stripe.Data[(size_t)i * blockBytes], blockBytes) != 0;
+        }
+        const long long piggybackUsecs = getUSecs() - t0;
+        const double piggybackBytes = (double)stripe.BytesRead / params.OriginalCount;
+
+        // Plain repair: read OriginalCount blocks, substituting recovery 1 for the lost one
+        stripe.BytesRead = 0;
+        t0 = getUSecs();
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            for (int j = 0; j < params.OriginalCount; ++j)
+            {
+                const int index = (j == i) ? params.OriginalCount + 1 : j;
+                readStripe(&stripe, index, 0, blockBytes, &received[(size_t)j * blockBytes]);
+                blocks[j].Block = &received[(size_t)j * blockBytes];
+                blocks[j].Index = (unsigned char)index;
+            }
+            failures += cm256_piggyback_decode(params, blocks) != 0;
+        }
+        const long long plainUsecs = getUSecs() - t0;
+        const double plainBytes = (double)stripe.BytesRead / params.OriginalCount;
+
+        std::cout << "k=" << params.OriginalCount << " m=" << params.RecoveryCount
+                  << " bytes=" << blockBytes << ": repair reads "
+                  << piggybackBytes / blockBytes << " blocks vs " << plainBytes / blockBytes
+                  << " (" << 100. * (1. - piggybackBytes / plainBytes) << "% less), cpu "
+                  << (double)piggybackUsecs / params.OriginalCount << " usec vs "
+                  << (double)plainUsecs / params.OriginalCount << " usec"
+                  << (failures ? " FAILED" : "") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Receive pipeline benchmark.
+
+    Usage: pipeline_bench [superframes] [workers]
+
+    Receives k=64 m=16 superframes of 1296-byte packets with 16 lost
+    originals in each, so every superframe needs a full decode.  Compares
+    decoding inline on the receive thread with the pipeline, and reports the
+    pipeline's per-stage latency.  Workers defaults to one per hardware
+    thread.
+*/
+
+#include <iostream>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include "../cm256_pipeline.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+static const int kOriginalCount = 64;
+static const int kRecoveryCount = 16;
+static const int kBlockBytes = 1296;
+static const int kBlockCount = kOriginalCount + kRecoveryCount;
+
+// Distinct superframes to encode; the rest repeat them
+static const int kUniqueSuperframes = 16;
+
+struct BenchState
+{
+    uint64_t NextSuperframe;
+    uint64_t Failures;
+};
+
+static void deliver(void* context, uint64_t superframe, const void* data, int result)
+{
+    BenchState* state = static_cast<BenchState*>(context);
+    state->Failures += (superframe != state->NextSuperframe++ || result != 0 || !data);
+}
+
+static void printStage(const char* name, const cm256_pipeline_stage& stage)
+{
+    std::cout << "  " << name << ": avg "
+              << (stage.Count ? (double)stage.TotalUsec / stage.Count : 0.)
+              << " usec, max " << stage.MaxUsec << " usec" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const int superframeCount = argc > 1 ? atoi(argv[1]) : 2000;
+    const int workerCount = argc > 2 ? atoi(argv[2]) : 0;
+
+    if (cm256_init() || superframeCount <= 0)
+    {
+        return 1;
+    }
+
+    cm256_encoder_params params;
+    params.OriginalCount = kOriginalCount;
+    params.RecoveryCount = kRecoveryCount;
+    params.BlockBytes = kBlockBytes;
+
+    std::vector<uint8_t> sent((size_t)kUniqueSuperframes * kBlockCount * kBlockBytes);
+    for (int s = 0; s < kUniqueSuperframes; ++s)
+    {
+        uint8_t* superframe = &sent[(size_t)s * kBlockCount * kBlockBytes];
+        for (size_t i = 0; i < (size_t)kOriginalCount * kBlockBytes; ++i)
+        {
+            superframe[i] = (uint8_t)(i * 31 + s * 7);
+        }
+
+        cm256_block blocks[256];
+        for (int i = 0; i < kOriginalCount; ++i)
+        {
+            blocks[i].Block = superframe + (size_t)i * kBlockBytes;
+            blocks[i].Index = (unsigned char)i;
+        }
+        cm256_encode(params, blocks, superframe + (size_t)kOriginalCount * kBlockBytes);
+    }
+
+    // Every fourth original is lost
+    std::vector<int> received;
+    for (int i = 0; i < kBlockCount; ++i)
+    {
+        if (i >= kOriginalCount || i % 4 != 0)
+        {
+            received.push_back(i);
+        }
+    }
+
+    // Inline: receive into buffers and decode on the receive thread
+    std::vector<uint8_t> buffers((size_t)kOriginalCount * kBlockBytes);
+    uint64_t failures = 0;
+    long long t0 = getUSecs();
+    for (int s = 0; s < superframeCount; ++s)
+    {
+        const uint8_t* superframe = &sent[(size_t)(s % kUniqueSuperframes) * kBlockCount * kBlockBytes];
+
+        cm256_block blocks[256];
+        for (int i = 0; i < kOriginalCount; ++i)
+        {
+            blocks[i].Block = &buffers[(size_t)i * kBlockBytes];
+            blocks[i].Index = (unsigned char)received[i];
+            memcpy(blocks[i].Block, superframe + (size_t)received[i] * kBlockBytes, kBlockBytes);
+        }
+        failures += cm256_decode(params, blocks) != 0;
+    }
+    const long long inlineUsecs = getUSecs() - t0;
+
+    // Pipeline
+    cm256_pipeline_params pipelineParams;
+    pipelineParams.OriginalCount = kOriginalCount;
+    pipelineParams.RecoveryCount = kRecoveryCount;
+    pipelineParams.BlockBytes = kBlockBytes;
+    pipelineParams.WorkerCount = workerCount;
+    pipelineParams.Window = 16;
+    pipelineParams.PoolBlocks = 0;
+
+    BenchState state;
+    state.NextSuperframe = 0;
+    state.Failures = 0;
+
+    cm256_pipeline* pipeline = cm256_pipeline_create(pipelineParams, deliver, &state);
+    if (!pipeline)
+    {
+        return 1;
+    }
+
+    t0 = getUSecs();
+    for (int s = 0; s < superframeCount; ++s)
+    {
+        const uint8_t* superframe = &sent[(size_t)(s % kUniqueSuperframes) * kBlockCount * kBlockBytes];
+
+        for (size_t i = 0; i < received.size(); ++i)
+        {
+            void* buffer = cm256_pipeline_acquire(pipeline);
+            if (!buffer)
+            {
+                failures++;
+                continue;
+            }
+            memcpy(buffer, superframe + (size_t)received[i] * kBlockBytes, kBlockBytes);
+            cm256_pipeline_submit(pipeline, s, received[i], buffer);
+        }
+    }
+    cm256_pipeline_flush(pipeline);
+    const long long pipelineUsecs = getUSecs() - t0;
+
+    cm256_pipeline_stats stats;
+    cm256_pipeline_get_stats(pipeline, &stats);
+    cm256_pipeline_destroy(pipeline);
+    failures += state.Failures + (state.NextSuperframe != (uint64_t)superframeCount);
+
+    const double megabytes = (double)superframeCount * kOriginalCount * kBlockBytes / 1000000.;
+    std::cout << "k=" << kOriginalCount << " m=" << kRecoveryCount << " bytes=" << kBlockBytes
+              << " superframes=" << superframeCount << std::endl;
+    std::cout << "inline:   " << (double)inlineUsecs / superframeCount << " usec per superframe, "
+              << megabytes / ((double)inlineUsecs / 1000000.) << " MBps" << std::endl;
+    std::cout << "pipeline: " << (double)pipelineUsecs / superframeCount << " usec per superframe, "
+              << megabytes / ((double)pipelineUsecs / 1000000.) << " MBps" << std::endl;
+    printStage("reassembly", stats.Reassembly);
+    printStage("queue", stats.Queue);
+    printStage("decode", stats.Decode);
+    printStage("reorder", stats.Reorder);
+    std::cout << "  extra packets " << stats.ExtraPackets << ", pool empty " << stats.PoolEmpty
+              << (failures ? " FAILED" : "") << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Mixed workload benchmark for the FEC job scheduler.
+
+    Usage: sched_bench [workers] [seconds]
+
+    Bulk rebuild decodes of 1 MiB blocks run back to back while a foreground
+    thread issues a small degraded-read decode every 2 msec.  Reports the
+    foreground latency percentiles and the bulk throughput for:
+
+    direct   : cm256_decode() on plain threads, left to the OS scheduler
+    fifo     : one class with whole-block jobs, so reads queue behind rebuilds
+    priority : reads in the latency class, rebuilds sliced in the bulk class
+    share=50 : as priority, with the bulk class limited to half the workers
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../cm256_scheduler.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+// One stripe with its first 'lost' originals replaced by recovery blocks
+struct DecodeStripe
+{
+    cm256_encoder_params Params;
+    std::vector<uint8_t> Encoded; // Originals then recovery blocks, end-to-end
+    std::vector<uint8_t> Work;
+    cm256_block Blocks[256];
+    int Lost;
+
+    void Initialize(int originalCount, int recoveryCount, int blockBytes, int lost)
+    {
+        Params.OriginalCount = originalCount;
+        Params.RecoveryCount = recoveryCount;
+        Params.BlockBytes = blockBytes;
+        Lost = lost;
+
+        Encoded.resize((size_t)(originalCount + recoveryCount) * blockBytes);
+        for (size_t i = 0; i < (size_t)originalCount * blockBytes; ++i)
+        {
+            Encoded[i] = (uint8_t)(i * 31 + 7);
+        }
+        for (int i = 0; i < originalCount; ++i)
+        {
+            Blocks[i].Block = &Encoded[(size_t)i * blockBytes];
+        }
+        cm256_encode(Params, Blocks, &Encoded[(size_t)originalCount * blockBytes]);
+        Work.resize((size_t)originalCount * blockBytes);
+    }
+
+    // Reset the blocks for another decode.  Without 'copy' the previous output
+    // is decoded again, which costs the same without touching memory first.
+    cm256_block* Prepare(bool copy)
+    {
+        for (int i = 0; i < Params.OriginalCount; ++i)
+        {
+            const int index = i < Lost ? Params.OriginalCount + i : i;
+            Blocks[i].Block = &Work[(size_t)i * Params.BlockBytes];
+            Blocks[i].Index = (unsigned char)index;
+            if (copy)
+            {
+                memcpy(Blocks[i].Block, &Encoded[(size_t)index * Params.BlockBytes], Params.BlockBytes);
+            }
+        }
+        return Blocks;
+    }
+};
+
+enum Mode
+{
+    MODE_DIRECT,
+    MODE_FIFO,
+    MODE_PRIORITY,
+    MODE_SHARE
+};
+
+static void runMode(Mode mode, const char* name, int workers, int seconds)
+{
+    cm256_scheduler* scheduler = nullptr;
+    if (mode != MODE_DIRECT)
+    {
+        cm256_scheduler_params params;
+        params.WorkerCount = workers;
+        params.SliceBytes = (mode == MODE_FIFO) ? 1048576 : 0;
+        params.SharePercent[CM256_PRIORITY_LATENCY] = 100;
+        params.SharePercent[CM256_PRIORITY_NORMAL] = 100;
+        params.SharePercent[CM256_PRIORITY_BULK] = (mode == MODE_SHARE) ? 50 : 100;
+        params.ShareWindowMsec = 0;
+        scheduler = cm256_scheduler_create(params);
+    }
+
+    const cm256_priority readPriority = (mode == MODE_FIFO) ? CM256_PRIORITY_NORMAL : CM256_PRIORITY_LATENCY;
+    const cm256_priority bulkPriority = (mode == MODE_FIFO) ? CM256_PRIORITY_NORMAL : CM256_PRIORITY_BULK;
+
+    std::atomic<bool> stop(false);
+    std::atomic<long long> bulkBytes(0);
+    std::atomic<int> failures(0);
+
+    // Rebuild threads, one per worker
+    std::vector<std::thread> bulkThreads;
+    for (int t = 0; t < workers; ++t)
+    {
+        bulkThreads.push_back(std::thread([&]() {
+            DecodeStripe stripe;
+            stripe.Initialize(10, 4, 1048576, 4);
+            stripe.Prepare(true);
+            while (!stop)
+            {
+                cm256_block* blocks = stripe.Prepare(false);
+                int result;
+                if (scheduler)
+                {
+                    result = cm256_scheduler_wait(scheduler,
+                        cm256_scheduler_decode(scheduler, bulkPriority, stripe.Params, blocks));
+                }
+                else
+                {
+                    result = cm256_decode(stripe.Params, blocks);
+                }
+                failures += result != 0;
+                bulkBytes += (long long)stripe.Params.OriginalCount * stripe.Params.BlockBytes;
+            }
+        }));
+    }
+
+    // Foreground reads
+    DecodeStripe stripe;
+    stripe.Initialize(10, 4, 4096, 1);
+    std::vector<long long> latencies;
+
+    const long long t0 = getUSecs();
+    while (getUSecs() - t0 < seconds * 1000000LL)
+    {
+        cm256_block* blocks = stripe.Prepare(true);
+        const long long start = getUSecs();
+        int result;
+        if (scheduler)
+        {
+            result = cm256_scheduler_wait(scheduler,
+                cm256_scheduler_decode(scheduler, readPriority, stripe.Params, blocks));
+        }
+        else
+        {
+            result = cm256_decode(stripe.Params, blocks);
+        }
+        latencies.push_back(getUSecs() - start);
+        failures += result != 0;
+        usleep(2000);
+    }
+    const long long elapsed = getUSecs() - t0;
+
+    stop = true;
+    for (size_t t = 0; t < bulkThreads.size(); ++t)
+    {
+        bulkThreads[t].join();
+    }
+    cm256_scheduler_destroy(scheduler);
+
+    std::sort(latencies.begin(), latencies.end());
+    const size_t n = latencies.size();
+    std::cout << name << ": read latency p50 " << latencies[n / 2] << " usec, p99 "
+              << latencies[n * 99 / 100] << " usec, max " << latencies[n - 1]
+              << " usec, bulk " << (double)bulkBytes / elapsed << " MB/s"
+              << (failures ? " FAILED" : "") << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const int workers = argc > 1 ? atoi(argv[1]) : std::max(1, (int)std::thread::hardware_concurrency());
+    const int seconds = argc > 2 ? atoi(argv[2]) : 3;
+
+    if (cm256_init() || workers <= 0 || seconds <= 0)
+    {
+        return 1;
+    }
+
+    std::cout << workers << " workers, 10+4 decodes: bulk 1 MiB blocks with 4 lost, reads 4 KiB blocks with 1 lost" << std::endl;
+
+    runMode(MODE_DIRECT, "direct  ", workers, seconds);
+    runMode(MODE_FIFO, "fifo    ", workers, seconds);
+    runMode(MODE_PRIORITY, "priority", workers, seconds);
+    runMode(MODE_SHARE, "share=50", workers, seconds);
+
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    Multi-process benchmark for the erasure-coded shared memory store.
+
+    Usage: store_bench [processes] [seconds] [originalCount] [recoveryCount] [valueBytes] [slotCount]
+
+    Several processes open the same store and issue a mix of gets and puts
+    against random slots, first with every segment healthy, then with one
+    original segment lost (degraded reads), and finally while that segment
+    is rebuilt in the background.
+*/
+
+#include <iostream>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../cm256_store.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+struct WorkerResult
+{
+    uint64_t Gets;
+    uint64_t Puts;
+    uint64_t Failures;
+};
+
+// Percentage of operations that are puts
+static const int PutPercent = 10;
+
+static void runWorker(const char* name, int seconds, int valueBytes, int seed, WorkerResult* result)
+{
+    cm256_store* store = cm256_store_open(name);
+    if (!store)
+    {
+        result->Failures = 1;
+        return;
+    }
+
+    const cm256_store_params params = cm256_store_get_params(store);
+    uint8_t* value = new uint8_t[valueBytes];
+    memset(value, seed, valueBytes);
+
+    srand(seed);
+    const long long deadline = getUSecs() + seconds * 1000000LL;
+    while (getUSecs() < deadline)
+    {
+        for (int i = 0; i < 64; ++i)
+        {
+            const int slot = rand() % params.SlotCount;
+
+            if (rand() % 100 < PutPercent)
+            {
+                if (cm256_store_put(store, slot, value, valueBytes) == 0)
+                {
+                    ++result->Puts;
+                }
+                else
+                {
+                    ++result->Failures;
+                }
+            }
+            else
+            {
+                if (cm256_store_get(store, slot, value, valueBytes) == valueBytes)
+                {
+                    ++result->Gets;
+                }
+                else
+                {
+                    ++result->Failures;
+                }
+            }
+        }
+    }
+
+    delete[] value;
+    cm256_store_close(store);
+}
+
+static bool runPhase(const char* label, const char* name, int processes, int seconds, int valueBytes)
+{
+    WorkerResult* results = static_cast<WorkerResult*>(mmap(nullptr, sizeof(WorkerResult) * processes,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (results == MAP_FAILED)
+    {
+        return false;
+    }
+    memset(results, 0, sizeof(WorkerResult) * processes);
+
+    for (int i = 0; i < processes; ++i)
+    {
+        if (fork() == 0)
+        {
+            runWorker(name, seconds, valueBytes, i + 1, results + i);
+            _exit(0);
+        }
+    }
+    for (int i = 0; i < processes; ++i)
+    {
+        wait(nullptr);
+    }
+
+    WorkerResult total = { 0, 0, 0 };
+    for (int i = 0; i < processes; ++i)
+    {
+        total.Gets += results[i].Gets;
+        total.Puts += results[i].Puts;
+        total.Failures += results[i].Failures;
+    }
+    munmap(results, sizeof(WorkerResult) * processes);
+
+    const double getsPerSec = total.Gets / (double)seconds;
+    const double putsPerSec = total.Puts / (double)seconds;
+    std::cout << label << ": "
+              << getsPerSec << " gets/s (" << getsPerSec * valueBytes / 1000000. << " MB/s), "
+              << putsPerSec << " puts/s (" << putsPerSec * valueBytes / 1000000. << " MB/s), "
+              << total.Failures << " failures" << std::endl;
+
+    return total.Failures == 0;
+}
+
+int main(int argc, char** argv)
+{
+    const int processes = argc > 1 ? atoi(argv[1]) : 4;
+    const int seconds = argc > 2 ? atoi(argv[2]) : 2;
+
+    cm256_store_params params;
+    params.OriginalCount = argc > 3 ? atoi(argv[3]) : 8;
+    params.RecoveryCount = argc > 4 ? atoi(argv[4]) : 2;
+    const int valueBytes = argc > 5 ? atoi(argv[5]) : 64 * 1024;
+    params.SlotCount = argc > 6 ? atoi(argv[6]) : 1024;
+    params.ChunkBytes = (valueBytes + params.OriginalCount - 1) / params.OriginalCount;
+
+    char name[64];
+    snprintf(name, sizeof(name), "cm256_store_bench_%d", (int)getpid());
+
+    cm256_store* store = cm256_store_create(name, params);
+    if (!store)
+    {
+        std::cerr << "Failed to create store" << std::endl;
+        return 1;
+    }
+
+    uint8_t* value = new uint8_t[valueBytes];
+    memset(value, 0xa5, valueBytes);
+    for (int slot = 0; slot < params.SlotCount; ++slot)
+    {
+        cm256_store_put(store, slot, value, valueBytes);
+    }
+    delete[] value;
+
+    cm256_store_stats stats;
+    cm256_store_get_stats(store, &stats);
+    std::cout << "Store k = " << params.OriginalCount << " m = " << params.RecoveryCount
+              << ", " << params.SlotCount << " values of " << valueBytes << " bytes, "
+              << processes << " processes" << std::endl;
+    std::cout << "Memory: " << stats.SegmentBytes << " bytes for " << stats.CapacityBytes
+              << " bytes of values = " << stats.SegmentBytes / (double)stats.CapacityBytes
+              << "x overhead (3x replication = " << 3 * stats.CapacityBytes << " bytes)" << std::endl;
+
+    bool success = runPhase("Healthy ", name, processes, seconds, valueBytes);
+
+    cm256_store_drop_segment(store, 0);
+    success &= runPhase("Degraded", name, processes, seconds, valueBytes);
+
+    cm256_store_rebuild(store, 0);
+    success &= runPhase("Rebuild ", name, processes, seconds, valueBytes);
+    success &= (cm256_store_rebuild_wait(store) == 0);
+
+    // Time a rebuild without foreground load
+    cm256_store_drop_segment(store, 0);
+    const long long t0 = getUSecs();
+    cm256_store_rebuild(store, 0);
+    success &= (cm256_store_rebuild_wait(store) == 0);
+    const long long usecs = getUSecs() - t0;
+
+    std::cout << "Rebuilt a " << stats.SegmentBytes / (params.OriginalCount + params.RecoveryCount)
+              << " byte segment in " << usecs << " usec" << std::endl;
+
+    cm256_store_unlink(store);
+    cm256_store_close(store);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+/*
+    Copyright (c) 2015 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of CM256 nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    fio-style benchmark for the erasure-coded virtual volume.
+
+    Usage: volume_bench [key=value ...]
+
+        dir=.          Directory for the backing files
+        k=8 m=2        Data and parity device counts
+        unit=65536     Stripe unit in bytes
+        size=256       Volume size in MiB
+        bs=4096        I/O size in bytes
+        rw=randwrite   read, write, randread or randwrite
+        runtime=5      Seconds to run
+        fail=-1        Device to fail before the run, for degraded mode
+
+    Reports IOPS, throughput, device bytes per user byte and CPU time.
+*/
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "../cm256_volume.h"
+
+static long long getUSecs()
+{
+    struct timeval tp;
+    gettimeofday(&tp, 0);
+    return (long long) tp.tv_sec * 1000000L + tp.tv_usec;
+}
+
+static long long getCpuUSecs()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (long long) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000L +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static std::string getOption(int argc, char** argv, const char* key, const char* defaultValue)
+{
+    const size_t keyLength = strlen(key);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], key, keyLength) == 0 && argv[i][keyLength] == '=')
+        {
+            return argv[i] + keyLength + 1;
+        }
+    }
+    return defaultValue;
+}
+
+int main(int argc, char** argv)
+{
+    const std::string dir = getOption(argc, argv, "dir", ".");
+    const std::string rw = getOption(argc, argv, "rw", "randwrite");
+    const int blockSize = atoi(getOption(argc, argv, "bs", "4096").c_str());
+    const int runtime = atoi(getOption(argc, argv, "runtime", "5").c_str());
+    const int failDevice = atoi(getOption(argc, argv, "fail", "-1").c_str());
+    const uint64_t sizeBytes = strtoull(getOption(argc, argv, "size", "256").c_str(), nullptr, 10) << 20;
+
+    cm256_volume_params params;
+    params.OriginalCount = atoi(getOption(argc, argv, "k", "8").c_str());
+    params.RecoveryCount = atoi(getOption(argc, argv, "m", "2").c_str());
+    params.StripeUnit = atoi(getOption(argc, argv, "unit", "65536").c_str());
+    params.StripeCount = sizeBytes / ((uint64_t)params.StripeUnit * params.OriginalCount);
+
+    const bool isWrite = (rw == "write" || rw == "randwrite");
+    const bool isRandom = (rw == "randread" || rw == "randwrite");
+
+    std::vector<std::string> paths;
+    std::vector<const char*> pathPointers;
+    for (int i = 0; i < params.OriginalCount + params.RecoveryCount; ++i)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "/volume_bench.%d", i);
+        paths.push_back(dir + name);
+    }
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        pathPointers.push_back(paths[i].c_str());
+    }
+
+    cm256_volume* volume = cm256_volume_open(&pathPointers[0], params, 1);
+    if (!volume || params.StripeCount == 0 || blockSize <= 0)
+    {
+        std::cerr << "Failed to open volume" << std::endl;
+        return 1;
+    }
+
+    const uint64_t volumeBytes = cm256_volume_size(volume);
+    std::vector<uint8_t> buffer(blockSize);
+    for (int i = 0; i < blockSize; ++i)
+    {
+        buffer[i] = (uint8_t)(i * 7);
+    }
+
+    // Lay out the data for read tests so that parity is consistent
+    if (!isWrite)
+    {
+        std::vector<uint8_t> fill(volumeBytes / params.StripeCount, 0x5a);
+        for (uint64_t offset = 0; offset < volumeBytes; offset += fill.size())
+        {
+            cm256_volume_pwrite(volume, &fill[0], fill.size(), offset);
+        }
+    }
+
+    if (failDevice >= 0)
+    {
+        cm256_volume_fail_device(volume, failDevice);
+    }
+
+    cm256_volume_stats before;
+    cm256_volume_get_stats(volume, &before);
+
+    srand(1);
+    const uint64_t blockCount = volumeBytes / blockSize;
+    uint64_t ios = 0, nextBlock = 0;
+    int failures = 0;
+
+    const long long cpu0 = getCpuUSecs();
+    const long long t0 = getUSecs();
+    const long long deadline = t0 + runtime * 1000000LL;
+
+    while (getUSecs() < deadline)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            uint64_t block = nextBlock++ % blockCount;
+            if (isRandom)
+            {
+                block = (((uint64_t)rand() << 31) ^ (uint64_t)rand()) % blockCount;
+            }
+
+            const int result = isWrite ?
+                cm256_volume_pwrite(volume, &buffer[0], blockSize, block * blockSize) :
+                cm256_volume_pread(volume, &buffer[0], blockSize, block * blockSize);
+            failures += (result != 0);
+            ++ios;
+        }
+    }
+
+    const long long usecs = getUSecs() - t0;
+    const long long cpuUsecs = getCpuUSecs() - cpu0;
+
+    cm256_volume_stats after;
+    cm256_volume_get_stats(volume, &after);
+
+    const double userBytes = (double)ios * blockSize;
+    const double seconds = usecs / 1000000.;
+
+    std::cout << rw << ": k=" << params.OriginalCount << " m=" << params.RecoveryCount
+              << " unit=" << params.StripeUnit << " bs=" << blockSize
+              << (failDevice >= 0 ? " (degraded)" : "") << std::endl;
+    std::cout << "  iops=" << (uint64_t)(ios / seconds)
+              << " bw=" << userBytes / seconds / 1000000. << " MB/s"
+              << " failures=" << failures << std::endl;
+    std::cout << "  device read/user byte=" << (after.DeviceReadBytes - before.DeviceReadBytes) / userBytes
+              << " device write/user byte=" << (after.DeviceWriteBytes - before.DeviceWriteBytes) / userBytes
+              << " cpu=" << cpuUsecs / (userBytes / 1000000.) << " usec/MB" << std::endl;
+    std::cout << "  full stripe=" << after.FullStripeWrites - before.FullStripeWrites
+              << " delta=" << after.DeltaWrites - before.DeltaWrites
+              << " reconstruct=" << after.ReconstructWrites - before.ReconstructWrites
+              << " degraded reads=" << after.DegradedReads - before.DegradedReads << std::endl;
+
+    cm256_volume_close(volume);
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        unlink(paths[i].c_str());
+    }
+
+    return failures == 0 ? 0 : 1;
+}
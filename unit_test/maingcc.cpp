@@ -26,10 +26,32 @@
     POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <mutex>
 #include <sys/time.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <string>
+#include <unistd.h>
+#include <thread>
+#include <vector>
 
 #include "../cm256.h"
+#include "../cm256_carousel.h"
+#include "../cm256_convert.h"
+#include "../cm256_fileset.h"
+#include "../cm256_large.h"
+#include "../cm256_parallel.h"
+#include "../cm256_piggyback.h"
+#include "../cm256_pipeline.h"
+#include "../cm256_progressive.h"
+#include "../cm256_read_cache.h"
+#include "../cm256_scheduler.h"
+#include "../cm256_store.h"
+#include "../cm256_stripe_cache.h"
+#include "../cm256_volume.h"
 
 long long getUSecs()
 {
@@ -487,8 +509,2129 @@ bool example3()
     return true;
 }
 
+/**
+ * Lose both originals and recovery blocks and regenerate all of them in one repair pass
+ */
+bool RepairTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    cm256_encoder_params params;
+    params.BlockBytes = 20000;
+#if CM256_MAX_BLOCKS < 48
+    params.OriginalCount = 24;
+#else
+    params.OriginalCount = 40;
+#endif
+    params.RecoveryCount = 8;
+
+    uint8_t* originalData = new uint8_t[params.OriginalCount * params.BlockBytes];
+    uint8_t* recoveryData = new uint8_t[params.RecoveryCount * params.BlockBytes];
+    uint8_t* repairedData = new uint8_t[params.RecoveryCount * params.BlockBytes];
+    uint8_t* receivedData = new uint8_t[params.OriginalCount * params.BlockBytes];
+
+    cm256_block blocks[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = originalData + i * params.BlockBytes;
+        blocks[i].Index = cm256_get_original_block_index(params, i);
+    }
+    initializeBlocks(blocks, params.OriginalCount, params.BlockBytes);
+
+    bool success = cm256_encode(params, blocks, recoveryData) == 0;
+
+    // Lose originals 3, 17, 20 and recovery blocks 0, 2, 5
+    static const int lostOriginals[3] = { 3, 17, 20 };
+    static const int usedRecovery[3] = { 1, 4, 7 };
+    unsigned char lostRecovery[3] = {
+        cm256_get_recovery_block_index(params, 0),
+        cm256_get_recovery_block_index(params, 2),
+        cm256_get_recovery_block_index(params, 5)
+    };
+
+    memcpy(receivedData, originalData, params.OriginalCount * params.BlockBytes);
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = receivedData + i * params.BlockBytes;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        uint8_t* block = receivedData + lostOriginals[i] * params.BlockBytes;
+        memcpy(block, recoveryData + usedRecovery[i] * params.BlockBytes, params.BlockBytes);
+        blocks[lostOriginals[i]].Index = cm256_get_recovery_block_index(params, usedRecovery[i]);
+    }
+
+    if (success)
+    {
+        success = cm256_repair(params, blocks, 3, lostRecovery, repairedData) == 0;
+    }
+    if (success)
+    {
+        success = validateSolution(blocks, params.OriginalCount, params.BlockBytes);
+    }
+    for (int i = 0; success && i < 3; ++i)
+    {
+        const int recoveryIndex = lostRecovery[i] - params.OriginalCount;
+        success = memcmp(repairedData + i * params.BlockBytes,
+                         recoveryData + recoveryIndex * params.BlockBytes,
+                         params.BlockBytes) == 0;
+    }
+
+    delete[] originalData;
+    delete[] recoveryData;
+    delete[] repairedData;
+    delete[] receivedData;
+
+    return success;
+}
+
+/**
+ * Store values in the erasure-coded shared memory store, lose segments and rebuild them
+ */
+bool StoreTest()
+{
+    cm256_store_params params;
+    params.OriginalCount = 4;
+    params.RecoveryCount = 2;
+    params.ChunkBytes = 1000;
+    params.SlotCount = 16;
+
+    static const int MaxValueBytes = 4000;
+
+    char name[64];
+    snprintf(name, sizeof(name), "cm256_test_%d", (int)getpid());
+
+    cm256_store* store = cm256_store_create(name, params);
+    if (!store)
+    {
+        return false;
+    }
+
+    // Value in slot i is i * 250 + 1 bytes long
+    uint8_t value[MaxValueBytes];
+    bool success = true;
+    for (int slot = 0; slot < params.SlotCount; ++slot)
+    {
+        for (int j = 0; j < MaxValueBytes; ++j)
+        {
+            value[j] = (uint8_t)(slot + j * 13);
+        }
+        success &= cm256_store_put(store, slot, value, slot * 250 + 1) == 0;
+    }
+
+    cm256_store* reader = cm256_store_open(name);
+    success &= (reader != nullptr);
+
+    // Check all values from the second handle, dropping segments along the way
+    static const int DroppedSegments[3] = { -1, 1, 4 };
+    for (int round = 0; success && round < 3; ++round)
+    {
+        if (DroppedSegments[round] >= 0)
+        {
+            success &= cm256_store_drop_segment(store, DroppedSegments[round]) == 0;
+        }
+
+        for (int slot = 0; success && slot < params.SlotCount; ++slot)
+        {
+            const int bytes = cm256_store_get(reader, slot, value, MaxValueBytes);
+            success &= (bytes == slot * 250 + 1);
+            for (int j = 0; success && j < bytes; ++j)
+            {
+                success &= (value[j] == (uint8_t)(slot + j * 13));
+            }
+        }
+    }
+
+    // Rebuild the lost original segment and then rely on it
+    if (success)
+    {
+        success &= cm256_store_rebuild(store, 1) == 0;
+        success &= cm256_store_rebuild(store, 1) == -1;
+        success &= cm256_store_rebuild_wait(store) == 0;
+        success &= cm256_store_drop_segment(store, 0) == 0;
+    }
+    for (int slot = 0; success && slot < params.SlotCount; ++slot)
+    {
+        const int bytes = cm256_store_get(reader, slot, value, MaxValueBytes);
+        success &= (bytes == slot * 250 + 1);
+        for (int j = 0; success && j < bytes; ++j)
+        {
+            success &= (value[j] == (uint8_t)(slot + j * 13));
+        }
+    }
+
+    cm256_store_stats stats;
+    cm256_store_get_stats(reader, &stats);
+    success &= (stats.DegradedGets > 0);
+
+    // With too many segments gone a rebuild fails, and leaves the segment
+    // lost so that it can be tried again
+    if (success)
+    {
+        success &= cm256_store_drop_segment(store, 2) == 0;
+        success &= cm256_store_rebuild(store, 0) == 0;
+        success &= cm256_store_rebuild_wait(store) == -3;
+        success &= cm256_store_rebuild(store, 0) == 0;
+        success &= cm256_store_rebuild_wait(store) == -3;
+        success &= cm256_store_get(reader, 0, value, MaxValueBytes) < 0;
+    }
+
+    cm256_store_unlink(store);
+    cm256_store_close(reader);
+    cm256_store_close(store);
+
+    return success;
+}
+
+/**
+ * Write and read an erasure-coded volume against a shadow copy while devices fail
+ */
+bool VolumeTest()
+{
+    cm256_volume_params params;
+    params.OriginalCount = 4;
+    params.RecoveryCount = 2;
+    params.StripeUnit = 4096;
+    params.StripeCount = 8;
+
+    char paths[6][64];
+    const char* pathPointers[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        snprintf(paths[i], sizeof(paths[i]), "/tmp/cm256_test_%d.%d", (int)getpid(), i);
+        pathPointers[i] = paths[i];
+    }
+
+    cm256_volume* volume = cm256_volume_open(pathPointers, params, 1);
+    if (!volume)
+    {
+        return false;
+    }
+
+    const int volumeBytes = (int)cm256_volume_size(volume);
+    uint8_t* shadow = new uint8_t[volumeBytes];
+    uint8_t* data = new uint8_t[volumeBytes];
+    memset(shadow, 0, volumeBytes);
+
+    bool success = true;
+    srand(5);
+
+    // Write ranges of every shape, failing a data device and then a parity device
+    for (int round = 0; success && round < 3; ++round)
+    {
+        if (round > 0)
+        {
+            cm256_volume_fail_device(volume, round == 1 ? 1 : 4);
+        }
+
+        for (int i = 0; success && i < 200; ++i)
+        {
+            int bytes = 1 + rand() % (i % 10 == 0 ? volumeBytes / 2 : 3000);
+            const int offset = rand() % (volumeBytes - bytes + 1);
+            for (int j = 0; j < bytes; ++j)
+            {
+                data[j] = (uint8_t)rand();
+            }
+
+            success &= cm256_volume_pwrite(volume, data, bytes, offset) == 0;
+            memcpy(shadow + offset, data, bytes);
+
+            bytes = 1 + rand() % 20000;
+            const int readOffset = rand() % (volumeBytes - bytes + 1);
+            success &= cm256_volume_pread(volume, data, bytes, readOffset) == 0;
+            success &= memcmp(data, shadow + readOffset, bytes) == 0;
+        }
+
+        success &= cm256_volume_pread(volume, data, volumeBytes, 0) == 0;
+        success &= memcmp(data, shadow, volumeBytes) == 0;
+    }
+
+    // Patch a range of stripe 2, column 3 given its old contents
+    if (success)
+    {
+        const int offset = 2 * 4 * params.StripeUnit + 3 * params.StripeUnit + 100;
+        for (int j = 0; j < 50; ++j)
+        {
+            data[j] = (uint8_t)rand();
+        }
+        success &= cm256_volume_write_delta(volume, 2, 3, 100, 50, shadow + offset, data) == 0;
+        memcpy(shadow + offset, data, 50);
+
+        success &= cm256_volume_pread(volume, data, volumeBytes, 0) == 0;
+        success &= memcmp(data, shadow, volumeBytes) == 0;
+    }
+
+    cm256_volume_stats stats;
+    cm256_volume_get_stats(volume, &stats);
+    success &= stats.FullStripeWrites > 0 && stats.DeltaWrites > 0 &&
+               stats.ReconstructWrites > 0 && stats.DegradedReads > 0;
+
+    cm256_volume_close(volume);
+    for (int i = 0; i < 6; ++i)
+    {
+        unlink(paths[i]);
+    }
+    delete[] shadow;
+    delete[] data;
+
+    return success;
+}
+
+bool StripeCacheTest()
+{
+    cm256_volume_params params;
+    params.OriginalCount = 4;
+    params.RecoveryCount = 2;
+    params.StripeUnit = 4096;
+    params.StripeCount = 8;
+
+    char paths[6][64];
+    const char* pathPointers[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        snprintf(paths[i], sizeof(paths[i]), "/tmp/cm256_test_%d.%d", (int)getpid(), i);
+        pathPointers[i] = paths[i];
+    }
+
+    cm256_volume* volume = cm256_volume_open(pathPointers, params, 1);
+    if (!volume)
+    {
+        return false;
+    }
+
+    cm256_stripe_cache_params cacheParams;
+    cacheParams.MaxDirtyStripes = 3;
+    cacheParams.FlushIntervalMsec = 20;
+
+    cm256_stripe_cache* cache = cm256_stripe_cache_create(volume, cacheParams);
+    if (!cache)
+    {
+        cm256_volume_close(volume);
+        return false;
+    }
+
+    const int volumeBytes = (int)cm256_volume_size(volume);
+    uint8_t* shadow = new uint8_t[volumeBytes];
+    uint8_t* data = new uint8_t[volumeBytes];
+    memset(shadow, 0, volumeBytes);
+
+    bool success = true;
+    srand(6);
+
+    // Mix small writes, whole stripes and reads through the cache
+    for (int i = 0; success && i < 400; ++i)
+    {
+        int bytes = 1 + rand() % (i % 20 == 0 ? volumeBytes / 2 : 2000);
+        const int offset = rand() % (volumeBytes - bytes + 1);
+        for (int j = 0; j < bytes; ++j)
+        {
+            data[j] = (uint8_t)rand();
+        }
+
+        success &= cm256_stripe_cache_write(cache, data, bytes, offset) == 0;
+        memcpy(shadow + offset, data, bytes);
+
+        bytes = 1 + rand() % 20000;
+        const int readOffset = rand() % (volumeBytes - bytes + 1);
+        success &= cm256_stripe_cache_read(cache, data, bytes, readOffset) == 0;
+        success &= memcmp(data, shadow + readOffset, bytes) == 0;
+
+        if (i == 200)
+        {
+            usleep(50000);
+        }
+    }
+
+    success &= cm256_stripe_cache_flush(cache) == 0;
+
+    cm256_stripe_cache_stats stats;
+    cm256_stripe_cache_get_stats(cache, &stats);
+    success &= stats.FullStripeFlushes > 0 && stats.CompletedStripeFlushes > 0 &&
+               stats.DeltaStripeFlushes > 0 && stats.PressureFlushes > 0;
+
+    cm256_stripe_cache_destroy(cache);
+
+    // Parity written by the cache must reconstruct the data
+    cm256_volume_fail_device(volume, 0);
+    cm256_volume_fail_device(volume, 5);
+    success &= cm256_volume_pread(volume, data, volumeBytes, 0) == 0;
+    success &= memcmp(data, shadow, volumeBytes) == 0;
+
+    // Flushes that fail must keep the stripe dirty for the next attempt
+    cm256_volume_fail_device(volume, 1);
+    cacheParams.FlushIntervalMsec = 1;
+    cache = cm256_stripe_cache_create(volume, cacheParams);
+    success &= cache != nullptr;
+    if (cache)
+    {
+        success &= cm256_stripe_cache_write(cache, data, 100, 0) == 0;
+        usleep(10000);
+        success &= cm256_stripe_cache_flush(cache) != 0;
+        success &= cm256_stripe_cache_flush(cache) != 0;
+
+        cm256_stripe_cache_get_stats(cache, &stats);
+        success &= stats.FlushErrors >= 3 && stats.TimerFlushes == 0 && stats.DeltaStripeFlushes == 0;
+        cm256_stripe_cache_destroy(cache);
+    }
+
+    cm256_volume_close(volume);
+    for (int i = 0; i < 6; ++i)
+    {
+        unlink(paths[i]);
+    }
+    delete[] shadow;
+    delete[] data;
+
+    return success;
+}
+
+bool FragmentDecodeTest()
+{
+    cm256_encoder_params params;
+    params.BlockBytes = 9000;
+    params.OriginalCount = 20;
+    params.RecoveryCount = 4;
+
+    const int fragmentBytes = 1400;
+    const int fragmentCount = (params.BlockBytes + fragmentBytes - 1) / fragmentBytes;
+    const int blockCount = params.OriginalCount + params.RecoveryCount;
+
+    uint8_t* originalData = new uint8_t[blockCount * params.BlockBytes];
+    uint8_t* decodedData = new uint8_t[params.OriginalCount * params.BlockBytes];
+    uint8_t* received = new uint8_t[blockCount * fragmentCount];
+    uint8_t* recovered = new uint8_t[params.OriginalCount * fragmentCount];
+
+    cm256_block blocks[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = originalData + i * params.BlockBytes;
+        blocks[i].Index = cm256_get_original_block_index(params, i);
+    }
+    initializeBlocks(blocks, params.OriginalCount, params.BlockBytes);
+
+    bool success = cm256_encode(params, blocks, originalData + params.OriginalCount * params.BlockBytes) == 0;
+
+    // Lose about one fragment in ten, and five fragments of the last column
+    srand(7);
+    for (int i = 0; i < blockCount * fragmentCount; ++i)
+    {
+        received[i] = (rand() % 10) != 0;
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        received[(i * 3) * fragmentCount + fragmentCount - 1] = 0;
+    }
+
+    // Provide the blocks in reverse order
+    cm256_fragment_block fragmentBlocks[256];
+    int erasedBlocks = 0;
+    for (int i = 0; i < blockCount; ++i)
+    {
+        const int index = blockCount - 1 - i;
+        fragmentBlocks[i].Block = originalData + index * params.BlockBytes;
+        fragmentBlocks[i].Received = received + index * fragmentCount;
+        fragmentBlocks[i].Index = static_cast<unsigned char>(index);
+        erasedBlocks += memchr(received + index * fragmentCount, 0, fragmentCount) != nullptr;
+    }
+
+    // Whole-block decoding could not have handled this
+    success &= erasedBlocks > params.RecoveryCount;
+
+    memset(decodedData, 0, params.OriginalCount * params.BlockBytes);
+    if (success)
+    {
+        success = cm256_decode_fragments(params, fragmentBytes, fragmentBlocks, blockCount,
+                                         decodedData, recovered) == -7;
+    }
+
+    for (int fragment = 0; success && fragment < fragmentCount; ++fragment)
+    {
+        int survivors = 0;
+        for (int i = 0; i < blockCount; ++i)
+        {
+            survivors += received[i * fragmentCount + fragment];
+        }
+
+        const int offset = fragment * fragmentBytes;
+        const int bytes = offset + fragmentBytes > params.BlockBytes ? params.BlockBytes - offset : fragmentBytes;
+
+        for (int i = 0; success && i < params.OriginalCount; ++i)
+        {
+            const bool expected = survivors >= params.OriginalCount || received[i * fragmentCount + fragment];
+            success = (recovered[i * fragmentCount + fragment] != 0) == expected;
+            if (success && expected)
+            {
+                success = memcmp(decodedData + i * params.BlockBytes + offset,
+                                 originalData + i * params.BlockBytes + offset, bytes) == 0;
+            }
+        }
+    }
+
+    // With at most RecoveryCount losses per fragment everything decodes
+    for (int fragment = 0; fragment < fragmentCount; ++fragment)
+    {
+        int losses = 0;
+        for (int i = 0; i < blockCount; ++i)
+        {
+            if (!received[i * fragmentCount + fragment] && ++losses > params.RecoveryCount)
+            {
+                received[i * fragmentCount + fragment] = 1;
+            }
+        }
+    }
+    if (success)
+    {
+        success = cm256_decode_fragments(params, fragmentBytes, fragmentBlocks, blockCount,
+                                         decodedData, nullptr) == 0;
+    }
+    if (success)
+    {
+        success = memcmp(decodedData, originalData, params.OriginalCount * params.BlockBytes) == 0;
+    }
+
+    delete[] originalData;
+    delete[] decodedData;
+    delete[] received;
+    delete[] recovered;
+
+    return success;
+}
+
+bool ParallelEncodeTest()
+{
+    static const int configs[4][3] = {
+        // OriginalCount, RecoveryCount, BlockBytes
+        { 200, 8, 1024 },
+        { 30, 5, 1300 },
+        { 7, 3, 40000 },
+        { 2, 2, 100 }
+    };
+
+    bool success = true;
+
+    for (int c = 0; success && c < 4; ++c)
+    {
+        // Skip shapes beyond the block limit of small-footprint builds
+        if (configs[c][0] + configs[c][1] > CM256_MAX_BLOCKS)
+        {
+            continue;
+        }
+
+        cm256_encoder_params params;
+        params.OriginalCount = configs[c][0];
+        params.RecoveryCount = configs[c][1];
+        params.BlockBytes = configs[c][2];
+
+        uint8_t* originalData = new uint8_t[params.OriginalCount * params.BlockBytes];
+        uint8_t* expected = new uint8_t[params.RecoveryCount * params.BlockBytes];
+        uint8_t* actual = new uint8_t[params.RecoveryCount * params.BlockBytes];
+
+        cm256_block blocks[256];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            blocks[i].Block = originalData + i * params.BlockBytes;
+            blocks[i].Index = cm256_get_original_block_index(params, i);
+        }
+        initializeBlocks(blocks, params.OriginalCount, params.BlockBytes);
+
+        success = cm256_encode(params, blocks, expected) == 0;
+
+        static const cm256_parallel_strategy strategies[3] = {
+            CM256_PARALLEL_AUTO, CM256_PARALLEL_BYTES, CM256_PARALLEL_COLUMNS
+        };
+
+        for (int threads = 1; success && threads <= 9; threads += 2)
+        {
+            for (int s = 0; success && s < 3; ++s)
+            {
+                memset(actual, 0xcc, params.RecoveryCount * params.BlockBytes);
+                success = cm256_encode_parallel(params, blocks, actual, threads, strategies[s]) == 0 &&
+                          memcmp(actual, expected, params.RecoveryCount * params.BlockBytes) == 0;
+            }
+        }
+
+        delete[] originalData;
+        delete[] expected;
+        delete[] actual;
+    }
+
+    return success;
+}
+
+bool VerifyTest()
+{
+    cm256_encoder_params params;
+    params.BlockBytes = 5000;
+    params.OriginalCount = 10;
+    params.RecoveryCount = 4;
+
+    uint8_t* originalData = new uint8_t[params.OriginalCount * params.BlockBytes];
+    uint8_t* recoveryData = new uint8_t[params.RecoveryCount * params.BlockBytes];
+
+    cm256_block originals[256], recovery[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        originals[i].Block = originalData + i * params.BlockBytes;
+        originals[i].Index = cm256_get_original_block_index(params, i);
+    }
+    initializeBlocks(originals, params.OriginalCount, params.BlockBytes);
+
+    bool success = cm256_encode(params, originals, recoveryData) == 0;
+
+    for (int i = 0; i < params.RecoveryCount; ++i)
+    {
+        recovery[i].Block = recoveryData + i * params.BlockBytes;
+        recovery[i].Index = cm256_get_recovery_block_index(params, i);
+    }
+
+    unsigned char mismatches[4];
+    success &= cm256_verify(params, originals, recovery, mismatches) == 0;
+    success &= memchr(mismatches, 1, 4) == nullptr;
+
+    // A bad original shows up in every recovery row
+    originalData[3 * params.BlockBytes + 4321] ^= 0x40;
+    success &= cm256_verify(params, originals, recovery, mismatches) == 1;
+    success &= memchr(mismatches, 0, 4) == nullptr;
+    success &= cm256_verify(params, originals, recovery, nullptr) == 1;
+    originalData[3 * params.BlockBytes + 4321] ^= 0x40;
+
+    // A bad recovery block only in its own row
+    recoveryData[2 * params.BlockBytes + 17] ^= 1;
+    success &= cm256_verify(params, originals, recovery, mismatches) == 1;
+    success &= mismatches[0] == 0 && mismatches[1] == 0 && mismatches[2] == 1 && mismatches[3] == 0;
+
+    delete[] originalData;
+    delete[] recoveryData;
+
+    return success;
+}
+
+bool EncodeCopyTest()
+{
+    static const int configs[3][3] = {
+        // OriginalCount, RecoveryCount, BlockBytes
+        { 100, 10, 1296 },
+        { 5, 3, 300000 },
+        { 1, 2, 777 }
+    };
+
+    bool success = true;
+
+    for (int c = 0; success && c < 3; ++c)
+    {
+        // Skip shapes beyond the block limit of small-footprint builds
+        if (configs[c][0] + configs[c][1] > CM256_MAX_BLOCKS)
+        {
+            continue;
+        }
+
+        cm256_encoder_params params;
+        params.OriginalCount = configs[c][0];
+        params.RecoveryCount = configs[c][1];
+        params.BlockBytes = configs[c][2];
+
+        uint8_t* originalData = new uint8_t[params.OriginalCount * params.BlockBytes];
+        uint8_t* copyData = new uint8_t[params.OriginalCount * params.BlockBytes];
+        uint8_t* expected = new uint8_t[params.RecoveryCount * params.BlockBytes];
+        uint8_t* actual = new uint8_t[params.RecoveryCount * params.BlockBytes];
+
+        cm256_block originals[256], copies[256];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            originals[i].Block = originalData + i * params.BlockBytes;
+            originals[i].Index = cm256_get_original_block_index(params, i);
+            copies[i].Block = copyData + i * params.BlockBytes;
+        }
+        initializeBlocks(originals, params.OriginalCount, params.BlockBytes);
+
+        success = cm256_encode(params, originals, expected) == 0 &&
+                  cm256_encode_copy(params, originals, copies, actual) == 0 &&
+                  memcmp(actual, expected, params.RecoveryCount * params.BlockBytes) == 0 &&
+                  memcmp(copyData, originalData, params.OriginalCount * params.BlockBytes) == 0;
+
+        delete[] originalData;
+        delete[] copyData;
+        delete[] expected;
+        delete[] actual;
+    }
+
+    return success;
+}
+
+struct PiggybackStripe
+{
+    cm256_encoder_params Params;
+    uint8_t* Data; // Originals then recovery blocks, end-to-end
+    uint64_t BytesRead;
+};
+
+static int readPiggybackStripe(void* context, int blockIndex, int offset, int bytes, void* data)
+{
+    PiggybackStripe* stripe = static_cast<PiggybackStripe*>(context);
+    memcpy(data, stripe->Data + blockIndex * stripe->Params.BlockBytes + offset, bytes);
+    stripe->BytesRead += bytes;
+    return 0;
+}
+
+bool PiggybackTest()
+{
+    static const int configs[3][3] = {
+        // OriginalCount, RecoveryCount, BlockBytes
+        { 10, 4, 4000 },
+        { 6, 3, 1000 },
+        { 3, 1, 64 }
+    };
+
+    bool success = true;
+
+    for (int c = 0; success && c < 3; ++c)
+    {
+        PiggybackStripe stripe;
+        stripe.Params.OriginalCount = configs[c][0];
+        stripe.Params.RecoveryCount = configs[c][1];
+        stripe.Params.BlockBytes = configs[c][2];
+
+        const cm256_encoder_params& params = stripe.Params;
+        const int blockCount = params.OriginalCount + params.RecoveryCount;
+        stripe.Data = new uint8_t[blockCount * params.BlockBytes];
+        uint8_t* received = new uint8_t[params.OriginalCount * params.BlockBytes];
+        uint8_t* repaired = new uint8_t[params.BlockBytes];
+
+        cm256_block blocks[256];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            blocks[i].Block = stripe.Data + i * params.BlockBytes;
+            blocks[i].Index = cm256_get_original_block_index(params, i);
+        }
+        initializeBlocks(blocks, params.OriginalCount, params.BlockBytes);
+
+        success = cm256_piggyback_encode(params, blocks, stripe.Data + params.OriginalCount * params.BlockBytes) == 0;
+
+        // Decode from the last OriginalCount blocks, which uses every recovery block
+        for (int i = 0; success && i < params.OriginalCount; ++i)
+        {
+            const int index = blockCount - params.OriginalCount + i;
+            memcpy(received + i * params.BlockBytes, stripe.Data + index * params.BlockBytes, params.BlockBytes);
+            blocks[i].Block = received + i * params.BlockBytes;
+            blocks[i].Index = (unsigned char)index;
+        }
+        success = success && cm256_piggyback_decode(params, blocks) == 0;
+        for (int i = 0; success && i < params.OriginalCount; ++i)
+        {
+            success = memcmp(blocks[i].Block, stripe.Data + blocks[i].Index * params.BlockBytes, params.BlockBytes) == 0;
+        }
+
+        // Repair every block, reading less than whole stripes for originals when m > 2
+        for (int i = 0; success && i < blockCount; ++i)
+        {
+            stripe.BytesRead = 0;
+            success = cm256_piggyback_repair(params, i, readPiggybackStripe, &stripe, repaired) == 0 &&
+                      memcmp(repaired, stripe.Data + i * params.BlockBytes, params.BlockBytes) == 0;
+
+            if (success && i < params.OriginalCount && params.RecoveryCount > 2)
+            {
+                success = stripe.BytesRead < (uint64_t)params.OriginalCount * params.BlockBytes;
+            }
+        }
+
+        delete[] stripe.Data;
+        delete[] received;
+        delete[] repaired;
+    }
+
+    return success;
+}
+
+struct ReadCacheStripe
+{
+    cm256_encoder_params Params;
+    uint8_t* Originals;
+    uint8_t* Recovery;
+    std::atomic<int> Fills;
+};
+
+static int fillReadCacheRange(void* context, uint64_t stripe, int originalIndex, int offset, int bytes, void* data)
+{
+    ReadCacheStripe* s = (ReadCacheStripe*)context;
+    s->Fills++;
+    if (stripe != 0)
+    {
+        return -8;
+    }
+
+    // Decode with the original lost, slowly enough that requests overlap
+    cm256_block blocks[256];
+    for (int i = 0; i < s->Params.OriginalCount; ++i)
+    {
+        blocks[i].Block = s->Originals + i * s->Params.BlockBytes;
+        blocks[i].Index = (unsigned char)i;
+    }
+    std::vector<uint8_t> copy(s->Params.BlockBytes);
+    blocks[originalIndex].Block = &copy[0];
+    memcpy(&copy[0], s->Recovery, s->Params.BlockBytes);
+    blocks[originalIndex].Index = cm256_get_recovery_block_index(s->Params, 0);
+    if (cm256_decode(s->Params, blocks))
+    {
+        return -5;
+    }
+    usleep(20000);
+
+    memcpy(data, (uint8_t*)blocks[originalIndex].Block + offset, bytes);
+    return 0;
+}
+
+bool ReadCacheTest()
+{
+    ReadCacheStripe s;
+    s.Params.OriginalCount = 8;
+    s.Params.RecoveryCount = 2;
+    s.Params.BlockBytes = 4096;
+    s.Fills = 0;
+
+    std::vector<uint8_t> originals(s.Params.OriginalCount * s.Params.BlockBytes);
+    std::vector<uint8_t> recovery(s.Params.RecoveryCount * s.Params.BlockBytes);
+    for (size_t i = 0; i < originals.size(); ++i)
+    {
+        originals[i] = (uint8_t)(i * 7 + i / 11);
+    }
+    s.Originals = &originals[0];
+    s.Recovery = &recovery[0];
+
+    cm256_block blocks[256];
+    for (int i = 0; i < s.Params.OriginalCount; ++i)
+    {
+        blocks[i].Block = s.Originals + i * s.Params.BlockBytes;
+    }
+    if (cm256_encode(s.Params, blocks, s.Recovery))
+    {
+        return false;
+    }
+
+    cm256_read_cache_params cacheParams;
+    cacheParams.MaxBytes = 3 * 1024;
+    cm256_read_cache* cache = cm256_read_cache_create(cacheParams);
+    if (!cache)
+    {
+        return false;
+    }
+
+    // Concurrent reads of the same range share one decode
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.push_back(std::thread([&]() {
+            uint8_t data[1024];
+            if (cm256_read_cache_get(cache, 0, 3, 512, 1024, data, fillReadCacheRange, &s) != 0 ||
+                memcmp(data, s.Originals + 3 * s.Params.BlockBytes + 512, 1024) != 0)
+            {
+                failures++;
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); ++t)
+    {
+        threads[t].join();
+    }
+
+    bool success = failures == 0 && s.Fills == 1;
+
+    cm256_read_cache_stats stats;
+    cm256_read_cache_get_stats(cache, &stats);
+    success &= stats.Misses == 1 && stats.Hits + stats.Joins == 7;
+
+    // Fill four ranges into room for three: the least recently used goes
+    uint8_t data[1024];
+    for (int i = 0; i < 4; ++i)
+    {
+        success &= cm256_read_cache_get(cache, 0, i, 0, 1024, data, fillReadCacheRange, &s) == 0;
+        success &= memcmp(data, s.Originals + i * s.Params.BlockBytes, 1024) == 0;
+        if (i == 1)
+        {
+            // Touch the first range so it outlives the others
+            success &= cm256_read_cache_get(cache, 0, 3, 512, 1024, data, fillReadCacheRange, &s) == 0;
+        }
+    }
+    cm256_read_cache_get_stats(cache, &stats);
+    success &= stats.Evictions == 2 && stats.CachedBytes == 3 * 1024 && stats.CachedRanges == 3;
+
+    const int fills = s.Fills;
+    success &= cm256_read_cache_get(cache, 0, 3, 512, 1024, data, fillReadCacheRange, &s) == 0;
+    success &= s.Fills == fills;
+
+    // Failed fills are reported and not cached
+    success &= cm256_read_cache_get(cache, 1, 0, 0, 1024, data, fillReadCacheRange, &s) == -8;
+    success &= cm256_read_cache_get(cache, 1, 0, 0, 1024, data, fillReadCacheRange, &s) == -8;
+    success &= s.Fills == fills + 2;
+
+    // Invalidation forces a new decode
+    cm256_read_cache_invalidate(cache, 0);
+    cm256_read_cache_get_stats(cache, &stats);
+    success &= stats.CachedBytes == 0 && stats.CachedRanges == 0;
+    success &= cm256_read_cache_get(cache, 0, 3, 512, 1024, data, fillReadCacheRange, &s) == 0;
+    success &= s.Fills == fills + 3;
+
+    cm256_read_cache_destroy(cache);
+    return success;
+}
+
+bool SchedulerTest()
+{
+    cm256_scheduler_params schedulerParams;
+    schedulerParams.WorkerCount = 3;
+    schedulerParams.SliceBytes = 4096;
+    schedulerParams.SharePercent[CM256_PRIORITY_LATENCY] = 100;
+    schedulerParams.SharePercent[CM256_PRIORITY_NORMAL] = 100;
+    schedulerParams.SharePercent[CM256_PRIORITY_BULK] = 30;
+    schedulerParams.ShareWindowMsec = 20;
+
+    cm256_scheduler* scheduler = cm256_scheduler_create(schedulerParams);
+    if (!scheduler)
+    {
+        return false;
+    }
+
+    static const int configs[3][3] = {
+        // OriginalCount, RecoveryCount, BlockBytes
+        { 10, 4, 100000 },
+        { 6, 3, 4097 },
+        { 1, 2, 5000 }
+    };
+
+    bool success = true;
+
+    for (int c = 0; success && c < 3; ++c)
+    {
+        cm256_encoder_params params;
+        params.OriginalCount = configs[c][0];
+        params.RecoveryCount = configs[c][1];
+        params.BlockBytes = configs[c][2];
+
+        const int jobCount = 6;
+        std::vector<uint8_t> originalData(params.OriginalCount * params.BlockBytes);
+        std::vector<uint8_t> expected(params.RecoveryCount * params.BlockBytes);
+        std::vector<uint8_t> recovery(jobCount * params.RecoveryCount * params.BlockBytes, 0xcc);
+
+        cm256_block blocks[256];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            blocks[i].Block = &originalData[i * params.BlockBytes];
+            blocks[i].Index = cm256_get_original_block_index(params, i);
+        }
+        initializeBlocks(blocks, params.OriginalCount, params.BlockBytes);
+        success = cm256_encode(params, blocks, &expected[0]) == 0;
+
+        // Encodes in every class at once
+        cm256_job* jobs[jobCount];
+        for (int j = 0; j < jobCount; ++j)
+        {
+            jobs[j] = cm256_scheduler_encode(scheduler, (cm256_priority)(j % CM256_PRIORITY_COUNT), params,
+                                             blocks, &recovery[j * params.RecoveryCount * params.BlockBytes]);
+            success &= jobs[j] != nullptr;
+        }
+        for (int j = 0; j < jobCount; ++j)
+        {
+            success &= jobs[j] && cm256_scheduler_wait(scheduler, jobs[j]) == 0;
+            success &= memcmp(&recovery[j * params.RecoveryCount * params.BlockBytes], &expected[0], expected.size()) == 0;
+        }
+
+        // Decodes with the first originals lost, a bulk job alongside a latency one
+        const int lost = std::min(params.OriginalCount, params.RecoveryCount);
+        cm256_block decodeBlocks[2][256];
+        std::vector<uint8_t> decodeData[2];
+        for (int j = 0; j < 2; ++j)
+        {
+            decodeData[j] = originalData;
+            memcpy(&decodeData[j][0], &expected[0], lost * params.BlockBytes);
+            for (int i = 0; i < params.OriginalCount; ++i)
+            {
+                decodeBlocks[j][i].Block = &decodeData[j][i * params.BlockBytes];
+                decodeBlocks[j][i].Index = (unsigned char)(i < lost ? cm256_get_recovery_block_index(params, i) : i);
+            }
+        }
+
+        cm256_job* bulk = cm256_scheduler_decode(scheduler, CM256_PRIORITY_BULK, params, decodeBlocks[0]);
+        cm256_job* latency = cm256_scheduler_decode(scheduler, CM256_PRIORITY_LATENCY, params, decodeBlocks[1]);
+        success &= bulk && latency;
+        success &= latency && cm256_scheduler_wait(scheduler, latency) == 0;
+        success &= bulk && cm256_scheduler_wait(scheduler, bulk) == 0;
+        success &= validateSolution(decodeBlocks[0], params.OriginalCount, params.BlockBytes);
+        success &= validateSolution(decodeBlocks[1], params.OriginalCount, params.BlockBytes);
+    }
+
+    cm256_scheduler_stats stats;
+    cm256_scheduler_get_stats(scheduler, &stats);
+    for (int c = 0; c < CM256_PRIORITY_COUNT; ++c)
+    {
+        success &= stats.Classes[c].Jobs > 0 && stats.Classes[c].Slices >= stats.Classes[c].Jobs;
+    }
+
+    cm256_scheduler_destroy(scheduler);
+    return success;
+}
+
+static bool writeTestFile(const char* path, const std::vector<uint8_t>& data)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+    const bool success = data.empty() || fwrite(&data[0], 1, data.size(), file) == data.size();
+    fclose(file);
+    return success;
+}
+
+static bool readTestFile(const char* path, std::vector<uint8_t>& data)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+    data.clear();
+    uint8_t buffer[4096];
+    size_t bytes;
+    while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + bytes);
+    }
+    fclose(file);
+    return true;
+}
+
+bool FileSetTest()
+{
+    // Unequal lengths, including an empty file and a partial last window
+    static const int lengths[5] = { 50000, 12345, 0, 40960, 1 };
+    const int inputCount = 5, parityCount = 3;
+
+    char names[8][64];
+    const char* inputs[5];
+    const char* parity[3];
+    std::vector<uint8_t> contents[5];
+    for (int i = 0; i < inputCount + parityCount; ++i)
+    {
+        snprintf(names[i], sizeof(names[i]), "/tmp/cm256_fileset_%d.%d", (int)getpid(), i);
+        if (i < inputCount)
+        {
+            inputs[i] = names[i];
+        }
+        else
+        {
+            parity[i - inputCount] = names[i];
+        }
+    }
+
+    bool success = true;
+    srand(113);
+    for (int i = 0; i < inputCount; ++i)
+    {
+        contents[i].resize(lengths[i]);
+        for (int j = 0; j < lengths[i]; ++j)
+        {
+            contents[i][j] = (uint8_t)rand();
+        }
+        success &= writeTestFile(inputs[i], contents[i]);
+    }
+
+    cm256_fileset_params params;
+    params.WindowBytes = 4096;
+    params.ThreadCount = 3;
+    success &= cm256_fileset_create(inputs, inputCount, parity, parityCount, params) == 0;
+
+    cm256_fileset_report report;
+    success &= cm256_fileset_check(inputs, inputCount, parity, parityCount, 2, 0, &report) == 0;
+    success &= report.WindowCount == 13 && report.DamagedWindows == 0 && report.DamagedParityWindows == 0;
+
+    int k = 0, m = 0;
+    success &= cm256_fileset_info(parity[2], &k, &m) == 0 && k == inputCount && m == parityCount;
+
+    // Lose a file, damage two more, and lose a parity file
+    unlink(inputs[0]);
+    std::vector<uint8_t> damaged = contents[1];
+    damaged[5000] ^= 1;
+    damaged.push_back(7);
+    success &= writeTestFile(inputs[1], damaged);
+    damaged = contents[3];
+    damaged[40000] ^= 0x80;
+    success &= writeTestFile(inputs[3], damaged);
+    unlink(parity[1]);
+
+    // Parity may be listed in any order
+    const char* shuffled[3] = { parity[2], parity[1], parity[0] };
+    success &= cm256_fileset_check(inputs, inputCount, shuffled, parityCount, 2, 0, &report) == 0;
+    success &= report.DamagedFiles == 2 && report.DamagedWindows == 13 + 2 + 1 &&
+               report.DamagedParityWindows == 13 && report.UnrecoverableWindows == 0;
+
+    success &= cm256_fileset_check(inputs, inputCount, shuffled, parityCount, 2, 1, &report) == 0;
+    success &= report.RepairedWindows == 16 + 13;
+
+    for (int i = 0; i < inputCount; ++i)
+    {
+        std::vector<uint8_t> data;
+        success &= readTestFile(inputs[i], data) && data == contents[i];
+    }
+    success &= cm256_fileset_check(inputs, inputCount, parity, parityCount, 1, 0, &report) == 0;
+    success &= report.DamagedWindows == 0 && report.DamagedParityWindows == 0 && report.DamagedFiles == 0;
+
+    // More erasures than parity in a window cannot be repaired
+    unlink(inputs[0]);
+    unlink(inputs[1]);
+    unlink(inputs[3]);
+    unlink(parity[0]);
+    success &= cm256_fileset_check(inputs, inputCount, parity, parityCount, 1, 1, &report) == -10;
+    success &= report.UnrecoverableWindows > 0;
+
+    for (int i = 0; i < inputCount + parityCount; ++i)
+    {
+        unlink(names[i]);
+    }
+
+    return success;
+}
+
+struct RowEncodeLog
+{
+    std::mutex Lock;
+    std::vector<int> Rows;
+    std::vector<std::thread::id> Threads;
+    const uint8_t* Expected;
+    int BlockBytes;
+    bool Matched;
+};
+
+static void logEncodedRow(void* context, int row, const void* recoveryBlock)
+{
+    RowEncodeLog* log = (RowEncodeLog*)context;
+    std::lock_guard<std::mutex> locker(log->Lock);
+    log->Rows.push_back(row);
+    log->Threads.push_back(std::this_thread::get_id());
+    log->Matched &= memcmp(recoveryBlock, log->Expected + row * log->BlockBytes, log->BlockBytes) == 0;
+}
+
+bool ProgressiveEncodeTest()
+{
+    cm256_encoder_params params;
+    params.OriginalCount = 20;
+    params.RecoveryCount = 6;
+    params.BlockBytes = 3000;
+
+    std::vector<uint8_t> originalData(params.OriginalCount * params.BlockBytes);
+    std::vector<uint8_t> expected(params.RecoveryCount * params.BlockBytes);
+    std::vector<uint8_t> actual(params.RecoveryCount * params.BlockBytes);
+
+    cm256_block blocks[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = &originalData[i * params.BlockBytes];
+    }
+    initializeBlocks(blocks, params.OriginalCount, params.BlockBytes);
+    if (cm256_encode(params, blocks, &expected[0]))
+    {
+        return false;
+    }
+
+    RowEncodeLog log;
+    log.Expected = &expected[0];
+    log.BlockBytes = params.BlockBytes;
+    log.Matched = true;
+
+    // Default order on the calling thread
+    bool success = cm256_encode_rows(params, blocks, &actual[0], nullptr, 0, logEncodedRow, &log) == 0;
+    success &= log.Rows.size() == 6 && log.Rows[0] == 0 && log.Rows[5] == 5 && log.Matched;
+    success &= actual == expected;
+
+    // Caller order, with a subset of the rows
+    static const unsigned char order[4] = { 0, 4, 2, 5 };
+    log.Rows.clear();
+    log.Threads.clear();
+    success &= cm256_encode_rows(params, blocks, &actual[0], order, 4, logEncodedRow, &log) == 0;
+    success &= log.Rows.size() == 4 && log.Rows[1] == 4 && log.Rows[3] == 5 && log.Matched;
+
+    // Duplicate rows are rejected
+    static const unsigned char duplicate[2] = { 1, 1 };
+    success &= cm256_encode_rows(params, blocks, &actual[0], duplicate, 2, logEncodedRow, &log) != 0;
+
+    // First two rows before returning, the rest on a worker
+    static const unsigned char reversed[6] = { 0, 5, 4, 3, 2, 1 };
+    std::fill(actual.begin(), actual.end(), 0);
+    log.Rows.clear();
+    log.Threads.clear();
+    cm256_row_encoder* encoder = cm256_encode_rows_start(params, blocks, &actual[0], reversed, 6, 2, logEncodedRow, &log);
+    success &= encoder != nullptr;
+    {
+        std::lock_guard<std::mutex> locker(log.Lock);
+        success &= log.Rows.size() >= 2 && log.Rows[0] == 0 && log.Rows[1] == 5;
+    }
+    success &= encoder && cm256_encode_rows_finish(encoder) == 0;
+    success &= log.Rows.size() == 6 && log.Rows[5] == 1 && log.Matched && actual == expected;
+    success &= log.Threads[1] == std::this_thread::get_id() && log.Threads[2] != std::this_thread::get_id();
+
+    return success;
+}
+
+bool IncrementalDecodeTest()
+{
+    static const int configs[4][5] = {
+        // OriginalCount, RecoveryCount, BlockBytes, initial losses, later losses
+        { 12, 5, 1000, 2, 2 },
+        { 40, 3, 777, 1, 2 },
+        { 2, 2, 64, 0, 2 },
+        { 1, 2, 100, 1, 0 }
+    };
+
+    bool success = true;
+
+    for (int c = 0; success && c < 4; ++c)
+    {
+        // Skip shapes beyond the block limit of small-footprint builds
+        if (configs[c][0] + configs[c][1] > CM256_MAX_BLOCKS)
+        {
+            continue;
+        }
+
+        cm256_encoder_params params;
+        params.OriginalCount = configs[c][0];
+        params.RecoveryCount = configs[c][1];
+        params.BlockBytes = configs[c][2];
+        const int initialLosses = configs[c][3];
+        const int laterLosses = configs[c][4];
+
+        std::vector<uint8_t> originalData(params.OriginalCount * params.BlockBytes);
+        std::vector<uint8_t> recoveryData(params.RecoveryCount * params.BlockBytes);
+
+        cm256_block blocks[256];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            blocks[i].Block = &originalData[i * params.BlockBytes];
+            blocks[i].Index = (unsigned char)i;
+        }
+        initializeBlocks(blocks, params.OriginalCount, params.BlockBytes);
+        success = cm256_encode(params, blocks, &recoveryData[0]) == 0;
+
+        // Replace the first originals with recovery blocks
+        for (int i = 0; i < initialLosses; ++i)
+        {
+            memcpy(blocks[i].Block, &recoveryData[i * params.BlockBytes], params.BlockBytes);
+            blocks[i].Index = cm256_get_recovery_block_index(params, i);
+        }
+
+        // The originals found lost later hold garbage from the start
+        for (int i = 0; i < laterLosses; ++i)
+        {
+            memset(blocks[params.OriginalCount - 1 - i].Block, 0x5a + i, params.BlockBytes / 2);
+        }
+
+        cm256_incremental* decoder = cm256_incremental_create(params, blocks);
+        success &= decoder != nullptr;
+        if (!decoder)
+        {
+            break;
+        }
+
+        cm256_block extra[256];
+        for (int i = 0; i < laterLosses; ++i)
+        {
+            const int row = initialLosses + i;
+            extra[i].Block = &recoveryData[row * params.BlockBytes];
+            extra[i].Index = cm256_get_recovery_block_index(params, row);
+
+            // Recovery blocks already in use are rejected
+            if (i == 0 && initialLosses > 0)
+            {
+                cm256_block reused = extra[i];
+                reused.Index = blocks[0].Index;
+                success &= cm256_incremental_extend(decoder, params.OriginalCount - 1, &reused) == -4;
+            }
+
+            success &= cm256_incremental_extend(decoder, params.OriginalCount - 1 - i, &extra[i]) == 0;
+            success &= cm256_incremental_extend(decoder, params.OriginalCount - 1 - i, &extra[i]) == -1;
+        }
+
+        success &= cm256_incremental_finish(decoder) == 0;
+        cm256_incremental_free(decoder);
+
+        // The recovery blocks and the good originals make up the stripe
+        cm256_block decoded[256];
+        int decodedCount = 0;
+        for (int i = 0; i < params.OriginalCount - laterLosses; ++i)
+        {
+            decoded[decodedCount++] = blocks[i];
+        }
+        for (int i = 0; i < laterLosses; ++i)
+        {
+            decoded[decodedCount++] = extra[i];
+        }
+        success &= validateSolution(decoded, params.OriginalCount, params.BlockBytes);
+    }
+
+    return success;
+}
+
+bool LargeBlockTest()
+{
+    cm256_large_params params;
+    params.OriginalCount = 5;
+    params.RecoveryCount = 3;
+    params.BlockBytes = 1000003;
+
+    cm256_encoder_params intParams;
+    intParams.OriginalCount = params.OriginalCount;
+    intParams.RecoveryCount = params.RecoveryCount;
+    intParams.BlockBytes = (int)params.BlockBytes;
+
+    std::vector<uint8_t> originalData(params.OriginalCount * params.BlockBytes);
+    std::vector<uint8_t> expected(params.RecoveryCount * params.BlockBytes);
+    std::vector<uint8_t> actual(params.RecoveryCount * params.BlockBytes);
+
+    cm256_block blocks[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = &originalData[i * params.BlockBytes];
+        blocks[i].Index = (unsigned char)i;
+    }
+    initializeBlocks(blocks, params.OriginalCount, intParams.BlockBytes);
+
+    bool success = cm256_encode(intParams, blocks, &expected[0]) == 0;
+    for (int threads = 1; success && threads <= 4; ++threads)
+    {
+        std::fill(actual.begin(), actual.end(), 0);
+        success = cm256_encode_large(params, blocks, &actual[0], threads) == 0 && actual == expected;
+    }
+
+    // Lose originals 1, 2 and 4
+    static const int lost[3] = { 1, 2, 4 };
+    for (int i = 0; i < 3; ++i)
+    {
+        blocks[lost[i]].Block = &actual[i * params.BlockBytes];
+        blocks[lost[i]].Index = cm256_get_recovery_block_index(intParams, i);
+    }
+    success &= cm256_decode_large(params, blocks, 3) == 0;
+    success &= validateSolution(blocks, params.OriginalCount, intParams.BlockBytes);
+
+    // The size_t kernels match the int ones
+    std::vector<uint8_t> x(expected.begin(), expected.begin() + 100000), y(x);
+    gf256_muladd_mem(&x[0], 7, &originalData[0], 100000);
+    gf256_muladd_mem_large(&y[0], 7, &originalData[0], 100000);
+    gf256_add2_mem(&x[0], &originalData[1], &originalData[2], 100000);
+    gf256_add2_mem_large(&y[0], &originalData[1], &originalData[2], 100000);
+    success &= x == y;
+
+    return success;
+}
+
+bool MultiXorTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    static const int counts[] = { 0, 1, 2, 3, 7, 8, 9, 16, 17, 64, 255 };
+    static const int lengths[] = { 0, 1, 7, 15, 16, 63, 64, 65, 200, 1296 };
+
+    std::vector<uint8_t> data(255 * 1300 + 1);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = (uint8_t)(i * 97 + (i >> 8) * 31 + 5);
+    }
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l)
+        {
+            const int count = counts[c];
+            const int bytes = lengths[l];
+
+            // Odd offsets so the sources are not aligned
+            const void* sources[256];
+            for (int j = 0; j < count; ++j)
+            {
+                sources[j] = &data[(size_t)j * 1300 + (j & 1)];
+            }
+
+            std::vector<uint8_t> expected(bytes + 1, 0), actual(bytes + 1, 0xcc);
+            for (int j = 0; j < count; ++j)
+            {
+                gf256_add_mem(&expected[0], sources[j], bytes);
+            }
+
+            gf256_addset_n_mem(&actual[0], sources, count, bytes);
+            if (memcmp(&expected[0], &actual[0], bytes) != 0 || actual[bytes] != 0xcc)
+            {
+                return false;
+            }
+
+            // Accumulating onto the result cancels it back to zero
+            gf256_add_n_mem(&actual[0], sources, count, bytes);
+            for (int i = 0; i < bytes; ++i)
+            {
+                if (actual[i] != 0)
+                {
+                    return false;
+                }
+            }
+            if (actual[bytes] != 0xcc)
+            {
+                return false;
+            }
+        }
+    }
+
+    // Parity row and single-erasure decode go through the multi-source path
+    cm256_encoder_params params;
+#if CM256_MAX_BLOCKS < 38
+    params.OriginalCount = 31;
+#else
+    params.OriginalCount = 37;
+#endif
+    params.RecoveryCount = 1;
+    params.BlockBytes = 1001;
+
+    std::vector<uint8_t> originals(params.OriginalCount * params.BlockBytes);
+    std::vector<uint8_t> recovery(params.BlockBytes);
+    cm256_block blocks[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = &originals[i * params.BlockBytes];
+        blocks[i].Index = cm256_get_original_block_index(params, i);
+    }
+    initializeBlocks(blocks, params.OriginalCount, params.BlockBytes);
+
+    if (cm256_encode(params, blocks, &recovery[0]))
+    {
+        return false;
+    }
+
+    blocks[5].Block = &recovery[0];
+    blocks[5].Index = cm256_get_recovery_block_index(params, 0);
+    if (cm256_decode(params, blocks))
+    {
+        return false;
+    }
+
+    return validateSolution(blocks, params.OriginalCount, params.BlockBytes);
+}
+
+// Small builds have no backend selection
+#if !defined(GF256_SMALL)
+
+// Encode and decode one stripe with two erasures, returns true if it round-trips
+static bool backendRoundTrip(int blockBytes)
+{
+    cm256_encoder_params params;
+    params.OriginalCount = 20;
+    params.RecoveryCount = 4;
+    params.BlockBytes = blockBytes;
+
+    std::vector<uint8_t> originals((size_t)params.OriginalCount * blockBytes);
+    std::vector<uint8_t> recovery((size_t)params.RecoveryCount * blockBytes);
+    cm256_block blocks[256];
+    for (int i = 0; i < params.OriginalCount; ++i)
+    {
+        blocks[i].Block = &originals[(size_t)i * blockBytes];
+        blocks[i].Index = cm256_get_original_block_index(params, i);
+    }
+    initializeBlocks(blocks, params.OriginalCount, blockBytes);
+
+    if (cm256_encode(params, blocks, &recovery[0]))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        blocks[3 + i * 7].Block = &recovery[(size_t)(i + 1) * blockBytes];
+        blocks[3 + i * 7].Index = cm256_get_recovery_block_index(params, i + 1);
+    }
+
+    return cm256_decode(params, blocks) == 0 &&
+           validateSolution(blocks, params.OriginalCount, blockBytes);
+}
+
+bool BackendSelectTest()
+{
+    if (cm256_init())
+    {
+        return false;
+    }
+
+    const std::string defaultName = gf256_backend_selected(GF256_SIZE_SMALL);
+
+    if (gf256_backend_autoselect(500) != 0)
+    {
+        return false;
+    }
+
+    // Every supported backend passes the self-test and the scalar kernels are always there
+    bool sawScalar = false;
+    for (int i = 0; i < gf256_backend_count(); ++i)
+    {
+        gf256_backend_info info;
+        if (gf256_get_backend_info(i, &info) != 0)
+        {
+            return false;
+        }
+        if (info.Supported && (info.Verified != 1 || info.MBps[GF256_SIZE_LARGE] <= 0.))
+        {
+            return false;
+        }
+        sawScalar |= strcmp(info.Name, "scalar") == 0;
+    }
+    if (!sawScalar || gf256_get_backend_info(gf256_backend_count(), nullptr) != -1)
+    {
+        return false;
+    }
+
+    // Blocks in every size class decode with the selected backends
+    if (!backendRoundTrip(1000) || !backendRoundTrip(20000) || !backendRoundTrip(100000))
+    {
+        return false;
+    }
+
+    // A/B: each backend forced in turn gives the same recovery data
+    if (gf256_backend_force("no-such-backend") != -1 || gf256_backend_selected(GF256_SIZE_CLASS_COUNT) != nullptr)
+    {
+        return false;
+    }
+    for (int i = 0; i < gf256_backend_count(); ++i)
+    {
+        gf256_backend_info info;
+        gf256_get_backend_info(i, &info);
+        if (!info.Supported)
+        {
+            continue;
+        }
+
+        if (gf256_backend_force(info.Name) != 0 ||
+            strcmp(gf256_backend_selected(GF256_SIZE_MEDIUM), info.Name) != 0 ||
+            !backendRoundTrip(1000) || !backendRoundTrip(20000))
+        {
+            return false;
+        }
+    }
+
+    // Leave the default backend in place for the other tests
+    return gf256_backend_force(defaultName.c_str()) == 0;
+}
+
+#endif // GF256_SMALL
+
+bool CarouselTest()
+{
+    cm256_carousel_params params;
+    params.BlockBytes = 1000;
+    params.RecoveryPerCycle = 6;
+    params.RecoveryRows = 0;
+
+    // Seven superframes, the last one partial.  Small-footprint builds need a
+    // superframe small enough to be rebuilt from recovery rows alone.
+#if CM256_MAX_BLOCKS < 40
+    params.OriginalCount = 12;
+    const uint64_t bytes = 6 * 12 * 1000 + 2345;
+    const uint64_t minCycles = 2;
+#else
+    params.OriginalCount = 20;
+    const uint64_t bytes = 6 * 20 * 1000 + 12345;
+    const uint64_t minCycles = 3;
+#endif
+    std::vector<uint8_t> data(bytes);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = (uint8_t)(i * 7 + (i >> 10));
+    }
+
+    cm256_carousel* carousel = cm256_carousel_create(params, &data[0], bytes);
+    if (!carousel || cm256_carousel_superframe_count(carousel) != 7)
+    {
+        return false;
+    }
+
+    // Only the first cycle of recovery rows is encoded up front
+    cm256_carousel_stats stats;
+    cm256_carousel_get_stats(carousel, &stats);
+    if (stats.RecoveryEncoded != 7 * 6)
+    {
+        return false;
+    }
+
+    // 40% random loss, and originals of superframe 2 never arrive
+    cm256_carousel_receiver* receiver = cm256_carousel_receiver_create(params, bytes);
+    if (!receiver)
+    {
+        return false;
+    }
+
+    uint32_t seed = 12345;
+    uint64_t packets = 0;
+    bool ok = true;
+    while (cm256_carousel_receiver_complete_count(receiver) < 7 && packets < 100000)
+    {
+        cm256_carousel_packet packet;
+        if (cm256_carousel_next(carousel, &packet) != 0)
+        {
+            ok = false;
+            break;
+        }
+        ++packets;
+
+        seed = seed * 1103515245 + 12345;
+        if ((seed >> 16) % 100 < 40 || (packet.Superframe == 2 && packet.Index < params.OriginalCount))
+        {
+            continue;
+        }
+
+        const int result = cm256_carousel_receive(receiver, &packet);
+        if (result < 0 || result > 2)
+        {
+            ok = false;
+            break;
+        }
+        if (result == 1 && !cm256_carousel_receiver_is_complete(receiver, packet.Superframe))
+        {
+            ok = false;
+            break;
+        }
+    }
+
+    ok = ok && cm256_carousel_receiver_complete_count(receiver) == 7 &&
+         memcmp(cm256_carousel_receiver_data(receiver), &data[0], (size_t)bytes) == 0;
+
+    // Superframe 2 needed recovery rows from later cycles, encoded on first use
+    cm256_carousel_get_stats(carousel, &stats);
+    ok = ok && stats.Cycles >= minCycles && stats.RecoveryEncoded > 7 * 6;
+
+    // Duplicates and completed superframes are ignored
+    cm256_carousel_packet packet;
+    cm256_carousel_next(carousel, &packet);
+    ok = ok && cm256_carousel_receive(receiver, &packet) == 2;
+    packet.Superframe = 7;
+    ok = ok && cm256_carousel_receive(receiver, &packet) == -4;
+
+    cm256_carousel_receiver_destroy(receiver);
+    cm256_carousel_destroy(carousel);
+
+    // A bounded rotation stops encoding once every row has been sent
+    params.RecoveryRows = 12;
+    carousel = cm256_carousel_create(params, &data[0], bytes);
+    ok = ok && carousel != nullptr;
+    for (int i = 0; ok && i < 7 * (params.OriginalCount + 6) * 5; ++i)
+    {
+        ok = cm256_carousel_next(carousel, &packet) == 0 &&
+             packet.Index < params.OriginalCount + params.RecoveryRows;
+    }
+    cm256_carousel_get_stats(carousel, &stats);
+    ok = ok && stats.Cycles == 5 && stats.RecoveryEncoded == 7 * 12;
+    cm256_carousel_destroy(carousel);
+
+    // Invalid parameters
+    params.RecoveryRows = 5;
+    ok = ok && cm256_carousel_create(params, &data[0], bytes) == nullptr;
+    params.RecoveryRows = 0;
+    params.RecoveryPerCycle = CM256_MAX_BLOCKS - params.OriginalCount + 1;
+    ok = ok && cm256_carousel_create(params, &data[0], bytes) == nullptr;
+
+    return ok;
+}
+
+struct PipelineTestState
+{
+    int OriginalCount;
+    int BlockBytes;
+    uint64_t NextSuperframe;
+    int Delivered;
+    int Failed;
+    bool Ok;
+};
+
+static uint8_t pipelineTestByte(uint64_t superframe, size_t offset)
+{
+    return (uint8_t)(offset * 13 + superframe * 101 + (offset >> 8));
+}
+
+static void pipelineTestDeliver(void* context, uint64_t superframe, const void* data, int result)
+{
+    PipelineTestState* state = static_cast<PipelineTestState*>(context);
+
+    // Strictly in order, whatever order the workers finish in
+    if (superframe != state->NextSuperframe++)
+    {
+        state->Ok = false;
+    }
+
+    if (result != 0)
+    {
+        state->Failed++;
+        if (superframe != 7 || result != -7 || data)
+        {
+            state->Ok = false;
+        }
+        return;
+    }
+
+    state->Delivered++;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < (size_t)state->OriginalCount * state->BlockBytes; ++i)
+    {
+        if (bytes[i] != pipelineTestByte(superframe, i))
+        {
+            state->Ok = false;
+            return;
+        }
+    }
+}
+
+bool PipelineTest()
+{
+    cm256_pipeline_params params;
+    params.OriginalCount = 20;
+    params.RecoveryCount = 8;
+    params.BlockBytes = 1000;
+    params.WorkerCount = 3;
+    params.Window = 4;
+    params.PoolBlocks = 0;
+
+    const int superframeCount = 30;
+    const int blockCount = params.OriginalCount + params.RecoveryCount;
+
+    cm256_encoder_params encoderParams;
+    encoderParams.OriginalCount = params.OriginalCount;
+    encoderParams.RecoveryCount = params.RecoveryCount;
+    encoderParams.BlockBytes = params.BlockBytes;
+
+    // Encode every superframe up front
+    std::vector<uint8_t> sent((size_t)superframeCount * blockCount * params.BlockBytes);
+    for (int s = 0; s < superframeCount; ++s)
+    {
+        uint8_t* superframe = &sent[(size_t)s * blockCount * params.BlockBytes];
+        for (size_t i = 0; i < (size_t)params.OriginalCount * params.BlockBytes; ++i)
+        {
+            superframe[i] = pipelineTestByte(s, i);
+        }
+
+        cm256_block blocks[256];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            blocks[i].Block = superframe + (size_t)i * params.BlockBytes;
+            blocks[i].Index = (unsigned char)i;
+        }
+        if (cm256_encode(encoderParams, blocks, superframe + (size_t)params.OriginalCount * params.BlockBytes))
+        {
+            return false;
+        }
+    }
+
+    PipelineTestState state;
+    state.OriginalCount = params.OriginalCount;
+    state.BlockBytes = params.BlockBytes;
+    state.NextSuperframe = 0;
+    state.Delivered = 0;
+    state.Failed = 0;
+    state.Ok = true;
+
+    // Like cm256_decode(), the pipeline needs at least one recovery block
+    cm256_pipeline_params noRecovery = params;
+    noRecovery.RecoveryCount = 0;
+    cm256_pipeline* rejected = cm256_pipeline_create(noRecovery, pipelineTestDeliver, &state);
+    if (rejected)
+    {
+        cm256_pipeline_destroy(rejected);
+        return false;
+    }
+
+    cm256_pipeline* pipeline = cm256_pipeline_create(params, pipelineTestDeliver, &state);
+    if (!pipeline)
+    {
+        return false;
+    }
+
+    // Packets of two superframes interleaved, 20% random loss up to
+    // RecoveryCount per superframe, and only half of superframe 7 arrives
+    uint32_t seed = 4321;
+    for (int s = 0; s < superframeCount; s += 2)
+    {
+        int lost[2] = { 0, 0 };
+
+        for (int i = 0; i < 2 * blockCount; ++i)
+        {
+            const int superframe = s + (i & 1);
+            const int index = blockCount - 1 - i / 2;
+
+            seed = seed * 1103515245 + 12345;
+            if (((seed >> 16) % 5 == 0 && lost[i & 1] < params.RecoveryCount) ||
+                (superframe == 7 && index % 2 == 0))
+            {
+                lost[i & 1]++;
+                continue;
+            }
+
+            void* buffer = cm256_pipeline_acquire(pipeline);
+            if (!buffer)
+            {
+                cm256_pipeline_destroy(pipeline);
+                return false;
+            }
+            memcpy(buffer, &sent[((size_t)superframe * blockCount + index) * params.BlockBytes], params.BlockBytes);
+            if (cm256_pipeline_submit(pipeline, superframe, index, buffer) < 0)
+            {
+                cm256_pipeline_destroy(pipeline);
+                return false;
+            }
+        }
+    }
+
+    // Bad block index: the buffer stays with the caller
+    void* buffer = cm256_pipeline_acquire(pipeline);
+    if (cm256_pipeline_submit(pipeline, 0, blockCount, buffer) != -4)
+    {
+        cm256_pipeline_destroy(pipeline);
+        return false;
+    }
+    cm256_pipeline_release(pipeline, buffer);
+
+    cm256_pipeline_flush(pipeline);
+
+    cm256_pipeline_stats stats;
+    cm256_pipeline_get_stats(pipeline, &stats);
+    cm256_pipeline_destroy(pipeline);
+
+    return state.Ok &&
+           state.NextSuperframe == (uint64_t)superframeCount &&
+           state.Delivered == superframeCount - 1 &&
+           state.Failed == 1 &&
+           stats.Delivered == (uint64_t)superframeCount - 1 &&
+           stats.Failed == 1 &&
+           stats.ExtraPackets > 0 &&
+           stats.PoolFree == (uint64_t)params.Window * blockCount &&
+           stats.Decode.Count == stats.Delivered &&
+           stats.Reassembly.Count == stats.Delivered;
+}
+
+struct ConvertTestStripes
+{
+    cm256_convert_params Params;
+    std::vector<uint8_t> Data; // Each narrow stripe's originals then recovery blocks, end-to-end
+    int Reads;
+};
+
+static int convertTestRead(void* context, int stripe, int blockIndex, void* data)
+{
+    ConvertTestStripes* stripes = static_cast<ConvertTestStripes*>(context);
+    const cm256_convert_params& params = stripes->Params;
+    const int stripeBlocks = params.StripeOriginalCount + params.StripeRecoveryCount;
+
+    memcpy(data, &stripes->Data[((size_t)stripe * stripeBlocks + blockIndex) * params.BlockBytes], params.BlockBytes);
+    stripes->Reads++;
+    return 0;
+}
+
+static bool convertShape(int stripeOriginalCount, int stripeRecoveryCount, int stripeCount, int recoveryCount)
+{
+    ConvertTestStripes stripes;
+    cm256_convert_params& params = stripes.Params;
+    params.StripeOriginalCount = stripeOriginalCount;
+    params.StripeRecoveryCount = stripeRecoveryCount;
+    params.StripeCount = stripeCount;
+    params.RecoveryCount = recoveryCount;
+    params.BlockBytes = 1000;
+
+    const int blockBytes = params.BlockBytes;
+    const int stripeBlocks = stripeOriginalCount + stripeRecoveryCount;
+    const cm256_encoder_params wide = cm256_convert_wide_params(params);
+
+    // Encode each narrow stripe
+    stripes.Data.resize((size_t)stripeCount * stripeBlocks * blockBytes);
+    for (size_t i = 0; i < stripes.Data.size(); ++i)
+    {
+        stripes.Data[i] = (uint8_t)(i * 29 + (i >> 9));
+    }
+
+    cm256_block blocks[256];
+    for (int s = 0; s < stripeCount; ++s)
+    {
+        uint8_t* stripe = &stripes.Data[(size_t)s * stripeBlocks * blockBytes];
+        for (int j = 0; j < stripeOriginalCount; ++j)
+        {
+            blocks[j].Block = stripe + (size_t)j * blockBytes;
+            blocks[j].Index = (unsigned char)j;
+        }
+        if (cm256_convert_encode(params, s, blocks, stripe + (size_t)stripeOriginalCount * blockBytes))
+        {
+            return false;
+        }
+    }
+
+    // Lose as many originals of the last stripe as it has recovery rows
+    const int lastStripe = stripeCount - 1;
+    std::vector<uint8_t> copy(&stripes.Data[(size_t)lastStripe * stripeBlocks * blockBytes],
+                              &stripes.Data[(size_t)lastStripe * stripeBlocks * blockBytes] + (size_t)stripeBlocks * blockBytes);
+    for (int i = 0; i < stripeOriginalCount; ++i)
+    {
+        const int index = i < stripeRecoveryCount ? stripeOriginalCount + i : i;
+        blocks[i].Block = &copy[(size_t)index * blockBytes];
+        blocks[i].Index = (unsigned char)index;
+    }
+    if (cm256_convert_decode(params, lastStripe, blocks))
+    {
+        return false;
+    }
+    for (int i = 0; i < stripeOriginalCount; ++i)
+    {
+        if (memcmp(blocks[i].Block, &stripes.Data[((size_t)lastStripe * stripeBlocks + blocks[i].Index) * blockBytes], blockBytes))
+        {
+            return false;
+        }
+    }
+
+    // Convert, and compare with encoding the wide stripe from scratch
+    std::vector<uint8_t> converted((size_t)recoveryCount * blockBytes);
+    stripes.Reads = 0;
+    if (cm256_convert(params, convertTestRead, &stripes, &converted[0]))
+    {
+        return false;
+    }
+    if (stripes.Reads != (recoveryCount <= stripeRecoveryCount ? stripeCount * recoveryCount : wide.OriginalCount))
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> expected((size_t)recoveryCount * blockBytes);
+    for (int i = 0; i < wide.OriginalCount; ++i)
+    {
+        blocks[i].Block = &stripes.Data[((size_t)(i / stripeOriginalCount) * stripeBlocks + i % stripeOriginalCount) * blockBytes];
+        blocks[i].Index = (unsigned char)i;
+    }
+    if (cm256_encode(wide, blocks, &expected[0]) || converted != expected)
+    {
+        return false;
+    }
+
+    // The wide stripe decodes with cm256_decode()
+    std::vector<uint8_t> wideCopy((size_t)wide.OriginalCount * blockBytes);
+    for (int i = 0; i < wide.OriginalCount; ++i)
+    {
+        if (i < recoveryCount)
+        {
+            memcpy(&wideCopy[(size_t)i * blockBytes], &converted[(size_t)i * blockBytes], blockBytes);
+            blocks[i].Index = (unsigned char)(wide.OriginalCount + i);
+        }
+        else
+        {
+            memcpy(&wideCopy[(size_t)i * blockBytes], blocks[i].Block, blockBytes);
+        }
+        blocks[i].Block = &wideCopy[(size_t)i * blockBytes];
+    }
+    if (cm256_decode(wide, blocks))
+    {
+        return false;
+    }
+    for (int i = 0; i < wide.OriginalCount; ++i)
+    {
+        const int index = blocks[i].Index;
+        if (memcmp(blocks[i].Block, &stripes.Data[((size_t)(index / stripeOriginalCount) * stripeBlocks + index % stripeOriginalCount) * blockBytes], blockBytes))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ConvertTest()
+{
+    if (!convertShape(6, 3, 2, 3) ||
+        !convertShape(6, 3, 2, 2) ||
+        !convertShape(6, 3, 2, 4) ||
+#if CM256_MAX_BLOCKS < 44
+        !convertShape(7, 4, 4, 4) ||
+#else
+        !convertShape(10, 4, 4, 4) ||
+#endif
+        !convertShape(1, 2, 3, 1))
+    {
+        return false;
+    }
+
+    // Wide stripe too large
+    cm256_convert_params params;
+    params.StripeOriginalCount = 64;
+    params.StripeRecoveryCount = 4;
+    params.StripeCount = 4;
+    params.RecoveryCount = 4;
+    params.BlockBytes = 1000;
+    cm256_block blocks[64];
+    uint8_t recovery[4];
+    return cm256_convert_encode(params, 0, blocks, recovery) == -2;
+}
+
+#if defined(CM256_SCRUB_PATH)
+
+// Run the cm256_scrub tool, collecting what it prints for bad stripes.
+// Returns its exit code, or -1 if it could not be run.
+static int runScrub(const std::string& args, std::string& output)
+{
+    const std::string command = std::string(CM256_SCRUB_PATH) + " " + args + " 2>/dev/null";
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe)
+    {
+        return -1;
+    }
+
+    output.clear();
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), pipe))
+    {
+        output += buffer;
+    }
+
+    const int status = pclose(pipe);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Invert one byte of a shard file; doing it again puts the byte back
+static bool flipShardByte(const char* path, long position)
+{
+    FILE* file = fopen(path, "r+b");
+    if (!file)
+    {
+        return false;
+    }
+    bool success = fseek(file, position, SEEK_SET) == 0;
+    const int value = success ? fgetc(file) : EOF;
+    success = value != EOF && fseek(file, position, SEEK_SET) == 0 &&
+              fputc(value ^ 0xff, file) != EOF;
+    fclose(file);
+    return success;
+}
+
+// Write the checkpoint of a scrub stopped before 'stripe' with one bad stripe
+static bool writeScrubCheckpoint(const char* path, int stripe, int badStripe)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+    const bool success = fprintf(file, "%d 1\n%d\n", stripe, badStripe) > 0;
+    fclose(file);
+    return success;
+}
+
+bool ScrubTest()
+{
+    cm256_encoder_params params;
+    params.OriginalCount = 4;
+    params.RecoveryCount = 2;
+    params.BlockBytes = 1000;
+
+    const int shardCount = params.OriginalCount + params.RecoveryCount;
+    const int stripeCount = 8;
+
+    char paths[6][64], checkpoint[64];
+    std::string args = "k=4 m=2 block=1000 checkpoint=";
+    snprintf(checkpoint, sizeof(checkpoint), "/tmp/cm256_scrub_%d.ckpt", (int)getpid());
+    args += checkpoint;
+    for (int i = 0; i < shardCount; ++i)
+    {
+        snprintf(paths[i], sizeof(paths[i]), "/tmp/cm256_scrub_%d.%d", (int)getpid(), i);
+        args += " ";
+        args += paths[i];
+    }
+
+    std::vector<uint8_t> shards[6];
+    for (int i = 0; i < shardCount; ++i)
+    {
+        shards[i].resize((size_t)stripeCount * params.BlockBytes);
+    }
+    for (int s = 0; s < stripeCount; ++s)
+    {
+        cm256_block blocks[256];
+        for (int i = 0; i < params.OriginalCount; ++i)
+        {
+            blocks[i].Block = &shards[i][(size_t)s * params.BlockBytes];
+            blocks[i].Index = (unsigned char)i;
+            for (int j = 0; j < params.BlockBytes; ++j)
+            {
+                static_cast<uint8_t*>(blocks[i].Block)[j] = (uint8_t)(s * 31 + i * 7 + j);
+            }
+        }
+        for (int r = 0; r < params.RecoveryCount; ++r)
+        {
+            cm256_encode_block(params, blocks, params.OriginalCount + r,
+                               &shards[params.OriginalCount + r][(size_t)s * params.BlockBytes]);
+        }
+    }
+
+    bool success = true;
+    for (int i = 0; i < shardCount; ++i)
+    {
+        success &= writeTestFile(paths[i], shards[i]);
+    }
+
+    // Damage original 2 of stripe 1 and original 0 of stripe 5
+    success &= flipShardByte(paths[2], 1 * params.BlockBytes + 17);
+    success &= flipShardByte(paths[0], 5 * params.BlockBytes + 300);
+
+    std::string output;
+    if (success)
+    {
+        // A full pass finds both, and a finished scrub removes its checkpoint
+        success &= runScrub(args, output) == 1;
+        success &= output.find("stripe 1:") != std::string::npos;
+        success &= output.find(std::string("bad block 2 in ") + paths[2]) != std::string::npos;
+        success &= output.find("stripe 5:") != std::string::npos;
+        success &= output.find(std::string("bad block 0 in ") + paths[0]) != std::string::npos;
+        success &= access(checkpoint, F_OK) != 0;
+    }
+
+    // Resume after the first four stripes, with stripe 1 already found bad
+    if (success)
+    {
+        success &= writeScrubCheckpoint(checkpoint, 4, 1);
+
+        success &= runScrub(args, output) == 1;
+        success &= output.find("stripe 1:") == std::string::npos;
+        success &= output.find("stripe 5:") != std::string::npos;
+        success &= access(checkpoint, F_OK) != 0;
+    }
+
+    // With the rest of the shards clean, the earlier find still fails the scrub
+    if (success)
+    {
+        success &= flipShardByte(paths[0], 5 * params.BlockBytes + 300);
+        success &= writeScrubCheckpoint(checkpoint, 4, 1);
+
+        success &= runScrub(args, output) == 1;
+        success &= output.empty();
+    }
+
+    // Once repaired, a fresh scrub passes
+    if (success)
+    {
+        success &= flipShardByte(paths[2], 1 * params.BlockBytes + 17);
+        success &= runScrub(args, output) == 0;
+        success &= output.empty();
+    }
+
+    unlink(checkpoint);
+    for (int i = 0; i < shardCount; ++i)
+    {
+        unlink(paths[i]);
+    }
+
+    return success;
+}
+
+#endif // CM256_SCRUB_PATH
+
 int main()
 {
+    // The examples use up to 128 + 32 blocks, more than a small-footprint build may allow
+#if CM256_MAX_BLOCKS >= 160
     if (!ExampleFileUsage())
     {
         std::cerr << "ExampleFileUsage failed" << std::endl;
@@ -513,6 +2656,179 @@ int main()
     }
 
     std::cerr << "example3 successful" << std::endl;
+#endif // CM256_MAX_BLOCKS >= 160
+
+    if (!RepairTest())
+    {
+        std::cerr << "RepairTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "RepairTest successful" << std::endl;
+
+    if (!StoreTest())
+    {
+        std::cerr << "StoreTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "StoreTest successful" << std::endl;
+
+    if (!VolumeTest())
+    {
+        std::cerr << "VolumeTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "VolumeTest successful" << std::endl;
+
+    if (!StripeCacheTest())
+    {
+        std::cerr << "StripeCacheTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "StripeCacheTest successful" << std::endl;
+
+    if (!FragmentDecodeTest())
+    {
+        std::cerr << "FragmentDecodeTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "FragmentDecodeTest successful" << std::endl;
+
+    if (!ParallelEncodeTest())
+    {
+        std::cerr << "ParallelEncodeTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "ParallelEncodeTest successful" << std::endl;
+
+    if (!VerifyTest())
+    {
+        std::cerr << "VerifyTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "VerifyTest successful" << std::endl;
+
+    if (!EncodeCopyTest())
+    {
+        std::cerr << "EncodeCopyTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "EncodeCopyTest successful" << std::endl;
+
+    if (!PiggybackTest())
+    {
+        std::cerr << "PiggybackTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "PiggybackTest successful" << std::endl;
+
+    if (!ReadCacheTest())
+    {
+        std::cerr << "ReadCacheTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "ReadCacheTest successful" << std::endl;
+
+    if (!SchedulerTest())
+    {
+        std::cerr << "SchedulerTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "SchedulerTest successful" << std::endl;
+
+    if (!FileSetTest())
+    {
+        std::cerr << "FileSetTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "FileSetTest successful" << std::endl;
+
+    if (!ProgressiveEncodeTest())
+    {
+        std::cerr << "ProgressiveEncodeTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "ProgressiveEncodeTest successful" << std::endl;
+
+    if (!IncrementalDecodeTest())
+    {
+        std::cerr << "IncrementalDecodeTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "IncrementalDecodeTest successful" << std::endl;
+
+    if (!LargeBlockTest())
+    {
+        std::cerr << "LargeBlockTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "LargeBlockTest successful" << std::endl;
+
+    if (!MultiXorTest())
+    {
+        std::cerr << "MultiXorTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "MultiXorTest successful" << std::endl;
+
+#if !defined(GF256_SMALL)
+    if (!BackendSelectTest())
+    {
+        std::cerr << "BackendSelectTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "BackendSelectTest successful" << std::endl;
+#endif
+
+    if (!CarouselTest())
+    {
+        std::cerr << "CarouselTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "CarouselTest successful" << std::endl;
+
+    if (!PipelineTest())
+    {
+        std::cerr << "PipelineTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "PipelineTest successful" << std::endl;
+
+    if (!ConvertTest())
+    {
+        std::cerr << "ConvertTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "ConvertTest successful" << std::endl;
+
+#if defined(CM256_SCRUB_PATH)
+    if (!ScrubTest())
+    {
+        std::cerr << "ScrubTest failed" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "ScrubTest successful" << std::endl;
+#endif // CM256_SCRUB_PATH
 
     return 0;
 }